@@ -32,6 +32,7 @@ class DBScan : Graph<T>
   DBScan() = delete;
   explicit DBScan(const size_t nThreads);
   void init(std::vector<T>&, std::function<bool(const T& v1, const T& v2)>);
+  void init(std::vector<T>&, std::function<bool(const T& v1, const T& v2)>, std::function<std::array<float, 3>(const T&)>, const float cellSize);
   void classifyVertices(const int);
   void classifyVertices(std::function<unsigned char(std::vector<Edge>&)> classFunction);
   void classifyVertices(std::function<unsigned char(std::vector<Edge>&)> classFunction, std::function<bool(State&, State&)> sortFunction);
@@ -56,6 +57,14 @@ void DBScan<T>::init(std::vector<T>& vertices, std::function<bool(const T& v1, c
   this->Graph<T>::computeEdges(discFunction);
 }
 
+template <typename T>
+void DBScan<T>::init(std::vector<T>& vertices, std::function<bool(const T& v1, const T& v2)> discFunction,
+                     std::function<std::array<float, 3>(const T&)> positionFunction, const float cellSize)
+{
+  this->Graph<T>::init(vertices);
+  this->Graph<T>::computeEdges(discFunction, positionFunction, cellSize);
+}
+
 template <typename T>
 void DBScan<T>::classifyVertices(const int nContributors)
 {
@@ -67,29 +76,13 @@ template <typename T>
 void DBScan<T>::classifyVertices(std::function<unsigned char(std::vector<Edge>& edges)> classFunction)
 {
   mClassFunction = classFunction;
-  const size_t size = {this->mVertices->size()};
-  mStates.resize(size);
+  mStates.resize(this->mVertices->size());
 
-  if (!this->isMultiThreading()) {
-    for (size_t iVertex{0}; iVertex < size; ++iVertex) {
-      mStates[iVertex] = std::make_pair<int, unsigned char>(iVertex, classFunction(this->getEdges()[iVertex]));
-    }
-  } else {
-    const size_t stride{static_cast<size_t>(std::ceil(this->mVertices->size() / static_cast<size_t>(this->mExecutors.size())))};
-    for (size_t iExecutor{0}; iExecutor < this->mExecutors.size(); ++iExecutor) {
-      // We cannot pass a template function to std::thread(), using lambda instead
-      this->mExecutors[iExecutor] = std::thread(
-        [iExecutor, stride, this](const auto& classFunction) {
-          for (size_t iVertex{iExecutor * stride}; iVertex < stride * (iExecutor + 1) && iVertex < this->mVertices->size(); ++iVertex) {
-            mStates[iVertex] = std::make_pair<int, unsigned char>(iVertex, classFunction(this->getEdges()[iVertex]));
-          }
-        },
-        mClassFunction);
+  this->forEachVertexRange([this](const size_t begin, const size_t end) {
+    for (size_t iVertex{begin}; iVertex < end; ++iVertex) {
+      mStates[iVertex] = std::make_pair<int, unsigned char>(iVertex, mClassFunction(this->mEdges[iVertex]));
     }
-  }
-  for (auto&& thread : this->mExecutors) {
-    thread.join();
-  }
+  });
 }
 
 template <typename T>
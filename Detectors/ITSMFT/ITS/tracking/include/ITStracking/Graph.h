@@ -15,13 +15,18 @@
 #ifndef TRACKINGITSU_INCLUDE_ALGORITHMS_H_
 #define TRACKINGITSU_INCLUDE_ALGORITHMS_H_
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <condition_variable>
+#include <exception>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <numeric>
 #include <queue>
+#include <stdexcept>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -45,6 +50,33 @@ class Barrier
   std::size_t count;
 };
 
+// Persistent set of threads, all running the same task, to avoid spawning new threads at every call.
+// The calling thread takes part in the processing as executor 0.
+class WorkerPool
+{
+ public:
+  explicit WorkerPool(const std::size_t nExecutors);
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+  ~WorkerPool();
+  std::size_t size() const { return mThreads.size() + 1; }
+  // Returns when task(iExecutor) is done on all executors, then rethrows the exception of the task if it threw on any of them
+  void run(const std::function<void(const std::size_t)>& task);
+
+ private:
+  void loop(const std::size_t iExecutor);
+
+  std::vector<std::thread> mThreads;
+  std::mutex mMutex;
+  std::condition_variable mStart;
+  std::condition_variable mDone;
+  const std::function<void(const std::size_t)>* mTask = nullptr;
+  unsigned long mGeneration = 0;
+  std::size_t mPending = 0;
+  std::exception_ptr mException;
+  bool mStop = false;
+};
+
 template <typename T>
 class Graph
 {
@@ -56,11 +88,20 @@ class Graph
   std::vector<int> getClusterIndices(const int);
   std::vector<int> getClusterIndices(const std::vector<unsigned char> /* , const int*/);
   void computeEdges(std::function<bool(const T& v1, const T& v2)>);
-  std::vector<std::vector<Edge>> getEdges() const { return mEdges; }
+  // Only tests pairs of vertices closer than cellSize along each axis, the link function must be false for all other pairs.
+  // Throws std::invalid_argument if cellSize is not a positive finite number, or if a position is not finite.
+  void computeEdges(std::function<bool(const T& v1, const T& v2)>, std::function<std::array<float, 3>(const T&)> positionFunction, const float cellSize);
+  const std::vector<std::vector<Edge>>& getEdges() const { return mEdges; }
   char isMultiThreading() const { return mIsMultiThread; }
 
   std::vector<T>* mVertices = nullptr; // Observer pointer
-  std::vector<std::thread> mExecutors; // Difficult to pass
+
+ protected:
+  // Calls function(begin, end) on consecutive ranges of vertices, one per executor
+  void forEachVertexRange(const std::function<void(const size_t, const size_t)>& function);
+
+  std::unique_ptr<WorkerPool> mExecutors;
+  std::vector<std::vector<Edge>> mEdges;
 
  private:
   void findVertexEdges(std::vector<Edge>& localEdges, const T& vertex, const size_t vId, const size_t size);
@@ -71,14 +112,17 @@ class Graph
 
   // Common data members
   std::function<bool(const T&, const T&)> mLinkFunction;
-  std::vector<std::vector<Edge>> mEdges;
   std::vector<unsigned char> mVisited;
 };
 
 template <typename T>
 Graph<T>::Graph(const size_t nThreads) : mNThreads{nThreads}
 {
-  mIsMultiThread = nThreads > 1 ? true : false;
+  mNThreads = std::max(std::min(static_cast<size_t>(std::thread::hardware_concurrency()), mNThreads), static_cast<size_t>(1));
+  mIsMultiThread = mNThreads > 1 ? true : false;
+  if (mIsMultiThread) {
+    mExecutors = std::make_unique<WorkerPool>(mNThreads);
+  }
 }
 
 template <typename T>
@@ -87,52 +131,126 @@ void Graph<T>::init(std::vector<T>& vertices)
 
   // Graph initialization
   mVertices = &vertices;
-  if (mIsMultiThread) {
-    mNThreads = std::min(static_cast<const size_t>(std::thread::hardware_concurrency()), mNThreads);
-    mExecutors.resize(mNThreads);
-  }
-
   mEdges.resize(vertices.size());
   mVisited.resize(vertices.size(), false);
 }
 
+template <typename T>
+void Graph<T>::forEachVertexRange(const std::function<void(const size_t, const size_t)>& function)
+{
+  const size_t size = {mVertices->size()};
+  if (!mIsMultiThread) {
+    function(0, size);
+    return;
+  }
+  const size_t stride{(size + mExecutors->size() - 1) / mExecutors->size()};
+  mExecutors->run([&function, stride, size](const size_t iExecutor) {
+    const size_t begin{std::min(iExecutor * stride, size)};
+    function(begin, std::min(begin + stride, size));
+  });
+}
+
 template <typename T>
 void Graph<T>::computeEdges(std::function<bool(const T& v1, const T& v2)> linkFunction)
 {
   mLinkFunction = linkFunction;
-  int tot_nedges = 0;
   const size_t size = {mVertices->size()};
-  if (!mIsMultiThread) {
-    for (size_t iVertex{0}; iVertex < size; ++iVertex) {
+  forEachVertexRange([size, this](const size_t begin, const size_t end) {
+    for (size_t iVertex{begin}; iVertex < end; ++iVertex) {
       findVertexEdges(mEdges[iVertex], (*mVertices)[iVertex], iVertex, size);
-      tot_nedges += static_cast<int>(mEdges[iVertex].size());
     }
-  } else {
-    mNThreads = std::min(static_cast<const size_t>(std::thread::hardware_concurrency()), mNThreads);
-    mExecutors.resize(mNThreads);
-    const size_t stride{static_cast<size_t>(std::ceil(mVertices->size() / static_cast<size_t>(mExecutors.size())))};
-    for (size_t iExecutor{0}; iExecutor < mExecutors.size(); ++iExecutor) {
-      // We cannot pass a template function to std::thread(), using lambda instead
-      mExecutors[iExecutor] = std::thread(
-        [iExecutor, stride, this](const auto& linkFunction) {
-          for (size_t iVertex1{iExecutor * stride}; iVertex1 < stride * (iExecutor + 1) && iVertex1 < mVertices->size(); ++iVertex1) {
-            for (size_t iVertex2{0}; iVertex2 < mVertices->size(); ++iVertex2) {
-              if (iVertex1 != iVertex2 && linkFunction((*mVertices)[iVertex1], (*mVertices)[iVertex2])) {
-                mEdges[iVertex1].emplace_back(iVertex2);
+  });
+}
+
+template <typename T>
+void Graph<T>::computeEdges(std::function<bool(const T& v1, const T& v2)> linkFunction, std::function<std::array<float, 3>(const T&)> positionFunction, const float cellSize)
+{
+  if (!(cellSize > 0.f) || !std::isfinite(cellSize)) {
+    throw std::invalid_argument{"Graph::computeEdges: the cell size must be positive and finite"};
+  }
+  mLinkFunction = linkFunction;
+  const size_t size = {mVertices->size()};
+  if (size == 0) {
+    return;
+  }
+
+  // Uniform grid over the bounding box of the vertices, with cells not smaller than cellSize,
+  // so that the links of a vertex can only be in its own cell or in the neighbouring ones
+  std::vector<std::array<float, 3>> positions(size);
+  std::array<float, 3> minPosition, maxPosition;
+  for (size_t iVertex{0}; iVertex < size; ++iVertex) {
+    positions[iVertex] = positionFunction((*mVertices)[iVertex]);
+    for (int iAxis{0}; iAxis < 3; ++iAxis) {
+      if (!std::isfinite(positions[iVertex][iAxis])) {
+        throw std::invalid_argument{"Graph::computeEdges: the vertex positions must be finite"};
+      }
+      minPosition[iAxis] = iVertex ? std::min(minPosition[iAxis], positions[iVertex][iAxis]) : positions[iVertex][iAxis];
+      maxPosition[iAxis] = iVertex ? std::max(maxPosition[iAxis], positions[iVertex][iAxis]) : positions[iVertex][iAxis];
+    }
+  }
+  double binSize{cellSize}; // In double precision, the extent of finite positions cannot overflow
+  std::array<int, 3> nBins;
+  while (true) { // Do not use more cells than vertices, larger cells still contain all the neighbours
+    size_t nCells{1};
+    for (int iAxis{0}; iAxis < 3; ++iAxis) {
+      nBins[iAxis] = static_cast<int>(std::min((static_cast<double>(maxPosition[iAxis]) - minPosition[iAxis]) / binSize, static_cast<double>(size))) + 1;
+      nCells *= nBins[iAxis];
+    }
+    if (nCells <= 2 * size) {
+      break;
+    }
+    binSize *= 2.;
+  }
+  auto getBin = [&](const float position, const int iAxis) {
+    return std::max(std::min(static_cast<int>(std::min((static_cast<double>(position) - minPosition[iAxis]) / binSize, static_cast<double>(size))), nBins[iAxis] - 1), 0);
+  };
+
+  // Counting sort of the vertex ids by cell, keeping them in increasing order inside each cell
+  std::vector<int> vertexCells(size);
+  std::vector<int> cellOffsets(nBins[0] * nBins[1] * nBins[2] + 1, 0);
+  for (size_t iVertex{0}; iVertex < size; ++iVertex) {
+    vertexCells[iVertex] = (getBin(positions[iVertex][0], 0) * nBins[1] + getBin(positions[iVertex][1], 1)) * nBins[2] + getBin(positions[iVertex][2], 2);
+    ++cellOffsets[vertexCells[iVertex] + 1];
+  }
+  std::partial_sum(cellOffsets.begin(), cellOffsets.end(), cellOffsets.begin());
+  std::vector<int> sortedVertices(size);
+  {
+    std::vector<int> fill(cellOffsets.begin(), cellOffsets.end() - 1);
+    for (size_t iVertex{0}; iVertex < size; ++iVertex) {
+      sortedVertices[fill[vertexCells[iVertex]]++] = iVertex;
+    }
+  }
+
+  forEachVertexRange([&](const size_t begin, const size_t end) {
+    for (size_t iVertex1{begin}; iVertex1 < end; ++iVertex1) {
+      auto& edges = mEdges[iVertex1];
+      edges.clear();
+      std::array<int, 3> bins;
+      for (int iAxis{0}; iAxis < 3; ++iAxis) {
+        bins[iAxis] = getBin(positions[iVertex1][iAxis], iAxis);
+      }
+      for (int iBin0{std::max(bins[0] - 1, 0)}; iBin0 <= std::min(bins[0] + 1, nBins[0] - 1); ++iBin0) {
+        for (int iBin1{std::max(bins[1] - 1, 0)}; iBin1 <= std::min(bins[1] + 1, nBins[1] - 1); ++iBin1) {
+          for (int iBin2{std::max(bins[2] - 1, 0)}; iBin2 <= std::min(bins[2] + 1, nBins[2] - 1); ++iBin2) {
+            const int cell{(iBin0 * nBins[1] + iBin1) * nBins[2] + iBin2};
+            for (int iSorted{cellOffsets[cell]}; iSorted < cellOffsets[cell + 1]; ++iSorted) {
+              const size_t iVertex2 = sortedVertices[iSorted];
+              if (iVertex1 != iVertex2 && mLinkFunction((*mVertices)[iVertex1], (*mVertices)[iVertex2])) {
+                edges.emplace_back(iVertex2);
               }
             }
           }
-        },
-        mLinkFunction);
+        }
+      }
+      std::sort(edges.begin(), edges.end()); // Same order as with the full scan
     }
-  }
-  for (auto&& thread : mExecutors) {
-    thread.join();
-  }
+  });
 }
+
 template <typename T>
 void Graph<T>::findVertexEdges(std::vector<Edge>& localEdges, const T& vertex, const size_t vId, const size_t size)
 {
+  localEdges.clear();
   for (size_t iVertex2{0}; iVertex2 < size; ++iVertex2) {
     if (vId != iVertex2 && mLinkFunction(vertex, (*mVertices)[iVertex2])) {
       localEdges.emplace_back(iVertex2);
@@ -166,41 +284,34 @@ std::vector<unsigned char> Graph<T>::getCluster(const int vertexId)
       }
     }
   } else {
-    const size_t stride{static_cast<size_t>(std::ceil(static_cast<float>(this->mVertices->size()) / static_cast<size_t>(this->mExecutors.size())))};
-    std::vector<unsigned char> frontier(mVertices->size(), false);
-    std::vector<unsigned char> flags(mVertices->size(), false);
+    const size_t size = {mVertices->size()};
+    const size_t stride{(size + mExecutors->size() - 1) / mExecutors->size()};
+    std::vector<unsigned char> frontier(size, false);
+    std::vector<unsigned char> flags(size, false);
 
     frontier[vertexId] = true;
-    int counter{0};
     while (std::any_of(frontier.begin(), frontier.end(), [](const char t) { return t; })) {
-      flags.resize(mVertices->size(), false);
-      Barrier barrier(mExecutors.size());
-      for (size_t iExecutor{0}; iExecutor < this->mExecutors.size(); ++iExecutor) {
-        mExecutors[iExecutor] = std::thread(
-          [&stride, &frontier, &visited, &barrier, &flags, this](const int executorId) {
-            for (size_t iVertex{executorId * stride}; iVertex < stride * (executorId + 1) && iVertex < this->mVertices->size(); ++iVertex) {
-              if (frontier[iVertex]) {
-                flags[iVertex] = true;
-                frontier[iVertex] = false;
-                visited[iVertex] = true;
-              }
-            }
-            barrier.Wait();
-            for (size_t iVertex{executorId * stride}; iVertex < stride * (executorId + 1) && iVertex < this->mVertices->size(); ++iVertex) {
-              if (flags[iVertex]) {
-                for (auto& edge : mEdges[iVertex]) {
-                  if (!visited[edge]) {
-                    frontier[edge] = true;
-                  }
-                }
+      std::fill(flags.begin(), flags.end(), false);
+      Barrier barrier(mExecutors->size());
+      mExecutors->run([stride, size, &frontier, &visited, &barrier, &flags, this](const size_t executorId) {
+        for (size_t iVertex{executorId * stride}; iVertex < stride * (executorId + 1) && iVertex < size; ++iVertex) {
+          if (frontier[iVertex]) {
+            flags[iVertex] = true;
+            frontier[iVertex] = false;
+            visited[iVertex] = true;
+          }
+        }
+        barrier.Wait();
+        for (size_t iVertex{executorId * stride}; iVertex < stride * (executorId + 1) && iVertex < size; ++iVertex) {
+          if (flags[iVertex]) {
+            for (auto& edge : mEdges[iVertex]) {
+              if (!visited[edge]) {
+                frontier[edge] = true;
               }
             }
-          },
-          iExecutor);
-      }
-      for (auto&& thread : mExecutors) {
-        thread.join();
-      }
+          }
+        }
+      });
     }
   }
   return visited;
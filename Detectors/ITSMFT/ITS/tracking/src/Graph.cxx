@@ -29,5 +29,83 @@ void Barrier::Wait()
   }
 }
 
+WorkerPool::WorkerPool(const std::size_t nExecutors)
+{
+  for (std::size_t iExecutor{1}; iExecutor < nExecutors; ++iExecutor) {
+    mThreads.emplace_back(&WorkerPool::loop, this, iExecutor);
+  }
+}
+
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mStart.notify_all();
+  for (auto&& thread : mThreads) {
+    thread.join();
+  }
+}
+
+void WorkerPool::run(const std::function<void(const std::size_t)>& task)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mTask = &task;
+    mPending = mThreads.size();
+    ++mGeneration;
+  }
+  mStart.notify_all();
+  std::exception_ptr exception;
+  try {
+    task(0);
+  } catch (...) {
+    exception = std::current_exception();
+  }
+  // The other executors still refer to the task, wait for them even if it failed here
+  std::unique_lock<std::mutex> lock(mMutex);
+  mDone.wait(lock, [this] { return mPending == 0; });
+  mTask = nullptr;
+  if (!exception) {
+    exception = mException;
+  }
+  mException = nullptr;
+  if (exception) {
+    std::rethrow_exception(exception);
+  }
+}
+
+void WorkerPool::loop(const std::size_t iExecutor)
+{
+  unsigned long generation{0};
+  while (true) {
+    const std::function<void(const std::size_t)>* task;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mStart.wait(lock, [this, generation] { return mStop || mGeneration != generation; });
+      if (mStop) {
+        return;
+      }
+      generation = mGeneration;
+      task = mTask;
+    }
+    std::exception_ptr exception;
+    try {
+      (*task)(iExecutor);
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (exception && !mException) {
+        mException = exception;
+      }
+      --mPending;
+    }
+    mDone.notify_one();
+  }
+}
+
 } // namespace its
 } // namespace o2
\ No newline at end of file
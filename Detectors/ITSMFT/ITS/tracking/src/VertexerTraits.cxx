@@ -12,7 +12,10 @@
 /// \brief
 /// \author matteo.concas@cern.ch
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <numeric>
 #include <ostream>
 #include <boost/histogram.hpp>
 #include <boost/format.hpp>
@@ -381,36 +384,269 @@ void VertexerTraits::computeMCFiltering()
 }
 #endif
 
+namespace
+{
+// Index of the tracklet lines on the z and on the direction phi at their point of closest approach to the beam axis.
+// For two lines passing at distances b1, b2 from the axis at heights z1, z2, with transverse direction components s1, s2
+// and directions phi1, phi2: DCA >= |z1 - z2| * s1 * s2 * |sin(phi1 - phi2)| - b1 - b2.
+// Lines closer than a cut thus have close z, or are almost coplanar with the axis, and only these need to be tested.
+// Similarly a line passes farther than |z - zPoint| * s - b - rPoint from a point at radius rPoint.
+// Lines for which the bounds are too loose (almost parallel to the axis or far from it) are always tested.
+class TrackletLinesIndex
+{
+ public:
+  TrackletLinesIndex(const std::vector<Line>& lines, const std::vector<bool>& usedLines);
+  // First unused line after iLine with a DCA to it not larger than pairCut, -1 if none
+  int findFirstPair(const int iLine, const float pairCut);
+  // Unused lines from firstLine on which can pass closer than maxDistance to point, in increasing order
+  void findCloseLines(const std::array<float, 3>& point, const float maxDistance, const int firstLine, std::vector<int>& lines);
+
+ private:
+  static constexpr float MinTransverseDirection{0.1f}; // Lines more parallel to the axis are always tested
+  static constexpr float MaxAxisDistance{0.2f};        // cm, lines passing farther from the axis are always tested
+  static constexpr float Tolerance{1.e-5f};            // Covers the float rounding in the DCA computation
+  static constexpr int MaxLinesScannedInOrder{32};     // Lines tested in order before using the index, when looking for a pair
+
+  int getZBin(const float z) const;
+  template <typename F>
+  void forUnusedLinesInCell(const int zBin, const int phiBin, const int firstLine, F&& function);
+
+  const std::vector<Line>& mLines;
+  const std::vector<bool>& mUsedLines;
+  std::vector<float> mZ;
+  std::vector<float> mPhi;
+  std::vector<float> mTransverseDirection;
+  std::vector<float> mAxisDistance;
+  std::vector<float> mOriginDistance;
+  std::vector<int> mWideLines;
+  std::vector<int> mCellLines;
+  std::vector<int> mCellBegin;
+  std::vector<int> mCellEnd;
+  int mNZBins{1};
+  int mNPhiBins{1};
+  float mZMin{0.f};
+  float mInverseZBinSize{1.f};
+  float mMinTransverseDirection{1.f};
+  float mMaxAxisDistance{0.f};
+  float mMaxOriginDistance{0.f};
+};
+
+TrackletLinesIndex::TrackletLinesIndex(const std::vector<Line>& lines, const std::vector<bool>& usedLines) : mLines{lines}, mUsedLines{usedLines}
+{
+  const int nLines{static_cast<int>(lines.size())};
+  mZ.resize(nLines);
+  mPhi.resize(nLines);
+  mTransverseDirection.resize(nLines);
+  mAxisDistance.resize(nLines);
+  mOriginDistance.resize(nLines);
+  std::vector<unsigned char> isWide(nLines, false);
+  float zMax{0.f};
+  for (int iLine{0}; iLine < nLines; ++iLine) {
+    const float* origin{lines[iLine].originPoint};
+    const float* direction{lines[iLine].cosinesDirector};
+    const double transverse2{static_cast<double>(direction[0]) * direction[0] + static_cast<double>(direction[1]) * direction[1]};
+    const double transverse{std::sqrt(transverse2)};
+    const bool isParallel{transverse < MinTransverseDirection}; // The same test decides the projection and the indexing
+    const double t{isParallel ? 0. : -(static_cast<double>(origin[0]) * direction[0] + static_cast<double>(origin[1]) * direction[1]) / transverse2};
+    const double axisPoint[3]{origin[0] + t * direction[0], origin[1] + t * direction[1], origin[2] + t * direction[2]};
+    const double axisDistance{std::sqrt(axisPoint[0] * axisPoint[0] + axisPoint[1] * axisPoint[1])};
+    if (isParallel || axisDistance > MaxAxisDistance || !std::isfinite(axisPoint[2])) {
+      isWide[iLine] = true;
+      mWideLines.push_back(iLine);
+      continue;
+    }
+    mZ[iLine] = axisPoint[2];
+    mPhi[iLine] = std::atan2(direction[1], direction[0]);
+    mTransverseDirection[iLine] = transverse;
+    mAxisDistance[iLine] = axisDistance;
+    mOriginDistance[iLine] = std::abs(t);
+    const bool isFirst{mWideLines.size() == static_cast<size_t>(iLine)};
+    mZMin = isFirst ? mZ[iLine] : std::min(mZMin, mZ[iLine]);
+    zMax = isFirst ? mZ[iLine] : std::max(zMax, mZ[iLine]);
+    mMinTransverseDirection = std::min(mMinTransverseDirection, mTransverseDirection[iLine]);
+    mMaxAxisDistance = std::max(mMaxAxisDistance, mAxisDistance[iLine]);
+    mMaxOriginDistance = std::max(mMaxOriginDistance, mOriginDistance[iLine]);
+  }
+
+  // Lines sorted by cell, and by index inside each cell
+  const int nIndexedLines{nLines - static_cast<int>(mWideLines.size())};
+  mNZBins = std::max(std::min(nIndexedLines / 16, 256), 1);
+  mNPhiBins = std::max(std::min(nIndexedLines / 32, 64), 1);
+  mInverseZBinSize = zMax > mZMin ? mNZBins / (zMax - mZMin) : 1.f;
+  mCellBegin.resize(mNZBins * mNPhiBins + 1, 0);
+  std::vector<int> lineCells(nLines);
+  for (int iLine{0}; iLine < nLines; ++iLine) {
+    if (!isWide[iLine]) {
+      const int phiBin{std::min(static_cast<int>((mPhi[iLine] + constants::math::Pi) * mNPhiBins / TwoPi), mNPhiBins - 1)};
+      lineCells[iLine] = std::max(phiBin, 0) * mNZBins + getZBin(mZ[iLine]);
+      ++mCellBegin[lineCells[iLine] + 1];
+    }
+  }
+  std::partial_sum(mCellBegin.begin(), mCellBegin.end(), mCellBegin.begin());
+  mCellEnd.assign(mCellBegin.begin(), mCellBegin.end() - 1);
+  mCellLines.resize(nIndexedLines);
+  for (int iLine{0}; iLine < nLines; ++iLine) {
+    if (!isWide[iLine]) {
+      mCellLines[mCellEnd[lineCells[iLine]]++] = iLine;
+    }
+  }
+}
+
+inline int TrackletLinesIndex::getZBin(const float z) const
+{
+  return std::max(std::min(static_cast<int>((z - mZMin) * mInverseZBinSize), mNZBins - 1), 0);
+}
+
+template <typename F>
+void TrackletLinesIndex::forUnusedLinesInCell(const int zBin, const int phiBin, const int firstLine, F&& function)
+{
+  // Used lines met on the way are dropped from the cell
+  const int cell{phiBin * mNZBins + zBin};
+  const auto end = mCellLines.begin() + mCellEnd[cell];
+  auto read = std::lower_bound(mCellLines.begin() + mCellBegin[cell], end, firstLine);
+  auto write = read;
+  while (read != end) {
+    if (mUsedLines[*read]) {
+      ++read;
+      continue;
+    }
+    *write++ = *read;
+    if (!function(*read++)) {
+      break;
+    }
+  }
+  if (write != read) {
+    mCellEnd[cell] = std::move(read, end, write) - mCellLines.begin();
+  }
+}
+
+int TrackletLinesIndex::findFirstPair(const int iLine, const float pairCut)
+{
+  const int nLines{static_cast<int>(mLines.size())};
+  int firstPair{nLines};
+  auto testLine = [&](const int iLine2) {
+    if (iLine2 >= firstPair) {
+      return false;
+    }
+    if (Line::getDCA(mLines[iLine], mLines[iLine2]) <= pairCut) {
+      firstPair = iLine2;
+      return false;
+    }
+    return true;
+  };
+
+  // The pair is often among the next lines: test them in order first, use the index only beyond them
+  const bool isWide{std::binary_search(mWideLines.begin(), mWideLines.end(), iLine)};
+  int firstIndexedLine{iLine + 1};
+  for (int nTested{0}; firstIndexedLine < nLines && (isWide || nTested < MaxLinesScannedInOrder); ++firstIndexedLine) {
+    if (!mUsedLines[firstIndexedLine]) {
+      ++nTested;
+      if (!testLine(firstIndexedLine)) {
+        return firstPair;
+      }
+    }
+  }
+  if (firstIndexedLine == nLines) {
+    return -1;
+  }
+  for (auto iLine2{std::lower_bound(mWideLines.begin(), mWideLines.end(), firstIndexedLine)}; iLine2 != mWideLines.end(); ++iLine2) {
+    if (!mUsedLines[*iLine2] && !testLine(*iLine2)) {
+      break;
+    }
+  }
+
+  // Lower bound of s1 * s2 * |sin(phi1 - phi2)| for each phi bin, and maximum |z1 - z2| allowed by it
+  const float maxDeltaZTimesSin{(pairCut + mAxisDistance[iLine] + mMaxAxisDistance) * (1.f + Tolerance) +
+                                (mOriginDistance[iLine] + mMaxOriginDistance) * Tolerance + Tolerance};
+  for (int iPhiBin{0}; iPhiBin < mNPhiBins; ++iPhiBin) {
+    const float deltaPhiMin{-constants::math::Pi + iPhiBin * TwoPi / mNPhiBins - mPhi[iLine]};
+    const float deltaPhiMax{deltaPhiMin + TwoPi / mNPhiBins};
+    float minSin{0.f};
+    if (std::floor(deltaPhiMax / constants::math::Pi) < std::ceil(deltaPhiMin / constants::math::Pi)) {
+      minSin = std::min(std::abs(std::sin(deltaPhiMin)), std::abs(std::sin(deltaPhiMax)));
+    }
+    const float minSinTimesTransverse{mTransverseDirection[iLine] * mMinTransverseDirection * minSin - Tolerance};
+    int minZBin{0}, maxZBin{mNZBins - 1};
+    if (minSinTimesTransverse > 0.f) {
+      const float maxDeltaZ{maxDeltaZTimesSin / minSinTimesTransverse};
+      minZBin = getZBin(mZ[iLine] - maxDeltaZ);
+      maxZBin = getZBin(mZ[iLine] + maxDeltaZ);
+    }
+    for (int iZBin{minZBin}; iZBin <= maxZBin; ++iZBin) {
+      forUnusedLinesInCell(iZBin, iPhiBin, firstIndexedLine, testLine);
+    }
+  }
+  return firstPair < nLines ? firstPair : -1;
+}
+
+void TrackletLinesIndex::findCloseLines(const std::array<float, 3>& point, const float maxDistance, const int firstLine, std::vector<int>& lines)
+{
+  lines.clear();
+  for (auto iLine{std::lower_bound(mWideLines.begin(), mWideLines.end(), firstLine)}; iLine != mWideLines.end(); ++iLine) {
+    if (!mUsedLines[*iLine] && Line::getDistanceFromPoint(mLines[*iLine], point) <= maxDistance * (1.f + Tolerance) + Tolerance) {
+      lines.push_back(*iLine);
+    }
+  }
+  const float maxDistanceTerm{(maxDistance + std::hypot(point[0], point[1])) * (1.f + Tolerance) + Tolerance};
+  const float maxDeltaZ{(maxDistanceTerm + mMaxAxisDistance * (1.f + Tolerance)) / mMinTransverseDirection};
+  const int minZBin{getZBin(point[2] - maxDeltaZ)};
+  const int maxZBin{getZBin(point[2] + maxDeltaZ)};
+  for (int iPhiBin{0}; iPhiBin < mNPhiBins; ++iPhiBin) {
+    for (int iZBin{minZBin}; iZBin <= maxZBin; ++iZBin) {
+      forUnusedLinesInCell(iZBin, iPhiBin, firstLine, [&](const int iLine) {
+        if (std::abs(mZ[iLine] - point[2]) * mTransverseDirection[iLine] <= maxDistanceTerm + mAxisDistance[iLine] * (1.f + Tolerance)) {
+          lines.push_back(iLine);
+        }
+        return true;
+      });
+    }
+  }
+  std::sort(lines.begin(), lines.end());
+}
+} // namespace
+
 void VertexerTraits::computeVertices()
 {
+  // Lines and clusters are processed in the same order as when testing all of them, only the ones which
+  // cannot pass the cuts are skipped, so that the result does not depend on the indexing
   const int numTracklets{static_cast<int>(mTracklets.size())};
   std::vector<bool> usedTracklets{};
   usedTracklets.resize(mTracklets.size(), false);
+  TrackletLinesIndex linesIndex{mTracklets, usedTracklets};
+  std::vector<int> candidates;
   for (int tracklet1{0}; tracklet1 < numTracklets; ++tracklet1) {
     if (usedTracklets[tracklet1])
       continue;
-    for (int tracklet2{tracklet1 + 1}; tracklet2 < numTracklets; ++tracklet2) {
-      if (usedTracklets[tracklet2])
+    const int tracklet2{linesIndex.findFirstPair(tracklet1, mVrtParams.pairCut)};
+    if (tracklet2 < 0)
+      continue;
+    mTrackletClusters.emplace_back(tracklet1, mTracklets[tracklet1], tracklet2, mTracklets[tracklet2]);
+    std::array<float, 3> tmpVertex{mTrackletClusters.back().getVertex()};
+    if (tmpVertex[0] * tmpVertex[0] + tmpVertex[1] * tmpVertex[1] > 4.f) {
+      mTrackletClusters.pop_back();
+      continue;
+    }
+    usedTracklets[tracklet1] = true;
+    usedTracklets[tracklet2] = true;
+    // The candidates stay valid as long as the vertex moves by less than the search margin
+    const float searchMargin{mVrtParams.pairCut};
+    std::array<float, 3> searchPoint{tmpVertex};
+    linesIndex.findCloseLines(searchPoint, mVrtParams.pairCut + searchMargin, 0, candidates);
+    for (size_t iCandidate{0}; iCandidate < candidates.size(); ++iCandidate) {
+      const int tracklet3{candidates[iCandidate]};
+      if (usedTracklets[tracklet3])
         continue;
-      if (Line::getDCA(mTracklets[tracklet1], mTracklets[tracklet2]) <= mVrtParams.pairCut) {
-        mTrackletClusters.emplace_back(tracklet1, mTracklets[tracklet1], tracklet2, mTracklets[tracklet2]);
-        std::array<float, 3> tmpVertex{mTrackletClusters.back().getVertex()};
-        if (tmpVertex[0] * tmpVertex[0] + tmpVertex[1] * tmpVertex[1] > 4.f) {
-          mTrackletClusters.pop_back();
-          break;
-        }
-        usedTracklets[tracklet1] = true;
-        usedTracklets[tracklet2] = true;
-        for (int tracklet3{0}; tracklet3 < numTracklets; ++tracklet3) {
-          if (usedTracklets[tracklet3])
-            continue;
-          if (Line::getDistanceFromPoint(mTracklets[tracklet3], tmpVertex) < mVrtParams.pairCut) {
-            mTrackletClusters.back().add(tracklet3, mTracklets[tracklet3]);
-            usedTracklets[tracklet3] = true;
-            tmpVertex = mTrackletClusters.back().getVertex();
-          }
+      if (Line::getDistanceFromPoint(mTracklets[tracklet3], tmpVertex) < mVrtParams.pairCut) {
+        mTrackletClusters.back().add(tracklet3, mTracklets[tracklet3]);
+        usedTracklets[tracklet3] = true;
+        tmpVertex = mTrackletClusters.back().getVertex();
+        if ((tmpVertex[0] - searchPoint[0]) * (tmpVertex[0] - searchPoint[0]) + (tmpVertex[1] - searchPoint[1]) * (tmpVertex[1] - searchPoint[1]) +
+              (tmpVertex[2] - searchPoint[2]) * (tmpVertex[2] - searchPoint[2]) >
+            searchMargin * searchMargin) {
+          searchPoint = tmpVertex;
+          linesIndex.findCloseLines(searchPoint, mVrtParams.pairCut + searchMargin, tracklet3 + 1, candidates);
+          iCandidate = -1;
         }
-        break;
       }
     }
   }
@@ -418,10 +654,35 @@ void VertexerTraits::computeVertices()
   std::sort(mTrackletClusters.begin(), mTrackletClusters.end(),
             [](ClusterLines& cluster1, ClusterLines& cluster2) { return cluster1.getSize() > cluster2.getSize(); });
   int noClusters{static_cast<int>(mTrackletClusters.size())};
+  // Clusters closer in z than the cluster cut to a following one are merged into it or dropped: look them up in z
+  std::vector<std::pair<float, int>> clustersZ(noClusters);
+  for (int iCluster{0}; iCluster < noClusters; ++iCluster) {
+    clustersZ[iCluster] = {mTrackletClusters[iCluster].getVertex()[2], iCluster};
+  }
+  std::sort(clustersZ.begin(), clustersZ.end());
+  std::vector<bool> removedClusters(noClusters, false);
+  auto findCloseClusters = [&](const float z, const int firstCluster) {
+    candidates.clear();
+    const float maxDeltaZ{mVrtParams.clusterCut + mVrtParams.pairCut + 1.e-4f};
+    for (auto cluster{std::lower_bound(clustersZ.begin(), clustersZ.end(), std::make_pair(z - maxDeltaZ, -1))};
+         cluster != clustersZ.end() && cluster->first <= z + maxDeltaZ; ++cluster) {
+      if (cluster->second >= firstCluster && !removedClusters[cluster->second]) {
+        candidates.push_back(cluster->second);
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+  };
   for (int iCluster1{0}; iCluster1 < noClusters; ++iCluster1) {
+    if (removedClusters[iCluster1])
+      continue;
     std::array<float, 3> vertex1{mTrackletClusters[iCluster1].getVertex()};
     std::array<float, 3> vertex2{};
-    for (int iCluster2{iCluster1 + 1}; iCluster2 < noClusters; ++iCluster2) {
+    float searchZ{vertex1[2]};
+    findCloseClusters(searchZ, iCluster1 + 1);
+    for (size_t iCandidate{0}; iCandidate < candidates.size(); ++iCandidate) {
+      const int iCluster2{candidates[iCandidate]};
+      if (removedClusters[iCluster2])
+        continue;
       vertex2 = mTrackletClusters[iCluster2].getVertex();
       if (std::abs(vertex1[2] - vertex2[2]) < mVrtParams.clusterCut) {
 
@@ -434,12 +695,26 @@ void VertexerTraits::computeVertices()
             vertex1 = mTrackletClusters[iCluster1].getVertex();
           }
         }
-        mTrackletClusters.erase(mTrackletClusters.begin() + iCluster2);
-        --iCluster2;
-        --noClusters;
+        removedClusters[iCluster2] = true;
+        if (std::abs(vertex1[2] - searchZ) > mVrtParams.pairCut) {
+          searchZ = vertex1[2];
+          findCloseClusters(searchZ, iCluster2 + 1);
+          iCandidate = -1;
+        }
+      }
+    }
+  }
+  int keptClusters{0};
+  for (int iCluster{0}; iCluster < noClusters; ++iCluster) {
+    if (!removedClusters[iCluster]) {
+      if (keptClusters != iCluster) {
+        mTrackletClusters[keptClusters] = std::move(mTrackletClusters[iCluster]);
       }
+      ++keptClusters;
     }
   }
+  mTrackletClusters.erase(mTrackletClusters.begin() + keptClusters, mTrackletClusters.end());
+  noClusters = keptClusters;
   for (int iCluster{0}; iCluster < noClusters; ++iCluster) {
     if (mTrackletClusters[iCluster].getSize() < mVrtParams.clusterContributorsCut && noClusters > 1) {
       mTrackletClusters.erase(mTrackletClusters.begin() + iCluster);
@@ -0,0 +1,123 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file   ITS/tracking/test/bench_Graph.cxx
+/// \brief  Benchmark of the edge building of the DBScan on tracklet lines
+
+#include "benchmark/benchmark.h"
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "ITStracking/ClusterLines.h"
+#include "ITStracking/DBScan.h"
+
+namespace
+{
+constexpr float PairCut{0.05f}; // cm, max distance along each axis of the points of closest approach to the beam line
+constexpr float DCACut{0.02f}; // cm, max DCA between two lines
+
+// Lines from piled-up primary vertices, about 40 each, with a fraction of fake combinatorial lines
+std::vector<o2::its::Line> generateLines(const int nLines)
+{
+  std::mt19937 mt(1234);
+  std::normal_distribution<float> vertexZ(0.f, 5.f);
+  std::normal_distribution<float> smearing(0.f, 0.003f);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  const float twoPi{2.f * static_cast<float>(M_PI)};
+
+  std::vector<std::array<float, 3>> vertices(1 + nLines / 50);
+  for (auto& vertex : vertices) {
+    vertex = {0.f, 0.f, vertexZ(mt)};
+  }
+  std::vector<o2::its::Line> lines;
+  lines.reserve(nLines);
+  for (int iLine{0}; iLine < nLines; ++iLine) {
+    float first[3], second[3];
+    const float phi{twoPi * uniform(mt)};
+    const float tanLambda{2.f * uniform(mt) - 1.f};
+    if (uniform(mt) < 0.8f) {
+      const auto& vertex = vertices[iLine % vertices.size()];
+      for (int i{0}; i < 3; ++i) {
+        first[i] = vertex[i] + smearing(mt);
+      }
+    } else {
+      const float phiFake{twoPi * uniform(mt)};
+      first[0] = 2.3f * std::cos(phiFake);
+      first[1] = 2.3f * std::sin(phiFake);
+      first[2] = 30.f * (uniform(mt) - 0.5f);
+    }
+    second[0] = first[0] + std::cos(phi);
+    second[1] = first[1] + std::sin(phi);
+    second[2] = first[2] + tanLambda;
+    lines.emplace_back(first, second);
+  }
+  return lines;
+}
+
+// Point of closest approach to the beam line
+std::array<float, 3> getBeamPoint(const o2::its::Line& line)
+{
+  const float* o{line.originPoint};
+  const float* d{line.cosinesDirector};
+  const float t{-(o[0] * d[0] + o[1] * d[1]) / (d[0] * d[0] + d[1] * d[1])};
+  return {o[0] + t * d[0], o[1] + t * d[1], o[2] + t * d[2]};
+}
+
+bool areLinked(const o2::its::Line& l1, const o2::its::Line& l2)
+{
+  const auto p1 = getBeamPoint(l1);
+  const auto p2 = getBeamPoint(l2);
+  for (int i{0}; i < 3; ++i) {
+    if (std::abs(p1[i] - p2[i]) > PairCut) {
+      return false;
+    }
+  }
+  return o2::its::Line::getDCA(l1, l2) < DCACut;
+}
+} // namespace
+
+static void BM_DBScanAllPairs(benchmark::State& state)
+{
+  auto lines = generateLines(state.range(0));
+  for (auto _ : state) {
+    o2::its::DBScan<o2::its::Line> dbscan(state.range(1));
+    dbscan.init(lines, areLinked);
+    dbscan.classifyVertices(3);
+    benchmark::DoNotOptimize(dbscan.getCores());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+static void BM_DBScanGrid(benchmark::State& state)
+{
+  auto lines = generateLines(state.range(0));
+  for (auto _ : state) {
+    o2::its::DBScan<o2::its::Line> dbscan(state.range(1));
+    dbscan.init(lines, areLinked, getBeamPoint, PairCut);
+    dbscan.classifyVertices(3);
+    benchmark::DoNotOptimize(dbscan.getCores());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+static void CustomArguments(benchmark::internal::Benchmark* bench)
+{
+  for (int nThreads : {1, 4}) {
+    for (int nLines : {1000, 3000, 10000, 30000, 100000}) {
+      bench->Args({nLines, nThreads});
+    }
+  }
+}
+
+BENCHMARK(BM_DBScanAllPairs)->Apply(CustomArguments)->Unit(benchmark::kMillisecond)->Complexity();
+BENCHMARK(BM_DBScanGrid)->Apply(CustomArguments)->Unit(benchmark::kMillisecond)->Complexity();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,103 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file   ITS/tracking/test/bench_Vertexer.cxx
+/// \brief  Benchmark of the clustering of the tracklet lines into vertices
+
+#include "benchmark/benchmark.h"
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "ITStracking/ClusterLines.h"
+#include "ITStracking/ROframe.h"
+#include "ITStracking/VertexerTraits.h"
+
+namespace
+{
+// Lines from a few piled-up primary vertices, with a fraction of fake combinatorial lines which,
+// like the ones passing the phi cut between the first layers, point roughly away from the beam line
+std::vector<o2::its::Line> generateLines(const int nLines, const int nVertices, const float fakeFraction)
+{
+  std::mt19937 mt(1234);
+  std::normal_distribution<float> vertexZ(0.f, 5.f);
+  std::normal_distribution<float> smearing(0.f, 0.003f);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  const float twoPi{2.f * static_cast<float>(M_PI)};
+
+  std::vector<std::array<float, 3>> vertices(nVertices);
+  for (auto& vertex : vertices) {
+    vertex = {smearing(mt), smearing(mt), vertexZ(mt)};
+  }
+  std::vector<o2::its::Line> lines;
+  lines.reserve(nLines);
+  for (int iLine{0}; iLine < nLines; ++iLine) {
+    float first[3], second[3];
+    float phi{twoPi * uniform(mt)};
+    const float tanLambda{2.f * uniform(mt) - 1.f};
+    if (uniform(mt) > fakeFraction) {
+      const auto& vertex = vertices[iLine % vertices.size()];
+      for (int i{0}; i < 3; ++i) {
+        first[i] = vertex[i] + smearing(mt);
+      }
+    } else {
+      const float phiFake{twoPi * uniform(mt)};
+      first[0] = 2.3f * std::cos(phiFake);
+      first[1] = 2.3f * std::sin(phiFake);
+      first[2] = 30.f * (uniform(mt) - 0.5f);
+      phi = phiFake + 0.02f * (uniform(mt) - 0.5f);
+    }
+    second[0] = first[0] + std::cos(phi);
+    second[1] = first[1] + std::sin(phi);
+    second[2] = first[2] + tanLambda;
+    lines.emplace_back(first, second);
+  }
+  return lines;
+}
+
+class LinesVertexerTraits : public o2::its::VertexerTraits
+{
+ public:
+  void computeVertices(const std::vector<o2::its::Line>& lines, o2::its::ROframe& event)
+  {
+    mEvent = &event;
+    mTracklets = lines;
+    mTrackletClusters.clear();
+    mVertices.clear();
+    VertexerTraits::computeVertices();
+  }
+};
+} // namespace
+
+static void BM_ComputeVertices(benchmark::State& state)
+{
+  const auto lines = generateLines(state.range(0), state.range(1), 0.5f);
+  LinesVertexerTraits traits;
+  o2::its::ROframe event(0);
+  for (auto _ : state) {
+    event.clear();
+    traits.computeVertices(lines, event);
+    benchmark::DoNotOptimize(traits.getVertices());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+static void CustomArguments(benchmark::internal::Benchmark* bench)
+{
+  for (int nVertices : {1, 100}) {
+    for (int nLines : {1000, 3000, 10000, 30000, 100000}) {
+      bench->Args({nLines, nVertices});
+    }
+  }
+}
+
+BENCHMARK(BM_ComputeVertices)->Apply(CustomArguments)->Unit(benchmark::kMillisecond)->Complexity();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file   ITS/tracking/test/test_Graph.cxx
+/// \brief  Comparison of the grid indexed edge building of the Graph with the full scan
+
+#define BOOST_TEST_MODULE Test ITS Graph
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "ITStracking/Graph.h"
+
+namespace
+{
+struct Point {
+  std::array<float, 3> position;
+};
+
+constexpr float LinkCut{0.7f};
+
+bool areLinked(const Point& point1, const Point& point2)
+{
+  for (int iAxis{0}; iAxis < 3; ++iAxis) {
+    if (std::abs(point1.position[iAxis] - point2.position[iAxis]) > LinkCut) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::array<float, 3> position(const Point& point)
+{
+  return point.position;
+}
+
+std::vector<Point> generatePoints(const int nPoints, const float extent)
+{
+  std::mt19937 mt(nPoints);
+  std::uniform_real_distribution<float> uniform(0.f, extent);
+  std::vector<Point> points(nPoints);
+  for (auto& point : points) {
+    point.position = {uniform(mt), uniform(mt), uniform(mt)};
+  }
+  return points;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(GraphSameEdgesWithGrid)
+{
+  for (int nPoints : {0, 1, 5, 100, 2000}) {
+    for (float extent : {0.1f, 10.f, 1000.f}) {
+      auto points = generatePoints(nPoints, extent);
+      o2::its::Graph<Point> reference(1);
+      reference.init(points);
+      reference.computeEdges(areLinked);
+      for (size_t nThreads : {1, 4}) {
+        o2::its::Graph<Point> graph(nThreads);
+        graph.init(points);
+        graph.computeEdges(areLinked, position, LinkCut);
+        BOOST_CHECK(graph.getEdges() == reference.getEdges());
+        o2::its::Graph<Point> fullScan(nThreads);
+        fullScan.init(points);
+        fullScan.computeEdges(areLinked);
+        BOOST_CHECK(fullScan.getEdges() == reference.getEdges());
+        // Building the edges again gives the same result
+        graph.computeEdges(areLinked, position, LinkCut);
+        BOOST_CHECK(graph.getEdges() == reference.getEdges());
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(GraphInvalidGrid)
+{
+  auto points = generatePoints(10, 10.f);
+  o2::its::Graph<Point> graph(1);
+  graph.init(points);
+  for (float cellSize : {0.f, -1.f, std::numeric_limits<float>::quiet_NaN(), std::numeric_limits<float>::infinity()}) {
+    BOOST_CHECK_THROW(graph.computeEdges(areLinked, position, cellSize), std::invalid_argument);
+  }
+  points[3].position[1] = std::numeric_limits<float>::quiet_NaN();
+  BOOST_CHECK_THROW(graph.computeEdges(areLinked, position, LinkCut), std::invalid_argument);
+
+  // The extent of finite positions can overflow a float
+  points[3].position[1] = std::numeric_limits<float>::max();
+  points[4].position[1] = -std::numeric_limits<float>::max();
+  o2::its::Graph<Point> reference(1);
+  reference.init(points);
+  reference.computeEdges(areLinked);
+  graph.computeEdges(areLinked, position, LinkCut);
+  BOOST_CHECK(graph.getEdges() == reference.getEdges());
+}
+
+BOOST_AUTO_TEST_CASE(WorkerPoolRethrows)
+{
+  o2::its::WorkerPool pool(4);
+  std::atomic<size_t> nRuns{0};
+  for (size_t failing{0}; failing < pool.size(); ++failing) {
+    nRuns = 0;
+    auto task = [&nRuns, failing](const size_t iExecutor) {
+      ++nRuns;
+      if (iExecutor == failing) {
+        throw std::runtime_error("failure");
+      }
+    };
+    // All the executors are done with the task before the exception reaches the caller
+    BOOST_CHECK_THROW(pool.run(task), std::runtime_error);
+    BOOST_CHECK_EQUAL(nRuns, pool.size());
+  }
+  // The pool is still usable afterwards
+  nRuns = 0;
+  pool.run([&nRuns](const size_t) { ++nRuns; });
+  BOOST_CHECK_EQUAL(nRuns, pool.size());
+}
@@ -0,0 +1,229 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file   ITS/tracking/test/test_Vertexer.cxx
+/// \brief  Comparison of the indexed clustering of the tracklet lines with the all-pairs one
+
+#define BOOST_TEST_MODULE Test ITS Vertexer
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "ITStracking/ClusterLines.h"
+#include "ITStracking/ROframe.h"
+#include "ITStracking/VertexerTraits.h"
+
+namespace
+{
+enum class FakeLines {
+  OutwardFromFirstLayer, // start at the first layer and point away from the beam line
+  Steep,                 // as above, but almost parallel to the beam line
+  FarFromAxis            // random directions, passing up to a few mm from the beam line
+};
+
+// Lines from piled-up primary vertices, with a fraction of fake combinatorial lines
+std::vector<o2::its::Line> generateLines(const int nLines, const int nVertices, const float fakeFraction, const FakeLines fakes, const unsigned int seed)
+{
+  std::mt19937 mt(seed);
+  std::normal_distribution<float> vertexZ(0.f, 5.f);
+  std::normal_distribution<float> smearing(0.f, 0.003f);
+  std::uniform_real_distribution<float> uniform(0.f, 1.f);
+  const float twoPi{2.f * static_cast<float>(M_PI)};
+
+  std::vector<std::array<float, 3>> vertices(nVertices);
+  for (auto& vertex : vertices) {
+    vertex = {smearing(mt), smearing(mt), vertexZ(mt)};
+  }
+  std::vector<o2::its::Line> lines;
+  lines.reserve(nLines);
+  for (int iLine{0}; iLine < nLines; ++iLine) {
+    float first[3], second[3];
+    float phi{twoPi * uniform(mt)};
+    const float tanLambda{fakes == FakeLines::Steep ? 20.f * (uniform(mt) - 0.5f) : 2.f * uniform(mt) - 1.f};
+    if (uniform(mt) > fakeFraction) {
+      const auto& vertex = vertices[iLine % vertices.size()];
+      for (int i{0}; i < 3; ++i) {
+        first[i] = vertex[i] + smearing(mt);
+      }
+    } else {
+      const float phiFake{twoPi * uniform(mt)};
+      const float radius{fakes == FakeLines::FarFromAxis ? 0.3f * uniform(mt) : 2.3f};
+      first[0] = radius * std::cos(phiFake);
+      first[1] = radius * std::sin(phiFake);
+      first[2] = 30.f * (uniform(mt) - 0.5f);
+      if (fakes != FakeLines::FarFromAxis) {
+        phi = phiFake + 0.02f * (uniform(mt) - 0.5f);
+      }
+    }
+    second[0] = first[0] + std::cos(phi);
+    second[1] = first[1] + std::sin(phi);
+    second[2] = first[2] + tanLambda;
+    lines.emplace_back(first, second);
+  }
+  return lines;
+}
+
+class LinesVertexerTraits : public o2::its::VertexerTraits
+{
+ public:
+  void computeVertices(const std::vector<o2::its::Line>& lines, o2::its::ROframe& event)
+  {
+    setLines(lines, event);
+    VertexerTraits::computeVertices();
+  }
+
+  // The clustering as it was before the lines were indexed, testing all the pairs of lines and clusters
+  void computeVerticesAllPairs(const std::vector<o2::its::Line>& lines, o2::its::ROframe& event)
+  {
+    using namespace o2::its;
+    setLines(lines, event);
+    const int numTracklets{static_cast<int>(mTracklets.size())};
+    std::vector<bool> usedTracklets(mTracklets.size(), false);
+    for (int tracklet1{0}; tracklet1 < numTracklets; ++tracklet1) {
+      if (usedTracklets[tracklet1])
+        continue;
+      for (int tracklet2{tracklet1 + 1}; tracklet2 < numTracklets; ++tracklet2) {
+        if (usedTracklets[tracklet2])
+          continue;
+        if (Line::getDCA(mTracklets[tracklet1], mTracklets[tracklet2]) <= mVrtParams.pairCut) {
+          mTrackletClusters.emplace_back(tracklet1, mTracklets[tracklet1], tracklet2, mTracklets[tracklet2]);
+          std::array<float, 3> tmpVertex{mTrackletClusters.back().getVertex()};
+          if (tmpVertex[0] * tmpVertex[0] + tmpVertex[1] * tmpVertex[1] > 4.f) {
+            mTrackletClusters.pop_back();
+            break;
+          }
+          usedTracklets[tracklet1] = true;
+          usedTracklets[tracklet2] = true;
+          for (int tracklet3{0}; tracklet3 < numTracklets; ++tracklet3) {
+            if (usedTracklets[tracklet3])
+              continue;
+            if (Line::getDistanceFromPoint(mTracklets[tracklet3], tmpVertex) < mVrtParams.pairCut) {
+              mTrackletClusters.back().add(tracklet3, mTracklets[tracklet3]);
+              usedTracklets[tracklet3] = true;
+              tmpVertex = mTrackletClusters.back().getVertex();
+            }
+          }
+          break;
+        }
+      }
+    }
+
+    std::sort(mTrackletClusters.begin(), mTrackletClusters.end(),
+              [](ClusterLines& cluster1, ClusterLines& cluster2) { return cluster1.getSize() > cluster2.getSize(); });
+    int noClusters{static_cast<int>(mTrackletClusters.size())};
+    for (int iCluster1{0}; iCluster1 < noClusters; ++iCluster1) {
+      std::array<float, 3> vertex1{mTrackletClusters[iCluster1].getVertex()};
+      std::array<float, 3> vertex2{};
+      for (int iCluster2{iCluster1 + 1}; iCluster2 < noClusters; ++iCluster2) {
+        vertex2 = mTrackletClusters[iCluster2].getVertex();
+        if (std::abs(vertex1[2] - vertex2[2]) < mVrtParams.clusterCut) {
+          float distance{(vertex1[0] - vertex2[0]) * (vertex1[0] - vertex2[0]) +
+                         (vertex1[1] - vertex2[1]) * (vertex1[1] - vertex2[1]) +
+                         (vertex1[2] - vertex2[2]) * (vertex1[2] - vertex2[2])};
+          if (distance <= mVrtParams.pairCut * mVrtParams.pairCut) {
+            for (auto label : mTrackletClusters[iCluster2].getLabels()) {
+              mTrackletClusters[iCluster1].add(label, mTracklets[label]);
+              vertex1 = mTrackletClusters[iCluster1].getVertex();
+            }
+          }
+          mTrackletClusters.erase(mTrackletClusters.begin() + iCluster2);
+          --iCluster2;
+          --noClusters;
+        }
+      }
+    }
+    for (int iCluster{0}; iCluster < noClusters; ++iCluster) {
+      if (mTrackletClusters[iCluster].getSize() < mVrtParams.clusterContributorsCut && noClusters > 1) {
+        mTrackletClusters.erase(mTrackletClusters.begin() + iCluster);
+        noClusters--;
+        continue;
+      }
+      const auto vertex = mTrackletClusters[iCluster].getVertex();
+      if (vertex[0] * vertex[0] + vertex[1] * vertex[1] < 1.98 * 1.98) {
+        mVertices.emplace_back(vertex[0], vertex[1], vertex[2], mTrackletClusters[iCluster].getRMS2(), mTrackletClusters[iCluster].getSize(),
+                               mTrackletClusters[iCluster].getAvgDistance2(), mEvent->getROFrameId());
+      }
+    }
+  }
+
+  std::vector<o2::its::ClusterLines>& getTrackletClusters() { return mTrackletClusters; }
+
+ private:
+  void setLines(const std::vector<o2::its::Line>& lines, o2::its::ROframe& event)
+  {
+    mEvent = &event;
+    mTracklets = lines;
+    mTrackletClusters.clear();
+    mVertices.clear();
+  }
+};
+
+void checkSameVertices(const std::vector<o2::its::Line>& lines)
+{
+  LinesVertexerTraits indexed, allPairs;
+  o2::its::ROframe indexedEvent(0), allPairsEvent(0);
+  indexed.computeVertices(lines, indexedEvent);
+  allPairs.computeVerticesAllPairs(lines, allPairsEvent);
+
+  auto& indexedClusters = indexed.getTrackletClusters();
+  auto& allPairsClusters = allPairs.getTrackletClusters();
+  BOOST_REQUIRE_EQUAL(indexedClusters.size(), allPairsClusters.size());
+  for (size_t iCluster{0}; iCluster < indexedClusters.size(); ++iCluster) {
+    BOOST_CHECK(indexedClusters[iCluster].getLabels() == allPairsClusters[iCluster].getLabels());
+    BOOST_CHECK(indexedClusters[iCluster].getVertex() == allPairsClusters[iCluster].getVertex());
+  }
+
+  const auto indexedVertices = indexed.getVertices();
+  const auto allPairsVertices = allPairs.getVertices();
+  BOOST_REQUIRE_EQUAL(indexedVertices.size(), allPairsVertices.size());
+  for (size_t iVertex{0}; iVertex < indexedVertices.size(); ++iVertex) {
+    BOOST_CHECK_EQUAL(indexedVertices[iVertex].mX, allPairsVertices[iVertex].mX);
+    BOOST_CHECK_EQUAL(indexedVertices[iVertex].mY, allPairsVertices[iVertex].mY);
+    BOOST_CHECK_EQUAL(indexedVertices[iVertex].mZ, allPairsVertices[iVertex].mZ);
+    BOOST_CHECK_EQUAL(indexedVertices[iVertex].mContributors, allPairsVertices[iVertex].mContributors);
+  }
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(VertexerSameAsAllPairs)
+{
+  for (auto fakes : {FakeLines::OutwardFromFirstLayer, FakeLines::Steep, FakeLines::FarFromAxis}) {
+    for (int nLines : {0, 1, 10, 300, 3000}) {
+      for (int nVertices : {1, 5, 50}) {
+        for (float fakeFraction : {0.f, 0.5f, 0.9f}) {
+          checkSameVertices(generateLines(nLines, nVertices, fakeFraction, fakes, nLines + nVertices));
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(VertexerOnlyWideLines)
+{
+  // None of the lines can be indexed: all of them pass far from the beam line, or are parallel to it
+  std::vector<o2::its::Line> lines;
+  for (int iLine{0}; iLine < 200; ++iLine) {
+    const float phi{0.1f * iLine};
+    const float z{0.05f * (iLine % 20)};
+    float first[3]{0.5f * std::cos(phi), 0.5f * std::sin(phi), z};
+    float second[3]{first[0] - std::sin(phi), first[1] + std::cos(phi), z + 0.5f};
+    if (iLine % 2) {
+      second[0] = first[0] + 0.01f * std::cos(phi);
+      second[1] = first[1];
+    }
+    lines.emplace_back(first, second);
+  }
+  checkSameVertices(lines);
+}
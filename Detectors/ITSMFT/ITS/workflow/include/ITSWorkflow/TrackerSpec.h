@@ -23,6 +23,9 @@
 #include "ITStracking/Vertexer.h"
 #include "ITStracking/VertexerTraits.h"
 
+#include <memory>
+#include <vector>
+
 namespace o2
 {
 namespace its
@@ -37,13 +40,18 @@ class TrackerDPL : public framework::Task
   void run(framework::ProcessingContext& pc) final;
 
  private:
+  /// Tracking state of one thread, the RO frames are distributed among the workers
+  struct Worker {
+    TrackerTraitsCPU trackerTraits; //FIXME: the traits should be taken from the GPUChain
+    VertexerTraits vertexerTraits;
+    std::unique_ptr<Tracker> tracker = nullptr;
+    std::unique_ptr<Vertexer> vertexer = nullptr;
+  };
+
   int mState = 0;
   bool mIsMC = false;
-  TrackerTraitsCPU mTrackerTraits; //FIXME: the traits should be taken from the GPUChain
-  VertexerTraits mVertexerTraits;
   std::unique_ptr<parameters::GRPObject> mGRP = nullptr;
-  std::unique_ptr<Tracker> mTracker = nullptr;
-  std::unique_ptr<Vertexer> mVertexer = nullptr;
+  std::vector<std::unique_ptr<Worker>> mWorkers;
 };
 
 /// create a processor spec
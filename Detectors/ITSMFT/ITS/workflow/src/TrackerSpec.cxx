@@ -10,6 +10,9 @@
 
 /// @file   TrackerSpec.cxx
 
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <vector>
 
 #include "TGeoGlobalMagField.h"
@@ -52,10 +55,15 @@ void TrackerDPL::init(InitContext& ic)
     geom->fillMatrixCache(utils::bit2Mask(TransformType::T2L, TransformType::T2GRot,
                                           TransformType::T2G));
 
-    mTracker = std::make_unique<Tracker>(&mTrackerTraits);
-    mVertexer = std::make_unique<Vertexer>(&mVertexerTraits);
     double origD[3] = {0., 0., 0.};
-    mTracker->setBz(field->getBz(origD));
+    auto nthreads = std::max(ic.options().get<int>("nthreads"), 1);
+    mWorkers.clear();
+    for (int i = 0; i < nthreads; i++) {
+      auto& worker = mWorkers.emplace_back(std::make_unique<Worker>());
+      worker->tracker = std::make_unique<Tracker>(&worker->trackerTraits);
+      worker->vertexer = std::make_unique<Vertexer>(&worker->vertexerTraits);
+      worker->tracker->setBz(field->getBz(origD));
+    }
   } else {
     LOG(ERROR) << "Cannot retrieve GRP from the " << filename.c_str() << " file !";
     mState = 0;
@@ -84,13 +92,9 @@ void TrackerDPL::run(ProcessingContext& pc)
 
   std::vector<o2::its::TrackITSExt> tracks;
   std::vector<int> allClusIdx;
-  o2::dataformats::MCTruthContainer<o2::MCCompLabel> trackLabels;
   std::vector<o2::its::TrackITS> allTracks;
   o2::dataformats::MCTruthContainer<o2::MCCompLabel> allTrackLabels;
 
-  std::uint32_t roFrame = 0;
-  ROframe event(0);
-
   bool continuous = mGRP->isDetContinuousReadOut("ITS");
   LOG(INFO) << "ITSTracker RO: continuous=" << continuous;
 
@@ -107,34 +111,64 @@ void TrackerDPL::run(ProcessingContext& pc)
   };
 
   if (continuous) {
-    for (const auto& rof : rofs) {
-      int nclUsed = ioutils::loadROFrameData(rof, event, &clusters, labels);
-      if (nclUsed) {
-        LOG(INFO) << "ROframe: " << roFrame << ", clusters loaded : " << nclUsed;
-        mVertexer->clustersToVertices(event);
-        event.addPrimaryVertices(mVertexer->exportVertices());
-        mTracker->setROFrame(roFrame);
-        mTracker->clustersToTracks(event);
-        tracks.swap(mTracker->getTracks());
-        LOG(INFO) << "Found tracks: " << tracks.size();
+    // The RO frames are independent: each worker picks the next one to process and keeps its
+    // results, which are then merged in RO frame order, so that the output does not depend on
+    // the number of threads. The geometry caches are filled in init, so loading is read-only.
+    struct ROFResult {
+      int nclUsed = 0;
+      std::vector<o2::its::TrackITSExt> tracks;
+      o2::dataformats::MCTruthContainer<o2::MCCompLabel> labels;
+    };
+    std::vector<ROFResult> results(rofs.size());
+    std::atomic<size_t> nextROF{0};
+    auto processROFs = [&](Worker& worker) {
+      ROframe event(0);
+      for (size_t iROF = nextROF++; iROF < rofs.size(); iROF = nextROF++) {
+        auto& result = results[iROF];
+        result.nclUsed = ioutils::loadROFrameData(rofs[iROF], event, &clusters, labels);
+        if (result.nclUsed) {
+          worker.vertexer->clustersToVertices(event);
+          event.addPrimaryVertices(worker.vertexer->exportVertices());
+          worker.tracker->setROFrame(iROF);
+          worker.tracker->clustersToTracks(event);
+          result.tracks.swap(worker.tracker->getTracks());
+          result.labels = worker.tracker->getTrackLabels(); /// FIXME: assignment ctor is not optimal.
+        }
+      }
+    };
+    size_t nWorkers = std::min(mWorkers.size(), rofs.size());
+    std::vector<std::future<void>> futures;
+    for (size_t i = 1; i < nWorkers; i++) {
+      futures.emplace_back(std::async(std::launch::async, processROFs, std::ref(*mWorkers[i])));
+    }
+    processROFs(*mWorkers[0]);
+    for (auto& f : futures) {
+      f.get();
+    }
+
+    for (size_t roFrame = 0; roFrame < rofs.size(); roFrame++) {
+      auto& result = results[roFrame];
+      if (result.nclUsed) {
+        LOG(INFO) << "ROframe: " << roFrame << ", clusters loaded : " << result.nclUsed;
+        LOG(INFO) << "Found tracks: " << result.tracks.size();
         int first = allTracks.size();
-        int number = tracks.size();
-        trackLabels = mTracker->getTrackLabels(); /// FIXME: assignment ctor is not optimal.
-        int shiftIdx = -rof.getROFEntry().getIndex();
+        int number = result.tracks.size();
+        int shiftIdx = -rofs[roFrame].getROFEntry().getIndex();
         rofs[roFrame].getROFEntry().setIndex(first);
         rofs[roFrame].setNROFEntries(number);
-        copyTracks(tracks, allTracks, allClusIdx, shiftIdx);
-        allTrackLabels.mergeAtBack(trackLabels);
+        copyTracks(result.tracks, allTracks, allClusIdx, shiftIdx);
+        allTrackLabels.mergeAtBack(result.labels);
       }
-      roFrame++;
     }
   } else {
+    auto& tracker = *mWorkers[0]->tracker;
+    ROframe event(0);
     ioutils::loadEventData(event, &clusters, labels);
     event.addPrimaryVertex(0.f, 0.f, 0.f); //FIXME :  run an actual vertex finder !
-    mTracker->clustersToTracks(event);
-    tracks.swap(mTracker->getTracks());
+    tracker.clustersToTracks(event);
+    tracks.swap(tracker.getTracks());
     copyTracks(tracks, allTracks, allClusIdx);
-    allTrackLabels = mTracker->getTrackLabels(); /// FIXME: assignment ctor is not optimal.
+    allTrackLabels = tracker.getTrackLabels(); /// FIXME: assignment ctor is not optimal.
   }
 
   LOG(INFO) << "ITSTracker pushed " << allTracks.size() << " tracks";
@@ -176,7 +210,8 @@ DataProcessorSpec getTrackerSpec(bool useMC)
     outputs,
     AlgorithmSpec{adaptFromTask<TrackerDPL>(useMC)},
     Options{
-      {"grp-file", VariantType::String, "o2sim_grp.root", {"Name of the grp file"}}}};
+      {"grp-file", VariantType::String, "o2sim_grp.root", {"Name of the grp file"}},
+      {"nthreads", VariantType::Int, 1, {"Number of threads, each one tracking a different RO frame"}}}};
 }
 
 } // namespace its
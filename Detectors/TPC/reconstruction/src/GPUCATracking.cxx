@@ -258,6 +258,8 @@ int GPUCATracking::runTracking(GPUO2InterfaceIOPtrs* data)
   }
 
   data->compressedClusters = ptrs.tpcCompressedClusters;
+  data->compressedClustersEncoded = ptrs.tpcCompressedClustersEncoded;
+  data->compressedClustersEncodedSize = ptrs.tpcCompressedClustersEncodedSize;
   mTrackingCAO2Interface->Clear(false);
 
   return (retVal);
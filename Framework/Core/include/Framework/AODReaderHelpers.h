@@ -13,6 +13,16 @@
 
 #include "Framework/AlgorithmSpec.h"
 
+#include <functional>
+#include <memory>
+
+namespace arrow
+{
+class Buffer;
+class RecordBatch;
+class Schema;
+} // namespace arrow
+
 namespace o2
 {
 namespace framework
@@ -23,6 +33,15 @@ namespace readers
 struct AODReaderHelpers {
   static AlgorithmSpec rootFileReaderCallback();
   static AlgorithmSpec run2ESDConverterCallback();
+
+  /// Read the Arrow IPC streams one after the other in @a content, which may be
+  /// separated by 0-padding, as in the files written by run2ESD2Run3AOD.
+  /// @a onStream is invoked with the schema of each stream, then @a onBatch
+  /// with each of its record batches.
+  /// @throws std::runtime_error if @a content is not a sequence of streams.
+  static void readArrowStreams(std::shared_ptr<arrow::Buffer> const& content,
+                               std::function<void(std::shared_ptr<arrow::Schema> const&)> const& onStream,
+                               std::function<void(arrow::RecordBatch const&)> const& onBatch);
 };
 
 } // namespace readers
@@ -19,6 +19,9 @@
 #include <arrow/table.h>
 #include <arrow/array.h>
 #include <gandiva/selection_vector.h>
+#include <gsl/span>
+#include <algorithm>
+#include <array>
 #include <cassert>
 
 namespace o2::soa
@@ -84,6 +87,15 @@ struct Flat {
   constexpr static bool chunked = false;
 };
 
+/// @return the values of the @a chunk -th chunk of @a column, starting from
+/// @a offset and of size @a length (-1 for the whole chunk).
+template <typename T>
+gsl::span<T const> getChunkSpan(arrow::Column const* column, int chunk, int64_t offset = 0, int64_t length = -1)
+{
+  auto array = std::static_pointer_cast<arrow_array_for_t<T>>(column->data()->chunk(chunk));
+  return {array->raw_values() + offset, length < 0 ? array->length() - offset : length};
+}
+
 /// Iterator on a single column.
 /// FIXME: the ChunkingPolicy for now is fixed to Flat and is a mere boolean
 /// which is used to switch off slow "chunking aware" parts. This is ok for
@@ -687,7 +699,72 @@ class Table
     return mTable->num_rows();
   }
 
+  /// @return true if all the persistent columns @a PC are made of a single chunk
+  template <typename... PC>
+  bool isFlat() const
+  {
+    return ((getColumn<PC>()->data()->num_chunks() == 1) && ...);
+  }
+
+  /// Bulk access to the persistent columns @a PC. @a f is invoked with one
+  /// contiguous gsl::span per column, for each range of rows which is
+  /// fully contained in a single chunk of all of them, so that it can run
+  /// a branchless (and vectorisable) loop over the values. E.g.:
+  ///
+  /// tracks.forEachSpan<aod::track::X, aod::track::Y>([](auto xs, auto ys) { ... });
+  ///
+  /// For tables made of a single chunk (the common case) @a f is invoked
+  /// exactly once, with spans covering the whole table.
+  template <typename... PC, typename F>
+  void forEachSpan(F&& f) const
+  {
+    static_assert(sizeof...(PC) > 0, "At least one column is needed");
+    static_assert((PC::persistent::value && ...), "Only persistent columns can be accessed in bulk");
+    if (size() == 0) {
+      return;
+    }
+    if (isFlat<PC...>()) {
+      f(getChunkSpan<typename PC::type>(getColumn<PC>(), 0)...);
+      return;
+    }
+    forEachChunkedSpan<PC...>(std::forward<F>(f), std::index_sequence_for<PC...>{});
+  }
+
  private:
+  template <typename T>
+  arrow::Column const* getColumn() const
+  {
+    return std::get<std::pair<T*, arrow::Column*>>(mColumnIndex).second;
+  }
+
+  /// Generic case of forEachSpan, where chunk boundaries are not necessarily
+  /// the same for all the columns (e.g. in a Join).
+  template <typename... PC, typename F, size_t... Is>
+  void forEachChunkedSpan(F&& f, std::index_sequence<Is...>) const
+  {
+    constexpr size_t N = sizeof...(PC);
+    std::array<arrow::Column const*, N> columns{getColumn<PC>()...};
+    std::array<int, N> chunks{};
+    std::array<int64_t, N> offsets{};
+    int64_t row = 0;
+    while (row < size()) {
+      int64_t length = size() - row;
+      for (size_t ci = 0; ci < N; ++ci) {
+        // Skip chunks we have already fully consumed, including empty ones.
+        while (offsets[ci] == columns[ci]->data()->chunk(chunks[ci])->length()) {
+          chunks[ci]++;
+          offsets[ci] = 0;
+        }
+        length = std::min(length, columns[ci]->data()->chunk(chunks[ci])->length() - offsets[ci]);
+      }
+      f(getChunkSpan<typename PC::type>(columns[Is], chunks[Is], offsets[Is], length)...);
+      for (size_t ci = 0; ci < N; ++ci) {
+        offsets[ci] += length;
+      }
+      row += length;
+    }
+  }
+
   template <typename T>
   arrow::Column* lookupColumn()
   {
@@ -18,10 +18,12 @@
 #include "Framework/ControlService.h"
 #include "Framework/DataProcessorSpec.h"
 #include "Framework/EndOfStreamContext.h"
+#include "Framework/Expressions.h"
 #include "Framework/Kernels.h"
 #include "Framework/Logger.h"
 #include "Framework/HistogramRegistry.h"
 #include "Framework/StructToTuple.h"
+#include "Framework/ThreadPool.h"
 #include "Framework/FunctionalHelpers.h"
 #include "Framework/Traits.h"
 #include "Framework/VariantHelpers.h"
@@ -30,6 +32,7 @@
 #include <arrow/compute/context.h>
 #include <arrow/compute/kernel.h>
 #include <arrow/table.h>
+#include <algorithm>
 #include <type_traits>
 #include <utility>
 #include <memory>
@@ -64,19 +67,52 @@ template <typename... PC>
 struct WritingCursor<soa::Table<PC...>> {
   using persistent_table_t = soa::Table<PC...>;
   using cursor_t = decltype(std::declval<TableBuilder>().cursor<persistent_table_t>());
+  using bulk_cursor_t = decltype(std::declval<TableBuilder>().bulkCursor<persistent_table_t>());
 
   void operator()(typename PC::type... args)
   {
     cursor(0, args...);
   }
 
+  /// Append @a n rows at once, given one array per persistent column.
+  void bulk(size_t n, typename PC::type const*... columns)
+  {
+    bulkCursor(0, n, columns...);
+  }
+
+  /// Append the @a n @a rows of an array of structs at once, taking each
+  /// persistent column from the given data member of S.
+  template <typename S>
+  void bulk(S const* rows, size_t n, typename PC::type S::*... members)
+  {
+    auto columns = std::make_tuple(std::unique_ptr<typename PC::type[]>(new typename PC::type[n])...);
+    auto transposeAndAppend = [&](auto&... column) {
+      (TableBuilderHelpers::transpose(rows, n, members, column.get()), ...);
+      bulk(n, column.get()...);
+    };
+    std::apply(transposeAndAppend, columns);
+  }
+
+  /// Reserve space for @a nRows more rows, so that they can be appended
+  /// without growing the columns row after row.
+  void reserve(size_t nRows)
+  {
+    mBuilder->reserve(nRows);
+  }
+
   bool resetCursor(TableBuilder& builder)
   {
+    mBuilder = &builder;
     cursor = std::move(FFL(builder.cursor<persistent_table_t>()));
+    bulkCursor = std::move(FFL(builder.bulkCursor<persistent_table_t>()));
     return true;
   }
 
   decltype(FFL(std::declval<cursor_t>())) cursor;
+  decltype(FFL(std::declval<bulk_cursor_t>())) bulkCursor;
+
+ private:
+  TableBuilder* mBuilder = nullptr;
 };
 
 /// This helper class allow you to declare things which will be crated by a
@@ -187,6 +223,9 @@ struct AnalysisTask {
 // Helper struct which builds a DataProcessorSpec from
 // the contents of an AnalysisTask...
 struct AnalysisDataProcessorBuilder {
+  /// The filters declared in a task, which apply to its soa::Filtered arguments
+  using Filters = std::vector<expressions::Filter const*>;
+
   template <typename Arg>
   static void doAppendInputWithMetadata(std::vector<InputSpec>& inputs)
   {
@@ -224,13 +263,13 @@ struct AnalysisDataProcessorBuilder {
   }
 
   template <typename R, typename C, typename Grouping, typename... Args>
-  static auto bindGroupingTable(InputRecord& record, R (C::*)(Grouping, Args...))
+  static auto bindGroupingTable(InputRecord& record, Filters const& filters, R (C::*)(Grouping, Args...))
   {
-    return extractSomethingFromRecord<Grouping>(record);
+    return extractSomethingFromRecord<Grouping>(record, filters);
   }
 
   template <typename R, typename C>
-  static auto bindGroupingTable(InputRecord& record, R (C::*)())
+  static auto bindGroupingTable(InputRecord& record, Filters const& filters, R (C::*)())
   {
     static_assert(always_static_assert_v<C>, "Your task process method needs at least one argument");
     return o2::soa::Table<>{nullptr};
@@ -243,12 +282,21 @@ struct AnalysisDataProcessorBuilder {
     return typename aod::MetadataTrait<T>::metadata::table_t(at);
   }
 
+  /// The selection for a soa::Filtered argument is created by evaluating
+  /// all the filters of the task which can be applied to its columns.
   template <typename T>
-  static auto extractFilteredTableFromRecord(InputRecord& record)
+  static auto extractFilteredTableFromRecord(InputRecord& record, Filters const& filters)
   {
     using metadata = typename aod::MetadataTrait<typename std::decay_t<T>::table_t>::metadata;
     auto at = record.get<TableConsumer>(metadata::label())->asArrowTable();
-    return soa::Filtered<typename metadata::table_t>(at, nullptr);
+    Filters compatible;
+    for (auto filter : filters) {
+      if (expressions::isSchemaCompatible(at->schema(), *filter)) {
+        compatible.push_back(filter);
+      }
+    }
+    auto selection = expressions::createSelection(at, expressions::createFilter(at->schema(), compatible));
+    return soa::Filtered<typename metadata::table_t>(at, selection);
   }
 
   template <typename T1, typename T2>
@@ -260,37 +308,37 @@ struct AnalysisDataProcessorBuilder {
   }
 
   template <typename T>
-  static auto extractSomethingFromRecord(InputRecord& record)
+  static auto extractSomethingFromRecord(InputRecord& record, Filters const& filters)
   {
     if constexpr (is_specialization<std::decay_t<T>, soa::Join>::value) {
       using left_t = typename std::decay_t<T>::left_t;
       using right_t = typename std::decay_t<T>::right_t;
       return extractJoinFromRecord<left_t, right_t>(record);
     } else if constexpr (is_specialization<std::decay_t<T>, soa::Filtered>::value) {
-      return extractFilteredTableFromRecord<T>(record);
+      return extractFilteredTableFromRecord<T>(record, filters);
     } else {
       return extractTableFromRecord<std::decay_t<T>>(record);
     }
   }
 
   template <typename R, typename C, typename Grouping, typename... Args>
-  static auto bindAssociatedTables(InputRecord& record, R (C::*)(Grouping, Args...))
+  static auto bindAssociatedTables(InputRecord& record, Filters const& filters, R (C::*)(Grouping, Args...))
   {
-    return std::make_tuple(extractSomethingFromRecord<Args>(record)...);
+    return std::make_tuple(extractSomethingFromRecord<Args>(record, filters)...);
   }
 
   template <typename R, typename C>
-  static auto bindAssociatedTables(InputRecord& record, R (C::*)())
+  static auto bindAssociatedTables(InputRecord& record, Filters const& filters, R (C::*)())
   {
     static_assert(always_static_assert_v<C>, "Your task process method needs at least one argument");
     return std::tuple<>{};
   }
 
   template <typename Task, typename R, typename C, typename Grouping, typename... Associated>
-  static void invokeProcess(Task& task, InputRecord& inputs, R (C::*)(Grouping, Associated...))
+  static void invokeProcess(Task& task, InputRecord& inputs, Filters const& filters, GroupByOptions groupingOptions, R (C::*)(Grouping, Associated...))
   {
-    auto groupingTable = AnalysisDataProcessorBuilder::bindGroupingTable(inputs, &C::process);
-    auto associatedTables = AnalysisDataProcessorBuilder::bindAssociatedTables(inputs, &C::process);
+    auto groupingTable = AnalysisDataProcessorBuilder::bindGroupingTable(inputs, filters, &C::process);
+    auto associatedTables = AnalysisDataProcessorBuilder::bindAssociatedTables(inputs, filters, &C::process);
 
     if constexpr (sizeof...(Associated) == 0) {
       // No extra tables: we need to either iterate over the contents of
@@ -354,23 +402,38 @@ struct AnalysisDataProcessorBuilder {
           using groupingMetadata = typename aod::MetadataTrait<std::decay_t<Grouping>>::metadata;
           arrow::compute::FunctionContext ctx;
           std::vector<arrow::compute::Datum> groupsCollection;
-          auto indexColumnName = std::string("fID4") + groupingMetadata::label();
-          auto result = o2::framework::sliceByColumn(&ctx, indexColumnName,
-                                                     allGroupedTable.asArrowTable(), &groupsCollection);
+          std::vector<uint64_t> groupsKeys;
+          groupingOptions.columnName = std::string("fID4") + groupingMetadata::label();
+          auto groupedArrowTable = allGroupedTable.asArrowTable();
+          auto result = o2::framework::sliceByColumn(&ctx, groupingOptions,
+                                                     groupedArrowTable, &groupsCollection, &groupsKeys);
           if (result.ok() == false) {
             LOGF(ERROR, "Error while splitting second collection");
             return;
           }
-          size_t currentGrouping = 0;
-          auto groupingElement = groupingTable.begin();
 
-          // FIXME: this assumes every groupingElement has a group associated,
-          // which migh not be the case.
-          for (auto& groupedDatum : groupsCollection) {
-            auto groupedElementsTable = arrow::util::get<std::shared_ptr<arrow::Table>>(groupedDatum.value);
-            task.process(groupingElement, AssociatedType{groupedElementsTable});
+          // The slices are matched to the grouping elements by the value of
+          // their index, so that a grouping element without any associated
+          // row gets an empty slice.
+          std::vector<std::shared_ptr<arrow::Column>> emptyColumns;
+          for (int ci = 0; ci < groupedArrowTable->num_columns(); ++ci) {
+            emptyColumns.emplace_back(groupedArrowTable->column(ci)->Slice(0, 0));
+          }
+          auto emptyTable = arrow::Table::Make(groupedArrowTable->schema(), emptyColumns);
+          size_t gi = 0;
+          auto groupingElement = groupingTable.begin();
+          for (uint64_t groupingIndex = 0; groupingIndex < (uint64_t)groupingTable.size(); ++groupingIndex) {
+            if (gi < groupsKeys.size() && groupsKeys[gi] == groupingIndex) {
+              auto groupedElementsTable = arrow::util::get<std::shared_ptr<arrow::Table>>(groupsCollection[gi++].value);
+              task.process(groupingElement, AssociatedType{groupedElementsTable});
+            } else {
+              task.process(groupingElement, AssociatedType{emptyTable});
+            }
             ++const_cast<std::decay_t<Grouping>&>(groupingElement);
           }
+          if (gi != groupsKeys.size()) {
+            LOGF(ERROR, "%d groups refer to a missing %s", groupsKeys.size() - gi, groupingMetadata::label());
+          }
         } else {
           static_assert(always_static_assert_v<AssociatedType>, "I do not know how to iterate on this");
         }
@@ -448,11 +511,13 @@ struct OutputManager<HistogramRegistry> {
 
   static bool finalize(ProcessingContext& context, HistogramRegistry& what)
   {
+    what.flush();
     return true;
   }
 
   static bool postRun(EndOfStreamContext& context, HistogramRegistry& what)
   {
+    what.flush();
     return true;
   }
 };
@@ -481,6 +546,25 @@ struct OutputManager<OutputObj<T>> {
   }
 };
 
+/// Collects the filters declared as members of a task
+template <typename T>
+struct FilterManager {
+  template <typename ANY>
+  static bool appendFilter(AnalysisDataProcessorBuilder::Filters& filters, ANY&)
+  {
+    return false;
+  }
+};
+
+template <>
+struct FilterManager<expressions::Filter> {
+  static bool appendFilter(AnalysisDataProcessorBuilder::Filters& filters, expressions::Filter& what)
+  {
+    filters.push_back(&what);
+    return true;
+  }
+};
+
 // SFINAE test
 template <typename T>
 class has_process
@@ -563,14 +647,30 @@ DataProcessorSpec adaptAnalysisTask(std::string name, Args&&... args)
     if constexpr (has_init<T>::value) {
       task->init(ic);
     }
-    return [task](ProcessingContext& pc) {
+    // The task is kept alive by the processing callback, so we can safely
+    // hold pointers to its filters.
+    AnalysisDataProcessorBuilder::Filters filters;
+    auto tupledTask = o2::framework::to_tuple_refs(*task.get());
+    std::apply([&filters](auto&... x) { return (FilterManager<std::decay_t<decltype(x)>>::appendFilter(filters, x), ...); }, tupledTask);
+
+    // Grouping the associated tables by their index is done in parallel
+    // by a pool which lives as long as the task.
+    GroupByOptions groupingOptions;
+    groupingOptions.nThreads = std::max(1, ic.options().get<int>("grouping-threads"));
+    std::shared_ptr<ThreadPool> groupingPool;
+    if (groupingOptions.nThreads > 1) {
+      groupingPool = std::make_shared<ThreadPool>(groupingOptions.nThreads);
+      groupingOptions.pool = groupingPool.get();
+    }
+
+    return [task, filters, groupingOptions, groupingPool](ProcessingContext& pc) {
       auto tupledTask = o2::framework::to_tuple_refs(*task.get());
       std::apply([&pc](auto&&... x) { return (OutputManager<std::decay_t<decltype(x)>>::prepare(pc, x), ...); }, tupledTask);
       if constexpr (has_run<T>::value) {
         task->run(pc);
       }
       if constexpr (has_process<T>::value) {
-        AnalysisDataProcessorBuilder::invokeProcess(*(task.get()), pc.inputs(), &T::process);
+        AnalysisDataProcessorBuilder::invokeProcess(*(task.get()), pc.inputs(), filters, groupingOptions, &T::process);
       }
       std::apply([&pc](auto&&... x) { return (OutputManager<std::decay_t<decltype(x)>>::finalize(pc, x), ...); }, tupledTask);
     };
@@ -583,7 +683,8 @@ DataProcessorSpec adaptAnalysisTask(std::string name, Args&&... args)
     // task itself.
     inputs,
     outputs,
-    algo};
+    algo,
+    {ConfigParamSpec{"grouping-threads", VariantType::Int, 1, {"Number of threads used to group the associated tables by their index"}}}};
   return spec;
 }
 
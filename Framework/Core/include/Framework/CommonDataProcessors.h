@@ -30,8 +30,18 @@ struct CommonDataProcessors {
   /// a binary dump for all the dangling inputs matching the Timeframe
   /// lifetime. @a unmatched will be filled with all the InputSpecs which are
   /// not going to be used by the returned DataProcessorSpec.
+  /// Writing happens in a separate thread, in (optionally compressed) blocks,
+  /// and the file ends with an index of its content.
   static DataProcessorSpec getGlobalFileSink(std::vector<InputSpec> const& danglingInputs,
                                              std::vector<InputSpec>& unmatched);
+  /// @return a DataProcessor which replays the timeslices of a file written by
+  /// the global file sink (@a filename, unless overridden with --infile),
+  /// optionally starting from a given timeslice and at a given rate. The file
+  /// is only opened when the device is initialised. Messages are sent with the
+  /// DataHeader they were dumped with, so @a outputs need to match all of
+  /// them, e.g. using a ConcreteDataTypeMatcher to accept any subSpec.
+  static DataProcessorSpec getGlobalFileSource(std::vector<OutputSpec> const& outputs,
+                                               std::string const& filename = "dpl-out.bin");
   /// @return a dummy DataProcessorSpec which requires all the passed @a InputSpec
   /// and simply discards them.
   static DataProcessorSpec getDummySink(std::vector<InputSpec> const& danglingInputs);
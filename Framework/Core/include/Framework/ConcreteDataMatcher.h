@@ -11,6 +11,8 @@
 #define O2_FRAMEWORK_CONCRETEDATAMATCHER_H_
 
 #include "Headers/DataHeader.h"
+#include <cstdint>
+#include <functional>
 
 namespace o2::framework
 {
@@ -81,4 +83,23 @@ struct ConcreteDataMatcher {
 };
 
 } // namespace o2::framework
+
+namespace std
+{
+/// Allows using ConcreteDataMatcher as a key of unordered containers,
+/// e.g. to dispatch incoming messages to their route without walking
+/// all the matchers.
+template <>
+struct hash<o2::framework::ConcreteDataMatcher> {
+  size_t operator()(o2::framework::ConcreteDataMatcher const& matcher) const noexcept
+  {
+    uint64_t seed = (uint64_t(matcher.origin.itg[0]) << 32) | matcher.subSpec;
+    for (auto part : matcher.description.itg) {
+      seed ^= part + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+  }
+};
+} // namespace std
+
 #endif
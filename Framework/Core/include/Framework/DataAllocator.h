@@ -89,9 +89,12 @@ class DataAllocator
   using DataDescription = o2::header::DataDescription;
   using SubSpecificationType = o2::header::DataHeader::SubSpecificationType;
 
+  /// @a dispatcher decides the routing of the timeslices to LeastLoaded
+  /// time pipelines. Without it, those are routed round robin.
   DataAllocator(TimingInfo* timingInfo,
                 ContextRegistry* contextes,
-                const AllowedOutputRoutes& routes);
+                const AllowedOutputRoutes& routes,
+                TimePipelineDispatcher* dispatcher = nullptr);
 
   DataChunk& newChunk(const Output&, size_t);
 
@@ -254,10 +257,12 @@ class DataAllocator
   {
     auto proxy = mContextRegistry->get<MessageContext>()->proxy();
     FairMQMessagePtr payloadMessage;
+    std::string channel;
     auto serializationType = o2::header::gSerializationMethodNone;
     if constexpr (is_messageable<T>::value == true) {
       // Serialize a snapshot of a trivially copyable, non-polymorphic object,
-      payloadMessage = proxy.createMessage(sizeof(T));
+      channel = matchDataHeader(spec, mTimingInfo->timeslice);
+      payloadMessage = createPayloadMessage(channel, sizeof(T));
       memcpy(payloadMessage->GetData(), &object, sizeof(T));
 
       serializationType = o2::header::gSerializationMethodNone;
@@ -269,7 +274,8 @@ class DataAllocator
         // reference object
         constexpr auto elementSizeInBytes = sizeof(ElementType);
         auto sizeInBytes = elementSizeInBytes * object.size();
-        payloadMessage = proxy.createMessage(sizeInBytes);
+        channel = matchDataHeader(spec, mTimingInfo->timeslice);
+        payloadMessage = createPayloadMessage(channel, sizeInBytes);
 
         if constexpr (std::is_pointer<typename T::value_type>::value == false) {
           // vector of elements
@@ -295,6 +301,7 @@ class DataAllocator
       }
     } else if constexpr (has_root_dictionary<T>::value == true || is_specialization<T, ROOTSerialized>::value == true) {
       // Serialize a snapshot of an object with root dictionary
+      channel = matchDataHeader(spec, mTimingInfo->timeslice);
       payloadMessage = proxy.createMessage();
       if constexpr (is_specialization<T, ROOTSerialized>::value == true) {
         // Explicitely ROOT serialize a snapshot of object.
@@ -339,7 +346,7 @@ class DataAllocator
                     "\n - std::vector of messageable structures or pointers to those"
                     "\n - types with ROOT dictionary and implementing ROOT ClassDef interface");
     }
-    addPartToContext(std::move(payloadMessage), spec, serializationType);
+    addPartToContext(std::move(payloadMessage), spec, channel, serializationType);
   }
 
   /// Take a snapshot of a raw data array which can be either POD or may contain a serialized
@@ -348,6 +355,17 @@ class DataAllocator
   void snapshot(const Output& spec, const char* payload, size_t payloadSize,
                 o2::header::SerializationMethod serializationMethod = o2::header::gSerializationMethodNone);
 
+  /// Take a snapshot of a raw data array, described by @a header, e.g. a message
+  /// read back from a dump. All the fields of the DataHeader (serialization method,
+  /// split payload parts, ...) are kept, only the DataProcessingHeader is the one
+  /// of the current timeslice. The payload size is the one in @a header.
+  void snapshot(o2::header::DataHeader const& header, const char* payload);
+
+  /// Send the message @a payload as it is, without copying it. Changes to the
+  /// data after the call will be visible to the receivers.
+  void adoptMessage(const Output& spec, FairMQMessagePtr&& payload,
+                    o2::header::SerializationMethod serializationMethod = o2::header::gSerializationMethodNone);
+
   /// make an object of type T and route to output specified by OutputRef
   /// The object is owned by the framework, returned reference can be used to fill the object.
   ///
@@ -422,6 +440,7 @@ class DataAllocator
   AllowedOutputRoutes mAllowedOutputRoutes;
   TimingInfo* mTimingInfo;
   ContextRegistry* mContextRegistry;
+  TimePipelineDispatcher* mTimePipelineDispatcher;
 
   std::string matchDataHeader(const Output& spec, size_t timeframeId);
   FairMQMessagePtr headerMessageFromOutput(Output const& spec,                                  //
@@ -430,8 +449,16 @@ class DataAllocator
                                            size_t payloadSize);                                 //
 
   Output getOutputByBind(OutputRef&& ref);
+  /// @return a payload message of @a size bytes for @a channel, taken from
+  /// the channel message pool if there is one.
+  FairMQMessagePtr createPayloadMessage(std::string const& channel, size_t size);
+  void addPartToContext(FairMQMessagePtr&& payload,
+                        const Output& spec,
+                        o2::header::SerializationMethod serializationMethod);
+  /// Same as above, for a @a spec already matched to its @a channel.
   void addPartToContext(FairMQMessagePtr&& payload,
                         const Output& spec,
+                        std::string const& channel,
                         o2::header::SerializationMethod serializationMethod);
 
   /// Fills the passed arrow::ipc::BatchRecordWriter in the framework and
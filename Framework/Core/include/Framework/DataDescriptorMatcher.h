@@ -12,6 +12,7 @@
 
 #include "Framework/ConcreteDataMatcher.h"
 #include "Framework/DataProcessingHeader.h"
+#include "Framework/HeaderStackIndex.h"
 #include "Headers/DataHeader.h"
 #include "Headers/Stack.h"
 
@@ -260,6 +261,10 @@ class DataDescriptorMatcher
   // kind of header.
   bool match(char const* d, VariableContext& context) const;
 
+  /// Same as above, with the headers in @a d already located by @a index,
+  /// so that the header stack is not walked again for each node.
+  bool match(char const* d, HeaderStackIndex const& index, VariableContext& context) const;
+
   bool operator==(DataDescriptorMatcher const& other) const;
 
   friend std::ostream& operator<<(std::ostream& os, DataDescriptorMatcher const& matcher);
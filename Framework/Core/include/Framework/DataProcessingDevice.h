@@ -19,19 +19,28 @@
 #include "Framework/DataProcessingStats.h"
 #include "Framework/ExpirationHandler.h"
 #include "Framework/MessageContext.h"
+#include "Framework/MessagePool.h"
 #include "Framework/RootObjectContext.h"
 #include "Framework/ArrowContext.h"
 #include "Framework/StringContext.h"
 #include "Framework/RawBufferContext.h"
 #include "Framework/ServiceRegistry.h"
+#include "Framework/ThreadPool.h"
 #include "Framework/InputRoute.h"
 #include "Framework/ForwardRoute.h"
 #include "Framework/TimingInfo.h"
+#include "Framework/TimePipelineDispatch.h"
 
 #include <fairmq/FairMQDevice.h>
 #include <fairmq/FairMQParts.h>
+#include <fairmq/FairMQPoller.h>
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace o2::framework
 {
@@ -54,9 +63,27 @@ class DataProcessingDevice : public FairMQDevice
  protected:
   bool handleData(FairMQParts&, InputChannelInfo&);
   bool tryDispatchComputation();
+  void receiveCredits();
+  void giveBackCredits(TimesliceId timeslice);
   void error(const char* msg);
 
  private:
+  /// The set of output contextes used by a worker thread to process a
+  /// timeslice. Each worker gets its own, so that user callbacks for
+  /// independent timeslices can run concurrently.
+  struct WorkerContext {
+    WorkerContext(DataProcessingDevice* device, DeviceSpec const& spec);
+
+    TimingInfo timingInfo;
+    MessageContext fairMQContext;
+    RootObjectContext rootContext;
+    StringContext stringContext;
+    ArrowContext dataFrameContext;
+    RawBufferContext rawBufferContext;
+    ContextRegistry contextRegistry;
+    DataAllocator allocator;
+  };
+
   /// The specification used to create the initial state of this device
   DeviceSpec const& mSpec;
   /// The current internal state of this device.
@@ -67,6 +94,14 @@ class DataProcessingDevice : public FairMQDevice
   AlgorithmSpec::ErrorCallback mError;
   std::unique_ptr<ConfigParamRegistry> mConfigRegistry;
   ServiceRegistry& mServiceRegistry;
+  /// The pools of the output messages, when enabled. Before the contextes,
+  /// so that it outlives the messages they hold.
+  std::unique_ptr<MessagePools> mMessagePools;
+  /// Routing of the timeslices to the LeastLoaded time pipelines fed by
+  /// this device, together with the channels their credits come from,
+  /// with the associated consumer.
+  TimePipelineDispatcher mTimePipelineDispatcher;
+  std::vector<std::pair<std::string, std::string>> mCreditChannels;
   TimingInfo mTimingInfo;
   MessageContext mFairMQContext;
   RootObjectContext mRootContext;
@@ -78,12 +113,37 @@ class DataProcessingDevice : public FairMQDevice
   DataRelayer mRelayer;
   std::vector<ExpirationHandler> mExpirationHandlers;
 
+  /// A timer feeding this device, together with the time when it is
+  /// next expected to fire, both in microseconds.
+  struct TimerDeadline {
+    uint64_t period;
+    uint64_t next;
+  };
+  /// Poller over the input channels, used to sleep until there is
+  /// something to do when --polling-timeout > 0, nullptr otherwise.
+  FairMQPollerPtr mInputPoller;
+  int mPollingTimeout = 0;                    /// Max time, in ms, we are allowed to sleep waiting for inputs
+  bool mHasEnumerations = false;              /// Enumerations create timeslices immediately, so we cannot sleep
+  bool mWasActive = true;                     /// Whether the previous iteration did some processing
+  std::vector<TimerDeadline> mTimerDeadlines; /// When the timers used by this device will expire
+
   int mErrorCount;
-  int mProcessingCount;
-  uint64_t mLastSlowMetricSentTimestamp = 0; /// The timestamp of the last time we sent slow metrics
-  uint64_t mLastMetricFlushedTimestamp = 0;  /// The timestamp of the last time we actually flushed metrics
-  uint64_t mBeginIterationTimestamp = 0;     /// The timestamp of when the current ConditionalRun was started
-  DataProcessingStats mStats;                /// Stats about the actual data processing.
+  std::atomic<int> mProcessingCount;
+  uint64_t mLastSlowMetricSentTimestamp = 0;  /// The timestamp of the last time we sent slow metrics
+  uint64_t mLastMetricFlushedTimestamp = 0;   /// The timestamp of the last time we actually flushed metrics
+  uint64_t mBeginIterationTimestamp = 0;      /// The timestamp of when the current ConditionalRun was started
+  uint64_t mLastPipelineAdaptedTimestamp = 0; /// The timestamp of the last time we tuned the relayer pipeline length
+  DataProcessingStats mStats;                 /// Stats about the actual data processing.
+  std::vector<int> mLastSentRelayerState;            /// The relayer state as it was last sent via metrics.
+  std::vector<std::string> mRelayerStateMetricNames; /// The preallocated names for the relayer state metrics.
+  /// Serialises sending, monitoring and stats updates between the
+  /// workers and the main thread.
+  std::mutex mSendMutex;
+  /// Pool of workers running the processing callbacks when
+  /// --worker-threads > 0, nullptr otherwise. Declared last so that
+  /// the workers are joined before any state they use goes away.
+  std::vector<std::unique_ptr<WorkerContext>> mWorkerContexts;
+  std::unique_ptr<ThreadPool> mWorkerPool;
 };
 
 } // namespace o2::framework
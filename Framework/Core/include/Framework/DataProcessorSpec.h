@@ -17,6 +17,7 @@
 #include "Framework/DataRef.h"
 #include "Framework/InputSpec.h"
 #include "Framework/OutputSpec.h"
+#include "Framework/TimePipelineDispatch.h"
 
 #include <string>
 #include <vector>
@@ -64,6 +65,9 @@ struct DataProcessorSpec {
   /// put, but this is actually to be handled in the actual DeviceSpec.
   size_t inputTimeSliceId = 0;
   size_t maxInputTimeslices = 1;
+  /// How the timeslices are distributed among the maxInputTimeslices
+  /// replicas of this DataProcessor.
+  TimePipelineDispatch timePipelineDispatch = TimePipelineDispatch::RoundRobin;
 };
 
 } // namespace framework
@@ -13,11 +13,13 @@
 #include "Framework/InputRoute.h"
 #include "Framework/DataDescriptorMatcher.h"
 #include "Framework/ForwardRoute.h"
+#include "Framework/HeaderStackIndex.h"
 #include "Framework/CompletionPolicy.h"
 #include "Framework/PartRef.h"
 #include "Framework/TimesliceIndex.h"
 
 #include <cstddef>
+#include <unordered_map>
 #include <vector>
 
 class FairMQMessage;
@@ -37,6 +39,7 @@ struct DataRelayerStats {
   uint64_t droppedComputations = 0;     /// How many computations have been dropped because one of the inputs was late
   uint64_t droppedIncomingMessages = 0; /// How many messages have been dropped (not relayed) because they were late
   uint64_t relayedMessages = 0;         /// How many messages have been successfully relayed
+  uint64_t pipelineResizes = 0;         /// How many times the pipeline length was adapted at runtime
 };
 
 class DataRelayer
@@ -69,6 +72,12 @@ class DataRelayer
   RelayChoice relay(std::unique_ptr<FairMQMessage>&& header,
                     std::unique_ptr<FairMQMessage>&& payload);
 
+  /// Same as above, for a header stack which the caller already indexed,
+  /// so that it does not need to be walked again.
+  RelayChoice relay(std::unique_ptr<FairMQMessage>&& header,
+                    std::unique_ptr<FairMQMessage>&& payload,
+                    HeaderStackIndex const& headerIndex);
+
   /// @returns the actions ready to be performed.
   std::vector<RecordAction> getReadyToProcess();
 
@@ -88,11 +97,36 @@ class DataRelayer
   /// Tune the maximum number of in flight timeslices this can handle.
   void setPipelineLength(size_t s);
 
+  /// Let the pipeline length be tuned at runtime by adaptPipelineLength(),
+  /// between MIN_PIPELINE_LENGTH and @a maxLength slots. Growth is inhibited
+  /// once the cache is expected to hold more than @a maxCachedBytes (0 means
+  /// no limit). A @a maxLength of 0 disables the tuning.
+  void setAdaptivePipelineLength(size_t maxLength, size_t maxCachedBytes);
+
+  /// Grow the pipeline when computations were dropped because of lack of
+  /// slots since the previous invokation, shrink it when most of the slots
+  /// were left unused for a few invokations in a row.
+  /// @return true if the pipeline length was changed.
+  bool adaptPipelineLength();
+
+  /// @return the number of bytes currently held in the cache.
+  size_t getCachedBytes() const;
+
+  /// @return the timeslices which were dropped without being processed
+  /// since the previous invokation, either because their data arrived
+  /// when they were already obsolete or because their slot was taken by a
+  /// newer timeslice.
+  std::vector<TimesliceId> getDroppedTimeslices();
+
   /// @return the current stats about the data relaying process
   DataRelayerStats const& getStats() const;
 
-  /// Send metrics with the VariableContext information
+  /// Send metrics with the VariableContext information and the state of
+  /// each cache entry. Only the values which changed since the previous
+  /// invokation are actually sent.
   void sendContextState();
+  /// Send the full set of metrics describing the cache, e.g. after it
+  /// was resized.
   void publishMetrics();
 
  private:
@@ -111,8 +145,29 @@ class DataRelayer
   CompletionPolicy mCompletionPolicy;
   std::vector<size_t> mDistinctRoutesIndex;
   std::vector<data_matcher::DataDescriptorMatcher> mInputMatchers;
+  /// Index of the routes which have a concrete matcher, keyed by (origin,
+  /// description, subSpec), so that we do not need to walk their matcher
+  /// tree for every incoming message. Only the routes in mWildcardRoutes,
+  /// i.e. those using wildcards or variables, are matched against
+  /// their DataDescriptorMatcher.
+  std::unordered_map<ConcreteDataMatcher, size_t> mConcreteRoutes;
+  std::vector<size_t> mWildcardRoutes;
   std::vector<data_matcher::VariableContext> mVariableContextes;
   std::vector<int> mCachedStateMetrics;
+  /// What was sent last time by sendContextState(), so that we only
+  /// send what changed.
+  std::vector<int> mLastSentStateMetrics;
+  std::vector<data_matcher::ContextElement::Value> mLastSentVariables;
+
+  /// State for the runtime tuning of the pipeline length
+  size_t mMaxPipelineLength = 0;
+  size_t mMaxCachedBytes = 0;
+  size_t mPeakUsedSlots = 0;
+  size_t mQuietIntervals = 0;
+  uint64_t mLastDroppedComputations = 0;
+
+  /// Timeslices dropped since the last getDroppedTimeslices()
+  std::vector<TimesliceId> mDroppedTimeslices;
 
   static std::vector<std::string> sMetricsNames;
   static std::vector<std::string> sVariablesMetricsNames;
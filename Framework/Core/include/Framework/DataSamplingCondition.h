@@ -17,14 +17,46 @@
 /// \author Piotr Konopka, piotr.jan.konopka@cern.ch
 
 #include "Framework/DataRef.h"
+#include "Framework/HeaderStackIndex.h"
 
 #include <boost/property_tree/ptree.hpp>
 
+#include <cstdint>
+#include <vector>
+
 namespace o2
 {
 namespace framework
 {
 
+/// Data samples which are evaluated together. The headers of each sample are
+/// looked up only once, and the fields used by the conditions are stored
+/// contiguously, so that they can be evaluated in tight loops.
+struct DataSamplingBatch {
+  std::vector<DataRef> refs;
+  std::vector<uint64_t> startTimes;
+  std::vector<uint64_t> payloadSizes;
+
+  void clear()
+  {
+    refs.clear();
+    startTimes.clear();
+    payloadSizes.clear();
+  }
+
+  void add(const DataRef& ref)
+  {
+    auto index = HeaderStackIndex::parse(ref.header);
+    const auto* dh = index.get<header::DataHeader>(ref.header);
+    const auto* dph = index.get<DataProcessingHeader>(ref.header);
+    refs.push_back(ref);
+    startTimes.push_back(dph ? dph->startTime : 0);
+    payloadSizes.push_back(dh ? dh->payloadSize : 0);
+  }
+
+  size_t size() const { return refs.size(); }
+};
+
 /// A standarised data sampling condition, to decide if given data sample should be passed forward.
 class DataSamplingCondition
 {
@@ -38,6 +70,19 @@ class DataSamplingCondition
   virtual void configure(const boost::property_tree::ptree&) = 0;
   /// \brief Makes decision whether to pass a data sample or not.
   virtual bool decide(const o2::framework::DataRef&) = 0;
+  /// \brief Makes decisions for a batch of data samples. The mask holds a non-zero value for the samples to be
+  /// evaluated and 0 for the others, the entries of the samples which should not be passed forward are set to 0.
+  ///
+  /// The default implementation calls decide() for each sample, conditions should override it
+  /// to avoid one virtual call per sample.
+  virtual void decideBatch(const DataSamplingBatch& batch, std::vector<uint8_t>& mask)
+  {
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (mask[i]) {
+        mask[i] = decide(batch.refs[i]);
+      }
+    }
+  }
 };
 
 } // namespace framework
@@ -65,6 +65,10 @@ class DataSamplingPolicy
   bool match(const ConcreteDataMatcher& input) const;
   /// \brief Returns true if user-defined conditions of sampling are fulfilled.
   bool decide(const o2::framework::DataRef&);
+  /// \brief Makes decisions for a batch of data samples, see DataSamplingCondition::decideBatch. The conditions
+  /// are evaluated one after the other on the whole batch, each one only on the samples still accepted.
+  /// Any non-zero value of the mask marks a sample to be evaluated.
+  void decide(const DataSamplingBatch& batch, std::vector<uint8_t>& mask);
   /// \brief Returns Output for given InputSpec to pass data forward.
   const Output prepareOutput(const ConcreteDataMatcher& input, Lifetime lifetime = Lifetime::Timeframe) const;
 
@@ -75,6 +79,10 @@ class DataSamplingPolicy
   std::string getFairMQOutputChannelName() const;
   uint32_t getTotalAcceptedMessages() const;
   uint32_t getTotalEvaluatedMessages() const;
+  /// \brief Accounts the payload of a sampled message, which was either shared with the input or copied.
+  void accountSampledBytes(uint64_t bytes, bool shared);
+  uint64_t getTotalSharedBytes() const;
+  uint64_t getTotalCopiedBytes() const;
 
   static header::DataOrigin createPolicyDataOrigin();
   static header::DataDescription createPolicyDataDescription(std::string policyName, size_t id);
@@ -88,6 +96,8 @@ class DataSamplingPolicy
   // stats
   uint32_t mTotalAcceptedMessages = 0;
   uint32_t mTotalEvaluatedMessages = 0;
+  uint64_t mTotalSharedBytes = 0;
+  uint64_t mTotalCopiedBytes = 0;
 };
 
 } // namespace framework
@@ -49,6 +49,12 @@ struct DeviceSpec {
   std::vector<InputRoute> inputs;
   std::vector<OutputRoute> outputs;
   std::vector<ForwardRoute> forwards;
+  /// Channels over which the replicas of the LeastLoaded time pipelines fed
+  /// by this device give back a credit for each timeslice they are done with.
+  std::vector<InputChannelSpec> creditInputChannels;
+  /// Channels over which this device, as a replica of a LeastLoaded time
+  /// pipeline, gives back its credits.
+  std::vector<OutputChannelSpec> creditOutputChannels;
   size_t rank;   // Id of a parallel processing I am part of
   size_t nSlots; // Total number of parallel units I am part of
   size_t inputTimesliceId;
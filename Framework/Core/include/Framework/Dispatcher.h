@@ -22,6 +22,8 @@
 #include "Framework/DataSamplingHeader.h"
 #include "Framework/Task.h"
 
+class FairMQTransportFactory;
+
 namespace o2
 {
 namespace framework
@@ -47,12 +49,17 @@ class Dispatcher : public Task
   Inputs getInputSpecs();
   Outputs getOutputSpecs();
 
+  /// \brief Creates the payload message of a sample, which refers to the buffer of @a inputMessage when the transport
+  /// allows it and is a copy of @a payload otherwise. The payload bytes are accounted in @a policy as shared or copied.
+  static FairMQMessagePtr samplePayload(FairMQTransportFactory& transport, FairMQMessage const* inputMessage,
+                                        const char* payload, size_t payloadSize, DataSamplingPolicy& policy);
+
  private:
   DataSamplingHeader prepareDataSamplingHeader(const DataSamplingPolicy& policy, const DeviceSpec& spec);
   header::Stack extractAdditionalHeaders(const char* inputHeaderStack) const;
-  void send(DataAllocator& dataAllocator, const DataRef& inputData, Output&& output) const;
-  void sendFairMQ(FairMQDevice* device, const DataRef& inputData, const std::string& fairMQChannel,
-                  header::Stack&& stack) const;
+  void send(DataAllocator& dataAllocator, const DataRef& inputData, FairMQMessagePtr&& payload, Output&& output) const;
+  void sendFairMQ(FairMQDevice* device, const DataRef& inputData, FairMQMessagePtr&& payload,
+                  const std::string& fairMQChannel, header::Stack&& stack) const;
 
   std::string mName;
   std::string mReconfigurationSource;
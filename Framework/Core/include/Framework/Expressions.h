@@ -18,6 +18,12 @@
 #include <variant>
 #include <string>
 #include <memory>
+#include <vector>
+
+namespace gandiva
+{
+class Filter;
+} // namespace gandiva
 
 namespace o2::framework::expressions
 {
@@ -122,6 +128,22 @@ struct Filter {
 };
 
 using Selection = std::shared_ptr<gandiva::SelectionVector>;
+/// A filter compiled by gandiva for a given schema
+using FilterPtr = std::shared_ptr<gandiva::Filter>;
+
+/// @return true if all the columns used in @a filter are present in @a schema
+bool isSchemaCompatible(std::shared_ptr<arrow::Schema> const& schema, Filter const& filter);
+
+/// Compile the logical and of @a filters for tables with the given @a schema.
+/// Compiled filters are cached, so that the (expensive) compilation only
+/// happens once for each (schema, expression) pair.
+/// @return nullptr if @a filters is empty.
+FilterPtr createFilter(std::shared_ptr<arrow::Schema> const& schema, std::vector<Filter const*> const& filters);
+FilterPtr createFilter(std::shared_ptr<arrow::Schema> const& schema, Filter const& filter);
+
+/// Evaluate @a filter on all the rows of @a table. A nullptr @a filter
+/// selects all the rows.
+Selection createSelection(std::shared_ptr<arrow::Table> table, FilterPtr const& filter);
 Selection createSelection(std::shared_ptr<arrow::Table> table, Filter const& filter);
 
 } // namespace o2::framework::expressions
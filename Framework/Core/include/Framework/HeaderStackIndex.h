@@ -0,0 +1,77 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef O2_FRAMEWORK_HEADERSTACKINDEX_H_
+#define O2_FRAMEWORK_HEADERSTACKINDEX_H_
+
+#include "Headers/DataHeader.h"
+#include "Framework/DataProcessingHeader.h"
+#include "Framework/SourceInfoHeader.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace o2::framework
+{
+
+/// Offsets of the headers DPL cares about inside a header stack. The stack
+/// is walked only once, in parse(), so that the headers can then be
+/// retrieved in constant time, rather than walking the stack again for each
+/// of them as o2::header::get does.
+///
+/// Like o2::header::get, the first header of a given type wins.
+struct HeaderStackIndex {
+  static constexpr int32_t Missing = -1;
+
+  int32_t dataHeader = Missing;
+  int32_t dataProcessingHeader = Missing;
+  int32_t sourceInfoHeader = Missing;
+
+  static HeaderStackIndex parse(void const* stack)
+  {
+    HeaderStackIndex index;
+    auto begin = reinterpret_cast<o2::byte const*>(stack);
+    for (auto current = header::BaseHeader::get(begin); current != nullptr; current = current->next()) {
+      auto offset = static_cast<int32_t>(reinterpret_cast<o2::byte const*>(current) - begin);
+      if (current->description == header::DataHeader::sHeaderType) {
+        index.dataHeader = index.dataHeader == Missing ? offset : index.dataHeader;
+      } else if (current->description == DataProcessingHeader::sHeaderType) {
+        index.dataProcessingHeader = index.dataProcessingHeader == Missing ? offset : index.dataProcessingHeader;
+      } else if (current->description == SourceInfoHeader::sHeaderType) {
+        index.sourceInfoHeader = index.sourceInfoHeader == Missing ? offset : index.sourceInfoHeader;
+      }
+    }
+    return index;
+  }
+
+  /// @return the header of type T in @a stack, which must be the one which
+  /// was parsed, or nullptr if it is not there.
+  template <typename T>
+  T const* get(void const* stack) const
+  {
+    int32_t offset = Missing;
+    if constexpr (std::is_same_v<T, header::DataHeader>) {
+      offset = dataHeader;
+    } else if constexpr (std::is_same_v<T, DataProcessingHeader>) {
+      offset = dataProcessingHeader;
+    } else if constexpr (std::is_same_v<T, SourceInfoHeader>) {
+      offset = sourceInfoHeader;
+    } else {
+      static_assert(std::is_same_v<T, header::DataHeader>, "Header type not indexed by HeaderStackIndex");
+    }
+    if (stack == nullptr || offset == Missing) {
+      return nullptr;
+    }
+    return reinterpret_cast<T const*>(reinterpret_cast<o2::byte const*>(stack) + offset);
+  }
+};
+
+} // namespace o2::framework
+
+#endif // O2_FRAMEWORK_HEADERSTACKINDEX_H_
@@ -25,38 +25,58 @@
 #include "THn.h"
 #include "THnSparse.h"
 
+#include <array>
+#include <memory>
 #include <string>
 #include <variant>
+#include <vector>
+
 namespace o2
 {
 
 namespace framework
 {
+/// Binning of one of the axes of a histogram
+struct AxisSpec {
+  AxisSpec(int nBins_, double xmin_, double xmax_)
+    : nBins(nBins_),
+      xmin(xmin_),
+      xmax(xmax_)
+  {
+  }
+
+  int nBins;
+  double xmin;
+  double xmax;
+};
+
 /// Data sctructure that will allow to construct a fully qualified TH* histogram
-/// Currently only supports TH1F
+/// The kind is the name of the ROOT class to be created, i.e. one of
+/// TH1X, TH2X, TH3X, THnX and THnSparseX, where X is C, S, I, F or D
+/// (and L for THn and THnSparse). One axis must be provided per dimension.
 struct HistogramConfigSpec {
   HistogramConfigSpec(char const* const kind_, unsigned int nBins_, double xmin_, double xmax_)
     : kind(kind_),
-      nBins(nBins_),
-      xmin(xmin_),
-      xmax(xmax_)
+      axes{{static_cast<int>(nBins_), xmin_, xmax_}}
+  {
+  }
+
+  HistogramConfigSpec(char const* const kind_, std::vector<AxisSpec> axes_)
+    : kind(kind_),
+      axes(std::move(axes_))
   {
   }
 
   HistogramConfigSpec()
     : kind(""),
-      nBins(1),
-      xmin(0),
-      xmax(1)
+      axes{{1, 0, 1}}
   {
   }
   HistogramConfigSpec(HistogramConfigSpec const& other) = default;
   HistogramConfigSpec(HistogramConfigSpec&& other) = default;
 
   std::string kind;
-  unsigned int nBins;
-  double xmin;
-  double xmax;
+  std::vector<AxisSpec> axes;
 };
 
 /// Data structure containing histogram specification for the HistogramRegistry
@@ -86,38 +106,102 @@ struct HistogramSpec {
   HistogramConfigSpec config;
 };
 
+/// Histograms are either one of the TH1 family (TH1, TH2 and TH3) or
+/// one of the THnBase family (THn and THnSparse)
+using HistPtr = std::variant<std::unique_ptr<TH1>, std::unique_ptr<THnBase>>;
+
+/// Create the histogram described by @a spec
+/// @throws std::runtime_error in case the kind is unknown or the number of
+/// axes does not match its dimension
+HistPtr createHistogram(HistogramSpec const& spec);
+
 /// Histogram registry for an analysis task that allows to define needed histograms
 /// and serves as the container/wrapper to fill them
+///
+/// Values passed to fill() are not filled immediately, but buffered in a
+/// per histogram columnar array, which is flushed in bulk via FillN once it
+/// is full, when the histogram is accessed with get(), when flush() is
+/// invoked and at the end of each processing step.
+/// A registry must not be filled from different threads: each thread should
+/// fill its own copy, obtained from createSubRegistry(), which can then be
+/// merged back into the original one.
 class HistogramRegistry
 {
  public:
   HistogramRegistry(char const* const name_, bool enable, std::vector<HistogramSpec> specs)
     : name(name_),
       enabled(enable),
+      mSpecs(std::move(specs)),
       mRegistryKey(),
-      mRegistryValue()
+      mRegistryValue(),
+      mBuffers()
   {
     mRegistryKey.fill(0u);
-    for (auto& spec : specs) {
+    for (auto& spec : mSpecs) {
       insert(spec);
     }
   }
 
-  auto& get(char const* const name) const
+  /// @return the TH1, TH2 or TH3 histogram associated to @a name, with all
+  /// the entries filled so far
+  std::unique_ptr<TH1> const& get(char const* const name) const
   {
-    const uint32_t id = compile_time_hash(name);
-    const uint32_t i = imask(id);
-    if (O2_BUILTIN_LIKELY(id == mRegistryKey[i])) {
-      return mRegistryValue[i];
+    const uint32_t i = find(compile_time_hash(name));
+    flush(i);
+    auto& value = mRegistryValue[i];
+    if (O2_BUILTIN_UNLIKELY(std::holds_alternative<std::unique_ptr<TH1>>(value) == false)) {
+      throw std::runtime_error(std::string("Histogram ") + name + " is not a TH1");
     }
-    for (auto j = 1u; j < MAX_REGISTRY_SIZE; ++j) {
-      if (id == mRegistryKey[imask(j + i)]) {
-        return mRegistryValue[imask(j + i)];
-      }
+    return std::get<std::unique_ptr<TH1>>(value);
+  }
+
+  /// @return the histogram associated to @a name as a T, with all the
+  /// entries filled so far, or nullptr if it is not a T. E.g. get<THnSparseF>("name").
+  template <typename T>
+  T* get(char const* const name) const
+  {
+    const uint32_t i = find(compile_time_hash(name));
+    flush(i);
+    return std::visit([](auto& histogram) { return dynamic_cast<T*>(histogram.get()); },
+                      mRegistryValue[i]);
+  }
+
+  /// Fill the histogram @a name with one entry. One value must be provided
+  /// per dimension, optionally followed by the weight of the entry.
+  template <typename... Ts>
+  void fill(char const* const name, Ts... values)
+  {
+    static_assert(sizeof...(Ts) > 0, "At least one value is needed to fill a histogram");
+    constexpr int nValues = sizeof...(Ts);
+    const uint32_t i = find(compile_time_hash(name));
+    auto& buffer = mBuffers[i];
+    if (O2_BUILTIN_UNLIKELY(nValues != buffer.dimension && nValues != buffer.dimension + 1)) {
+      throw std::runtime_error(std::string("Wrong number of values to fill histogram ") + name);
+    }
+    double const args[] = {static_cast<double>(values)...};
+    double* entry = buffer.values.data() + buffer.entries;
+    for (int d = 0; d < buffer.dimension; ++d) {
+      entry[d * FillBuffer::capacity] = args[d];
+    }
+    entry[buffer.dimension * FillBuffer::capacity] = nValues > buffer.dimension ? args[nValues - 1] : 1.;
+    if (++buffer.entries == FillBuffer::capacity) {
+      flush(i);
     }
-    throw std::runtime_error("No match found!");
   }
 
+  /// Fill all the buffered entries in their histograms
+  void flush();
+
+  /// @return an empty registry with the same histograms as this one.
+  HistogramRegistry createSubRegistry() const
+  {
+    return {name.c_str(), enabled, mSpecs};
+  }
+
+  /// Add the content of the histograms of @a other to the ones of this registry.
+  /// Both registries are flushed beforehand.
+  void merge(HistogramRegistry& other);
+
   // @return the associated OutputSpec
   OutputSpec const spec()
   {
@@ -135,18 +219,32 @@ class HistogramRegistry
   mutable uint32_t lookup = 0;
 
  private:
-  void insert(HistogramSpec& spec)
+  /// Columnar buffer of the entries to be filled in a histogram.
+  /// The values of each dimension are contiguous, followed by the weights.
+  struct FillBuffer {
+    static constexpr size_t capacity = 1024;
+    int dimension = 0;
+    size_t entries = 0;
+    std::vector<double> values;
+  };
+
+  void insert(HistogramSpec& spec);
+  /// Fill the buffered entries of the histogram at @a i. The buffers only
+  /// delay the filling, so this does not change the observable state.
+  void flush(uint32_t i) const;
+
+  uint32_t find(uint32_t id) const
   {
-    uint32_t i = imask(spec.id);
-    for (auto j = 0u; j < MAX_REGISTRY_SIZE; ++j) {
-      if (mRegistryValue[imask(j + i)].get() == nullptr) {
-        mRegistryKey[imask(j + i)] = spec.id;
-        mRegistryValue[imask(j + i)] = {std::make_unique<TH1F>(spec.name.data(), spec.readableName.data(), spec.config.nBins, spec.config.xmin, spec.config.xmax)};
-        lookup += j;
-        return;
+    const uint32_t i = imask(id);
+    if (O2_BUILTIN_LIKELY(id == mRegistryKey[i])) {
+      return i;
+    }
+    for (auto j = 1u; j < MAX_REGISTRY_SIZE; ++j) {
+      if (id == mRegistryKey[imask(j + i)]) {
+        return imask(j + i);
       }
     }
-    throw std::runtime_error("Internal array is full.");
+    throw std::runtime_error("No match found!");
   }
 
   inline constexpr uint32_t imask(uint32_t i) const
@@ -155,13 +253,15 @@ class HistogramRegistry
   }
   std::string name;
   bool enabled;
+  std::vector<HistogramSpec> mSpecs;
 
   /// The maximum number of histograms in buffer is currently set to 512
   /// which seems to be both reasonably large and allowing for very fast lookup
   static constexpr uint32_t mask = 0x1FF;
   static constexpr uint32_t MAX_REGISTRY_SIZE = mask + 1;
   std::array<uint32_t, MAX_REGISTRY_SIZE> mRegistryKey;
-  std::array<std::unique_ptr<TH1>, MAX_REGISTRY_SIZE> mRegistryValue;
+  std::array<HistPtr, MAX_REGISTRY_SIZE> mRegistryValue;
+  mutable std::array<FillBuffer, MAX_REGISTRY_SIZE> mBuffers;
 };
 
 } // namespace framework
@@ -182,6 +182,17 @@ class InputRecord
     }
   }
 
+  /// @return the message holding the payload of the input at @a pos, so that
+  /// it can be passed on without copying it, or nullptr if not available.
+  /// The message is owned by the framework and only valid during processing.
+  FairMQMessage const* getPayloadMessage(int pos) const
+  {
+    if (pos * 2 + 1 >= mSpan.size() || pos < 0) {
+      throw std::runtime_error("Unknown message requested at position " + std::to_string(pos));
+    }
+    return mSpan.getMessage(pos * 2 + 1);
+  }
+
   template <typename T = DataRef, typename std::enable_if_t<std::is_same<T, DataRef>::value == true, int> = 0>
   decltype(auto) get(char const* binding) const
   {
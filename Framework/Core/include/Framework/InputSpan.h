@@ -10,6 +10,10 @@
 #ifndef FRAMEWORK_INPUTSPAN_H
 #define FRAMEWORK_INPUTSPAN_H
 
+#include <functional>
+
+class FairMQMessage;
+
 namespace o2
 {
 namespace framework
@@ -32,12 +36,28 @@ class InputSpan
   {
   }
 
+  /// Same as above, with @a messageGetter providing the message which holds
+  /// the buffer of each element, when the span is backed by messages.
+  InputSpan(std::function<const char*(size_t)> getter, std::function<FairMQMessage const*(size_t)> messageGetter, size_t size)
+    : mGetter{getter},
+      mMessageGetter{messageGetter},
+      mSize{size}
+  {
+  }
+
   /// @a i-th element of the InputSpan
   char const* get(size_t i) const
   {
     return mGetter(i);
   }
 
+  /// The message holding the @a i-th element of the InputSpan, or nullptr if
+  /// the span is not backed by messages.
+  FairMQMessage const* getMessage(size_t i) const
+  {
+    return mMessageGetter ? mMessageGetter(i) : nullptr;
+  }
+
   /// Number of elements in the InputSpan
   size_t size() const
   {
@@ -46,6 +66,7 @@ class InputSpan
 
  private:
   std::function<char const*(size_t)> mGetter;
+  std::function<FairMQMessage const*(size_t)> mMessageGetter;
   size_t mSize;
 };
 
@@ -18,7 +18,9 @@
 #include <arrow/util/visibility.h>
 #include <arrow/util/variant.h>
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace arrow
 {
@@ -33,6 +35,7 @@ class FunctionContext;
 
 namespace o2::framework
 {
+class ThreadPool;
 
 struct ARROW_EXPORT HashByColumnOptions {
   std::string columnName;
@@ -69,9 +72,21 @@ class ARROW_EXPORT HashByColumnKernel : public arrow::compute::UnaryKernel
 
 struct ARROW_EXPORT GroupByOptions {
   std::string columnName;
+  /// Number of ranges of rows the column is split into, to be processed
+  /// in parallel.
+  size_t nThreads = 1;
+  /// The pool processing the ranges. When not given, a pool shared by the
+  /// whole process is created at the first call with nThreads > 1.
+  ThreadPool* pool = nullptr;
 };
 
-/// Build ranges
+/// Build ranges of consecutive rows with the same value of the
+/// (sorted) grouping column.
+/// * The input datum has to be a table like object.
+/// * The output datum is a table with one row per group, with columns
+///   "start" (the first row of the group) and "count" (its size).
+/// Rows with a negative value of the grouping column are considered
+/// unassigned and do not belong to any group.
 class ARROW_EXPORT SortedGroupByKernel : public arrow::compute::UnaryKernel
 {
  public:
@@ -94,12 +109,52 @@ class ARROW_EXPORT SortedGroupByKernel : public arrow::compute::UnaryKernel
   GroupByOptions mOptions;
 };
 
+/// Find the permutation of rows which groups together the rows with the
+/// same value of an (unsorted) grouping column, using a hash table.
+/// * The input datum has to be a table like object.
+/// * The output datum is a table with the single column "row", with the
+///   indices of the input rows, ordered by increasing value of the
+///   grouping column and, within a group, by their original position.
+/// Rows with a negative value of the grouping column are dropped.
+class ARROW_EXPORT HashGroupByKernel : public arrow::compute::UnaryKernel
+{
+ public:
+  explicit HashGroupByKernel(GroupByOptions options = {});
+  arrow::Status Call(arrow::compute::FunctionContext* ctx,
+                     arrow::compute::Datum const& table,
+                     arrow::compute::Datum* outputRows) override;
+#pragma GCC diagnostic push
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Winconsistent-missing-override"
+#endif // __clang__
+  std::shared_ptr<arrow::DataType> out_type() const final
+  {
+    return mType;
+  }
+#pragma GCC diagnostic pop
+
+ private:
+  std::shared_ptr<arrow::DataType> mType;
+  GroupByOptions mOptions;
+};
+
 /// Slice a given table is a vector of tables each containing a slice.
+/// In case @a key is not sorted, the rows are first grouped by
+/// HashGroupByKernel, so that each slice still contains all the rows
+/// with a given value.
 arrow::Status sliceByColumn(arrow::compute::FunctionContext* context,
                             std::string const& key,
                             arrow::compute::Datum const& inputTable,
                             std::vector<arrow::compute::Datum>* outputSlices);
 
+/// Same as above, grouping with the given @a options. When @a outputKeys
+/// is given, it gets the value of the key column of each slice.
+arrow::Status sliceByColumn(arrow::compute::FunctionContext* context,
+                            GroupByOptions const& options,
+                            arrow::compute::Datum const& inputTable,
+                            std::vector<arrow::compute::Datum>* outputSlices,
+                            std::vector<uint64_t>* outputKeys = nullptr);
+
 } // namespace o2::framework
 
 #endif // O2_FRAMEWORK_KERNELS_H_
@@ -33,6 +33,8 @@ namespace o2
 namespace framework
 {
 
+class MessagePools;
+
 class MessageContext
 {
  public:
@@ -156,7 +158,7 @@ class MessageContext
         // the transport factory
         mFactory{context->proxy().getTransport(bindingChannel, index)},
         // the memory resource takes ownership of the message
-        mResource{mFactory ? mFactory->GetMemoryResource() : nullptr},
+        mResource{mFactory ? context->getMemoryResource(bindingChannel, index) : nullptr},
         // create the vector with apropriate underlying memory resource for the message
         mData{std::forward<Args>(args)..., pmr::polymorphic_allocator<value_type>(mResource)}
     {
@@ -436,10 +438,23 @@ class MessageContext
   FairMQMessagePtr createMessage(const std::string& channel, int index, size_t size);
   FairMQMessagePtr createMessage(const std::string& channel, int index, void* data, size_t size, fairmq_free_fn* ffn, void* hint);
 
+  /// @return the memory resource used for the containers created for
+  /// @a channel, i.e. the message pool of the channel if pools are in use,
+  /// the one of its transport otherwise.
+  pmr::FairMQMemoryResource* getMemoryResource(const std::string& channel, int index);
+
+  /// Create the payload messages using @a pools, which need to outlive
+  /// this context. nullptr disables pooling.
+  void setMessagePools(MessagePools* pools)
+  {
+    mPools = pools;
+  }
+
  private:
   FairMQDeviceProxy mProxy;
   Messages mMessages;
   DispatchCallback mDispatchCallback;
+  MessagePools* mPools = nullptr;
 };
 } // namespace framework
 } // namespace o2
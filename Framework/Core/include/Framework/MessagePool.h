@@ -0,0 +1,128 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef O2_FRAMEWORK_MESSAGEPOOL_H_
+#define O2_FRAMEWORK_MESSAGEPOOL_H_
+
+#include "MemoryResources/MemoryResources.h"
+
+#include <fairmq/FairMQMessage.h>
+#include <fairmq/FairMQTransportFactory.h>
+#include <fairmq/FairMQUnmanagedRegion.h>
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace o2::framework
+{
+
+struct MessagePoolStats {
+  /// Messages created from a recycled buffer
+  size_t hits = 0;
+  /// Messages which could not be served by the pool
+  size_t misses = 0;
+  /// Buffers given back to the pool once the receiver was done with them
+  size_t recycled = 0;
+  /// Bytes of the region handed out so far, recycled buffers included
+  size_t reservedBytes = 0;
+};
+
+/// Pool of payload messages for a given channel. Messages are carved out of
+/// an unmanaged region of the channel transport. Once the receiver is done
+/// with one of them, the transport hands its buffer back to the pool, where
+/// it is merged with the neighbouring free ranges. Each message takes the
+/// smallest free range it fits in, and leaves the rest free. In steady state,
+/// where every timeframe creates the same set of large buffers, this avoids
+/// going through the shared memory allocator at all.
+///
+/// Messages smaller than @a minSize, or which do not fit anymore in the
+/// region, are created as usual by the transport.
+///
+/// The pool is also a memory resource, so that the containers created with
+/// DataAllocator::make can grow inside pooled messages.
+class MessagePool : public pmr::FairMQMemoryResource
+{
+ public:
+  static constexpr size_t Granularity = 4096;
+
+  MessagePool(FairMQTransportFactory* transport, size_t regionSize, size_t minSize);
+  ~MessagePool() override;
+
+  MessagePool(MessagePool const&) = delete;
+  MessagePool& operator=(MessagePool const&) = delete;
+
+  /// @return a message of @a size bytes, reusing a released buffer if
+  /// possible. Thread safe.
+  FairMQMessagePtr create(size_t size);
+
+  MessagePoolStats stats() const;
+
+  FairMQMessagePtr getMessage(void* p) override;
+  void* setMessage(FairMQMessagePtr message) override;
+  FairMQTransportFactory* getTransportFactory() noexcept override { return mTransport; }
+  size_t getNumberOfMessages() const noexcept override;
+
+ protected:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+  bool do_is_equal(const memory_resource& other) const noexcept override { return this == &other; }
+
+ private:
+  /// Invoked by the transport when the receiver releases a message
+  void release(void* data, size_t capacity);
+  /// Add a free range, merging it with its neighbours. Needs the lock.
+  void addFree(char* data, size_t size);
+  /// Remove a free range. Needs the lock.
+  void eraseFree(std::map<char*, size_t>::iterator range);
+
+  FairMQTransportFactory* mTransport;
+  size_t mMinSize;
+  mutable std::mutex mMutex;
+  /// Free ranges of the region, by address and by size
+  std::map<char*, size_t> mFreeByAddress;
+  std::multimap<size_t, char*> mFreeBySize;
+  /// Messages handed out as memory resource allocations
+  std::unordered_map<void*, FairMQMessagePtr> mAllocated;
+  size_t mRegionOffset = 0;
+  MessagePoolStats mStats;
+  /// Last, so that no callback can come once the rest is gone.
+  FairMQUnmanagedRegionPtr mRegion;
+};
+
+/// The message pools of a device, one per output channel, created the first
+/// time a message is requested for the channel.
+class MessagePools
+{
+ public:
+  /// Each channel gets a region of @a regionSize bytes. Messages smaller than
+  /// @a minSize bypass the pools.
+  MessagePools(size_t regionSize, size_t minSize = 64 * 1024);
+
+  /// @return the pool of @a channel, creating it with @a transport if needed.
+  MessagePool& get(std::string const& channel, FairMQTransportFactory* transport);
+
+  /// @return the statistics of each of the pools created so far.
+  std::vector<std::pair<std::string, MessagePoolStats>> stats() const;
+
+ private:
+  size_t mRegionSize;
+  size_t mMinSize;
+  mutable std::mutex mMutex;
+  std::unordered_map<std::string, std::unique_ptr<MessagePool>> mPools;
+};
+
+} // namespace o2::framework
+
+#endif // O2_FRAMEWORK_MESSAGEPOOL_H_
@@ -11,6 +11,7 @@
 #define FRAMEWORK_OUTPUTROUTE_H
 
 #include "Framework/OutputSpec.h"
+#include "Framework/TimePipelineDispatch.h"
 #include <cstddef>
 #include <string>
 
@@ -26,6 +27,15 @@ struct OutputRoute {
   size_t maxTimeslices;
   OutputSpec matcher;
   std::string channel;
+  /// With TimePipelineDispatch::LeastLoaded, @a timeslice is the index of
+  /// the consumer replica, and which timeslices it gets is decided at
+  /// runtime by the TimePipelineDispatcher of the device.
+  TimePipelineDispatch dispatch = TimePipelineDispatch::RoundRobin;
+  /// The time pipelined DataProcessor, for LeastLoaded dispatching
+  std::string consumer = "";
+  /// The channel over which the replica gives back its credits, for
+  /// LeastLoaded dispatching
+  std::string creditChannel = "";
 };
 
 } // namespace framework
@@ -27,11 +27,15 @@
 #include <memory>
 #include <tuple>
 
+class TTree;
+
 namespace o2
 {
 namespace framework
 {
 
+class ThreadPool;
+
 template <typename T>
 struct TreeReaderValueTraits {
 };
@@ -79,6 +83,25 @@ struct RootTableBuilderHelpers {
       filler(0, ValueExtractor::deref(values)...);
     }
   }
+
+  /// Convert the branches @a branchNames of @a tree to a table, with one
+  /// column per branch, named after it. Rather than going entry by entry,
+  /// each branch is read one basket at a time (using ROOT bulk I/O, when
+  /// the branch supports it) and its column is filled directly from the
+  /// basket content. When a @a pool is given, the branches are converted
+  /// in parallel, one task per branch, each worker reading (and
+  /// decompressing) from its own copy of the file. Trees in memory, or in
+  /// a TMemFile, are always converted serially.
+  ///
+  /// Only branches with a single leaf of a basic type (Bool_t included), or
+  /// a fixed size array of them (which is converted to a list column), are
+  /// supported.
+  ///
+  /// @throws std::runtime_error if a branch is missing, unsupported or
+  /// cannot be read.
+  static std::shared_ptr<arrow::Table> convertTTreeBulk(TTree& tree,
+                                                        std::vector<std::string> const& branchNames,
+                                                        ThreadPool* pool = nullptr);
 };
 
 } // namespace framework
@@ -27,6 +27,7 @@
 #include <string>
 #include <memory>
 #include <tuple>
+#include <type_traits>
 
 namespace arrow
 {
@@ -83,10 +84,23 @@ struct BuilderUtils {
     return builder->UnsafeAppend(value);
   }
 
-  template <typename BuilderType, typename PTR>
-  static arrow::Status bulkAppend(BuilderType& builder, size_t bulkSize, const PTR ptr)
+  /// Append @a bulkSize values at once. Numeric columns are appended with
+  /// a single copy of the whole batch, the others one value at a time, after
+  /// having reserved the space for all of them.
+  template <typename BuilderType, typename T>
+  static arrow::Status bulkAppend(BuilderType& builder, size_t bulkSize, T const* ptr)
   {
-    return builder->AppendValues(ptr, bulkSize, nullptr);
+    if constexpr (std::is_same_v<T, bool>) {
+      return builder->AppendValues(reinterpret_cast<uint8_t const*>(ptr), bulkSize, nullptr);
+    } else if constexpr (std::is_arithmetic_v<T>) {
+      return builder->AppendValues(ptr, bulkSize, nullptr);
+    } else {
+      auto status = builder->Reserve(bulkSize);
+      for (size_t i = 0; status.ok() && i < bulkSize; ++i) {
+        status = append(builder, ptr[i]);
+      }
+      return status;
+    }
   }
 
   template <typename BuilderType, typename ITERATOR>
@@ -225,6 +239,16 @@ struct TableBuilderHelpers {
   {
     return (std::get<Is>(builders)->Reserve(s).ok() && ...);
   }
+
+  /// Copy @a member of each of the @a n @a rows to @a column, to go from
+  /// an array of structs to the one array per column bulk appends expect.
+  template <typename S, typename T>
+  static void transpose(S const* rows, size_t n, T S::*member, T* column)
+  {
+    for (size_t i = 0; i < n; ++i) {
+      column[i] = rows[i].*member;
+    }
+  }
 };
 
 /// Helper class which creates a lambda suitable for building
@@ -256,6 +280,11 @@ class TableBuilder
       TableBuilderHelpers::reserveAll(*builders, nRows, seq);
     }
     mBuilders = builders; // We store the builders
+    mReserver = [builders](size_t n) {
+      if (TableBuilderHelpers::reserveAll(*builders, n, std::make_index_sequence<sizeof...(ARGS)>{}) == false) {
+        throw std::runtime_error("Unable to reserve " + std::to_string(n) + " rows");
+      }
+    };
   }
 
   template <typename... ARGS>
@@ -336,11 +365,48 @@ class TableBuilder
     makeBuilders<ARGS...>(columnNames, nRows);
     makeFinalizer<ARGS...>();
 
+    return bulkAppender<ARGS...>();
+  }
+
+  /// Creates a lambda which appends a batch of rows at once, given one
+  /// array per column, to the columns created by any of the persist
+  /// methods. ARGS must be the same as the ones used to create them.
+  template <typename... ARGS>
+  auto bulkAppender()
+  {
+    using BuildersTuple = typename std::tuple<std::unique_ptr<typename BuilderTraits<ARGS>::BuilderType>...>;
+    if (mBuilders == nullptr) {
+      throw std::runtime_error("TableBuilder::bulkAppender needs the columns to be created first");
+    }
     return [builders = (BuildersTuple*)mBuilders](unsigned int slot, size_t batchSize, typename BuilderMaker<ARGS>::FillType const*... args) -> void {
-      TableBuilderHelpers::bulkAppend(*builders, batchSize, std::index_sequence_for<ARGS...>{}, std::forward_as_tuple(args...));
+      auto status = TableBuilderHelpers::bulkAppend(*builders, batchSize, std::index_sequence_for<ARGS...>{}, std::forward_as_tuple(args...));
+      if (status == false) {
+        throw std::runtime_error("Unable to append");
+      }
     };
   }
 
+  /// Same as cursor(), but appending a batch of rows at once. The columns
+  /// must have been created with cursor<T>() first.
+  template <typename T>
+  auto bulkCursor()
+  {
+    using persistent_filter = soa::FilterPersistentColumns<T>;
+    using persistent_columns_pack = typename persistent_filter::persistent_columns_pack;
+    constexpr auto persistent_size = pack_size(persistent_columns_pack{});
+    return bulkCursorHelper<typename persistent_filter::persistent_table_t>(std::make_index_sequence<persistent_size>());
+  }
+
+  /// Reserve space for @a nRows more rows in all the columns, so that
+  /// appending them does not need to grow the buffers again.
+  void reserve(size_t nRows)
+  {
+    if (!mReserver) {
+      throw std::runtime_error("TableBuilder::reserve needs the columns to be created first");
+    }
+    mReserver(nRows);
+  }
+
   /// Actually creates the arrow::Table from the builders
   std::shared_ptr<arrow::Table> finalize();
 
@@ -355,7 +421,14 @@ class TableBuilder
     return this->template persist<typename pack_element_t<Is, typename T::columns>::type...>(columnNames);
   }
 
+  template <typename T, size_t... Is>
+  auto bulkCursorHelper(std::index_sequence<Is...> s)
+  {
+    return this->template bulkAppender<typename pack_element_t<Is, typename T::columns>::type...>();
+  }
+
   std::function<void(void)> mFinalizer;
+  std::function<void(size_t)> mReserver;
   void* mBuilders;
   arrow::MemoryPool* mMemoryPool;
   std::shared_ptr<arrow::Schema> mSchema;
@@ -0,0 +1,74 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef O2_FRAMEWORK_THREADPOOL_H_
+#define O2_FRAMEWORK_THREADPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace o2::framework
+{
+
+/// A fixed size pool of worker threads consuming a FIFO queue of tasks.
+/// Each task gets the index of the worker executing it, so that callers
+/// can keep per worker state (e.g. output contextes, scratch buffers)
+/// without further synchronisation.
+///
+/// Tasks must not throw: any exception escaping a task is caught and
+/// logged, so that the worker keeps running.
+class ThreadPool
+{
+ public:
+  using Task = std::function<void(size_t workerId)>;
+
+  /// Create a pool with @a nWorkers threads. A pool with 0 workers
+  /// executes the tasks inline in push().
+  explicit ThreadPool(size_t nWorkers);
+  ~ThreadPool();
+
+  ThreadPool(ThreadPool const&) = delete;
+  ThreadPool& operator=(ThreadPool const&) = delete;
+
+  /// Enqueue a task to be executed by the first available worker.
+  void push(Task&& task);
+
+  /// Block until all the tasks pushed so far have been executed.
+  void wait();
+
+  /// Block until a task pushed now would be started right away, i.e. until
+  /// fewer tasks than workers are pending, or at most @a timeout milliseconds.
+  void waitForIdleWorker(int timeout);
+
+  /// @return the number of tasks which were pushed and are not yet completed.
+  size_t pending() const;
+
+  /// @return the number of worker threads in the pool.
+  size_t size() const { return mWorkers.size(); }
+
+ private:
+  void run(size_t workerId);
+
+  std::vector<std::thread> mWorkers;
+  std::deque<Task> mQueue;
+  mutable std::mutex mMutex;
+  std::condition_variable mTaskAvailable;
+  std::condition_variable mTaskDone;
+  size_t mPending = 0;
+  bool mStopping = false;
+};
+
+} // namespace o2::framework
+
+#endif // O2_FRAMEWORK_THREADPOOL_H_
@@ -0,0 +1,76 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef O2_FRAMEWORK_TIMEPIPELINEDISPATCH_H_
+#define O2_FRAMEWORK_TIMEPIPELINEDISPATCH_H_
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace o2::framework
+{
+
+/// How the timeslices are distributed among the replicas of a time
+/// pipelined DataProcessor.
+enum struct TimePipelineDispatch {
+  /// Timeslice t goes to replica t % replicas.
+  RoundRobin,
+  /// Each timeslice goes to the replica with the fewest timeslices still
+  /// to be processed. Replicas give back a credit to their producer for
+  /// each timeslice they are done with.
+  LeastLoaded
+};
+
+/// Keeps track of the timeslices a device has sent to each replica of the
+/// LeastLoaded time pipelines it feeds, and decides which replica gets
+/// a new one. Thread safe.
+///
+/// A credit which never comes back, e.g. because the message got lost,
+/// would make its replica look busy forever. Timeslices are therefore
+/// forgotten, as if credited, once @a expireAfter newer ones were sent to
+/// the same pipeline.
+class TimePipelineDispatcher
+{
+ public:
+  explicit TimePipelineDispatcher(size_t expireAfter = 1024) : mExpireAfter{expireAfter} {}
+
+  /// @return the replica of @a consumer, out of @a replicas, which is to
+  /// process @a timeslice. The first call for a given timeslice picks the
+  /// replica with the fewest outstanding timeslices, the round robin one
+  /// in case of a tie, and the following ones return the same replica until
+  /// it gives back its credit.
+  size_t replicaFor(std::string const& consumer, size_t replicas, size_t timeslice);
+  /// The replica of @a consumer processing @a timeslice is done with it.
+  /// Credits for unknown timeslices are ignored.
+  void credit(std::string const& consumer, size_t timeslice);
+  /// @return the number of timeslices @a replica of @a consumer still has
+  /// to give back.
+  size_t outstanding(std::string const& consumer, size_t replica) const;
+
+ private:
+  struct Pipeline {
+    std::vector<size_t> outstanding;
+    /// The replica each outstanding timeslice was sent to
+    std::unordered_map<size_t, size_t> assigned;
+    /// The timeslices in the order they were assigned, including the
+    /// ones credited in the meanwhile.
+    std::deque<size_t> order;
+  };
+  size_t mExpireAfter;
+  mutable std::mutex mMutex;
+  std::unordered_map<std::string, Pipeline> mPipelines;
+};
+
+} // namespace o2::framework
+
+#endif // O2_FRAMEWORK_TIMEPIPELINEDISPATCH_H_
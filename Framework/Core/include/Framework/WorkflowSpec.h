@@ -98,8 +98,16 @@ Inputs mergeInputs(Inputs inputs,
 /// robin fashion. All the consumers of this DataProcessorSpec will have to connect
 /// to each one of the parallel workers or a "TimeMerger" device will have to do that for
 /// you.
+///
+/// By default timeslices are distributed round robin. With
+/// TimePipelineDispatch::LeastLoaded, each timeslice goes instead to the
+/// worker with the fewest timeslices still to be processed, which helps when
+/// the processing time varies a lot between timeslices. In that case all the
+/// inputs of the DataProcessorSpec must come from a single, not time
+/// pipelined, producer.
 DataProcessorSpec timePipeline(DataProcessorSpec original,
-                               size_t count);
+                               size_t count,
+                               TimePipelineDispatch dispatch = TimePipelineDispatch::RoundRobin);
 
 /// The purpose of this helper is to create a query on the data via a properly formatted
 /// @a matcher string which describes data in terms of the O2 Data Model descriptor.
@@ -20,17 +20,22 @@
 #include "Framework/SourceInfoHeader.h"
 #include "Framework/ChannelInfo.h"
 #include "Framework/Logger.h"
+#include "Framework/ThreadPool.h"
 
 #include <FairMQDevice.h>
 #include <ROOT/RDataFrame.hxx>
 #include <TFile.h>
+#include <TTree.h>
 
 #include <arrow/ipc/reader.h>
 #include <arrow/ipc/writer.h>
+#include <arrow/io/file.h>
 #include <arrow/io/interfaces.h>
+#include <arrow/io/memory.h>
 #include <arrow/table.h>
 #include <arrow/util/key_value_metadata.h>
 
+#include <algorithm>
 #include <thread>
 
 namespace o2::framework::readers
@@ -102,37 +107,170 @@ enum AODTypeMask : uint64_t {
   DZeroFlagged = 1 << 8
 };
 
+namespace
+{
+/// The AOD tables we know about, together with their bit in the read mask.
+constexpr std::pair<char const*, AODTypeMask> AODTypes[] = {
+  {"TRACKPAR", AODTypeMask::Tracks},
+  {"TRACKPARCOV", AODTypeMask::TracksCov},
+  {"TRACKEXTRA", AODTypeMask::TracksExtra},
+  {"CALO", AODTypeMask::Calo},
+  {"MUON", AODTypeMask::Muon},
+  {"VZERO", AODTypeMask::VZero},
+  {"COLLISION", AODTypeMask::Collisions},
+  {"TIMEFRAME", AODTypeMask::Timeframe},
+  {"DZEROFLAGGED", AODTypeMask::DZeroFlagged}};
+
+/// @return the bit of the read mask associated to @a description, or None.
+uint64_t getAODTypeMask(std::string const& description)
+{
+  for (auto& [name, mask] : AODTypes) {
+    if (description == name) {
+      return mask;
+    }
+  }
+  return AODTypeMask::None;
+}
+} // anonymous namespace
+
+void AODReaderHelpers::readArrowStreams(std::shared_ptr<arrow::Buffer> const& content,
+                                        std::function<void(std::shared_ptr<arrow::Schema> const&)> const& onStream,
+                                        std::function<void(arrow::RecordBatch const&)> const& onBatch)
+{
+  // Reading from a BufferReader slices the underlying buffer, rather than
+  // copying it, so the batches keep pointing to the original memory.
+  arrow::io::BufferReader input(content);
+  auto const* data = content->data();
+  int64_t const size = content->size();
+  int64_t position = 0;
+  while (true) {
+    // Skip the 0-padding between one stream and the other.
+    position = std::find_if(data + position, data + size, [](uint8_t byte) { return byte != 0; }) - data;
+    if (position == size) {
+      break;
+    }
+    auto status = input.Seek(position);
+    if (status.ok() == false) {
+      throw std::runtime_error("Unable to seek to offset " + std::to_string(position) + ": " + status.message());
+    }
+    std::shared_ptr<arrow::RecordBatchReader> reader;
+    status = arrow::ipc::RecordBatchStreamReader::Open(&input, &reader);
+    if (status.ok() == false) {
+      throw std::runtime_error("Unable to read stream at offset " + std::to_string(position) + ": " + status.message());
+    }
+    onStream(reader->schema());
+    while (true) {
+      std::shared_ptr<arrow::RecordBatch> batch;
+      status = reader->ReadNext(&batch);
+      if (status.ok() == false) {
+        throw std::runtime_error("Unable to read record batch of the stream at offset " + std::to_string(position) + ": " + status.message());
+      }
+      if (batch.get() == nullptr) {
+        break;
+      }
+      onBatch(*batch);
+    }
+    auto start = position;
+    status = input.Tell(&position);
+    if (status.ok() == false) {
+      throw std::runtime_error("Unable to get the end of the stream at offset " + std::to_string(start) + ": " + status.message());
+    }
+    if (position <= start) {
+      throw std::runtime_error("Empty stream at offset " + std::to_string(start));
+    }
+  }
+}
+
 uint64_t calculateReadMask(std::vector<OutputRoute> const& routes, header::DataOrigin const& origin)
 {
   uint64_t readMask = None;
   for (auto& route : routes) {
     auto concrete = DataSpecUtils::asConcreteDataTypeMatcher(route.matcher);
-    auto description = concrete.description;
-    if (description == header::DataDescription{"TRACKPAR"}) {
-      readMask |= AODTypeMask::Tracks;
-    } else if (description == header::DataDescription{"TRACKPARCOV"}) {
-      readMask |= AODTypeMask::TracksCov;
-    } else if (description == header::DataDescription{"TRACKEXTRA"}) {
-      readMask |= AODTypeMask::TracksExtra;
-    } else if (description == header::DataDescription{"CALO"}) {
-      readMask |= AODTypeMask::Calo;
-    } else if (description == header::DataDescription{"MUON"}) {
-      readMask |= AODTypeMask::Muon;
-    } else if (description == header::DataDescription{"VZERO"}) {
-      readMask |= AODTypeMask::VZero;
-    } else if (description == header::DataDescription{"COLLISION"}) {
-      readMask |= AODTypeMask::Collisions;
-    } else if (description == header::DataDescription{"TIMEFRAME"}) {
-      readMask |= AODTypeMask::Timeframe;
-    } else if (description == header::DataDescription{"DZEROFLAGGED"}) {
-      readMask |= AODTypeMask::DZeroFlagged;
-    } else {
-      throw std::runtime_error(std::string("Unknown AOD type: ") + description.str);
+    auto description = concrete.description.as<std::string>();
+    auto mask = getAODTypeMask(description);
+    if (mask == AODTypeMask::None) {
+      throw std::runtime_error(std::string("Unknown AOD type: ") + description);
     }
+    readMask |= mask;
   }
   return readMask;
 }
 
+namespace
+{
+/// Read the AOD tables from @a filename, which is expected to contain the
+/// Arrow IPC streams produced by the run2ESD2Run3AOD converter (e.g.
+/// run2ESD2Run3AOD AliESDs.root > aod.arrow). The file is memory mapped,
+/// so record batches are only copied once, when they are serialised in the
+/// output messages, and the payload of tables which were not requested
+/// in @a readMask is never touched.
+/// @return false in case the file could not be read, throws if its content is
+/// not a sequence of Arrow IPC streams.
+bool readArrowStreamFile(std::string const& filename, uint64_t readMask, DataAllocator& outputs)
+{
+  std::shared_ptr<arrow::io::MemoryMappedFile> file;
+  auto status = arrow::io::MemoryMappedFile::Open(filename, arrow::io::FileMode::READ, &file);
+  if (status.ok() == false) {
+    LOG(ERROR) << "Unable to map " << filename << ": " << status.message();
+    return false;
+  }
+  int64_t size = 0;
+  std::shared_ptr<arrow::Buffer> content;
+  if (file->GetSize(&size).ok() == false || file->ReadAt(0, size, &content).ok() == false) {
+    LOG(ERROR) << "Unable to read " << filename;
+    return false;
+  }
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  AODReaderHelpers::readArrowStreams(
+    content,
+    [readMask, &outputs, &writer](std::shared_ptr<arrow::Schema> const& schema) {
+      std::unordered_map<std::string, std::string> meta;
+      if (schema->metadata()) {
+        schema->metadata()->ToUnorderedMap(&meta);
+      }
+      auto description = meta["description"];
+      writer.reset();
+      if (getAODTypeMask(description) & readMask) {
+        header::DataDescription outputDescription;
+        outputDescription.runtimeInit(description.c_str());
+        writer = outputs.make<arrow::ipc::RecordBatchWriter>(Output{"AOD", outputDescription}, schema);
+      }
+    },
+    [&writer](arrow::RecordBatch const& batch) {
+      if (writer && writer->WriteRecordBatch(batch).ok() == false) {
+        throw std::runtime_error("Error while writing record");
+      }
+    });
+  return true;
+}
+
+bool isArrowFile(std::string const& filename)
+{
+  std::string extension = ".arrow";
+  return filename.size() > extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+/// Convert @a branches of the tree @a treeName in @a file, reading them in
+/// bulk (and in parallel, if a @a pool is given), and send the resulting
+/// table as @a description.
+void sendTreeBulk(TFile& file, char const* treeName, std::vector<std::string> const& branches,
+                  char const* description, DataAllocator& outputs, ThreadPool* pool)
+{
+  auto tree = dynamic_cast<TTree*>(file.Get(treeName));
+  if (tree == nullptr) {
+    LOG(ERROR) << "Tree " << treeName << " not found in " << file.GetName();
+    return;
+  }
+  auto table = RootTableBuilderHelpers::convertTTreeBulk(*tree, branches, pool);
+  header::DataDescription outputDescription;
+  outputDescription.runtimeInit(description);
+  auto writer = outputs.make<arrow::ipc::RecordBatchWriter>(Output{"AOD", outputDescription}, table->schema());
+  if (writer->WriteTable(*table).ok() == false) {
+    throw std::runtime_error(std::string("Error while writing ") + description);
+  }
+}
+} // anonymous namespace
+
 AlgorithmSpec AODReaderHelpers::run2ESDConverterCallback()
 {
   auto callback = AlgorithmSpec{adaptStateful([](ConfigParamRegistry const& options,
@@ -279,8 +417,11 @@ AlgorithmSpec AODReaderHelpers::rootFileReaderCallback()
 
     uint64_t readMask = calculateReadMask(spec.outputs, header::DataOrigin{"AOD"});
     auto counter = std::make_shared<int>(0);
+    // The branches of the flat trees are converted in parallel, one per task.
+    auto pool = std::make_shared<ThreadPool>(std::max(options.get<int>("aod-reader-threads"), 0));
     return adaptStateless([readMask,
                            counter,
+                           pool,
                            filenames](DataAllocator& outputs, ControlService& control) {
       if (*counter >= filenames.size()) {
         LOG(info) << "All input files processed";
@@ -289,6 +430,14 @@ AlgorithmSpec AODReaderHelpers::rootFileReaderCallback()
         return;
       }
       auto f = filenames[*counter];
+      // Pre-converted files do not need to go through ROOT.
+      if (isArrowFile(f)) {
+        *counter += 1;
+        if (readArrowStreamFile(f, readMask, outputs) == false) {
+          LOG(ERROR) << "Unable to read AOD from " << f;
+        }
+        return;
+      }
       auto infile = std::make_unique<TFile>(f.c_str());
       *counter += 1;
       if (infile.get() == nullptr || infile->IsOpen() == false) {
@@ -298,70 +447,29 @@ AlgorithmSpec AODReaderHelpers::rootFileReaderCallback()
 
       /// FIXME: Substitute here the actual data you want to convert for the AODReader
       if (readMask & AODTypeMask::Tracks) {
-        std::unique_ptr<TTreeReader> reader = std::make_unique<TTreeReader>("O2tracks", infile.get());
-        auto& trackParBuilder = outputs.make<TableBuilder>(Output{"AOD", "TRACKPAR"});
-        TTreeReaderValue<int> c0(*reader, "fID4Tracks");
-        TTreeReaderValue<float> c1(*reader, "fX");
-        TTreeReaderValue<float> c2(*reader, "fAlpha");
-        TTreeReaderValue<float> c3(*reader, "fY");
-        TTreeReaderValue<float> c4(*reader, "fZ");
-        TTreeReaderValue<float> c5(*reader, "fSnp");
-        TTreeReaderValue<float> c6(*reader, "fTgl");
-        TTreeReaderValue<float> c7(*reader, "fSigned1Pt");
-        RootTableBuilderHelpers::convertTTree(trackParBuilder, *reader,
-                                              c0, c1, c2, c3, c4, c5, c6, c7);
+        sendTreeBulk(*infile, "O2tracks",
+                     {"fID4Tracks", "fX", "fAlpha", "fY", "fZ", "fSnp", "fTgl", "fSigned1Pt"},
+                     "TRACKPAR", outputs, pool.get());
       }
 
       if (readMask & AODTypeMask::TracksCov) {
-        std::unique_ptr<TTreeReader> covReader = std::make_unique<TTreeReader>("O2tracks", infile.get());
-        TTreeReaderValue<float> c0(*covReader, "fCYY");
-        TTreeReaderValue<float> c1(*covReader, "fCZY");
-        TTreeReaderValue<float> c2(*covReader, "fCZZ");
-        TTreeReaderValue<float> c3(*covReader, "fCSnpY");
-        TTreeReaderValue<float> c4(*covReader, "fCSnpZ");
-        TTreeReaderValue<float> c5(*covReader, "fCSnpSnp");
-        TTreeReaderValue<float> c6(*covReader, "fCTglSnp");
-        TTreeReaderValue<float> c7(*covReader, "fCTglTgl");
-        TTreeReaderValue<float> c8(*covReader, "fC1PtY");
-        TTreeReaderValue<float> c9(*covReader, "fC1PtZ");
-        TTreeReaderValue<float> c10(*covReader, "fC1PtSnp");
-        TTreeReaderValue<float> c11(*covReader, "fC1PtTgl");
-        TTreeReaderValue<float> c12(*covReader, "fC1Pt21Pt2");
-        auto& trackParCovBuilder = outputs.make<TableBuilder>(Output{"AOD", "TRACKPARCOV"});
-        RootTableBuilderHelpers::convertTTree(trackParCovBuilder, *covReader,
-                                              c0, c1, c2, c3, c4, c5, c6, c7, c8, c9, c10, c11, c12);
+        sendTreeBulk(*infile, "O2tracks",
+                     {"fCYY", "fCZY", "fCZZ", "fCSnpY", "fCSnpZ", "fCSnpSnp", "fCTglSnp", "fCTglTgl",
+                      "fC1PtY", "fC1PtZ", "fC1PtSnp", "fC1PtTgl", "fC1Pt21Pt2"},
+                     "TRACKPARCOV", outputs, pool.get());
       }
 
       if (readMask & AODTypeMask::TracksExtra) {
-        std::unique_ptr<TTreeReader> extraReader = std::make_unique<TTreeReader>("O2tracks", infile.get());
-        TTreeReaderValue<float> c0(*extraReader, "fTPCinnerP");
-        TTreeReaderValue<uint64_t> c1(*extraReader, "fFlags");
-        TTreeReaderValue<unsigned char> c2(*extraReader, "fITSClusterMap");
-        TTreeReaderValue<unsigned short> c3(*extraReader, "fTPCncls");
-        TTreeReaderValue<unsigned char> c4(*extraReader, "fTRDntracklets");
-        TTreeReaderValue<float> c5(*extraReader, "fITSchi2Ncl");
-        TTreeReaderValue<float> c6(*extraReader, "fTPCchi2Ncl");
-        TTreeReaderValue<float> c7(*extraReader, "fTRDchi2");
-        TTreeReaderValue<float> c8(*extraReader, "fTOFchi2");
-        TTreeReaderValue<float> c9(*extraReader, "fTPCsignal");
-        TTreeReaderValue<float> c10(*extraReader, "fTRDsignal");
-        TTreeReaderValue<float> c11(*extraReader, "fTOFsignal");
-        TTreeReaderValue<float> c12(*extraReader, "fLength");
-        auto& extraBuilder = outputs.make<TableBuilder>(Output{"AOD", "TRACKEXTRA"});
-        RootTableBuilderHelpers::convertTTree(extraBuilder, *extraReader,
-                                              c0, c1, c2, c3, c4, c5, c6, c7, c8, c9, c10, c11);
+        sendTreeBulk(*infile, "O2tracks",
+                     {"fTPCinnerP", "fFlags", "fITSClusterMap", "fTPCncls", "fTRDntracklets", "fITSchi2Ncl",
+                      "fTPCchi2Ncl", "fTRDchi2", "fTOFchi2", "fTPCsignal", "fTRDsignal", "fTOFsignal"},
+                     "TRACKEXTRA", outputs, pool.get());
       }
 
       if (readMask & AODTypeMask::Calo) {
-        std::unique_ptr<TTreeReader> extraReader = std::make_unique<TTreeReader>("O2calo", infile.get());
-        TTreeReaderValue<int> c0(*extraReader, "fID4Calo");
-        TTreeReaderValue<short> c1(*extraReader, "fCellNumber");
-        TTreeReaderValue<float> c2(*extraReader, "fAmplitude");
-        TTreeReaderValue<float> c3(*extraReader, "fTime");
-        TTreeReaderValue<int8_t> c4(*extraReader, "fType");
-        auto& extraBuilder = outputs.make<TableBuilder>(Output{"AOD", "CALO"});
-        RootTableBuilderHelpers::convertTTree(extraBuilder, *extraReader,
-                                              c0, c1, c2, c3, c4);
+        sendTreeBulk(*infile, "O2calo",
+                     {"fID4Calo", "fCellNumber", "fAmplitude", "fTime", "fType"},
+                     "CALO", outputs, pool.get());
       }
 
       if (readMask & AODTypeMask::Muon) {
@@ -394,35 +502,12 @@ AlgorithmSpec AODReaderHelpers::rootFileReaderCallback()
 
       // Candidates as described by Gianmichele example
       if (readMask & AODTypeMask::DZeroFlagged) {
-        std::unique_ptr<TTreeReader> dzReader = std::make_unique<TTreeReader>("fTreeDzeroFlagged", infile.get());
-
-        TTreeReaderValue<float> c0(*dzReader, "d_len_ML");
-        TTreeReaderValue<int> c1(*dzReader, "cand_type_ML");
-        TTreeReaderValue<float> c2(*dzReader, "cos_p_ML");
-        TTreeReaderValue<float> c3(*dzReader, "cos_p_xy_ML");
-        TTreeReaderValue<float> c4(*dzReader, "d_len_xy_ML");
-        TTreeReaderValue<float> c5(*dzReader, "eta_prong0_ML");
-        TTreeReaderValue<float> c6(*dzReader, "eta_prong1_ML");
-        TTreeReaderValue<float> c7(*dzReader, "imp_par_prong0_ML");
-        TTreeReaderValue<float> c8(*dzReader, "imp_par_prong1_ML");
-        TTreeReaderValue<float> c9(*dzReader, "imp_par_xy_ML");
-        TTreeReaderValue<float> c10(*dzReader, "inv_mass_ML");
-        TTreeReaderValue<float> c11(*dzReader, "max_norm_d0d0exp_ML");
-        TTreeReaderValue<float> c12(*dzReader, "norm_dl_xy_ML");
-        TTreeReaderValue<float> c13(*dzReader, "pt_cand_ML");
-        TTreeReaderValue<float> c14(*dzReader, "pt_prong0_ML");
-        TTreeReaderValue<float> c15(*dzReader, "pt_prong1_ML");
-        TTreeReaderValue<float> c16(*dzReader, "y_cand_ML");
-        TTreeReaderValue<float> c17(*dzReader, "phi_cand_ML");
-        TTreeReaderValue<float> c18(*dzReader, "eta_cand_ML");
-        TTreeReaderValue<int> c19(*dzReader, "cand_evtID_ML");
-        TTreeReaderValue<int> c20(*dzReader, "cand_fileID_ML");
-
-        auto& dzBuilder = outputs.make<TableBuilder>(Output{"AOD", "DZEROFLAGGED"});
-        RootTableBuilderHelpers::convertTTree(dzBuilder, *dzReader,
-                                              c0, c1, c2, c3, c4, c5, c6, c7,
-                                              c8, c9, c10, c11, c12, c13, c14,
-                                              c15, c16, c17, c18, c19, c20);
+        sendTreeBulk(*infile, "fTreeDzeroFlagged",
+                     {"d_len_ML", "cand_type_ML", "cos_p_ML", "cos_p_xy_ML", "d_len_xy_ML", "eta_prong0_ML",
+                      "eta_prong1_ML", "imp_par_prong0_ML", "imp_par_prong1_ML", "imp_par_xy_ML", "inv_mass_ML",
+                      "max_norm_d0d0exp_ML", "norm_dl_xy_ML", "pt_cand_ML", "pt_prong0_ML", "pt_prong1_ML",
+                      "y_cand_ML", "phi_cand_ML", "eta_cand_ML", "cand_evtID_ML", "cand_fileID_ML"},
+                     "DZEROFLAGGED", outputs, pool.get());
       }
     });
   })};
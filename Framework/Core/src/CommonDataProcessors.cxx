@@ -26,12 +26,13 @@
 #include "Framework/Variant.h"
 #include "../../../Algorithm/include/Algorithm/HeaderStack.h"
 #include "Framework/OutputObjHeader.h"
+#include "DataDumpFile.h"
 
 #include "TFile.h"
 
+#include <algorithm>
 #include <chrono>
 #include <exception>
-#include <fstream>
 #include <functional>
 #include <memory>
 #include <string>
@@ -182,6 +183,9 @@ DataProcessorSpec
   auto writerFunction = [danglingOutputInputs](InitContext& ic) -> std::function<void(ProcessingContext&)> {
     auto filename = ic.options().get<std::string>("outfile");
     auto keepString = ic.options().get<std::string>("keep");
+    auto compression = ic.options().get<std::string>("compression");
+    auto blockSize = static_cast<size_t>(ic.options().get<int>("block-size")) * 1024 * 1024;
+    auto maxPendingBlocks = static_cast<size_t>(ic.options().get<int>("max-pending-blocks"));
 
     if (filename.empty()) {
       throw std::runtime_error("output file missing");
@@ -208,21 +212,24 @@ DataProcessorSpec
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
       });
     }
-    auto output = std::make_shared<std::ofstream>(filename.c_str(), std::ios_base::binary);
+    auto output = std::make_shared<DataDumpWriter>(filename, compression, blockSize, maxPendingBlocks);
+    // Blocks still in flight and the index are written when the data stops flowing.
+    auto closeOutput = [output]() {
+      output->close();
+      LOG(INFO) << "Wrote " << output->entries() << " entries to dump file";
+    };
+    auto& callbacks = ic.services().get<CallbackService>();
+    callbacks.set(CallbackService::Id::EndOfStream, [closeOutput](EndOfStreamContext&) { closeOutput(); });
+    callbacks.set(CallbackService::Id::Stop, closeOutput);
     return std::move([output, matcher = outputMatcher](ProcessingContext& pc) mutable -> void {
       VariableContext matchingContext;
-      LOG(INFO) << "processing data set with " << pc.inputs().size() << " entries";
       for (const auto& entry : pc.inputs()) {
-        LOG(INFO) << "  " << *(entry.spec);
         auto header = DataRefUtils::getHeader<header::DataHeader*>(entry);
         auto dataProcessingHeader = DataRefUtils::getHeader<DataProcessingHeader*>(entry);
         if (matcher->match(*header, matchingContext) == false) {
           continue;
         }
-        output->write(reinterpret_cast<char const*>(header), sizeof(header::DataHeader));
-        output->write(reinterpret_cast<char const*>(dataProcessingHeader), sizeof(DataProcessingHeader));
-        output->write(entry.payload, o2::framework::DataRefUtils::getPayloadSize(entry));
-        LOG(INFO) << "wrote data, size " << o2::framework::DataRefUtils::getPayloadSize(entry);
+        output->write(*header, *dataProcessingHeader, entry.payload, o2::framework::DataRefUtils::getPayloadSize(entry));
       }
     });
   };
@@ -247,7 +254,71 @@ DataProcessorSpec
     Outputs{},
     AlgorithmSpec(writerFunction),
     {{"outfile", VariantType::String, "dpl-out.bin", {"Name of the output file"}},
-     {"keep", VariantType::String, "", {"Comma separated list of ORIGIN/DESCRIPTION/SUBSPECIFICATION to save in outfile"}}}};
+     {"keep", VariantType::String, "", {"Comma separated list of ORIGIN/DESCRIPTION/SUBSPECIFICATION to save in outfile"}},
+     {"compression", VariantType::String, "none", {"Compression of the blocks written to outfile: none, lz4, zstd"}},
+     {"block-size", VariantType::Int, 64, {"Size in MB of the blocks written to outfile"}},
+     {"max-pending-blocks", VariantType::Int, 4, {"Number of blocks which can wait to be written before blocking the processing"}}}};
+
+  return spec;
+}
+
+DataProcessorSpec CommonDataProcessors::getGlobalFileSource(std::vector<OutputSpec> const& outputs, std::string const& filename)
+{
+  // The file is only opened by the device, so that the workflow can be
+  // defined (e.g. by the driver) even where the file is not available.
+  auto readerFunction = [outputs](InitContext& ic) -> std::function<void(ProcessingContext&)> {
+    auto reader = std::make_shared<DataDumpReader>(ic.options().get<std::string>("infile"));
+    auto startTimeslice = static_cast<uint64_t>(ic.options().get<int64_t>("start-timeslice"));
+    auto maxTimeslices = ic.options().get<int>("max-timeslices");
+    auto rate = ic.options().get<float>("rate");
+
+    for (auto& entry : reader->index()) {
+      auto matches = [&entry](OutputSpec const& output) {
+        return DataSpecUtils::match(output, ConcreteDataMatcher{entry.origin, entry.description, entry.subSpec});
+      };
+      if (std::none_of(outputs.begin(), outputs.end(), matches)) {
+        throw std::runtime_error("Message " + entry.origin.as<std::string>() + "/" + entry.description.as<std::string>() + "/" +
+                                 std::to_string(entry.subSpec) + " in the dump file does not match any of the outputs");
+      }
+    }
+
+    auto allTimeslices = reader->timeslices();
+    auto timeslices = std::make_shared<std::vector<uint64_t>>(std::lower_bound(allTimeslices.begin(), allTimeslices.end(), startTimeslice), allTimeslices.end());
+    if (maxTimeslices >= 0 && timeslices->size() > static_cast<size_t>(maxTimeslices)) {
+      timeslices->resize(maxTimeslices);
+    }
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(rate > 0 ? 1. / rate : 0.));
+    auto next = std::make_shared<std::chrono::steady_clock::time_point>(std::chrono::steady_clock::now());
+    auto current = std::make_shared<size_t>(0);
+
+    return [reader, timeslices, period, next, current](ProcessingContext& pc) {
+      auto& control = pc.services().get<ControlService>();
+      if (*current >= timeslices->size()) {
+        LOG(INFO) << "All the timeslices in the dump file were replayed";
+        control.endOfStream();
+        control.readyToQuit(QuitRequest::Me);
+        return;
+      }
+      std::this_thread::sleep_until(*next);
+      *next += period;
+      for (auto& indexEntry : reader->entries((*timeslices)[(*current)++])) {
+        // Messages are sent with the DataHeader they were dumped with.
+        auto entry = reader->read(indexEntry);
+        entry.header.payloadSize = entry.payloadSize;
+        pc.outputs().snapshot(entry.header, entry.payload);
+      }
+    };
+  };
+
+  DataProcessorSpec spec{
+    "internal-dpl-global-binary-file-source",
+    Inputs{},
+    outputs,
+    AlgorithmSpec(readerFunction),
+    {{"infile", VariantType::String, filename, {"Name of the dump file to replay"}},
+     {"start-timeslice", VariantType::Int64, int64_t{0}, {"First dumped timeslice to replay"}},
+     {"max-timeslices", VariantType::Int, -1, {"Maximum number of timeslices to replay, -1 for all"}},
+     {"rate", VariantType::Float, 0.f, {"Timeslices replayed per second, 0 for as fast as possible"}}}};
 
   return spec;
 }
@@ -36,10 +36,12 @@ using DataProcessingHeader = o2::framework::DataProcessingHeader;
 
 DataAllocator::DataAllocator(TimingInfo* timingInfo,
                              ContextRegistry* contextRegistry,
-                             const AllowedOutputRoutes& routes)
+                             const AllowedOutputRoutes& routes,
+                             TimePipelineDispatcher* dispatcher)
   : mAllowedOutputRoutes{routes},
     mTimingInfo{timingInfo},
-    mContextRegistry{contextRegistry}
+    mContextRegistry{contextRegistry},
+    mTimePipelineDispatcher{dispatcher}
 {
 }
 
@@ -47,7 +49,14 @@ std::string DataAllocator::matchDataHeader(const Output& spec, size_t timeslice)
 {
   // FIXME: we should take timeframeId into account as well.
   for (auto& output : mAllowedOutputRoutes) {
-    if (DataSpecUtils::match(output.matcher, spec.origin, spec.description, spec.subSpec) && ((timeslice % output.maxTimeslices) == output.timeslice)) {
+    if (DataSpecUtils::match(output.matcher, spec.origin, spec.description, spec.subSpec) == false) {
+      continue;
+    }
+    size_t replica = timeslice % output.maxTimeslices;
+    if (output.dispatch == TimePipelineDispatch::LeastLoaded && mTimePipelineDispatcher) {
+      replica = mTimePipelineDispatcher->replicaFor(output.consumer, output.maxTimeslices, timeslice);
+    }
+    if (replica == output.timeslice) {
       return output.channel;
     }
   }
@@ -107,10 +116,20 @@ FairMQMessagePtr DataAllocator::headerMessageFromOutput(Output const& spec,
   return o2::pmr::getMessage(o2::header::Stack{channelAlloc, dh, dph, spec.metaHeader});
 }
 
+FairMQMessagePtr DataAllocator::createPayloadMessage(std::string const& channel, size_t size)
+{
+  return mContextRegistry->get<MessageContext>()->createMessage(channel, 0, size);
+}
+
 void DataAllocator::addPartToContext(FairMQMessagePtr&& payloadMessage, const Output& spec,
                                      o2::header::SerializationMethod serializationMethod)
 {
-  std::string channel = matchDataHeader(spec, mTimingInfo->timeslice);
+  addPartToContext(std::move(payloadMessage), spec, matchDataHeader(spec, mTimingInfo->timeslice), serializationMethod);
+}
+
+void DataAllocator::addPartToContext(FairMQMessagePtr&& payloadMessage, const Output& spec, std::string const& channel,
+                                     o2::header::SerializationMethod serializationMethod)
+{
   // the correct payload size is st later when sending the
   // RootObjectContext, see DataProcessor::doSend
   auto headerMessage = headerMessageFromOutput(spec, channel, serializationMethod, 0);
@@ -181,11 +200,30 @@ void DataAllocator::adopt(const Output& spec, TableBuilder* tb)
 void DataAllocator::snapshot(const Output& spec, const char* payload, size_t payloadSize,
                              o2::header::SerializationMethod serializationMethod)
 {
-  auto proxy = mContextRegistry->get<MessageContext>()->proxy();
-  FairMQMessagePtr payloadMessage(proxy.createMessage(payloadSize));
+  std::string channel = matchDataHeader(spec, mTimingInfo->timeslice);
+  FairMQMessagePtr payloadMessage = createPayloadMessage(channel, payloadSize);
   memcpy(payloadMessage->GetData(), payload, payloadSize);
 
-  addPartToContext(std::move(payloadMessage), spec, serializationMethod);
+  addPartToContext(std::move(payloadMessage), spec, channel, serializationMethod);
+}
+
+void DataAllocator::snapshot(DataHeader const& header, const char* payload)
+{
+  Output spec{header.dataOrigin, header.dataDescription, header.subSpecification};
+  std::string channel = matchDataHeader(spec, mTimingInfo->timeslice);
+  auto context = mContextRegistry->get<MessageContext>();
+
+  DataProcessingHeader dph{mTimingInfo->timeslice, 1};
+  auto channelAlloc = o2::pmr::getTransportAllocator(context->proxy().getTransport(channel, 0));
+  auto headerMessage = o2::pmr::getMessage(o2::header::Stack{channelAlloc, header, dph});
+  auto& object = context->add<MessageContext::TrivialObject>(std::move(headerMessage), channel, 0, header.payloadSize);
+  memcpy(object.data(), payload, header.payloadSize);
+}
+
+void DataAllocator::adoptMessage(const Output& spec, FairMQMessagePtr&& payload,
+                                 o2::header::SerializationMethod serializationMethod)
+{
+  addPartToContext(std::move(payload), spec, serializationMethod);
 }
 
 void DataAllocator::create(const Output& spec,
@@ -195,6 +195,11 @@ bool DataDescriptorMatcher::match(header::Stack const& stack, VariableContext& c
 // actual polymorphic matcher which is able to cast the pointer to the correct
 // kind of header.
 bool DataDescriptorMatcher::match(char const* d, VariableContext& context) const
+{
+  return this->match(d, HeaderStackIndex::parse(d), context);
+}
+
+bool DataDescriptorMatcher::match(char const* d, HeaderStackIndex const& index, VariableContext& context) const
 {
   bool leftValue = false, rightValue = false;
 
@@ -224,29 +229,29 @@ bool DataDescriptorMatcher::match(char const* d, VariableContext& context) const
   // }
   //  When we drop support for macOS 10.13
   if (auto pval0 = std::get_if<OriginValueMatcher>(&mLeft)) {
-    auto dh = o2::header::get<header::DataHeader*>(d);
+    auto dh = index.get<header::DataHeader>(d);
     if (dh == nullptr) {
       throw std::runtime_error("Cannot find DataHeader");
     }
     leftValue = pval0->match(*dh, context);
   } else if (auto pval1 = std::get_if<DescriptionValueMatcher>(&mLeft)) {
-    auto dh = o2::header::get<header::DataHeader*>(d);
+    auto dh = index.get<header::DataHeader>(d);
     if (dh == nullptr) {
       throw std::runtime_error("Cannot find DataHeader");
     }
     leftValue = pval1->match(*dh, context);
   } else if (auto pval2 = std::get_if<SubSpecificationTypeValueMatcher>(&mLeft)) {
-    auto dh = o2::header::get<header::DataHeader*>(d);
+    auto dh = index.get<header::DataHeader>(d);
     if (dh == nullptr) {
       throw std::runtime_error("Cannot find DataHeader");
     }
     leftValue = pval2->match(*dh, context);
   } else if (auto pval3 = std::get_if<std::unique_ptr<DataDescriptorMatcher>>(&mLeft)) {
-    leftValue = (*pval3)->match(d, context);
+    leftValue = (*pval3)->match(d, index, context);
   } else if (auto pval4 = std::get_if<ConstantValueMatcher>(&mLeft)) {
     leftValue = pval4->match();
   } else if (auto pval5 = std::get_if<StartTimeValueMatcher>(&mLeft)) {
-    auto dph = o2::header::get<DataProcessingHeader*>(d);
+    auto dph = index.get<DataProcessingHeader>(d);
     if (dph == nullptr) {
       throw std::runtime_error("Cannot find DataProcessingHeader");
     }
@@ -266,20 +271,20 @@ bool DataDescriptorMatcher::match(char const* d, VariableContext& context) const
   }
 
   if (auto pval0 = std::get_if<OriginValueMatcher>(&mRight)) {
-    auto dh = o2::header::get<header::DataHeader*>(d);
+    auto dh = index.get<header::DataHeader>(d);
     rightValue = pval0->match(*dh, context);
   } else if (auto pval1 = std::get_if<DescriptionValueMatcher>(&mRight)) {
-    auto dh = o2::header::get<header::DataHeader*>(d);
+    auto dh = index.get<header::DataHeader>(d);
     rightValue = pval1->match(*dh, context);
   } else if (auto pval2 = std::get_if<SubSpecificationTypeValueMatcher>(&mRight)) {
-    auto dh = o2::header::get<header::DataHeader*>(d);
+    auto dh = index.get<header::DataHeader>(d);
     rightValue = pval2->match(*dh, context);
   } else if (auto pval3 = std::get_if<std::unique_ptr<DataDescriptorMatcher>>(&mRight)) {
-    rightValue = (*pval3)->match(d, context);
+    rightValue = (*pval3)->match(d, index, context);
   } else if (auto pval4 = std::get_if<ConstantValueMatcher>(&mRight)) {
     rightValue = pval4->match();
   } else if (auto pval5 = std::get_if<StartTimeValueMatcher>(&mRight)) {
-    auto dph = o2::header::get<DataProcessingHeader*>(d);
+    auto dph = index.get<DataProcessingHeader>(d);
     rightValue = pval5->match(*dph, context);
   }
   // There are cases in which not having a rightValue might be legitimate,
@@ -0,0 +1,310 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "DataDumpFile.h"
+#include "Framework/Logger.h"
+
+#include <arrow/status.h>
+#include <arrow/util/compression.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace o2::framework
+{
+
+namespace
+{
+constexpr size_t BLOCK_ALIGNMENT = 4096;
+
+constexpr std::pair<char const*, arrow::Compression::type> Codecs[] = {
+  {"none", arrow::Compression::UNCOMPRESSED},
+  {"lz4", arrow::Compression::LZ4},
+  {"zstd", arrow::Compression::ZSTD},
+  {"gzip", arrow::Compression::GZIP},
+  {"snappy", arrow::Compression::SNAPPY},
+  {"brotli", arrow::Compression::BROTLI}};
+
+std::unique_ptr<arrow::util::Codec> createCodec(arrow::Compression::type type)
+{
+  std::unique_ptr<arrow::util::Codec> codec;
+  if (type == arrow::Compression::UNCOMPRESSED) {
+    return codec;
+  }
+  auto status = arrow::util::Codec::Create(type, &codec);
+  if (status.ok() == false) {
+    throw std::runtime_error("Unable to create codec: " + status.message());
+  }
+  return codec;
+}
+
+AlignedBuffer allocateAligned(size_t size)
+{
+  auto ptr = static_cast<char*>(std::aligned_alloc(BLOCK_ALIGNMENT, size));
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return AlignedBuffer{ptr};
+}
+} // namespace
+
+DataDumpWriter::DataDumpWriter(std::string const& filename, std::string const& compression,
+                               size_t blockSize, size_t maxPendingBlocks)
+  : mFile{filename, std::ios_base::binary},
+    mBlockSize{blockSize},
+    mMaxPendingBlocks{std::max<size_t>(maxPendingBlocks, 1)}
+{
+  if (!mFile) {
+    throw std::runtime_error("Unable to open " + filename + " for writing");
+  }
+  auto codec = std::find_if(std::begin(Codecs), std::end(Codecs), [&compression](auto& c) { return compression == c.first; });
+  if (codec == std::end(Codecs)) {
+    throw std::runtime_error("Unknown compression " + compression);
+  }
+  mCodecType = codec->second;
+  mCodec = createCodec(codec->second);
+  mCurrent = getBlock(mBlockSize);
+  mThread = std::thread{[this]() { this->run(); }};
+}
+
+DataDumpWriter::~DataDumpWriter()
+{
+  try {
+    close();
+  } catch (std::exception& e) {
+    LOG(ERROR) << "Error while closing dump file: " << e.what();
+  }
+}
+
+DataDumpWriter::Block DataDumpWriter::getBlock(size_t minSize)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto free = std::find_if(mFree.begin(), mFree.end(), [minSize](Block const& b) { return b.capacity >= minSize; });
+    if (free != mFree.end()) {
+      Block block = std::move(*free);
+      mFree.erase(free);
+      block.size = 0;
+      return block;
+    }
+  }
+  Block block;
+  // Entries bigger than a block get a block of their own.
+  block.capacity = (std::max(minSize, mBlockSize) + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT * BLOCK_ALIGNMENT;
+  block.data = allocateAligned(block.capacity);
+  return block;
+}
+
+void DataDumpWriter::submitBlock()
+{
+  if (mCurrent.size == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mMutex);
+  // Back pressure only kicks in when the disk cannot keep up for longer
+  // than mMaxPendingBlocks blocks.
+  mBlockWritten.wait(lock, [this]() { return mPending.size() < mMaxPendingBlocks || mFailed; });
+  mPending.emplace_back(std::move(mCurrent));
+  mSubmittedBlocks++;
+  lock.unlock();
+  mBlockAvailable.notify_one();
+}
+
+void DataDumpWriter::write(header::DataHeader const& dh, DataProcessingHeader const& dph, char const* payload, size_t payloadSize)
+{
+  if (mClosed) {
+    throw std::runtime_error("Writing to a closed dump file");
+  }
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mFailed) {
+      throw std::runtime_error("Unable to write dump file");
+    }
+  }
+  size_t entrySize = sizeof(header::DataHeader) + sizeof(DataProcessingHeader) + payloadSize;
+  if (mCurrent.size + entrySize > mCurrent.capacity) {
+    submitBlock();
+    mCurrent = getBlock(entrySize);
+  }
+  mIndex.push_back(DataDumpIndexEntry{dph.startTime, dh.dataOrigin, dh.dataDescription, dh.subSpecification,
+                                      mSubmittedBlocks, mCurrent.size, entrySize});
+  char* target = mCurrent.data.get() + mCurrent.size;
+  std::memcpy(target, &dh, sizeof(header::DataHeader));
+  target += sizeof(header::DataHeader);
+  std::memcpy(target, &dph, sizeof(DataProcessingHeader));
+  target += sizeof(DataProcessingHeader);
+  std::memcpy(target, payload, payloadSize);
+  mCurrent.size += entrySize;
+}
+
+void DataDumpWriter::run()
+{
+  std::vector<uint8_t> compressed;
+  uint64_t position = 0;
+  while (true) {
+    Block block;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mBlockAvailable.wait(lock, [this]() { return mStopping || mPending.empty() == false; });
+      if (mPending.empty()) {
+        return;
+      }
+      block = std::move(mPending.front());
+      mPending.pop_front();
+    }
+    DataDumpBlockHeader header;
+    header.codec = mCodecType;
+    header.uncompressedSize = block.size;
+    char const* data = block.data.get();
+    header.compressedSize = block.size;
+    if (mCodec) {
+      auto input = reinterpret_cast<uint8_t const*>(block.data.get());
+      compressed.resize(mCodec->MaxCompressedLen(block.size, input));
+      int64_t compressedSize = 0;
+      auto status = mCodec->Compress(block.size, input, compressed.size(), compressed.data(), &compressedSize);
+      if (status.ok() == false) {
+        LOG(WARNING) << "Unable to compress block, writing it uncompressed: " << status.message();
+        header.codec = arrow::Compression::UNCOMPRESSED;
+      } else {
+        header.compressedSize = compressedSize;
+        data = reinterpret_cast<char const*>(compressed.data());
+      }
+    }
+    mFile.write(reinterpret_cast<char const*>(&header), sizeof(header));
+    mFile.write(data, header.compressedSize);
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!mFile) {
+        LOG(ERROR) << "Unable to write block to dump file";
+        mFailed = true;
+      }
+      mBlockOffsets.push_back(position);
+      mFree.emplace_back(std::move(block));
+    }
+    position += sizeof(header) + header.compressedSize;
+    mBlockWritten.notify_all();
+  }
+}
+
+void DataDumpWriter::close()
+{
+  if (mClosed) {
+    return;
+  }
+  mClosed = true;
+  submitBlock();
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mBlockAvailable.notify_one();
+  mThread.join();
+  // The I/O thread is gone, now we know where each block ended up.
+  DataDumpTrailer trailer;
+  trailer.indexOffset = mFile.tellp();
+  trailer.entries = mIndex.size();
+  for (auto& entry : mIndex) {
+    entry.blockOffset = mBlockOffsets.at(entry.blockOffset);
+  }
+  mFile.write(reinterpret_cast<char const*>(mIndex.data()), mIndex.size() * sizeof(DataDumpIndexEntry));
+  mFile.write(reinterpret_cast<char const*>(&trailer), sizeof(trailer));
+  mFile.close();
+  if (mFailed || !mFile) {
+    throw std::runtime_error("Unable to write dump file");
+  }
+}
+
+DataDumpReader::DataDumpReader(std::string const& filename)
+  : mFile{filename, std::ios_base::binary}
+{
+  if (!mFile) {
+    throw std::runtime_error("Unable to open " + filename);
+  }
+  DataDumpTrailer trailer;
+  mFile.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios_base::end);
+  mFile.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+  if (!mFile || trailer.magic != DataDumpTrailer::sMagic || trailer.version != DataDumpTrailer::sVersion) {
+    throw std::runtime_error(filename + " is not an indexed dump file");
+  }
+  mIndex.resize(trailer.entries);
+  mFile.seekg(trailer.indexOffset);
+  mFile.read(reinterpret_cast<char*>(mIndex.data()), mIndex.size() * sizeof(DataDumpIndexEntry));
+  if (!mFile) {
+    throw std::runtime_error("Unable to read the index of " + filename);
+  }
+  mSorted = mIndex;
+  std::stable_sort(mSorted.begin(), mSorted.end(), [](auto& a, auto& b) { return a.timeslice < b.timeslice; });
+}
+
+DataDumpReader::~DataDumpReader() = default;
+
+std::vector<uint64_t> DataDumpReader::timeslices() const
+{
+  std::vector<uint64_t> result;
+  for (auto& entry : mSorted) {
+    if (result.empty() || result.back() != entry.timeslice) {
+      result.push_back(entry.timeslice);
+    }
+  }
+  return result;
+}
+
+std::vector<DataDumpIndexEntry> DataDumpReader::entries(uint64_t timeslice) const
+{
+  auto [begin, end] = std::equal_range(mSorted.begin(), mSorted.end(), DataDumpIndexEntry{timeslice},
+                                      [](auto& a, auto& b) { return a.timeslice < b.timeslice; });
+  return {begin, end};
+}
+
+DataDumpEntry DataDumpReader::read(DataDumpIndexEntry const& entry)
+{
+  if (entry.blockOffset != mBlockOffset) {
+    DataDumpBlockHeader header;
+    mFile.seekg(entry.blockOffset);
+    mFile.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!mFile || header.magic != DataDumpBlockHeader::sMagic) {
+      throw std::runtime_error("Corrupted block at offset " + std::to_string(entry.blockOffset));
+    }
+    mBlock.resize(header.uncompressedSize);
+    if (header.codec == arrow::Compression::UNCOMPRESSED) {
+      mFile.read(mBlock.data(), header.uncompressedSize);
+    } else {
+      if (mCodec.get() == nullptr || mCodecType != header.codec) {
+        mCodec = createCodec(static_cast<arrow::Compression::type>(header.codec));
+        mCodecType = header.codec;
+      }
+      mCompressed.resize(header.compressedSize);
+      mFile.read(mCompressed.data(), header.compressedSize);
+      auto status = mCodec->Decompress(header.compressedSize, reinterpret_cast<uint8_t const*>(mCompressed.data()),
+                                       header.uncompressedSize, reinterpret_cast<uint8_t*>(mBlock.data()));
+      if (status.ok() == false) {
+        throw std::runtime_error("Unable to decompress block: " + status.message());
+      }
+    }
+    if (!mFile) {
+      throw std::runtime_error("Unable to read block at offset " + std::to_string(entry.blockOffset));
+    }
+    mBlockOffset = entry.blockOffset;
+  }
+  if (entry.offset + entry.size > mBlock.size()) {
+    throw std::runtime_error("Entry outside of its block");
+  }
+  DataDumpEntry result;
+  char const* source = mBlock.data() + entry.offset;
+  std::memcpy(&result.header, source, sizeof(header::DataHeader));
+  source += sizeof(header::DataHeader);
+  std::memcpy(&result.processingHeader, source, sizeof(DataProcessingHeader));
+  source += sizeof(DataProcessingHeader);
+  result.payload = source;
+  result.payloadSize = entry.size - sizeof(header::DataHeader) - sizeof(DataProcessingHeader);
+  return result;
+}
+
+} // namespace o2::framework
@@ -0,0 +1,188 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#ifndef O2_FRAMEWORK_DATADUMPFILE_H_
+#define O2_FRAMEWORK_DATADUMPFILE_H_
+
+#include "Framework/DataProcessingHeader.h"
+#include "Headers/DataHeader.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace arrow::util
+{
+class Codec;
+}
+
+namespace o2::framework
+{
+
+/// Binary layout of the files written by the global file sink:
+///
+///   [DataDumpBlockHeader, block]* [DataDumpIndexEntry]* DataDumpTrailer
+///
+/// Each block, once decompressed, contains a sequence of entries, each one
+/// made of a DataHeader, a DataProcessingHeader and the payload. The trailer
+/// points to the index, which allows locating any entry without scanning
+/// the whole file.
+struct DataDumpBlockHeader {
+  static constexpr uint32_t sMagic = 0x4b4c4244; // "DBLK"
+  uint32_t magic = sMagic;
+  /// arrow::Compression::type of the block
+  uint32_t codec = 0;
+  uint64_t compressedSize = 0;
+  uint64_t uncompressedSize = 0;
+};
+
+struct DataDumpIndexEntry {
+  /// The DataProcessingHeader::startTime of the entry
+  uint64_t timeslice;
+  header::DataOrigin origin;
+  header::DataDescription description;
+  header::DataHeader::SubSpecificationType subSpec;
+  /// Offset of the block header in the file
+  uint64_t blockOffset;
+  /// Offset of the entry in the uncompressed block
+  uint64_t offset;
+  /// Size of the entry, headers included
+  uint64_t size;
+};
+
+struct DataDumpTrailer {
+  static constexpr uint32_t sMagic = 0x58444e49; // "INDX"
+  static constexpr uint32_t sVersion = 1;
+  uint32_t magic = sMagic;
+  uint32_t version = sVersion;
+  uint64_t indexOffset = 0;
+  uint64_t entries = 0;
+};
+
+/// Buffers allocated with a given alignment, so that they can be handed
+/// as they are to the I/O layer.
+struct AlignedDeleter {
+  void operator()(char* ptr) const { std::free(ptr); }
+};
+using AlignedBuffer = std::unique_ptr<char[], AlignedDeleter>;
+
+/// Write behind dumper of messages. Entries are accumulated in large
+/// aligned blocks, which are (optionally) compressed and written to disk
+/// by a dedicated I/O thread, so that the caller only blocks if more than
+/// @a maxPendingBlocks are waiting to be written.
+class DataDumpWriter
+{
+ public:
+  /// @a compression is one of none, lz4, zstd (or any other codec supported
+  /// by the arrow build in use).
+  DataDumpWriter(std::string const& filename, std::string const& compression,
+                 size_t blockSize = 64 * 1024 * 1024, size_t maxPendingBlocks = 4);
+  ~DataDumpWriter();
+
+  DataDumpWriter(DataDumpWriter const&) = delete;
+  DataDumpWriter& operator=(DataDumpWriter const&) = delete;
+
+  /// Append an entry to the current block.
+  /// @throws std::runtime_error in case the I/O thread failed.
+  void write(header::DataHeader const& dh, DataProcessingHeader const& dph, char const* payload, size_t payloadSize);
+
+  /// Flush all the pending blocks and write the index. Safe to call more
+  /// than once.
+  void close();
+
+  /// @return the number of entries written so far.
+  size_t entries() const { return mIndex.size(); }
+
+ private:
+  struct Block {
+    AlignedBuffer data;
+    size_t capacity = 0;
+    size_t size = 0;
+  };
+
+  Block getBlock(size_t minSize);
+  void submitBlock();
+  void run();
+
+  std::ofstream mFile;
+  std::unique_ptr<arrow::util::Codec> mCodec;
+  uint32_t mCodecType = 0;
+  size_t mBlockSize;
+  size_t mMaxPendingBlocks;
+  bool mClosed = false;
+
+  Block mCurrent;
+  /// Index entries, with blockOffset holding the block number until
+  /// the block has actually been written.
+  std::vector<DataDumpIndexEntry> mIndex;
+  size_t mSubmittedBlocks = 0;
+
+  std::thread mThread;
+  std::mutex mMutex;
+  std::condition_variable mBlockAvailable;
+  std::condition_variable mBlockWritten;
+  std::deque<Block> mPending;
+  std::vector<Block> mFree;
+  std::vector<uint64_t> mBlockOffsets;
+  bool mStopping = false;
+  bool mFailed = false;
+};
+
+/// An entry read back from a file. The payload remains valid until the
+/// next read.
+struct DataDumpEntry {
+  header::DataHeader header;
+  DataProcessingHeader processingHeader;
+  char const* payload = nullptr;
+  size_t payloadSize = 0;
+};
+
+/// Random access reader for the files written by DataDumpWriter.
+class DataDumpReader
+{
+ public:
+  /// @throws std::runtime_error if the file cannot be opened or has no index.
+  explicit DataDumpReader(std::string const& filename);
+  ~DataDumpReader();
+
+  /// @return all the entries in the file, in the order they were written.
+  std::vector<DataDumpIndexEntry> const& index() const { return mIndex; }
+
+  /// @return the distinct timeslices in the file, sorted.
+  std::vector<uint64_t> timeslices() const;
+
+  /// @return the index entries belonging to @a timeslice.
+  std::vector<DataDumpIndexEntry> entries(uint64_t timeslice) const;
+
+  /// Read the entry described by @a entry. Consecutive reads from the same
+  /// block only decompress it once.
+  DataDumpEntry read(DataDumpIndexEntry const& entry);
+
+ private:
+  std::ifstream mFile;
+  std::unique_ptr<arrow::util::Codec> mCodec;
+  uint32_t mCodecType = 0;
+  std::vector<DataDumpIndexEntry> mIndex;
+  /// The index, sorted by timeslice
+  std::vector<DataDumpIndexEntry> mSorted;
+  std::vector<char> mCompressed;
+  std::vector<char> mBlock;
+  uint64_t mBlockOffset = -1;
+};
+
+} // namespace o2::framework
+
+#endif // O2_FRAMEWORK_DATADUMPFILE_H_
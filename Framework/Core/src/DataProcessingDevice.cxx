@@ -17,6 +17,7 @@
 #include "Framework/EndOfStreamContext.h"
 #include "Framework/FairOptionsRetriever.h"
 #include "Framework/FairMQDeviceProxy.h"
+#include "Framework/HeaderStackIndex.h"
 #include "Framework/CallbackService.h"
 #include "Framework/TMessageSerializer.h"
 #include "Framework/InputRecord.h"
@@ -36,6 +37,9 @@
 #include <TMessage.h>
 #include <TClonesArray.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <vector>
 #include <memory>
 
@@ -54,6 +58,15 @@ namespace o2
 namespace framework
 {
 
+namespace
+{
+uint64_t getCurrentTimeUs()
+{
+  auto now = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+}
+} // namespace
+
 DataProcessingDevice::DataProcessingDevice(DeviceSpec const& spec, ServiceRegistry& registry, DeviceState& state)
   : mSpec{spec},
     mState{state},
@@ -68,7 +81,7 @@ DataProcessingDevice::DataProcessingDevice(DeviceSpec const& spec, ServiceRegist
     mDataFrameContext{FairMQDeviceProxy{this}},
     mRawBufferContext{FairMQDeviceProxy{this}},
     mContextRegistry{&mFairMQContext, &mRootContext, &mStringContext, &mDataFrameContext, &mRawBufferContext},
-    mAllocator{&mTimingInfo, &mContextRegistry, spec.outputs},
+    mAllocator{&mTimingInfo, &mContextRegistry, spec.outputs, &mTimePipelineDispatcher},
     mRelayer{spec.completionPolicy,
              spec.inputs,
              registry.get<Monitoring>(),
@@ -79,6 +92,7 @@ DataProcessingDevice::DataProcessingDevice(DeviceSpec const& spec, ServiceRegist
 {
   StateMonitoring<DataProcessingStatus>::start();
   auto dispatcher = [this](FairMQParts&& parts, std::string const& channel, unsigned int index) {
+    std::lock_guard<std::mutex> lock(mSendMutex);
     DataProcessor::doSend(*this, std::move(parts), channel.c_str(), index);
   };
 
@@ -87,6 +101,25 @@ DataProcessingDevice::DataProcessingDevice(DeviceSpec const& spec, ServiceRegist
   }
 }
 
+DataProcessingDevice::WorkerContext::WorkerContext(DataProcessingDevice* device, DeviceSpec const& spec)
+  : fairMQContext{FairMQDeviceProxy{device}},
+    rootContext{FairMQDeviceProxy{device}},
+    stringContext{FairMQDeviceProxy{device}},
+    dataFrameContext{FairMQDeviceProxy{device}},
+    rawBufferContext{FairMQDeviceProxy{device}},
+    contextRegistry{&fairMQContext, &rootContext, &stringContext, &dataFrameContext, &rawBufferContext},
+    allocator{&timingInfo, &contextRegistry, spec.outputs, &device->mTimePipelineDispatcher}
+{
+  auto dispatcher = [device](FairMQParts&& parts, std::string const& channel, unsigned int index) {
+    std::lock_guard<std::mutex> lock(device->mSendMutex);
+    DataProcessor::doSend(*device, std::move(parts), channel.c_str(), index);
+  };
+
+  if (spec.dispatchPolicy.action == DispatchPolicy::DispatchOp::WhenReady) {
+    fairMQContext.init(dispatcher);
+  }
+}
+
 /// This  takes care  of initialising  the device  from its  specification. In
 /// particular it needs to:
 ///
@@ -94,6 +127,11 @@ DataProcessingDevice::DataProcessingDevice(DeviceSpec const& spec, ServiceRegist
 /// * Materialize the correct callbacks for expiring records. We need to do it
 ///   here because the configuration is available only at this point.
 /// * Invoke the actual init callback, which returns the processing callback.
+/// * Create the worker threads, if requested via --worker-threads.
+/// * Enable the runtime tuning of the relayer pipeline length, if
+///   requested via --max-pipeline-length.
+/// * Find out which timers we need to wake up for, if --polling-timeout
+///   allows the device to sleep while waiting for inputs.
 void DataProcessingDevice::Init()
 {
   // For some reason passing rateLogging does not work anymore.
@@ -127,8 +165,37 @@ void DataProcessingDevice::Init()
     mExpirationHandlers.emplace_back(std::move(handler));
   }
 
+  // Timers and enumerations do not come from any channel, so when we are
+  // allowed to sleep waiting for data we still need to wake up in time
+  // for them to be created by processDanglingInputs.
+  mPollingTimeout = GetConfig()->Count("polling-timeout") ? GetConfig()->GetValue<int>("polling-timeout") : 0;
+  mHasEnumerations = false;
+  mTimerDeadlines.clear();
+  auto startTime = getCurrentTimeUs();
+  for (auto& di : distinct) {
+    auto& route = mSpec.inputs[di];
+    if (route.matcher.lifetime == Lifetime::Enumeration) {
+      mHasEnumerations = true;
+    } else if (route.matcher.lifetime == Lifetime::Timer) {
+      auto period = mConfigRegistry->get<int>((std::string{"period-"} + route.matcher.binding).c_str());
+      mTimerDeadlines.push_back(TimerDeadline{(uint64_t)period, startTime + period});
+    }
+  }
+
+  int maxPipelineLength = GetConfig()->Count("max-pipeline-length") ? GetConfig()->GetValue<int>("max-pipeline-length") : 0;
+  size_t maxPipelineBytes = GetConfig()->Count("max-pipeline-bytes") ? GetConfig()->GetValue<size_t>("max-pipeline-bytes") : 0;
+  if (maxPipelineLength > 0) {
+    LOG(INFO) << "Tuning pipeline length at runtime, up to " << maxPipelineLength << " slots";
+    mRelayer.setAdaptivePipelineLength(maxPipelineLength, maxPipelineBytes);
+  }
+
+  // We want all the metrics of a given interval to go out in a single
+  // flush, so the buffer needs to be able to hold the state of every
+  // relayer slot (both from the device and from the relayer itself) and
+  // of its variables, on top of the usual metrics.
   auto& monitoring = mServiceRegistry.get<Monitoring>();
-  monitoring.enableBuffering(MONITORING_QUEUE_SIZE);
+  size_t maxSlots = std::max(mRelayer.getParallelTimeslices(), (size_t)std::max(maxPipelineLength, 0));
+  monitoring.enableBuffering(MONITORING_QUEUE_SIZE + maxSlots * (2 * mSpec.inputs.size() + data_matcher::MAX_MATCHING_VARIABLE));
   static const std::string dataProcessorIdMetric = "dataprocessor_id";
   static const std::string dataProcessorIdValue = mSpec.name;
   monitoring.addGlobalTag("dataprocessor_id", dataProcessorIdValue);
@@ -149,13 +216,96 @@ void DataProcessingDevice::Init()
       mState.inputChannelInfos[ci].state = InputChannelState::Pull;
     }
   }
+
+  /// When requested, the processing of independent timeslices is done by a
+  /// pool of workers, each one with its own set of output contextes.
+  /// Receiving and relaying stays on the main thread, so that ordering
+  /// per channel is preserved.
+  int workerThreads = GetConfig()->Count("worker-threads") ? GetConfig()->GetValue<int>("worker-threads") : 0;
+  mWorkerPool.reset();
+  mWorkerContexts.clear();
+  if (workerThreads > 0) {
+    LOG(INFO) << "Processing timeslices with " << workerThreads << " worker threads";
+    for (int wi = 0; wi < workerThreads; ++wi) {
+      mWorkerContexts.emplace_back(std::make_unique<WorkerContext>(this, mSpec));
+    }
+    mWorkerPool = std::make_unique<ThreadPool>(workerThreads);
+  }
+
+  /// Output messages can be recycled, rather than allocated from scratch
+  /// for every timeslice, if --message-pool-size is given. All the
+  /// contextes share the same pools. Pools are never dropped, as messages
+  /// from them might still be in flight.
+  size_t messagePoolSize = GetConfig()->Count("message-pool-size") ? GetConfig()->GetValue<size_t>("message-pool-size") : 0;
+  if (messagePoolSize > 0 && mMessagePools.get() == nullptr) {
+    LOG(INFO) << "Recycling output messages from a " << messagePoolSize << " bytes region per channel";
+    mMessagePools = std::make_unique<MessagePools>(messagePoolSize);
+  }
+  MessagePools* pools = messagePoolSize > 0 ? mMessagePools.get() : nullptr;
+  mFairMQContext.setMessagePools(pools);
+  for (auto& worker : mWorkerContexts) {
+    worker->fairMQContext.setMessagePools(pools);
+  }
+
+  mCreditChannels.clear();
+  for (auto& route : mSpec.outputs) {
+    if (route.creditChannel.empty()) {
+      continue;
+    }
+    std::pair<std::string, std::string> credit{route.creditChannel, route.consumer};
+    if (std::find(mCreditChannels.begin(), mCreditChannels.end(), credit) == mCreditChannels.end()) {
+      mCreditChannels.push_back(credit);
+    }
+  }
 }
 
-void DataProcessingDevice::PreRun() { mServiceRegistry.get<CallbackService>()(CallbackService::Id::Start); }
+void DataProcessingDevice::PreRun()
+{
+  // Channels are only ready at this point, so this is where we can
+  // create the poller over them. Channels which are not expected to ever
+  // receive data (e.g. the clock) are excluded. Credits from the time
+  // pipelines we feed need to wake us up as well.
+  mInputPoller.reset();
+  if (mPollingTimeout > 0) {
+    std::vector<std::string> polledChannels;
+    for (size_t ci = 0; ci < mSpec.inputChannels.size(); ++ci) {
+      if (mState.inputChannelInfos[ci].state == InputChannelState::Running) {
+        polledChannels.push_back(mSpec.inputChannels[ci].name);
+      }
+    }
+    for (auto& credit : mCreditChannels) {
+      if (std::find(polledChannels.begin(), polledChannels.end(), credit.first) == polledChannels.end()) {
+        polledChannels.push_back(credit.first);
+      }
+    }
+    if (polledChannels.empty() == false) {
+      try {
+        auto& transport = *fChannels.at(polledChannels[0]).at(0).Transport();
+        mInputPoller = transport.CreatePoller(fChannels, polledChannels);
+      } catch (std::exception& e) {
+        LOG(WARNING) << "Unable to wait on input channels, falling back to busy polling: " << e.what();
+      }
+    }
+  }
+  mWasActive = true;
+  mServiceRegistry.get<CallbackService>()(CallbackService::Id::Start);
+}
 
-void DataProcessingDevice::PostRun() { mServiceRegistry.get<CallbackService>()(CallbackService::Id::Stop); }
+void DataProcessingDevice::PostRun()
+{
+  if (mWorkerPool) {
+    mWorkerPool->wait();
+  }
+  mServiceRegistry.get<CallbackService>()(CallbackService::Id::Stop);
+}
 
-void DataProcessingDevice::Reset() { mServiceRegistry.get<CallbackService>()(CallbackService::Id::Reset); }
+void DataProcessingDevice::Reset()
+{
+  if (mWorkerPool) {
+    mWorkerPool->wait();
+  }
+  mServiceRegistry.get<CallbackService>()(CallbackService::Id::Reset);
+}
 
 /// We drive the state loop ourself so that we will be able to support
 /// non-data triggers like those which are time based.
@@ -167,11 +317,14 @@ bool DataProcessingDevice::ConditionalRun()
                              &stats = mStats,
                              &lastSent = mLastSlowMetricSentTimestamp,
                              &currentTime = mBeginIterationTimestamp,
+                             &sendMutex = mSendMutex,
+                             &messagePools = mMessagePools,
                              &monitoring = mServiceRegistry.get<Monitoring>()]()
     -> void {
     if (currentTime - lastSent < 5000) {
       return;
     }
+    std::lock_guard<std::mutex> lock(sendMutex);
 
     O2_SIGNPOST_START(MonitoringStatus::ID, MonitoringStatus::SEND, 0, 0, O2_SIGNPOST_BLUE);
 
@@ -179,6 +332,7 @@ bool DataProcessingDevice::ConditionalRun()
     monitoring.send(Metric{(int)relayerStats.droppedComputations, "dropped_computations"}.addTag(Key::Subsystem, Value::DPL));
     monitoring.send(Metric{(int)relayerStats.droppedIncomingMessages, "dropped_incoming_messages"}.addTag(Key::Subsystem, Value::DPL));
     monitoring.send(Metric{(int)relayerStats.relayedMessages, "relayed_messages"}.addTag(Key::Subsystem, Value::DPL));
+    monitoring.send(Metric{(int)relayerStats.pipelineResizes, "pipeline_resizes"}.addTag(Key::Subsystem, Value::DPL));
 
     monitoring.send(Metric{(int)stats.pendingInputs, "inputs/relayed/pending"}.addTag(Key::Subsystem, Value::DPL));
     monitoring.send(Metric{(int)stats.incomplete, "inputs/relayed/incomplete"}.addTag(Key::Subsystem, Value::DPL));
@@ -195,6 +349,19 @@ bool DataProcessingDevice::ConditionalRun()
                       .addTag(Key::Subsystem, Value::DPL));
     monitoring.send(Metric{(stats.lastTotalProcessedSize / (stats.lastLatency.maxLatency ? stats.lastLatency.maxLatency : 1) / 1000), "input_rate_mb_s"}
                       .addTag(Key::Subsystem, Value::DPL));
+    if (messagePools) {
+      MessagePoolStats total;
+      for (auto& [channel, poolStats] : messagePools->stats()) {
+        total.hits += poolStats.hits;
+        total.misses += poolStats.misses;
+        total.recycled += poolStats.recycled;
+        total.reservedBytes += poolStats.reservedBytes;
+      }
+      monitoring.send(Metric{(int)total.hits, "message_pool_hits"}.addTag(Key::Subsystem, Value::DPL));
+      monitoring.send(Metric{(int)total.misses, "message_pool_misses"}.addTag(Key::Subsystem, Value::DPL));
+      monitoring.send(Metric{(int)total.recycled, "message_pool_recycled"}.addTag(Key::Subsystem, Value::DPL));
+      monitoring.send(Metric{(double)total.reservedBytes, "message_pool_reserved_bytes"}.addTag(Key::Subsystem, Value::DPL));
+    }
 
     lastSent = currentTime;
     O2_SIGNPOST_END(MonitoringStatus::ID, MonitoringStatus::SEND, 0, 0, O2_SIGNPOST_BLUE);
@@ -202,22 +369,33 @@ bool DataProcessingDevice::ConditionalRun()
 
   /// This will flush metrics only once every second.
   auto flushMetrics = [& stats = mStats,
+                       &lastSentState = mLastSentRelayerState,
+                       &stateMetricNames = mRelayerStateMetricNames,
                        &relayer = mRelayer,
                        &lastFlushed = mLastMetricFlushedTimestamp,
                        &currentTime = mBeginIterationTimestamp,
+                       &sendMutex = mSendMutex,
                        &monitoring = mServiceRegistry.get<Monitoring>()]()
     -> void {
     if (currentTime - lastFlushed < 1000) {
       return;
     }
+    std::lock_guard<std::mutex> lock(sendMutex);
 
     O2_SIGNPOST_START(MonitoringStatus::ID, MonitoringStatus::FLUSH, 0, 0, O2_SIGNPOST_RED);
-    // Send all the relevant metrics for the relayer to update the GUI
-    // FIXME: do a delta with the previous version if too many metrics are still
-    // sent...
+    // Send the relevant metrics for the relayer to update the GUI. We only
+    // send what changed since last flush, reusing the metric names.
+    for (size_t si = lastSentState.size(); si < stats.relayerState.size(); ++si) {
+      stateMetricNames.push_back("data_relayer/" + std::to_string(si));
+      lastSentState.push_back(-1);
+    }
     for (size_t si = 0; si < stats.relayerState.size(); ++si) {
       auto state = stats.relayerState[si];
-      monitoring.send({state, "data_relayer/" + std::to_string(si)});
+      if (state == lastSentState[si]) {
+        continue;
+      }
+      monitoring.send({state, stateMetricNames[si]});
+      lastSentState[si] = state;
     }
     relayer.sendContextState();
     monitoring.flushBuffer();
@@ -225,16 +403,68 @@ bool DataProcessingDevice::ConditionalRun()
     O2_SIGNPOST_END(MonitoringStatus::ID, MonitoringStatus::FLUSH, 0, 0, O2_SIGNPOST_RED);
   };
 
+  /// This will adapt the number of slots of the relayer, at most once
+  /// every second, to what was needed in the meanwhile.
+  auto adaptPipelineLength = [&relayer = mRelayer,
+                              &lastAdapted = mLastPipelineAdaptedTimestamp,
+                              &currentTime = mBeginIterationTimestamp,
+                              &sendMutex = mSendMutex]() -> void {
+    if (currentTime - lastAdapted < 1000) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(sendMutex);
+    relayer.adaptPipelineLength();
+    lastAdapted = currentTime;
+  };
+
   auto switchState = [& control = mServiceRegistry.get<ControlService>(),
                       &state = mState.streaming](StreamingState newState) {
     state = newState;
     control.notifyStreamingState(state);
   };
 
+  /// When allowed to, rather than spinning on the input channels we sleep
+  /// until either some data arrives or one of the timers is about to
+  /// expire. We never sleep longer than --polling-timeout, so that state
+  /// transitions and the Idle callback are still handled in reasonable time.
+  /// When all the workers are busy, complete records might be waiting in
+  /// the relayer, so we wait for a worker to be free instead.
+  /// @return true if we actually waited on the channels, meaning that the
+  /// poller knows which channels have data.
+  auto waitForInputs = [&poller = mInputPoller,
+                        &workerPool = mWorkerPool,
+                        &timers = mTimerDeadlines,
+                        pollingTimeout = mPollingTimeout,
+                        hasEnumerations = mHasEnumerations,
+                        wasActive = mWasActive,
+                        &state = mState.streaming]() -> bool {
+    if (!poller || wasActive || state != StreamingState::Streaming) {
+      return false;
+    }
+    int timeout = hasEnumerations ? 0 : pollingTimeout;
+    auto now = getCurrentTimeUs();
+    for (auto& timer : timers) {
+      if (now >= timer.next) {
+        timer.next = now + timer.period;
+        timeout = 0;
+      } else {
+        timeout = std::min(timeout, (int)((timer.next - now + 999) / 1000));
+      }
+    }
+    if (workerPool && workerPool->pending() >= workerPool->size()) {
+      workerPool->waitForIdleWorker(timeout);
+      return false;
+    }
+    poller->Poll(timeout);
+    return true;
+  };
+
+  bool polled = waitForInputs();
   auto now = std::chrono::high_resolution_clock::now();
   mBeginIterationTimestamp = (uint64_t)std::chrono::duration<double, std::milli>(now.time_since_epoch()).count();
 
   mServiceRegistry.get<CallbackService>()(CallbackService::Id::ClockTick);
+  receiveCredits();
   // Wether or not we had something to do.
   bool active = false;
   // Notice that in case there are no input channels we should the allDone
@@ -252,6 +482,9 @@ bool DataProcessingDevice::ConditionalRun()
     if (info.state != InputChannelState::Running) {
       continue;
     }
+    if (polled && mInputPoller->CheckInput(channel.name, 0) == false) {
+      continue;
+    }
     FairMQParts parts;
     auto result = this->Receive(parts, channel.name, 0, 0);
     if (result > 0) {
@@ -263,7 +496,14 @@ bool DataProcessingDevice::ConditionalRun()
     mServiceRegistry.get<CallbackService>()(CallbackService::Id::Idle);
   }
   mRelayer.processDanglingInputs(mExpirationHandlers, mServiceRegistry);
-  this->tryDispatchComputation();
+  active |= this->tryDispatchComputation();
+  // Timeslices which we will never process are as good as done for our
+  // producer.
+  for (auto& timeslice : mRelayer.getDroppedTimeslices()) {
+    giveBackCredits(timeslice);
+  }
+  mWasActive = active;
+  adaptPipelineLength();
 
   sendRelayerMetrics();
   flushMetrics();
@@ -283,6 +523,9 @@ bool DataProcessingDevice::ConditionalRun()
     while (this->tryDispatchComputation()) {
       mRelayer.processDanglingInputs(mExpirationHandlers, mServiceRegistry);
     }
+    if (mWorkerPool) {
+      mWorkerPool->wait();
+    }
     sendRelayerMetrics();
     flushMetrics();
     mContextRegistry.get<MessageContext>()->clear();
@@ -292,6 +535,7 @@ bool DataProcessingDevice::ConditionalRun()
     mContextRegistry.get<RawBufferContext>()->clear();
     EndOfStreamContext eosContext{mServiceRegistry, mAllocator};
     mServiceRegistry.get<CallbackService>()(CallbackService::Id::EndOfStream, eosContext);
+    std::lock_guard<std::mutex> lock(mSendMutex);
     DataProcessor::doSend(*this, *mContextRegistry.get<MessageContext>());
     DataProcessor::doSend(*this, *mContextRegistry.get<RootObjectContext>());
     DataProcessor::doSend(*this, *mContextRegistry.get<StringContext>());
@@ -306,6 +550,45 @@ bool DataProcessingDevice::ConditionalRun()
   return true;
 }
 
+/// The replicas of the LeastLoaded time pipelines we feed tell us which
+/// timeslices they are done with, so that the following ones can go
+/// to the least loaded of them.
+void DataProcessingDevice::receiveCredits()
+{
+  for (auto& [channel, consumer] : mCreditChannels) {
+    while (true) {
+      FairMQParts parts;
+      if (this->Receive(parts, channel, 0, 0) <= 0) {
+        break;
+      }
+      for (auto& part : parts) {
+        if (part->GetSize() != sizeof(uint64_t)) {
+          LOG(ERROR) << "Malformed credit on channel " << channel;
+          continue;
+        }
+        uint64_t timeslice;
+        memcpy(&timeslice, part->GetData(), sizeof(uint64_t));
+        mTimePipelineDispatcher.credit(consumer, timeslice);
+      }
+    }
+  }
+}
+
+void DataProcessingDevice::giveBackCredits(TimesliceId timeslice)
+{
+  if (mSpec.creditOutputChannels.empty()) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mSendMutex);
+  for (auto& channel : mSpec.creditOutputChannels) {
+    FairMQParts parts;
+    parts.AddPart(this->NewMessageFor(channel.name, 0, sizeof(uint64_t)));
+    uint64_t value = timeslice.value;
+    memcpy(parts.At(0)->GetData(), &value, sizeof(uint64_t));
+    this->Send(parts, channel.name, 0);
+  }
+}
+
 /// This is the inner loop of our framework. The actual implementation
 /// is divided in two parts. In the first one we define a set of lambdas
 /// which describe what is actually going to happen, hiding all the state
@@ -338,23 +621,32 @@ bool DataProcessingDevice::handleData(FairMQParts& parts, InputChannelInfo& info
   // and we do a few stats. We bind parts as a lambda captured variable, rather
   // than an input, because we do not want the outer loop actually be exposed
   // to the implementation details of the messaging layer.
-  auto getInputTypes = [& stats = mStats, &parts, &info]() -> std::optional<std::vector<InputType>> {
+  //
+  // The header stack of each part is walked only once, and the resulting
+  // index is handed over to the relayer, so that it does not need to look
+  // for the headers again.
+  std::vector<HeaderStackIndex> headerIndices;
+  auto getInputTypes = [& stats = mStats, &parts, &info, &headerIndices]() -> std::optional<std::vector<InputType>> {
     stats.inputParts = parts.Size();
 
     if (parts.Size() % 2) {
       return std::nullopt;
     }
     std::vector<InputType> results(parts.Size() / 2, InputType::Invalid);
+    headerIndices.resize(parts.Size() / 2);
 
     for (size_t hi = 0; hi < parts.Size() / 2; ++hi) {
       auto pi = hi * 2;
-      auto sih = o2::header::get<SourceInfoHeader*>(parts.At(pi)->GetData());
+      auto headerData = parts.At(pi)->GetData();
+      auto& headerIndex = headerIndices[hi];
+      headerIndex = HeaderStackIndex::parse(headerData);
+      auto sih = headerIndex.get<SourceInfoHeader>(headerData);
       if (sih) {
         info.state = sih->state;
         results[hi] = InputType::SourceInfo;
         continue;
       }
-      auto dh = o2::header::get<DataHeader*>(parts.At(pi)->GetData());
+      auto dh = headerIndex.get<DataHeader>(headerData);
       if (!dh) {
         results[hi] = InputType::Invalid;
         LOGP(error, "Header is not a DataHeader?");
@@ -365,7 +657,7 @@ bool DataProcessingDevice::handleData(FairMQParts& parts, InputChannelInfo& info
         LOGP(error, "DataHeader payloadSize mismatch");
         continue;
       }
-      auto dph = o2::header::get<DataProcessingHeader*>(parts.At(pi)->GetData());
+      auto dph = headerIndex.get<DataProcessingHeader>(headerData);
       if (!dph) {
         results[hi] = InputType::Invalid;
         LOGP(error, "Header stack does not contain DataProcessingHeader");
@@ -380,7 +672,7 @@ bool DataProcessingDevice::handleData(FairMQParts& parts, InputChannelInfo& info
     device.error(message);
   };
 
-  auto handleValidMessages = [&parts, &relayer = mRelayer, &reportError](std::vector<InputType> const& types) {
+  auto handleValidMessages = [&parts, &headerIndices, &relayer = mRelayer, &reportError](std::vector<InputType> const& types) {
     // We relay execution to make sure we have a complete set of parts
     // available.
     for (size_t pi = 0; pi < (parts.Size() / 2); ++pi) {
@@ -390,7 +682,8 @@ bool DataProcessingDevice::handleData(FairMQParts& parts, InputChannelInfo& info
           auto payloadIndex = 2 * pi + 1;
           assert(payloadIndex < parts.Size());
           auto relayed = relayer.relay(std::move(parts.At(headerIndex)),
-                                       std::move(parts.At(payloadIndex)));
+                                       std::move(parts.At(payloadIndex)),
+                                       headerIndices[pi]);
           if (relayed == DataRelayer::WillNotRelay) {
             reportError("Unable to relay part.");
           }
@@ -424,31 +717,29 @@ bool DataProcessingDevice::handleData(FairMQParts& parts, InputChannelInfo& info
 
 bool DataProcessingDevice::tryDispatchComputation()
 {
-  // This is the actual hidden state for the outer loop. In case we decide we
-  // want to support multithreaded dispatching of operations, I can simply
-  // move these to some thread local store and the rest of the lambdas
-  // should work just fine.
+  // This is the actual hidden state for the outer loop. The inputs and the
+  // output contextes are passed explicitly to the lambdas, because when we
+  // run with worker threads each worker has its own set of contextes and
+  // owns the inputs of the timeslice it is processing. For the same reason
+  // the lambdas which end up in a worker task only capture state which
+  // outlives this function, i.e. members of the device.
   std::vector<DataRelayer::RecordAction> completed;
-  std::vector<std::unique_ptr<FairMQMessage>> currentSetOfInputs;
+  using InputMessages = std::vector<std::unique_ptr<FairMQMessage>>;
 
-  auto& allocator = mAllocator;
-  auto& context = *mContextRegistry.get<MessageContext>();
   auto& device = *this;
   auto& errorCallback = mError;
-  auto& errorCount = mErrorCount;
   auto& forwards = mSpec.forwards;
   auto& inputsSchema = mSpec.inputs;
   auto& processingCount = mProcessingCount;
-  auto& rdfContext = *mContextRegistry.get<ArrowContext>();
   auto& relayer = mRelayer;
-  auto& rootContext = *mContextRegistry.get<RootObjectContext>();
+  auto& sendMutex = mSendMutex;
   auto& serviceRegistry = mServiceRegistry;
+  auto& state = mState;
   auto& statefulProcess = mStatefulProcess;
   auto& statelessProcess = mStatelessProcess;
-  auto& stringContext = *mContextRegistry.get<StringContext>();
-  auto& timingInfo = mTimingInfo;
+  auto& stats = mStats;
   auto& timesliceIndex = mServiceRegistry.get<TimesliceIndex>();
-  auto& rawContext = *mContextRegistry.get<RawBufferContext>();
+  auto& workerPool = mWorkerPool;
 
   // These duplicate references are created so that each function
   // does not need to know about the whole class state, but I can
@@ -464,11 +755,27 @@ bool DataProcessingDevice::tryDispatchComputation()
     device.error(message);
   };
 
+  // The signposts used to track the state are not thread safe, so we only
+  // move between states when processing on the main thread.
+  auto moveTo = [](DataProcessingStatus status, bool trackState) {
+    if (trackState) {
+      StateMonitoring<DataProcessingStatus>::moveTo(status);
+    }
+  };
+
   // For the moment we have a simple "immediately dispatch" policy for stuff
   // in the cache. This could be controlled from the outside e.g. by waiting
   // for a few sets of inputs to arrive before we actually dispatch the
   // computation, however this can be defined at a later stage.
-  auto canDispatchSomeComputation = [&completed, &relayer]() -> bool {
+  // When all the workers are busy we leave the inputs in the relayer, so
+  // that backpressure builds up upstream rather than in the worker queue.
+  auto canDispatchSomeComputation = [&completed, &relayer, &workerPool, &state]() -> bool {
+    if (workerPool && workerPool->pending() >= workerPool->size()) {
+      if (state.streaming == StreamingState::Streaming) {
+        return false;
+      }
+      workerPool->wait();
+    }
     completed = relayer.getReadyToProcess();
     return completed.empty() == false;
   };
@@ -477,21 +784,23 @@ bool DataProcessingDevice::tryDispatchComputation()
   // indicate a complete set of inputs. Notice how I fill the completed
   // vector and return it, so that I can have a nice for loop iteration later
   // on.
-  auto getReadyActions = [&relayer, &completed, &stats = mStats]() -> std::vector<DataRelayer::RecordAction> {
+  auto getReadyActions = [&relayer, &completed, &stats]() -> std::vector<DataRelayer::RecordAction> {
     stats.pendingInputs = (int)relayer.getParallelTimeslices() - completed.size();
     stats.incomplete = completed.empty() ? 1 : 0;
     return completed;
   };
 
-  // This is needed to convert from a pair of pointers to an actual DataRef
-  // and to make sure the ownership is moved from the cache in the relayer to
-  // the execution.
-  auto fillInputs = [&relayer, &inputsSchema, &currentSetOfInputs](TimesliceSlot slot) -> InputRecord {
-    currentSetOfInputs = std::move(relayer.getInputsForTimeslice(slot));
-    InputSpan span{[&currentSetOfInputs](size_t i) -> char const* {
-                     return currentSetOfInputs.at(i) ? static_cast<char const*>(currentSetOfInputs.at(i)->GetData()) : nullptr;
+  // This is needed to convert from a pair of pointers to an actual DataRef.
+  // The ownership of the messages has already been moved from the cache in
+  // the relayer to @a inputs.
+  auto fillInputs = [&inputsSchema](InputMessages& inputs) -> InputRecord {
+    InputSpan span{[&inputs](size_t i) -> char const* {
+                     return inputs.at(i) ? static_cast<char const*>(inputs.at(i)->GetData()) : nullptr;
+                   },
+                   [&inputs](size_t i) -> FairMQMessage const* {
+                     return inputs.at(i).get();
                    },
-                   currentSetOfInputs.size()};
+                   inputs.size()};
     return InputRecord{inputsSchema, std::move(span)};
   };
 
@@ -499,62 +808,67 @@ bool DataProcessingDevice::tryDispatchComputation()
   // why we do the stateful processing before the stateless one.
   // PROCESSING:{START,END} is done so that we can trigger on begin / end of processing
   // in the GUI.
-  auto dispatchProcessing = [&processingCount, &allocator, &statefulProcess, &statelessProcess, &monitoringService,
-                             &context, &rootContext, &stringContext, &rdfContext, &rawContext, &serviceRegistry, &device](TimesliceSlot slot, InputRecord& record) {
+  auto dispatchProcessing = [&processingCount, &statefulProcess, &statelessProcess, &serviceRegistry,
+                             &sendMutex, &device, moveTo](InputRecord& record, DataAllocator& allocator,
+                                                          ContextRegistry& contexts, bool trackState) {
     if (statefulProcess) {
       ProcessingContext processContext{record, serviceRegistry, allocator};
-      StateMonitoring<DataProcessingStatus>::moveTo(DataProcessingStatus::IN_DPL_USER_CALLBACK);
+      moveTo(DataProcessingStatus::IN_DPL_USER_CALLBACK, trackState);
       statefulProcess(processContext);
-      StateMonitoring<DataProcessingStatus>::moveTo(DataProcessingStatus::IN_DPL_OVERHEAD);
+      moveTo(DataProcessingStatus::IN_DPL_OVERHEAD, trackState);
       processingCount++;
     }
     if (statelessProcess) {
       ProcessingContext processContext{record, serviceRegistry, allocator};
-      StateMonitoring<DataProcessingStatus>::moveTo(DataProcessingStatus::IN_DPL_USER_CALLBACK);
+      moveTo(DataProcessingStatus::IN_DPL_USER_CALLBACK, trackState);
       statelessProcess(processContext);
-      StateMonitoring<DataProcessingStatus>::moveTo(DataProcessingStatus::IN_DPL_OVERHEAD);
+      moveTo(DataProcessingStatus::IN_DPL_OVERHEAD, trackState);
       processingCount++;
     }
 
-    DataProcessor::doSend(device, context);
-    DataProcessor::doSend(device, rootContext);
-    DataProcessor::doSend(device, stringContext);
-    DataProcessor::doSend(device, rdfContext);
-    DataProcessor::doSend(device, rawContext);
+    std::lock_guard<std::mutex> lock(sendMutex);
+    DataProcessor::doSend(device, *contexts.get<MessageContext>());
+    DataProcessor::doSend(device, *contexts.get<RootObjectContext>());
+    DataProcessor::doSend(device, *contexts.get<StringContext>());
+    DataProcessor::doSend(device, *contexts.get<ArrowContext>());
+    DataProcessor::doSend(device, *contexts.get<RawBufferContext>());
   };
 
   // Error handling means printing the error and updating the metric
-  auto errorHandling = [&errorCallback, &monitoringService, &serviceRegistry](std::exception& e, InputRecord& record) {
-    StateMonitoring<DataProcessingStatus>::moveTo(DataProcessingStatus::IN_DPL_ERROR_CALLBACK);
+  auto errorHandling = [&errorCallback, &monitoringService, &serviceRegistry, &sendMutex, moveTo](std::exception& e, InputRecord& record, bool trackState) {
+    moveTo(DataProcessingStatus::IN_DPL_ERROR_CALLBACK, trackState);
     LOG(ERROR) << "Exception caught: " << e.what() << std::endl;
     if (errorCallback) {
-      monitoringService.send({1, "error"});
+      {
+        std::lock_guard<std::mutex> lock(sendMutex);
+        monitoringService.send({1, "error"});
+      }
       ErrorContext errorContext{record, serviceRegistry, e};
       errorCallback(errorContext);
     }
-    StateMonitoring<DataProcessingStatus>::moveTo(DataProcessingStatus::IN_DPL_OVERHEAD);
+    moveTo(DataProcessingStatus::IN_DPL_OVERHEAD, trackState);
   };
 
   // I need a preparation step which gets the current timeslice id and
   // propagates it to the various contextes (i.e. the actual entities which
   // create messages) because the messages need to have the timeslice id into
-  // it.
-  auto prepareAllocatorForCurrentTimeSlice = [&timingInfo, &rootContext, &stringContext, &rdfContext, &rawContext, &context, &relayer, &timesliceIndex](TimesliceSlot i) {
-    auto timeslice = timesliceIndex.getTimesliceForSlot(i);
+  // it. The timeslice is looked up by the caller, since the index can only
+  // be accessed from the main thread.
+  auto prepareAllocatorForCurrentTimeSlice = [](TimesliceId timeslice, TimingInfo& timingInfo, ContextRegistry& contexts) {
     timingInfo.timeslice = timeslice.value;
-    rootContext.clear();
-    context.clear();
-    stringContext.clear();
-    rdfContext.clear();
-    rawContext.clear();
+    contexts.get<RootObjectContext>()->clear();
+    contexts.get<MessageContext>()->clear();
+    contexts.get<StringContext>()->clear();
+    contexts.get<ArrowContext>()->clear();
+    contexts.get<RawBufferContext>()->clear();
   };
 
   // When processing them, timers will have to be cleaned up
   // to avoid double counting them.
   // This was actually the easiest solution we could find for
   // O2-646.
-  auto cleanTimers = [&currentSetOfInputs](TimesliceSlot slot, InputRecord& record) {
-    assert(record.size() * 2 == currentSetOfInputs.size());
+  auto cleanTimers = [](InputRecord& record, InputMessages& inputs) {
+    assert(record.size() * 2 == inputs.size());
     for (size_t ii = 0, ie = record.size(); ii < ie; ++ii) {
       DataRef input = record.getByPos(ii);
       if (input.spec->lifetime != Lifetime::Timer) {
@@ -564,8 +878,8 @@ bool DataProcessingDevice::tryDispatchComputation()
         continue;
       }
       // This will hopefully delete the message.
-      std::unique_ptr<FairMQMessage> header = std::move(currentSetOfInputs[ii * 2]);
-      std::unique_ptr<FairMQMessage> payload = std::move(currentSetOfInputs[ii * 2 + 1]);
+      std::unique_ptr<FairMQMessage> header = std::move(inputs[ii * 2]);
+      std::unique_ptr<FairMQMessage> payload = std::move(inputs[ii * 2 + 1]);
     }
   };
 
@@ -573,8 +887,8 @@ bool DataProcessingDevice::tryDispatchComputation()
   // the inputs which are shared between this device and others
   // to the next one in the daisy chain.
   // FIXME: do it in a smarter way than O(N^2)
-  auto forwardInputs = [&reportError, &forwards, &device, &currentSetOfInputs](TimesliceSlot slot, InputRecord& record) {
-    assert(record.size() * 2 == currentSetOfInputs.size());
+  auto forwardInputs = [reportError, &forwards, &device, &sendMutex](InputRecord& record, InputMessages& inputs) {
+    assert(record.size() * 2 == inputs.size());
     for (size_t ii = 0, ie = record.size(); ii < ie; ++ii) {
       DataRef input = record.getByPos(ii);
 
@@ -585,24 +899,25 @@ bool DataProcessingDevice::tryDispatchComputation()
       if (input.header == nullptr || input.payload == nullptr) {
         continue;
       }
-      auto sih = o2::header::get<SourceInfoHeader*>(input.header);
+      auto headerIndex = HeaderStackIndex::parse(input.header);
+      auto sih = headerIndex.get<SourceInfoHeader>(input.header);
       if (sih) {
         continue;
       }
 
-      auto dh = o2::header::get<DataHeader*>(input.header);
+      auto dh = headerIndex.get<DataHeader>(input.header);
       if (!dh) {
         reportError("Header is not a DataHeader?");
         continue;
       }
-      auto dph = o2::header::get<DataProcessingHeader*>(input.header);
+      auto dph = headerIndex.get<DataProcessingHeader>(input.header);
       if (!dph) {
         reportError("Header stack does not contain DataProcessingHeader");
         continue;
       }
 
-      auto& header = currentSetOfInputs[ii * 2];
-      auto& payload = currentSetOfInputs[ii * 2 + 1];
+      auto& header = inputs[ii * 2];
+      auto& payload = inputs[ii * 2 + 1];
 
       for (auto forward : forwards) {
         if (DataSpecUtils::match(forward.matcher, dh->dataOrigin, dh->dataDescription, dh->subSpecification) && (dph->startTime % forward.maxTimeslices) == forward.timeslice) {
@@ -627,6 +942,7 @@ bool DataProcessingDevice::tryDispatchComputation()
           assert(forwardedParts.Size() == 2);
           assert(o2::header::get<DataProcessingHeader*>(forwardedParts.At(0)->GetData()));
           // FIXME: this should use a correct subchannel
+          std::lock_guard<std::mutex> lock(sendMutex);
           device.Send(forwardedParts, forward.channel, 0);
         }
       }
@@ -661,65 +977,103 @@ bool DataProcessingDevice::tryDispatchComputation()
     return totalInputSize;
   };
 
-  auto switchState = [& control = mServiceRegistry.get<ControlService>(),
-                      &state = mState.streaming](StreamingState newState) {
-    state = newState;
-    control.notifyStreamingState(state);
+  auto updateRelayerState = [&stats, &sendMutex](TimesliceSlot slot, InputRecord& record, int validState) {
+    std::lock_guard<std::mutex> lock(sendMutex);
+    for (size_t ai = 0; ai != record.size(); ai++) {
+      auto cacheId = slot.index * record.size() + ai;
+      auto state = record.isValid(ai) ? validState : 0;
+      stats.relayerState.resize(std::max(cacheId + 1, stats.relayerState.size()), 0);
+      stats.relayerState[cacheId] = state;
+    }
   };
 
-  if (canDispatchSomeComputation() == false) {
-    return false;
-  }
-
-  for (auto action : getReadyActions()) {
-    if (action.op == CompletionPolicy::CompletionOp::Wait) {
-      continue;
-    }
+  // When we are a replica of a LeastLoaded time pipeline, our producer
+  // needs to know once we are done with a timeslice.
+  auto giveBackCredits = [&device](TimesliceId timeslice) {
+    device.giveBackCredits(timeslice);
+  };
 
-    prepareAllocatorForCurrentTimeSlice(TimesliceSlot{action.slot});
-    InputRecord record = fillInputs(action.slot);
+  // This is what happens to a single complete record, either on the main
+  // thread or in one of the workers.
+  auto processAction = [=, &forwards, &state, &stats, &sendMutex](DataRelayer::RecordAction action, TimesliceId timeslice, InputMessages& inputs,
+                                                                  TimingInfo& timingInfo, DataAllocator& allocator, ContextRegistry& contexts, bool trackState) {
+    prepareAllocatorForCurrentTimeSlice(timeslice, timingInfo, contexts);
+    InputRecord record = fillInputs(inputs);
     if (action.op == CompletionPolicy::CompletionOp::Discard) {
       if (forwards.empty() == false) {
-        forwardInputs(action.slot, record);
-        continue;
+        forwardInputs(record, inputs);
+        giveBackCredits(timeslice);
+        return;
       }
     }
     auto tStart = std::chrono::high_resolution_clock::now();
-    for (size_t ai = 0; ai != record.size(); ai++) {
-      auto cacheId = action.slot.index * record.size() + ai;
-      auto state = record.isValid(ai) ? 2 : 0;
-      mStats.relayerState.resize(std::max(cacheId + 1, mStats.relayerState.size()), 0);
-      mStats.relayerState[cacheId] = state;
-    }
+    updateRelayerState(action.slot, record, 2);
     try {
-      if (mState.quitRequested == false) {
-        dispatchProcessing(action.slot, record);
+      if (state.quitRequested == false) {
+        dispatchProcessing(record, allocator, contexts, trackState);
       }
     } catch (std::exception& e) {
-      errorHandling(e, record);
-    }
-    for (size_t ai = 0; ai != record.size(); ai++) {
-      auto cacheId = action.slot.index * record.size() + ai;
-      auto state = record.isValid(ai) ? 3 : 0;
-      mStats.relayerState.resize(std::max(cacheId + 1, mStats.relayerState.size()), 0);
-      mStats.relayerState[cacheId] = state;
+      errorHandling(e, record, trackState);
     }
+    updateRelayerState(action.slot, record, 3);
     auto tEnd = std::chrono::high_resolution_clock::now();
-    mStats.lastElapsedTimeMs = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
-    mStats.lastTotalProcessedSize = calculateTotalInputRecordSize(record);
-    mStats.lastLatency = calculateInputRecordLatency(record, tStart);
+    {
+      std::lock_guard<std::mutex> lock(sendMutex);
+      stats.lastElapsedTimeMs = std::chrono::duration<double, std::milli>(tEnd - tStart).count();
+      stats.lastTotalProcessedSize = calculateTotalInputRecordSize(record);
+      stats.lastLatency = calculateInputRecordLatency(record, tStart);
+    }
     // We forward inputs only when we consume them. If we simply Process them,
     // we keep them for next message arriving.
     if (action.op == CompletionPolicy::CompletionOp::Consume) {
       if (forwards.empty() == false) {
-        forwardInputs(action.slot, record);
+        forwardInputs(record, inputs);
       }
     } else if (action.op == CompletionPolicy::CompletionOp::Process) {
-      cleanTimers(action.slot, record);
+      cleanTimers(record, inputs);
     }
+    // With Process the inputs are kept for the next message arriving, so
+    // we are not done with the timeslice yet.
+    if (action.op != CompletionPolicy::CompletionOp::Process) {
+      giveBackCredits(timeslice);
+    }
+  };
+
+  auto switchState = [& control = mServiceRegistry.get<ControlService>(),
+                      &state](StreamingState newState) {
+    state.streaming = newState;
+    control.notifyStreamingState(newState);
+  };
+
+  if (canDispatchSomeComputation() == false) {
+    return false;
   }
-  // We now broadcast the end of stream if it was requested
+
+  for (auto action : getReadyActions()) {
+    if (action.op == CompletionPolicy::CompletionOp::Wait) {
+      continue;
+    }
+    // The relayer and the timeslice index are only accessed from the main
+    // thread, so we extract everything we need from them here.
+    auto timeslice = timesliceIndex.getTimesliceForSlot(action.slot);
+    if (workerPool == nullptr) {
+      InputMessages inputs = relayer.getInputsForTimeslice(action.slot);
+      processAction(action, timeslice, inputs, mTimingInfo, mAllocator, mContextRegistry, true);
+      continue;
+    }
+    auto inputs = std::make_shared<InputMessages>(relayer.getInputsForTimeslice(action.slot));
+    workerPool->push([processAction, action, timeslice, inputs, &workerContexts = mWorkerContexts](size_t workerId) {
+      auto& worker = *workerContexts[workerId];
+      processAction(action, timeslice, *inputs, worker.timingInfo, worker.allocator, worker.contextRegistry, false);
+    });
+  }
+  // We now broadcast the end of stream if it was requested. Whatever
+  // is still being processed by the workers needs to go out first.
   if (mState.streaming == StreamingState::EndOfStreaming) {
+    if (workerPool) {
+      workerPool->wait();
+    }
+    std::lock_guard<std::mutex> lock(sendMutex);
     for (auto& channel : mSpec.outputChannels) {
       DataProcessingHelpers::sendEndOfStream(*this, channel);
     }
@@ -732,6 +1086,7 @@ bool DataProcessingDevice::tryDispatchComputation()
 void DataProcessingDevice::error(const char* msg)
 {
   LOG(ERROR) << msg;
+  std::lock_guard<std::mutex> lock(mSendMutex);
   mErrorCount++;
   mServiceRegistry.get<Monitoring>().send(Metric{mErrorCount, "errors"}.addTag(Key::Subsystem, Value::DPL));
 }
@@ -23,8 +23,10 @@
 #include "DataRelayerHelpers.h"
 
 #include <Monitoring/Monitoring.h>
+#include <fairmq/FairMQMessage.h>
 
 #include <gsl/span>
+#include <algorithm>
 #include <string>
 
 using namespace o2::framework::data_matcher;
@@ -40,8 +42,14 @@ namespace framework
 constexpr int INVALID_INPUT = -1;
 
 // 16 is just some reasonable numer
-// The number should really be tuned at runtime for each processor.
+// The number can be tuned at runtime for each processor via
+// setAdaptivePipelineLength().
 constexpr int DEFAULT_PIPELINE_LENGTH = 16;
+// The minimum number of slots we shrink to when tuning at runtime.
+constexpr size_t MIN_PIPELINE_LENGTH = 2;
+// How many consecutive invokations of adaptPipelineLength() need to
+// see mostly unused slots before we actually shrink the pipeline.
+constexpr size_t SHRINK_AFTER_QUIET_INTERVALS = 3;
 
 // FIXME: do we really need to pass the forwards?
 DataRelayer::DataRelayer(const CompletionPolicy& policy,
@@ -56,6 +64,16 @@ DataRelayer::DataRelayer(const CompletionPolicy& policy,
 {
   setPipelineLength(DEFAULT_PIPELINE_LENGTH);
 
+  // When multiple routes match the same data, the first one wins, so we
+  // only keep the first occurrence of each concrete matcher.
+  for (size_t ri = 0; ri < routes.size(); ++ri) {
+    if (auto concrete = std::get_if<ConcreteDataMatcher>(&routes[ri].matcher.matcher)) {
+      mConcreteRoutes.emplace(*concrete, ri);
+    } else {
+      mWildcardRoutes.push_back(ri);
+    }
+  }
+
   // The queries are all the same, so we only have width 1
   auto numInputTypes = mDistinctRoutesIndex.size();
   sQueriesMetricsNames.resize(numInputTypes * 1);
@@ -127,31 +145,82 @@ void DataRelayer::processDanglingInputs(std::vector<ExpirationHandler> const& ex
 /// This does the mapping between a route and a InputSpec. The
 /// reason why these might diffent is that when you have timepipelining
 /// you have one route per timeslice, even if the type is the same.
-size_t matchToContext(void* data,
-                      std::vector<DataDescriptorMatcher> const& matchers,
-                      VariableContext& context)
+///
+/// @a concreteInput is the first route whose concrete matcher has the same
+/// (origin, description, subSpec) as the data, or INVALID_INPUT if there is
+/// none. For it we only need to check the start time against the context,
+/// like the StartTimeValueMatcher{ContextRef{0}} in its matcher tree would do.
+/// The routes in @a wildcardRoutes still go through the full matcher tree,
+/// in the same order as before, so that the first matching route wins.
+int matchToContext(void* data,
+                   HeaderStackIndex const& headerIndex,
+                   std::vector<DataDescriptorMatcher> const& matchers,
+                   std::vector<size_t> const& wildcardRoutes,
+                   int concreteInput,
+                   uint64_t startTime,
+                   VariableContext& context)
 {
-  for (size_t ri = 0, re = matchers.size(); ri < re; ++ri) {
-    auto& matcher = matchers[ri];
+  auto matchConcrete = [startTime, &context]() -> bool {
+    if (auto value = std::get_if<uint64_t>(&context.get(0))) {
+      return *value == startTime;
+    }
+    context.put({0, startTime});
+    context.commit();
+    return true;
+  };
 
-    if (matcher.match(reinterpret_cast<char const*>(data), context)) {
+  bool concreteChecked = concreteInput == INVALID_INPUT;
+  for (auto ri : wildcardRoutes) {
+    if (concreteChecked == false && ri > (size_t)concreteInput) {
+      concreteChecked = true;
+      if (matchConcrete()) {
+        return concreteInput;
+      }
+    }
+    if (matchers[ri].match(reinterpret_cast<char const*>(data), headerIndex, context)) {
       context.commit();
       return ri;
     }
     context.discard();
   }
+  if (concreteChecked == false && matchConcrete()) {
+    return concreteInput;
+  }
   return INVALID_INPUT;
 }
 
+/// @return true if the two variables hold the same value. We cannot
+/// simply compare the variants, because None is not comparable.
+bool isSameVariable(ContextElement::Value const& a, ContextElement::Value const& b)
+{
+  if (a.index() != b.index()) {
+    return false;
+  }
+  if (auto pval = std::get_if<uint64_t>(&a)) {
+    return *pval == std::get<uint64_t>(b);
+  } else if (auto pval2 = std::get_if<uint32_t>(&a)) {
+    return *pval2 == std::get<uint32_t>(b);
+  } else if (auto pval3 = std::get_if<std::string>(&a)) {
+    return *pval3 == std::get<std::string>(b);
+  }
+  return true;
+}
+
 /// Send the contents of a context as metrics, so that we can examine them in
-/// the GUI.
+/// the GUI. Only the variables which differ from what is in @a lastSent are
+/// sent, and @a lastSent is updated accordingly.
 void sendVariableContextMetrics(VariableContext& context, TimesliceSlot slot,
-                                monitoring::Monitoring& metrics, std::vector<std::string> const& names)
+                                monitoring::Monitoring& metrics, std::vector<std::string> const& names,
+                                std::vector<ContextElement::Value>& lastSent)
 {
-  const std::string nullstring{"null"};
+  static const std::string nullstring{"null"};
 
   for (size_t i = 0; i < MAX_MATCHING_VARIABLE; i++) {
     auto& var = context.get(i);
+    auto& last = lastSent[16 * slot.index + i];
+    if (isSameVariable(var, last)) {
+      continue;
+    }
     if (auto pval = std::get_if<uint64_t>(&var)) {
       metrics.send(monitoring::Metric{std::to_string(*pval), names[16 * slot.index + i]});
     } else if (auto pval2 = std::get_if<std::string>(&var)) {
@@ -159,12 +228,22 @@ void sendVariableContextMetrics(VariableContext& context, TimesliceSlot slot,
     } else {
       metrics.send(monitoring::Metric{nullstring, names[16 * slot.index + i]});
     }
+    last = var;
   }
 }
 
 DataRelayer::RelayChoice
   DataRelayer::relay(std::unique_ptr<FairMQMessage>&& header,
                      std::unique_ptr<FairMQMessage>&& payload)
+{
+  auto headerIndex = HeaderStackIndex::parse(header->GetData());
+  return relay(std::move(header), std::move(payload), headerIndex);
+}
+
+DataRelayer::RelayChoice
+  DataRelayer::relay(std::unique_ptr<FairMQMessage>&& header,
+                     std::unique_ptr<FairMQMessage>&& payload,
+                     HeaderStackIndex const& headerIndex)
 {
   // STATE HOLDING VARIABLES
   // This is the class level state of the relaying. If we start supporting
@@ -179,16 +258,34 @@ DataRelayer::RelayChoice
 
   // IMPLEMENTATION DETAILS
   //
+  // The concrete routes only depend on the DataHeader, so we look them up
+  // once per message, rather than once per slot.
+  int concreteInput = INVALID_INPUT;
+  uint64_t startTime = 0;
+  auto dh = headerIndex.get<DataHeader>(header->GetData());
+  auto dph = headerIndex.get<DataProcessingHeader>(header->GetData());
+  if (dh && dph) {
+    auto ci = mConcreteRoutes.find(ConcreteDataMatcher{dh->dataOrigin, dh->dataDescription, dh->subSpecification});
+    if (ci != mConcreteRoutes.end()) {
+      concreteInput = ci->second;
+      startTime = dph->startTime;
+    }
+  }
+
   // This returns the identifier for the given input. We use a separate
   // function because while it's trivial now, the actual matchmaking will
   // become more complicated when we will start supporting ranges.
   auto getInputTimeslice = [& matchers = mInputMatchers,
+                            &wildcardRoutes = mWildcardRoutes,
+                            concreteInput,
+                            startTime,
                             &header,
+                            &headerIndex,
                             &index](VariableContext& context)
     -> std::tuple<int, TimesliceId> {
     /// FIXME: for the moment we only use the first context and reset
     /// between one invokation and the other.
-    auto input = matchToContext(header->GetData(), matchers, context);
+    auto input = matchToContext(header->GetData(), headerIndex, matchers, wildcardRoutes, concreteInput, startTime, context);
 
     if (input == INVALID_INPUT) {
       return {
@@ -254,6 +351,16 @@ DataRelayer::RelayChoice
     assert(header.get() == nullptr && payload.get() == nullptr);
   };
 
+  // Keep track of how many slots are used at the same time, so that
+  // we know by how much we can shrink the pipeline.
+  auto updatePeakUsage = [&index, &peak = mPeakUsedSlots]() {
+    size_t used = 0;
+    for (size_t ci = 0; ci < index.size(); ++ci) {
+      used += index.isValid(TimesliceSlot{ci}) ? 1 : 0;
+    }
+    peak = std::max(peak, used);
+  };
+
   auto updateStatistics = [& stats = mStats](TimesliceIndex::ActionTaken action) {
     // Update statistics for what happened
     switch (action) {
@@ -316,6 +423,7 @@ DataRelayer::RelayChoice
     saveInSlot(timeslice, input, slot);
     index.publishSlot(slot);
     index.markAsDirty(slot, true);
+    updatePeakUsage();
     mStats.relayedMessages++;
     return WillRelay;
   }
@@ -325,9 +433,8 @@ DataRelayer::RelayChoice
   VariableContext pristineContext;
   std::tie(input, timeslice) = getInputTimeslice(pristineContext);
 
-  auto DataHeaderInfo = [&header]() {
+  auto DataHeaderInfo = [dh]() {
     std::string error;
-    const auto* dh = o2::header::get<o2::header::DataHeader*>(header->GetData());
     if (dh) {
       error += dh->dataOrigin.as<std::string>() + "/" + dh->dataDescription.as<std::string>() + "/" + dh->subSpecification;
     } else {
@@ -357,6 +464,7 @@ DataRelayer::RelayChoice
 
   if (action == TimesliceIndex::ActionTaken::DropObsolete) {
     LOG(WARNING) << "Incoming data is already obsolete, not relaying.";
+    mDroppedTimeslices.push_back(timeslice);
     return WillNotRelay;
   }
 
@@ -366,11 +474,25 @@ DataRelayer::RelayChoice
   }
 
   // At this point the variables match the new input but the
-  // cache still holds the old data, so we prune it.
+  // cache still holds the old data, so we prune it. The timeslice it
+  // belonged to will never be processed.
+  if (action == TimesliceIndex::ActionTaken::ReplaceObsolete) {
+    for (size_t ai = slot.index * numInputTypes, ae = ai + numInputTypes; ai != ae; ++ai) {
+      if (cache[ai].header == nullptr) {
+        continue;
+      }
+      auto oldDph = o2::header::get<DataProcessingHeader*>(cache[ai].header->GetData());
+      if (oldDph) {
+        mDroppedTimeslices.push_back(TimesliceId{oldDph->startTime});
+        break;
+      }
+    }
+  }
   pruneCache(slot);
   saveInSlot(timeslice, input, slot);
   index.publishSlot(slot);
   index.markAsDirty(slot, true);
+  updatePeakUsage();
 
   return WillRelay;
 }
@@ -500,6 +622,13 @@ std::vector<std::unique_ptr<FairMQMessage>>
   return std::move(messages);
 }
 
+std::vector<TimesliceId> DataRelayer::getDroppedTimeslices()
+{
+  std::vector<TimesliceId> result;
+  result.swap(mDroppedTimeslices);
+  return result;
+}
+
 size_t
   DataRelayer::getParallelTimeslices() const
 {
@@ -517,6 +646,85 @@ void DataRelayer::setPipelineLength(size_t s)
   publishMetrics();
 }
 
+void DataRelayer::setAdaptivePipelineLength(size_t maxLength, size_t maxCachedBytes)
+{
+  mMaxPipelineLength = maxLength ? std::max(maxLength, MIN_PIPELINE_LENGTH) : 0;
+  mMaxCachedBytes = maxCachedBytes;
+  mLastDroppedComputations = mStats.droppedComputations;
+  mPeakUsedSlots = 0;
+  mQuietIntervals = 0;
+  if (mMaxPipelineLength && mTimesliceIndex.size() > mMaxPipelineLength) {
+    setPipelineLength(mMaxPipelineLength);
+  }
+}
+
+bool DataRelayer::adaptPipelineLength()
+{
+  if (mMaxPipelineLength == 0 || mDistinctRoutesIndex.empty()) {
+    return false;
+  }
+  auto const current = mTimesliceIndex.size();
+  auto const dropped = mStats.droppedComputations - mLastDroppedComputations;
+  auto const peak = mPeakUsedSlots;
+  mLastDroppedComputations = mStats.droppedComputations;
+  mPeakUsedSlots = 0;
+
+  size_t target = current;
+  if (dropped > 0) {
+    // We did not have enough slots to keep all the incomplete timeslices,
+    // so we double the pipeline, unless the estimated memory footprint
+    // would be too large.
+    mQuietIntervals = 0;
+    target = std::min(mMaxPipelineLength, std::max(current * 2, MIN_PIPELINE_LENGTH));
+    size_t used = 0;
+    for (size_t ci = 0; ci < current; ++ci) {
+      used += mTimesliceIndex.isValid(TimesliceSlot{ci}) ? 1 : 0;
+    }
+    if (mMaxCachedBytes && used && getCachedBytes() / used * target > mMaxCachedBytes) {
+      LOG(WARNING) << "Not growing pipeline beyond " << current << " slots because of memory pressure";
+      target = current;
+    }
+  } else if (2 * peak < current && ++mQuietIntervals >= SHRINK_AFTER_QUIET_INTERVALS) {
+    // Most of the slots were unused for a while. We shrink, keeping twice
+    // the peak usage as headroom. Only the trailing slots can be removed,
+    // so we stop at the last one which is still in use.
+    mQuietIntervals = 0;
+    target = std::max(2 * peak, MIN_PIPELINE_LENGTH);
+    auto const numInputTypes = mDistinctRoutesIndex.size();
+    for (size_t si = current; si > target; --si) {
+      bool inUse = mTimesliceIndex.isValid(TimesliceSlot{si - 1});
+      for (size_t ai = (si - 1) * numInputTypes, ae = ai + numInputTypes; ai != ae; ++ai) {
+        inUse |= (mCache[ai].header != nullptr) || (mCache[ai].payload != nullptr);
+      }
+      if (inUse) {
+        target = si;
+        break;
+      }
+    }
+  }
+
+  if (target == current) {
+    return false;
+  }
+  LOG(INFO) << "Resizing pipeline from " << current << " to " << target << " slots";
+  setPipelineLength(target);
+  mStats.pipelineResizes++;
+  mMetrics.send({(int)target, "data_relayer/pipeline_length"});
+  mMetrics.send({(int)mStats.pipelineResizes, "data_relayer/pipeline_resizes"});
+  return true;
+}
+
+size_t DataRelayer::getCachedBytes() const
+{
+  size_t result = 0;
+  for (auto& part : mCache) {
+    if (part.payload) {
+      result += part.payload->GetSize();
+    }
+  }
+  return result;
+}
+
 void DataRelayer::publishMetrics()
 {
   auto numInputTypes = mDistinctRoutesIndex.size();
@@ -547,6 +755,9 @@ void DataRelayer::publishMetrics()
     assert(ci < sVariablesMetricsNames.size());
     mMetrics.send({std::string("null"), sVariablesMetricsNames[ci]});
   }
+  // Everything was reset to its default, so this is what was last sent.
+  mLastSentStateMetrics.assign(mCache.size(), 0);
+  mLastSentVariables.assign(mVariableContextes.size() * 16, None{});
 }
 
 DataRelayerStats const& DataRelayer::getStats() const
@@ -559,10 +770,14 @@ void DataRelayer::sendContextState()
   for (size_t ci = 0; ci < mTimesliceIndex.size(); ++ci) {
     auto slot = TimesliceSlot{ci};
     sendVariableContextMetrics(mTimesliceIndex.getPublishedVariablesForSlot(slot), slot,
-                               mMetrics, sVariablesMetricsNames);
+                               mMetrics, sVariablesMetricsNames, mLastSentVariables);
   }
   for (size_t si = 0; si < mCachedStateMetrics.size(); ++si) {
+    if (mCachedStateMetrics[si] == mLastSentStateMetrics[si]) {
+      continue;
+    }
     mMetrics.send({mCachedStateMetrics[si], sMetricsNames[si]});
+    mLastSentStateMetrics[si] = mCachedStateMetrics[si];
   }
 }
 
@@ -73,6 +73,12 @@ class DataSamplingConditionCustom : public DataSamplingCondition
     return mCondition->decide(dataRef);
   }
 
+  /// \brief Invokes decideBatch() of a custom condition
+  void decideBatch(const DataSamplingBatch& batch, std::vector<uint8_t>& mask) override
+  {
+    mCondition->decideBatch(batch, mask);
+  }
+
  private:
   std::unique_ptr<DataSamplingCondition> mCondition;
 };
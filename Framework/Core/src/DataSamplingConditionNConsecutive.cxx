@@ -54,6 +54,15 @@ class DataSamplingConditionNConsecutive : public DataSamplingCondition
     // strongly relying on assumption, that timesliceID always increments by one.
     return dpHeader->startTime % mCycleSize < mSamplesNumber;
   }
+  /// \brief Same as above, for all the samples of the batch at once
+  void decideBatch(const DataSamplingBatch& batch, std::vector<uint8_t>& mask) override
+  {
+    const auto* startTimes = batch.startTimes.data();
+    auto* result = mask.data();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      result[i] = result[i] && startTimes[i] % mCycleSize < mSamplesNumber;
+    }
+  }
 
  private:
   size_t mSamplesNumber;
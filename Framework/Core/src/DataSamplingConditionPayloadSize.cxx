@@ -52,6 +52,15 @@ class DataSamplingConditionPayloadSize : public DataSamplingCondition
 
     return header->payloadSize >= mLowerLimit && header->payloadSize <= mUpperLimit;
   }
+  /// \brief Same as above, for all the samples of the batch at once
+  void decideBatch(const DataSamplingBatch& batch, std::vector<uint8_t>& mask) override
+  {
+    const auto* sizes = batch.payloadSizes.data();
+    auto* result = mask.data();
+    for (size_t i = 0; i < batch.size(); ++i) {
+      result[i] = result[i] && sizes[i] >= mLowerLimit && sizes[i] <= mUpperLimit;
+    }
+  }
 
  private:
   size_t mLowerLimit;
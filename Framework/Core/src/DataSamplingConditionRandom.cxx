@@ -56,7 +56,23 @@ class DataSamplingConditionRandom : public DataSamplingCondition
     const auto* dpHeader = get<DataProcessingHeader*>(dataRef.header);
     assert(dpHeader);
 
-    int64_t diff = dpHeader->startTime - mCurrentTimesliceID;
+    return decide(dpHeader->startTime);
+  }
+  /// \brief Same as above, for all the samples of the batch at once. Samples of the same timeslice
+  /// share the same decision, so the generator is only moved when the timeslice changes.
+  void decideBatch(const DataSamplingBatch& batch, std::vector<uint8_t>& mask) override
+  {
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (mask[i]) {
+        mask[i] = decide(batch.startTimes[i]);
+      }
+    }
+  }
+
+ private:
+  bool decide(DataProcessingHeader::StartTime timeslice)
+  {
+    int64_t diff = timeslice - mCurrentTimesliceID;
     if (diff == -1) {
       return mLastDecision;
     } else if (diff < -1) {
@@ -66,11 +82,10 @@ class DataSamplingConditionRandom : public DataSamplingCondition
     }
 
     mLastDecision = mGenerator() < mThreshold;
-    mCurrentTimesliceID = dpHeader->startTime + 1;
+    mCurrentTimesliceID = timeslice + 1;
     return mLastDecision;
   }
 
- private:
   uint32_t mThreshold;
   pcg32_fast mGenerator;
   bool mLastDecision;
@@ -19,6 +19,8 @@
 #include "Framework/DataSpecUtils.h"
 #include "Framework/DataDescriptorQueryBuilder.h"
 
+#include <algorithm>
+
 namespace o2
 {
 namespace framework
@@ -126,6 +128,21 @@ bool DataSamplingPolicy::decide(const o2::framework::DataRef& dataRef)
   return decision;
 }
 
+void DataSamplingPolicy::decide(const DataSamplingBatch& batch, std::vector<uint8_t>& mask)
+{
+  // Any non-zero value marks a sample to be evaluated, as in DataSamplingCondition::decideBatch
+  auto isSet = [](uint8_t value) { return value != 0; };
+  auto accepted = [&mask, &isSet]() { return static_cast<uint32_t>(std::count_if(mask.begin(), mask.end(), isSet)); };
+  mTotalEvaluatedMessages += accepted();
+  for (auto& condition : mConditions) {
+    if (std::none_of(mask.begin(), mask.end(), isSet)) {
+      break;
+    }
+    condition->decideBatch(batch, mask);
+  }
+  mTotalAcceptedMessages += accepted();
+}
+
 const Output DataSamplingPolicy::prepareOutput(const ConcreteDataMatcher& input, Lifetime lifetime) const
 {
   auto result = mPaths.find(input);
@@ -169,6 +186,21 @@ uint32_t DataSamplingPolicy::getTotalEvaluatedMessages() const
   return mTotalEvaluatedMessages;
 }
 
+void DataSamplingPolicy::accountSampledBytes(uint64_t bytes, bool shared)
+{
+  (shared ? mTotalSharedBytes : mTotalCopiedBytes) += bytes;
+}
+
+uint64_t DataSamplingPolicy::getTotalSharedBytes() const
+{
+  return mTotalSharedBytes;
+}
+
+uint64_t DataSamplingPolicy::getTotalCopiedBytes() const
+{
+  return mTotalCopiedBytes;
+}
+
 header::DataOrigin DataSamplingPolicy::createPolicyDataOrigin()
 {
   return header::DataOrigin("DS");
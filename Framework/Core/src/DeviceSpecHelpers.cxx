@@ -323,8 +323,17 @@ void DeviceSpecHelpers::processOutEdgeActions(std::vector<DeviceSpec>& devices,
         consumer.maxInputTimeslices,
         outputsMatchers[edge.outputGlobalIndex],
         channel.name};
+      if (consumer.maxInputTimeslices != 1) {
+        route.dispatch = consumer.timePipelineDispatch;
+        route.consumer = consumer.name;
+      }
       device.outputs.emplace_back(route);
     } else {
+      // A device forwarding its inputs does not know which replica they
+      // were given to by their producer.
+      if (consumer.maxInputTimeslices != 1 && consumer.timePipelineDispatch == TimePipelineDispatch::LeastLoaded) {
+        throw std::runtime_error("Time pipeline " + consumer.name + " cannot be LeastLoaded, since it gets its inputs forwarded by " + device.id);
+      }
       ForwardRoute route{
         edge.timeIndex,
         consumer.maxInputTimeslices,
@@ -617,6 +626,71 @@ void DeviceSpecHelpers::processInEdgeActions(std::vector<DeviceSpec>& devices,
   resourceManager.notifyAcceptedOffer(acceptedOffer);
 }
 
+void DeviceSpecHelpers::connectTimePipelineCredits(std::vector<DeviceSpec>& devices,
+                                                   ResourceManager& resourceManager)
+{
+  // The devices feeding each of the LeastLoaded time pipelines.
+  std::map<std::string, std::vector<size_t>> producers;
+  for (size_t di = 0; di < devices.size(); ++di) {
+    for (auto& route : devices[di].outputs) {
+      if (route.dispatch != TimePipelineDispatch::LeastLoaded) {
+        continue;
+      }
+      auto& feeding = producers[route.consumer];
+      if (std::find(feeding.begin(), feeding.end(), di) == feeding.end()) {
+        feeding.push_back(di);
+      }
+    }
+  }
+
+  for (auto& [consumer, feeding] : producers) {
+    // Each producer would pick replicas on its own, so the inputs of a
+    // given timeslice could end up in different replicas.
+    if (feeding.size() != 1) {
+      std::string ids;
+      for (auto di : feeding) {
+        ids += " " + devices[di].id;
+      }
+      throw std::runtime_error("Time pipeline " + consumer + " cannot be LeastLoaded, since it has more than one producer:" + ids);
+    }
+    auto& producer = devices[feeding.front()];
+    std::vector<size_t> replicas;
+    for (size_t di = 0; di < devices.size(); ++di) {
+      if (devices[di].name == consumer) {
+        replicas.push_back(di);
+      }
+    }
+
+    // The producer binds one channel per replica, so that it knows which
+    // one each credit comes from.
+    ComputingOffer offer;
+    for (auto& available : resourceManager.getAvailableOffers()) {
+      if (available.hostname == producer.resource.hostname && available.rangeSize >= replicas.size()) {
+        offer.hostname = available.hostname;
+        offer.startPort = available.startPort;
+        break;
+      }
+    }
+    if (offer.hostname.empty()) {
+      throw std::runtime_error("No ports left on " + producer.resource.hostname + " for the credits of time pipeline " + consumer);
+    }
+    for (auto di : replicas) {
+      auto& replica = devices[di];
+      unsigned short port = offer.startPort + offer.rangeSize;
+      offer.rangeSize += 1;
+      std::string name = "credits_from_" + replica.id + "_to_" + producer.id;
+      producer.creditInputChannels.push_back(InputChannelSpec{name, ChannelType::Pull, ChannelMethod::Bind, offer.hostname, port});
+      replica.creditOutputChannels.push_back(OutputChannelSpec{name, ChannelType::Push, ChannelMethod::Connect, offer.hostname, port, 1});
+      for (auto& route : producer.outputs) {
+        if (route.consumer == consumer && route.timeslice == replica.inputTimesliceId) {
+          route.creditChannel = name;
+        }
+      }
+    }
+    resourceManager.notifyAcceptedOffer(offer);
+  }
+}
+
 // Construct the list of actual devices we want, given a workflow.
 //
 // FIXME: make start port configurable?
@@ -686,6 +760,7 @@ void DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(WorkflowSpec const& workf
 
   processInEdgeActions(devices, deviceIndex, connections, resourceManager, inEdgeIndex, logicalEdges,
                        inActions, workflow, availableForwardsInfo, channelPolicies, defaultOffer);
+  connectTimePipelineCredits(devices, resourceManager);
   // We apply the completion policies here since this is where we have all the
   // devices resolved.
   for (auto& device : devices) {
@@ -841,6 +916,11 @@ void DeviceSpecHelpers::prepareArguments(bool defaultQuiet, bool defaultStopped,
         realOdesc.add_options()("child-driver", bpo::value<std::string>());
         realOdesc.add_options()("rate", bpo::value<std::string>());
         realOdesc.add_options()("shm-segment-size", bpo::value<std::string>());
+        realOdesc.add_options()("worker-threads", bpo::value<std::string>());
+        realOdesc.add_options()("max-pipeline-length", bpo::value<std::string>());
+        realOdesc.add_options()("max-pipeline-bytes", bpo::value<std::string>());
+        realOdesc.add_options()("polling-timeout", bpo::value<std::string>());
+        realOdesc.add_options()("message-pool-size", bpo::value<std::string>());
         filterArgsFct(expansions.we_wordc, expansions.we_wordv, realOdesc);
         wordfree(&expansions);
         return;
@@ -898,6 +978,14 @@ void DeviceSpecHelpers::prepareArguments(bool defaultQuiet, bool defaultStopped,
       tmpArgs.emplace_back(std::string("--channel-config"));
       tmpArgs.emplace_back(inputChannel2String(channel));
     }
+    for (auto& channel : spec.creditOutputChannels) {
+      tmpArgs.emplace_back(std::string("--channel-config"));
+      tmpArgs.emplace_back(outputChannel2String(channel));
+    }
+    for (auto& channel : spec.creditInputChannels) {
+      tmpArgs.emplace_back(std::string("--channel-config"));
+      tmpArgs.emplace_back(inputChannel2String(channel));
+    }
 
     // We create the final option list, depending on the channels
     // which are present in a device.
@@ -935,6 +1023,11 @@ boost::program_options::options_description DeviceSpecHelpers::getForwardedDevic
     ("monitoring-backend", bpo::value<std::string>(), "monitoring connection string")                           //
     ("infologger-mode", bpo::value<std::string>(), "INFOLOGGER_MODE override")                                  //
     ("infologger-severity", bpo::value<std::string>(), "minimun FairLogger severity which goes to info logger") //
+    ("worker-threads", bpo::value<std::string>(), "number of threads processing timeslices concurrently")       //
+    ("max-pipeline-length", bpo::value<std::string>(), "upper bound for the runtime tuned pipeline length")     //
+    ("max-pipeline-bytes", bpo::value<std::string>(), "cached bytes above which the pipeline does not grow")    //
+    ("polling-timeout", bpo::value<std::string>(), "max ms to sleep waiting for inputs or timers")              //
+    ("message-pool-size", bpo::value<std::string>(), "bytes per output channel to recycle messages from")      //
     ("child-driver", bpo::value<std::string>(), "external driver to start childs with (e.g. valgrind)");        //
 
   return forwardedDeviceOptions;
@@ -104,6 +104,13 @@ struct DeviceSpecHelpers {
     std::vector<ChannelConfigurationPolicy> const& channelPolicies,
     ComputingOffer const& defaultOffer);
 
+  /// This creates the channels over which the replicas of the
+  /// LeastLoaded time pipelines give back their credits to
+  /// their producer, and checks that each of them has only one.
+  static void connectTimePipelineCredits(
+    std::vector<DeviceSpec>& devices,
+    ResourceManager& resourceManager);
+
   /// return a description of all options to be forwarded to the device
   /// by default
   static boost::program_options::options_description getForwardedDeviceOptions();
@@ -22,15 +22,41 @@
 
 #include <Configuration/ConfigurationInterface.h>
 #include <Configuration/ConfigurationFactory.h>
+#include <Monitoring/Monitoring.h>
 #include <fairmq/FairMQDevice.h>
 
 using namespace o2::configuration;
+using o2::monitoring::Metric;
+using o2::monitoring::Monitoring;
 
 namespace o2
 {
 namespace framework
 {
 
+namespace
+{
+// Creates a message which refers to the same buffer as @a source, when the
+// transport allows it. This is zero-copy for the transports which refcount
+// their buffers, otherwise the transport copies the data itself.
+FairMQMessagePtr shareMessage(FairMQTransportFactory& transport, FairMQMessage const* source)
+{
+  if (source == nullptr || transport.GetType() != source->GetType()) {
+    return nullptr;
+  }
+  FairMQMessagePtr message = transport.CreateMessage();
+  message->Copy(*source);
+  return message;
+}
+
+FairMQMessagePtr copyMessage(FairMQTransportFactory& transport, char const* payload, size_t payloadSize)
+{
+  FairMQMessagePtr message = transport.CreateMessage(payloadSize);
+  memcpy(message->GetData(), payload, payloadSize);
+  return message;
+}
+} // namespace
+
 Dispatcher::Dispatcher(std::string name, const std::string reconfigurationSource)
   : mName(name), mReconfigurationSource(reconfigurationSource)
 {
@@ -62,35 +88,82 @@ void Dispatcher::init(InitContext& ctx)
 
 void Dispatcher::run(ProcessingContext& ctx)
 {
-  for (const auto& input : ctx.inputs()) {
+  auto& device = *ctx.services().get<RawDeviceService>().device();
+  std::vector<DataSamplingPolicy*> sampledPolicies;
+
+  // All the inputs are evaluated at once by each policy, so that the
+  // conditions are invoked once per timeslice rather than once per input.
+  auto& inputRecord = ctx.inputs();
+  DataSamplingBatch batch;
+  std::vector<int> positions;
+  std::vector<ConcreteDataMatcher> inputMatchers;
+  for (int pos = 0; pos < static_cast<int>(inputRecord.size()); ++pos) {
+    auto input = inputRecord.getByPos(pos);
     if (input.header != nullptr && input.spec != nullptr) {
       const auto* inputHeader = header::get<header::DataHeader*>(input.header);
-      ConcreteDataMatcher inputMatcher{inputHeader->dataOrigin, inputHeader->dataDescription, inputHeader->subSpecification};
-
-      for (auto& policy : mPolicies) {
-        // todo: consider getting the outputSpec in match to improve performance
-        // todo: consider matching (and deciding) in completion policy to save some time
-
-        if (policy->match(inputMatcher) && policy->decide(input)) {
-
-          // We copy every header which is not DataHeader or DataProcessingHeader,
-          // so that custom data-dependent headers are passed forward,
-          // and we add a DataSamplingHeader.
-          header::Stack headerStack{
-            std::move(extractAdditionalHeaders(input.header)),
-            std::move(prepareDataSamplingHeader(*policy.get(), ctx.services().get<const DeviceSpec>()))};
-
-          if (!policy->getFairMQOutputChannel().empty()) {
-            sendFairMQ(ctx.services().get<RawDeviceService>().device(), input, policy->getFairMQOutputChannelName(), std::move(headerStack));
-          } else {
-            Output output = policy->prepareOutput(inputMatcher, input.spec->lifetime);
-            output.metaHeader = std::move(header::Stack{std::move(output.metaHeader), std::move(headerStack)});
-            send(ctx.outputs(), input, std::move(output));
-          }
-        }
+      inputMatchers.push_back(ConcreteDataMatcher{inputHeader->dataOrigin, inputHeader->dataDescription, inputHeader->subSpecification});
+      positions.push_back(pos);
+      batch.add(input);
+    }
+  }
+
+  std::vector<uint8_t> mask(batch.size());
+  for (auto& policy : mPolicies) {
+    // todo: consider getting the outputSpec in match to improve performance
+    // todo: consider matching (and deciding) in completion policy to save some time
+    for (size_t i = 0; i < batch.size(); ++i) {
+      mask[i] = policy->match(inputMatchers[i]);
+    }
+    policy->decide(batch, mask);
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      if (mask[i] == 0) {
+        continue;
+      }
+      const auto& input = batch.refs[i];
+      const auto& inputMatcher = inputMatchers[i];
+      const auto payloadSize = batch.payloadSizes[i];
+
+      // We copy every header which is not DataHeader or DataProcessingHeader,
+      // so that custom data-dependent headers are passed forward,
+      // and we add a DataSamplingHeader.
+      header::Stack headerStack{
+        std::move(extractAdditionalHeaders(input.header)),
+        std::move(prepareDataSamplingHeader(*policy.get(), ctx.services().get<const DeviceSpec>()))};
+
+      auto payloadMessage = samplePayload(*device.Transport(), inputRecord.getPayloadMessage(positions[i]), input.payload, payloadSize, *policy);
+      if (std::find(sampledPolicies.begin(), sampledPolicies.end(), policy.get()) == sampledPolicies.end()) {
+        sampledPolicies.push_back(policy.get());
+      }
+
+      if (!policy->getFairMQOutputChannel().empty()) {
+        sendFairMQ(&device, input, std::move(payloadMessage), policy->getFairMQOutputChannelName(), std::move(headerStack));
+      } else {
+        Output output = policy->prepareOutput(inputMatcher, input.spec->lifetime);
+        output.metaHeader = std::move(header::Stack{std::move(output.metaHeader), std::move(headerStack)});
+        send(ctx.outputs(), input, std::move(payloadMessage), std::move(output));
       }
     }
   }
+
+  auto& monitoring = ctx.services().get<Monitoring>();
+  for (auto policy : sampledPolicies) {
+    monitoring.send(Metric{static_cast<double>(policy->getTotalSharedBytes()), "datasampling_" + policy->getName() + "_shared_bytes"});
+    monitoring.send(Metric{static_cast<double>(policy->getTotalCopiedBytes()), "datasampling_" + policy->getName() + "_copied_bytes"});
+  }
+}
+
+FairMQMessagePtr Dispatcher::samplePayload(FairMQTransportFactory& transport, FairMQMessage const* inputMessage,
+                                           const char* payload, size_t payloadSize, DataSamplingPolicy& policy)
+{
+  // The sampled payload refers to the input one whenever possible.
+  auto payloadMessage = shareMessage(transport, inputMessage);
+  bool shared = payloadMessage && payloadMessage->GetData() == payload;
+  if (!payloadMessage) {
+    payloadMessage = copyMessage(transport, payload, payloadSize);
+  }
+  policy.accountSampledBytes(payloadSize, shared);
+  return payloadMessage;
 }
 
 DataSamplingHeader Dispatcher::prepareDataSamplingHeader(const DataSamplingPolicy& policy, const DeviceSpec& spec)
@@ -122,15 +195,15 @@ header::Stack Dispatcher::extractAdditionalHeaders(const char* inputHeaderStack)
   return headerStack;
 }
 
-void Dispatcher::send(DataAllocator& dataAllocator, const DataRef& inputData, Output&& output) const
+void Dispatcher::send(DataAllocator& dataAllocator, const DataRef& inputData, FairMQMessagePtr&& payload, Output&& output) const
 {
   const auto* inputHeader = header::get<header::DataHeader*>(inputData.header);
-  dataAllocator.snapshot(output, inputData.payload, inputHeader->payloadSize, inputHeader->payloadSerializationMethod);
+  dataAllocator.adoptMessage(output, std::move(payload), inputHeader->payloadSerializationMethod);
 }
 
 // ideally this should be in a separate proxy device or use Lifetime::External
-void Dispatcher::sendFairMQ(FairMQDevice* device, const DataRef& inputData, const std::string& fairMQChannel,
-                            header::Stack&& stack) const
+void Dispatcher::sendFairMQ(FairMQDevice* device, const DataRef& inputData, FairMQMessagePtr&& payload,
+                            const std::string& fairMQChannel, header::Stack&& stack) const
 {
   const auto* dh = header::get<header::DataHeader*>(inputData.header);
   assert(dh);
@@ -145,14 +218,9 @@ void Dispatcher::sendFairMQ(FairMQDevice* device, const DataRef& inputData, cons
   auto channelAlloc = o2::pmr::getTransportAllocator(device->Transport());
   FairMQMessagePtr msgHeaderStack = o2::pmr::getMessage(std::move(headerStack), channelAlloc);
 
-  char* payloadCopy = new char[dh->payloadSize];
-  memcpy(payloadCopy, inputData.payload, dh->payloadSize);
-  auto cleanupFcn = [](void* data, void*) { delete[] reinterpret_cast<char*>(data); };
-  FairMQMessagePtr msgPayload(device->NewMessage(payloadCopy, dh->payloadSize, cleanupFcn, payloadCopy));
-
   FairMQParts message;
   message.AddPart(move(msgHeaderStack));
-  message.AddPart(move(msgPayload));
+  message.AddPart(move(payload));
 
   int64_t bytesSent = device->Send(message, fairMQChannel);
 }
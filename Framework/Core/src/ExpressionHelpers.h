@@ -10,6 +10,7 @@
 #ifndef O2_FRAMEWORK_EXPRESSIONS_HELPERS_H_
 #define O2_FRAMEWORK_EXPRESSIONS_HELPERS_H_
 #include "Framework/Expressions.h"
+#include <gandiva/gandiva_aliases.h>
 #include <vector>
 #include <iosfwd>
 
@@ -41,6 +42,11 @@ struct ColumnOperationSpec {
 };
 
 std::vector<ColumnOperationSpec> createKernelsFromFilter(Filter const& filter);
+
+/// Build the gandiva expression tree corresponding to the flattened @a opSpecs,
+/// as returned by createKernelsFromFilter, for a table with the given @a schema.
+gandiva::NodePtr createExpressionTree(std::vector<ColumnOperationSpec> const& opSpecs,
+                                      std::shared_ptr<arrow::Schema> const& schema);
 } // namespace o2::framework::expressions
 
 #endif // O2_FRAMEWORK_EXPRESSIONS_HELPERS_H_
@@ -12,9 +12,16 @@
 #include "Framework/VariantHelpers.h"
 
 #include <arrow/table.h>
+#include <gandiva/filter.h>
 #include <gandiva/selection_vector.h>
+#include <gandiva/tree_expr_builder.h>
 #include <stack>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
 
 using namespace o2::framework;
 
@@ -136,14 +143,300 @@ std::vector<ColumnOperationSpec> createKernelsFromFilter(Filter const& filter)
   return columnOperationSpecs;
 }
 
-Selection createSelection(std::shared_ptr<arrow::Table> table, Filter const& expr)
+namespace
 {
-  std::shared_ptr<gandiva::SelectionVector> result;
-  auto status = gandiva::SelectionVector::MakeInt32(table->num_rows(), arrow::default_memory_pool(), &result);
+/// @return the gandiva name of the function implementing @a op
+std::string gandivaFunctionName(BasicOp op)
+{
+  switch (op) {
+    case BasicOp::Addition:
+      return "add";
+    case BasicOp::Subtraction:
+      return "subtract";
+    case BasicOp::Division:
+      return "divide";
+    case BasicOp::LessThan:
+      return "less_than";
+    case BasicOp::LessThanOrEqual:
+      return "less_than_or_equal_to";
+    case BasicOp::GreaterThan:
+      return "greater_than";
+    case BasicOp::GreaterThanOrEqual:
+      return "greater_than_or_equal_to";
+    case BasicOp::Equal:
+      return "equal";
+    default:
+      throw std::runtime_error("Operation not supported by gandiva");
+  }
+}
+
+/// @return true if @a v is represented exactly by the type T
+template <typename T, typename V>
+bool isLossless(V v)
+{
+  if constexpr (std::is_floating_point_v<V> && std::is_integral_v<T>) {
+    // The upper bound is a power of two, so it is exact also as a double.
+    auto upper = static_cast<V>(std::numeric_limits<T>::max() / 2 + 1) * 2;
+    return v >= static_cast<V>(std::numeric_limits<T>::lowest()) && v < upper && std::trunc(v) == v;
+  } else if constexpr (std::is_integral_v<V> && std::is_integral_v<T>) {
+    auto x = static_cast<int64_t>(v);
+    if constexpr (std::is_same_v<T, uint64_t>) {
+      return x >= 0;
+    } else {
+      return x >= static_cast<int64_t>(std::numeric_limits<T>::lowest()) && x <= static_cast<int64_t>(std::numeric_limits<T>::max());
+    }
+  } else {
+    return static_cast<V>(static_cast<T>(v)) == v;
+  }
+}
+
+template <typename T, typename V>
+gandiva::NodePtr makeLosslessLiteral(V v)
+{
+  if (isLossless<T>(v) == false) {
+    return nullptr;
+  }
+  return gandiva::TreeExprBuilder::MakeLiteral(static_cast<T>(v));
+}
+
+/// Gandiva does not do any implicit conversion, so literals need to be
+/// created with the same type of the column they are compared with.
+/// @return nullptr if the literal cannot be represented exactly by @a type,
+/// in which case the column needs to be promoted instead.
+gandiva::NodePtr makeLiteral(LiteralNode::var_t const& value, std::shared_ptr<arrow::DataType> const& type)
+{
+  return std::visit(
+    [&type](auto v) -> gandiva::NodePtr {
+      if (type == nullptr) {
+        return gandiva::TreeExprBuilder::MakeLiteral(v);
+      }
+      switch (type->id()) {
+        case arrow::Type::BOOL:
+          return makeLosslessLiteral<bool>(v);
+        case arrow::Type::INT8:
+          return makeLosslessLiteral<int8_t>(v);
+        case arrow::Type::INT16:
+          return makeLosslessLiteral<int16_t>(v);
+        case arrow::Type::INT32:
+          return makeLosslessLiteral<int32_t>(v);
+        case arrow::Type::INT64:
+          return makeLosslessLiteral<int64_t>(v);
+        case arrow::Type::UINT8:
+          return makeLosslessLiteral<uint8_t>(v);
+        case arrow::Type::UINT16:
+          return makeLosslessLiteral<uint16_t>(v);
+        case arrow::Type::UINT32:
+          return makeLosslessLiteral<uint32_t>(v);
+        case arrow::Type::UINT64:
+          return makeLosslessLiteral<uint64_t>(v);
+        case arrow::Type::FLOAT:
+          return makeLosslessLiteral<float>(v);
+        case arrow::Type::DOUBLE:
+          return makeLosslessLiteral<double>(v);
+        default:
+          throw std::runtime_error("Unsupported column type in filter: " + type->ToString());
+      }
+    },
+    value);
+}
+
+/// Promote @a node to double, for the cases in which a literal cannot be
+/// converted exactly to its type, e.g. n >= 6.5 with n an integer column.
+gandiva::NodePtr castToDouble(gandiva::NodePtr const& node, std::shared_ptr<arrow::DataType> const& type)
+{
+  switch (type->id()) {
+    case arrow::Type::INT32:
+    case arrow::Type::INT64:
+    case arrow::Type::FLOAT:
+      return gandiva::TreeExprBuilder::MakeFunction("castFLOAT8", {node}, arrow::float64());
+    default:
+      throw std::runtime_error("Literal in filter cannot be represented exactly as " + type->ToString());
+  }
+}
+
+std::shared_ptr<arrow::Field> getField(std::shared_ptr<arrow::Schema> const& schema, std::string const& name)
+{
+  auto field = schema->GetFieldByName(name);
+  if (field == nullptr) {
+    throw std::runtime_error("Unable to find column " + name + " used in filter");
+  }
+  return field;
+}
+} // namespace
+
+gandiva::NodePtr createExpressionTree(std::vector<ColumnOperationSpec> const& opSpecs,
+                                      std::shared_ptr<arrow::Schema> const& schema)
+{
+  // The specs are sorted so that the children of a node always come after
+  // it, so we build the tree backwards, keeping the nodes by result index.
+  std::unordered_map<size_t, gandiva::NodePtr> subtrees;
+
+  auto datumType = [&schema, &subtrees](DatumSpec const& spec) -> std::shared_ptr<arrow::DataType> {
+    if (auto index = std::get_if<size_t>(&spec.datum)) {
+      return subtrees.at(*index)->return_type();
+    } else if (auto name = std::get_if<std::string>(&spec.datum)) {
+      return getField(schema, *name)->type();
+    }
+    return nullptr;
+  };
+
+  auto datumNode = [&schema, &subtrees](DatumSpec const& spec, std::shared_ptr<arrow::DataType> const& otherType) -> gandiva::NodePtr {
+    if (auto index = std::get_if<size_t>(&spec.datum)) {
+      return subtrees.at(*index);
+    } else if (auto literal = std::get_if<LiteralNode::var_t>(&spec.datum)) {
+      return makeLiteral(*literal, otherType);
+    } else if (auto name = std::get_if<std::string>(&spec.datum)) {
+      return gandiva::TreeExprBuilder::MakeField(getField(schema, *name));
+    }
+    throw std::runtime_error("Malformed filter expression");
+  };
+
+  auto doubleLiteral = [](DatumSpec const& spec) {
+    return std::visit([](auto v) { return gandiva::TreeExprBuilder::MakeLiteral(static_cast<double>(v)); },
+                      std::get<LiteralNode::var_t>(spec.datum));
+  };
+
+  for (auto it = opSpecs.rbegin(); it != opSpecs.rend(); ++it) {
+    auto& spec = *it;
+    auto leftType = datumType(spec.left);
+    auto rightType = datumType(spec.right);
+    auto left = datumNode(spec.left, rightType);
+    auto right = datumNode(spec.right, leftType);
+    if (left == nullptr) {
+      left = doubleLiteral(spec.left);
+      right = castToDouble(right, rightType);
+    } else if (right == nullptr) {
+      right = doubleLiteral(spec.right);
+      left = castToDouble(left, leftType);
+    }
+    gandiva::NodePtr node;
+    switch (spec.op) {
+      case BasicOp::LogicalAnd:
+        node = gandiva::TreeExprBuilder::MakeAnd({left, right});
+        break;
+      case BasicOp::LogicalOr:
+        node = gandiva::TreeExprBuilder::MakeOr({left, right});
+        break;
+      case BasicOp::Addition:
+      case BasicOp::Subtraction:
+      case BasicOp::Division:
+        node = gandiva::TreeExprBuilder::MakeFunction(gandivaFunctionName(spec.op), {left, right}, left->return_type());
+        break;
+      default:
+        node = gandiva::TreeExprBuilder::MakeFunction(gandivaFunctionName(spec.op), {left, right}, arrow::boolean());
+        break;
+    }
+    subtrees[std::get<size_t>(spec.result.datum)] = node;
+  }
+  return subtrees.at(0);
+}
+
+bool isSchemaCompatible(std::shared_ptr<arrow::Schema> const& schema, Filter const& filter)
+{
+  for (auto& spec : createKernelsFromFilter(filter)) {
+    for (auto datum : {&spec.left, &spec.right}) {
+      auto name = std::get_if<std::string>(&datum->datum);
+      if (name != nullptr && schema->GetFieldByName(*name) == nullptr) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+FilterPtr createFilter(std::shared_ptr<arrow::Schema> const& schema, std::vector<Filter const*> const& filters)
+{
+  if (filters.empty()) {
+    return nullptr;
+  }
+  std::vector<gandiva::NodePtr> nodes;
+  for (auto filter : filters) {
+    nodes.push_back(createExpressionTree(createKernelsFromFilter(*filter), schema));
+  }
+  auto condition = gandiva::TreeExprBuilder::MakeCondition(nodes.size() == 1 ? nodes[0] : gandiva::TreeExprBuilder::MakeAnd(nodes));
+
+  // Building the expression tree is cheap, generating the code for it is
+  // not, so we keep around what we have already compiled.
+  static std::mutex cacheMutex;
+  static std::unordered_map<std::string, FilterPtr> cache;
+  auto key = schema->ToString() + "\n" + condition->ToString();
+  std::lock_guard<std::mutex> lock(cacheMutex);
+  auto cached = cache.find(key);
+  if (cached != cache.end()) {
+    return cached->second;
+  }
+  std::shared_ptr<gandiva::Filter> result;
+  auto status = gandiva::Filter::Make(schema, condition, &result);
+  if (status.ok() == false) {
+    throw std::runtime_error("Unable to compile filter: " + status.ToString());
+  }
+  cache.emplace(key, result);
+  return result;
+}
+
+FilterPtr createFilter(std::shared_ptr<arrow::Schema> const& schema, Filter const& filter)
+{
+  return createFilter(schema, std::vector<Filter const*>{&filter});
+}
+
+Selection createSelection(std::shared_ptr<arrow::Table> table, FilterPtr const& filter)
+{
+  Selection result;
+  auto status = gandiva::SelectionVector::MakeInt64(table->num_rows(), arrow::default_memory_pool(), &result);
   if (status.ok() == false) {
     throw std::runtime_error("Unable to create selection");
   }
+  if (filter == nullptr) {
+    for (int64_t ri = 0; ri < table->num_rows(); ++ri) {
+      result->SetIndex(ri, ri);
+    }
+    result->SetNumSlots(table->num_rows());
+    return result;
+  }
+
+  // Gandiva works on record batches, so in case the table is made of
+  // multiple chunks we need to evaluate them one by one and merge the
+  // resulting selections, shifting the indices by the batch offset.
+  arrow::TableBatchReader reader(*table);
+  std::shared_ptr<arrow::RecordBatch> batch;
+  int64_t offset = 0;
+  int64_t slots = 0;
+  while (true) {
+    status = reader.ReadNext(&batch);
+    if (status.ok() == false) {
+      throw std::runtime_error("Unable to read table: " + status.ToString());
+    }
+    if (batch == nullptr) {
+      break;
+    }
+    if (batch->num_rows() == table->num_rows()) {
+      status = filter->Evaluate(*batch, result);
+      if (status.ok() == false) {
+        throw std::runtime_error("Unable to evaluate filter: " + status.ToString());
+      }
+      return result;
+    }
+    Selection batchSelection;
+    status = gandiva::SelectionVector::MakeInt64(batch->num_rows(), arrow::default_memory_pool(), &batchSelection);
+    if (status.ok() == false) {
+      throw std::runtime_error("Unable to create selection");
+    }
+    status = filter->Evaluate(*batch, batchSelection);
+    if (status.ok() == false) {
+      throw std::runtime_error("Unable to evaluate filter: " + status.ToString());
+    }
+    for (int64_t si = 0; si < batchSelection->GetNumSlots(); ++si) {
+      result->SetIndex(slots++, offset + batchSelection->GetIndex(si));
+    }
+    offset += batch->num_rows();
+  }
+  result->SetNumSlots(slots);
   return result;
 }
 
+Selection createSelection(std::shared_ptr<arrow::Table> table, Filter const& expression)
+{
+  return createSelection(table, createFilter(table->schema(), expression));
+}
+
 } // namespace o2::framework::expressions
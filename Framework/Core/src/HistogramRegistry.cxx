@@ -0,0 +1,194 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/HistogramRegistry.h"
+
+#include <type_traits>
+
+namespace o2::framework
+{
+
+namespace
+{
+void checkAxes(HistogramSpec const& spec, size_t dimension)
+{
+  if (spec.config.axes.size() != dimension) {
+    throw std::runtime_error("Histogram " + spec.name + " of kind " + spec.config.kind + " needs " + std::to_string(dimension) + " axes");
+  }
+}
+
+template <typename T>
+HistPtr makeHistogram(HistogramSpec const& spec)
+{
+  auto const& axes = spec.config.axes;
+  auto name = spec.name.data();
+  auto title = spec.readableName.data();
+  if constexpr (std::is_base_of_v<THnBase, T>) {
+    if (axes.empty()) {
+      throw std::runtime_error("Histogram " + spec.name + " of kind " + spec.config.kind + " needs at least one axis");
+    }
+    std::vector<int> nBins;
+    std::vector<double> xmin;
+    std::vector<double> xmax;
+    for (auto& axis : axes) {
+      nBins.push_back(axis.nBins);
+      xmin.push_back(axis.xmin);
+      xmax.push_back(axis.xmax);
+    }
+    return std::unique_ptr<THnBase>{new T(name, title, axes.size(), nBins.data(), xmin.data(), xmax.data())};
+  } else {
+    std::unique_ptr<TH1> histogram;
+    if constexpr (std::is_base_of_v<TH3, T>) {
+      checkAxes(spec, 3);
+      histogram.reset(new T(name, title, axes[0].nBins, axes[0].xmin, axes[0].xmax, axes[1].nBins, axes[1].xmin, axes[1].xmax, axes[2].nBins, axes[2].xmin, axes[2].xmax));
+    } else if constexpr (std::is_base_of_v<TH2, T>) {
+      checkAxes(spec, 2);
+      histogram.reset(new T(name, title, axes[0].nBins, axes[0].xmin, axes[0].xmax, axes[1].nBins, axes[1].xmin, axes[1].xmax));
+    } else {
+      checkAxes(spec, 1);
+      histogram.reset(new T(name, title, axes[0].nBins, axes[0].xmin, axes[0].xmax));
+    }
+    // The registry owns the histogram, not the current directory.
+    histogram->SetDirectory(nullptr);
+    return histogram;
+  }
+}
+
+int getDimension(HistPtr const& value)
+{
+  if (auto histogram = std::get_if<std::unique_ptr<TH1>>(&value)) {
+    return (*histogram)->GetDimension();
+  }
+  return std::get<std::unique_ptr<THnBase>>(value)->GetNdimensions();
+}
+
+using HistogramFactory = HistPtr (*)(HistogramSpec const&);
+
+constexpr std::pair<char const*, HistogramFactory> HistogramFactories[] = {
+  {"TH1C", makeHistogram<TH1C>},
+  {"TH1S", makeHistogram<TH1S>},
+  {"TH1I", makeHistogram<TH1I>},
+  {"TH1F", makeHistogram<TH1F>},
+  {"TH1D", makeHistogram<TH1D>},
+  {"TH2C", makeHistogram<TH2C>},
+  {"TH2S", makeHistogram<TH2S>},
+  {"TH2I", makeHistogram<TH2I>},
+  {"TH2F", makeHistogram<TH2F>},
+  {"TH2D", makeHistogram<TH2D>},
+  {"TH3C", makeHistogram<TH3C>},
+  {"TH3S", makeHistogram<TH3S>},
+  {"TH3I", makeHistogram<TH3I>},
+  {"TH3F", makeHistogram<TH3F>},
+  {"TH3D", makeHistogram<TH3D>},
+  {"THnC", makeHistogram<THnC>},
+  {"THnS", makeHistogram<THnS>},
+  {"THnI", makeHistogram<THnI>},
+  {"THnL", makeHistogram<THnL>},
+  {"THnF", makeHistogram<THnF>},
+  {"THnD", makeHistogram<THnD>},
+  {"THnSparseC", makeHistogram<THnSparseC>},
+  {"THnSparseS", makeHistogram<THnSparseS>},
+  {"THnSparseI", makeHistogram<THnSparseI>},
+  {"THnSparseL", makeHistogram<THnSparseL>},
+  {"THnSparseF", makeHistogram<THnSparseF>},
+  {"THnSparseD", makeHistogram<THnSparseD>}};
+} // namespace
+
+HistPtr createHistogram(HistogramSpec const& spec)
+{
+  for (auto& [kind, factory] : HistogramFactories) {
+    if (spec.config.kind == kind) {
+      return factory(spec);
+    }
+  }
+  throw std::runtime_error("Unknown histogram kind " + spec.config.kind + " for " + spec.name);
+}
+
+void HistogramRegistry::insert(HistogramSpec& spec)
+{
+  uint32_t i = imask(spec.id);
+  for (auto j = 0u; j < MAX_REGISTRY_SIZE; ++j) {
+    auto& value = mRegistryValue[imask(j + i)];
+    if (std::visit([](auto& histogram) { return histogram.get() == nullptr; }, value)) {
+      mRegistryKey[imask(j + i)] = spec.id;
+      value = createHistogram(spec);
+      auto& buffer = mBuffers[imask(j + i)];
+      buffer.dimension = getDimension(value);
+      buffer.values.resize((buffer.dimension + 1) * FillBuffer::capacity);
+      lookup += j;
+      return;
+    }
+  }
+  throw std::runtime_error("Internal array is full.");
+}
+
+void HistogramRegistry::flush(uint32_t i) const
+{
+  auto& buffer = mBuffers[i];
+  if (buffer.entries == 0) {
+    return;
+  }
+  auto n = buffer.entries;
+  auto dimension = buffer.dimension;
+  auto column = [&buffer](int d) { return buffer.values.data() + d * FillBuffer::capacity; };
+  double const* weights = column(dimension);
+  auto& value = mRegistryValue[i];
+  if (auto histogram = std::get_if<std::unique_ptr<TH1>>(&value)) {
+    if (dimension == 1) {
+      (*histogram)->FillN(n, column(0), weights);
+    } else if (dimension == 2) {
+      static_cast<TH2*>(histogram->get())->FillN(n, column(0), column(1), weights);
+    } else {
+      auto h3 = static_cast<TH3*>(histogram->get());
+      double const* x = column(0);
+      double const* y = column(1);
+      double const* z = column(2);
+      for (size_t ei = 0; ei < n; ++ei) {
+        h3->Fill(x[ei], y[ei], z[ei], weights[ei]);
+      }
+    }
+  } else {
+    auto& hn = std::get<std::unique_ptr<THnBase>>(value);
+    std::vector<double> coordinates(dimension);
+    for (size_t ei = 0; ei < n; ++ei) {
+      for (int d = 0; d < dimension; ++d) {
+        coordinates[d] = column(d)[ei];
+      }
+      hn->Fill(coordinates.data(), weights[ei]);
+    }
+  }
+  buffer.entries = 0;
+}
+
+void HistogramRegistry::flush()
+{
+  for (auto i = 0u; i < MAX_REGISTRY_SIZE; ++i) {
+    flush(i);
+  }
+}
+
+void HistogramRegistry::merge(HistogramRegistry& other)
+{
+  flush();
+  other.flush();
+  for (auto& spec : mSpecs) {
+    auto& target = mRegistryValue[find(spec.id)];
+    auto& source = other.mRegistryValue[other.find(spec.id)];
+    if (target.index() != source.index()) {
+      throw std::runtime_error("Cannot merge histograms " + spec.name + " of different kinds");
+    }
+    if (auto histogram = std::get_if<std::unique_ptr<TH1>>(&target)) {
+      (*histogram)->Add(std::get<std::unique_ptr<TH1>>(source).get());
+    } else {
+      std::get<std::unique_ptr<THnBase>>(target)->Add(std::get<std::unique_ptr<THnBase>>(source).get());
+    }
+  }
+}
+
+} // namespace o2::framework
@@ -9,14 +9,23 @@
 // or submit itself to any jurisdiction.
 #include "Framework/Kernels.h"
 #include "Framework/TableBuilder.h"
+#include "Framework/ThreadPool.h"
 #include "ArrowDebugHelpers.h"
 
 #include <arrow/builder.h>
 #include <arrow/status.h>
 #include <arrow/type.h>
+#include <arrow/type_traits.h>
 #include <arrow/util/variant.h>
+#include <algorithm>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <iostream>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 using namespace arrow;
 using namespace arrow::compute;
@@ -48,66 +57,369 @@ SortedGroupByKernel::SortedGroupByKernel(GroupByOptions options)
 {
 }
 
-template <typename T, typename ARRAY>
-Status doGrouping(std::shared_ptr<ChunkedArray> chunkedArray, Datum* outputRanges)
+namespace
 {
+/// Invoke @a f with an instance of the arrow type of the supported grouping
+/// columns.
+template <typename F>
+Status dispatchIndexType(std::shared_ptr<DataType> const& type, F&& f)
+{
+  switch (type->id()) {
+    case Type::UINT64:
+      return f(UInt64Type{});
+    case Type::INT64:
+      return f(Int64Type{});
+    case Type::UINT32:
+      return f(UInt32Type{});
+    case Type::INT32:
+      return f(Int32Type{});
+    default:
+      return Status::NotImplemented("Unsupported type for grouping column: " + type->ToString());
+  }
+}
+
+/// The raw values of each chunk of @a chunkedArray, with their length
+template <typename T>
+std::vector<std::pair<T const*, int64_t>> getChunks(ChunkedArray const& chunkedArray)
+{
+  using ARRAY = NumericArray<typename CTypeTraits<T>::ArrowType>;
+  std::vector<std::pair<T const*, int64_t>> chunks;
+  for (int ci = 0; ci < chunkedArray.num_chunks(); ++ci) {
+    auto chunk = std::static_pointer_cast<ARRAY>(chunkedArray.chunk(ci));
+    chunks.emplace_back(chunk->raw_values(), chunk->length());
+  }
+  return chunks;
+}
+
+template <typename T>
+bool isUnassigned(T value)
+{
+  if constexpr (std::is_signed_v<T>) {
+    return value < 0;
+  } else {
+    return false;
+  }
+}
+
+template <typename T>
+struct Run {
+  T value;
+  uint64_t start;
+  uint64_t count;
+};
+
+/// Find the runs of equal values in the rows [@a begin, @a end)
+template <typename T>
+void findRuns(std::vector<std::pair<T const*, int64_t>> const& chunks, int64_t begin, int64_t end, std::vector<Run<T>>& runs)
+{
+  int64_t offset = 0;
+  for (auto& [data, length] : chunks) {
+    auto first = std::max(begin, offset);
+    auto last = std::min(end, offset + length);
+    for (auto ri = first; ri < last; ++ri) {
+      auto value = data[ri - offset];
+      if (runs.empty() == false && runs.back().value == value) {
+        runs.back().count++;
+      } else {
+        runs.push_back(Run<T>{value, (uint64_t)ri, 1});
+      }
+    }
+    offset += length;
+  }
+}
+
+/// The pool used to group columns when the caller does not provide one.
+ThreadPool& defaultGroupingPool()
+{
+  static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()));
+  return pool;
+}
+
+template <typename T>
+Status doGrouping(ChunkedArray const& chunkedArray, GroupByOptions const& options, Datum* outputRanges)
+{
+  auto chunks = getChunks<T>(chunkedArray);
+  auto nRows = chunkedArray.length();
+  // Each thread looks for runs in its own contiguous range of rows. Runs
+  // crossing the boundaries between ranges are stitched together
+  // afterwards, so the result does not depend on the number of threads.
+  size_t nRanges = std::max<size_t>(1, std::min<size_t>(options.nThreads, nRows));
+  std::vector<std::vector<Run<T>>> runsPerRange(nRanges);
+  auto rangeSize = (nRows + nRanges - 1) / nRanges;
+  auto findRange = [&chunks, &runsPerRange, rangeSize, nRows](size_t ri) {
+    findRuns(chunks, ri * rangeSize, std::min<int64_t>(nRows, (ri + 1) * rangeSize), runsPerRange[ri]);
+  };
+  if (nRanges == 1) {
+    findRange(0);
+  } else {
+    // The pool might be shared with other callers, so we wait only for
+    // our own ranges.
+    auto& pool = options.pool ? *options.pool : defaultGroupingPool();
+    std::mutex mutex;
+    std::condition_variable rangeDone;
+    size_t remaining = nRanges;
+    for (size_t ri = 0; ri < nRanges; ++ri) {
+      pool.push([&findRange, &mutex, &rangeDone, &remaining, ri](size_t) {
+        findRange(ri);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--remaining == 0) {
+          rangeDone.notify_one();
+        }
+      });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    rangeDone.wait(lock, [&remaining]() { return remaining == 0; });
+  }
+
+  std::vector<Run<T>> runs;
+  for (auto& rangeRuns : runsPerRange) {
+    auto first = rangeRuns.begin();
+    if (first != rangeRuns.end() && runs.empty() == false && runs.back().value == first->value) {
+      runs.back().count += first->count;
+      ++first;
+    }
+    runs.insert(runs.end(), first, rangeRuns.end());
+  }
+
   TableBuilder builder;
   auto writer = builder.persist<uint64_t, uint64_t>({"start", "count"});
-  T currentIndex = std::static_pointer_cast<ARRAY>(chunkedArray->chunk(0))->raw_values()[0];
-  T currentCount = 0;
-  for (size_t ci = 0; ci < chunkedArray->num_chunks(); ++ci) {
-    auto chunk = chunkedArray->chunk(ci);
-    T const* data = std::static_pointer_cast<ARRAY>(chunk)->raw_values();
-    for (size_t ai = 0; ai < chunk->length(); ++ai) {
-      if (currentIndex == data[ai]) {
-        currentCount++;
-      } else if (currentIndex != -1) {
-        writer(0, currentIndex, currentCount);
-        currentIndex = data[ai];
-        currentCount = 1;
-      }
+  for (auto& run : runs) {
+    if (isUnassigned(run.value)) {
+      continue;
     }
+    writer(0, run.start, run.count);
   }
-  writer(0, currentIndex, currentCount);
   *outputRanges = std::move(builder.finalize());
   return arrow::Status::OK();
 }
 
-Status SortedGroupByKernel::Call(FunctionContext* ctx, Datum const& inputTable, Datum* outputRanges)
+template <typename T>
+bool isSorted(ChunkedArray const& chunkedArray)
 {
-  using namespace arrow;
-  if (inputTable.kind() == Datum::TABLE) {
-    auto table = util::get<std::shared_ptr<arrow::Table>>(inputTable.value);
-    auto columnIndex = table->schema()->GetFieldIndex(mOptions.columnName);
-    auto dataType = table->column(columnIndex)->type();
-    auto chunkedArray = table->column(columnIndex)->data();
-    if (dataType->id() == Type::UINT64) {
-      return doGrouping<uint64_t, arrow::UInt64Array>(chunkedArray, outputRanges);
-    } else if (dataType->id() == Type::INT64) {
-      return doGrouping<int64_t, arrow::Int64Array>(chunkedArray, outputRanges);
-    } else if (dataType->id() == Type::UINT32) {
-      return doGrouping<uint32_t, arrow::UInt32Array>(chunkedArray, outputRanges);
-    } else if (dataType->id() == Type::INT32) {
-      return doGrouping<int32_t, arrow::Int32Array>(chunkedArray, outputRanges);
+  bool first = true;
+  T previous{};
+  for (auto& [data, length] : getChunks<T>(chunkedArray)) {
+    for (int64_t ai = 0; ai < length; ++ai) {
+      if (first == false && data[ai] < previous) {
+        return false;
+      }
+      previous = data[ai];
+      first = false;
+    }
+  }
+  return true;
+}
+
+template <typename T>
+Status doHashGrouping(ChunkedArray const& chunkedArray, Datum* outputRows)
+{
+  auto chunks = getChunks<T>(chunkedArray);
+  // First pass: count the rows for each value.
+  std::unordered_map<T, uint64_t> offsets;
+  for (auto& [data, length] : chunks) {
+    for (int64_t ai = 0; ai < length; ++ai) {
+      if (isUnassigned(data[ai]) == false) {
+        offsets[data[ai]]++;
+      }
+    }
+  }
+  // Groups are sorted by value, so that the result is the same as
+  // if the column was sorted in the first place.
+  std::vector<T> values;
+  values.reserve(offsets.size());
+  for (auto& [value, count] : offsets) {
+    values.push_back(value);
+  }
+  std::sort(values.begin(), values.end());
+  uint64_t total = 0;
+  for (auto value : values) {
+    auto count = offsets[value];
+    offsets[value] = total;
+    total += count;
+  }
+  // Second pass: put each row in its place.
+  std::vector<uint64_t> rows(total);
+  int64_t offset = 0;
+  for (auto& [data, length] : chunks) {
+    for (int64_t ai = 0; ai < length; ++ai) {
+      if (isUnassigned(data[ai]) == false) {
+        rows[offsets[data[ai]]++] = offset + ai;
+      }
     }
+    offset += length;
   }
+
+  UInt64Builder builder;
+  ARROW_RETURN_NOT_OK(builder.AppendValues(rows.data(), rows.size()));
+  std::shared_ptr<Array> array;
+  ARROW_RETURN_NOT_OK(builder.Finish(&array));
+  *outputRows = Datum(arrow::Table::Make(arrow::schema({arrow::field("row", arrow::uint64())}), {array}));
+  return arrow::Status::OK();
+}
+
+/// Gather the @a rows of a numeric @a column in a new array.
+template <typename ARROWTYPE>
+Status takeRows(ChunkedArray const& column, std::vector<uint64_t> const& rows, std::shared_ptr<Array>* out)
+{
+  using T = typename ARROWTYPE::c_type;
+  auto chunks = getChunks<T>(column);
+  std::vector<int64_t> chunkStarts;
+  int64_t offset = 0;
+  for (auto& chunk : chunks) {
+    chunkStarts.push_back(offset);
+    offset += chunk.second;
+  }
+  NumericBuilder<ARROWTYPE> builder;
+  ARROW_RETURN_NOT_OK(builder.Reserve(rows.size()));
+  for (auto row : rows) {
+    auto ci = std::upper_bound(chunkStarts.begin(), chunkStarts.end(), (int64_t)row) - chunkStarts.begin() - 1;
+    builder.UnsafeAppend(chunks[ci].first[row - chunkStarts[ci]]);
+  }
+  return builder.Finish(out);
+}
+
+/// @return a new table with the given @a rows of @a table
+Status takeRows(std::shared_ptr<arrow::Table> const& table, std::vector<uint64_t> const& rows, std::shared_ptr<arrow::Table>* out)
+{
+  std::vector<std::shared_ptr<Array>> arrays;
+  for (int ci = 0; ci < table->num_columns(); ++ci) {
+    auto column = table->column(ci);
+    std::shared_ptr<Array> array;
+    switch (column->type()->id()) {
+      case Type::INT8:
+        ARROW_RETURN_NOT_OK(takeRows<Int8Type>(*column->data(), rows, &array));
+        break;
+      case Type::UINT8:
+        ARROW_RETURN_NOT_OK(takeRows<UInt8Type>(*column->data(), rows, &array));
+        break;
+      case Type::INT16:
+        ARROW_RETURN_NOT_OK(takeRows<Int16Type>(*column->data(), rows, &array));
+        break;
+      case Type::UINT16:
+        ARROW_RETURN_NOT_OK(takeRows<UInt16Type>(*column->data(), rows, &array));
+        break;
+      case Type::INT32:
+        ARROW_RETURN_NOT_OK(takeRows<Int32Type>(*column->data(), rows, &array));
+        break;
+      case Type::UINT32:
+        ARROW_RETURN_NOT_OK(takeRows<UInt32Type>(*column->data(), rows, &array));
+        break;
+      case Type::INT64:
+        ARROW_RETURN_NOT_OK(takeRows<Int64Type>(*column->data(), rows, &array));
+        break;
+      case Type::UINT64:
+        ARROW_RETURN_NOT_OK(takeRows<UInt64Type>(*column->data(), rows, &array));
+        break;
+      case Type::FLOAT:
+        ARROW_RETURN_NOT_OK(takeRows<FloatType>(*column->data(), rows, &array));
+        break;
+      case Type::DOUBLE:
+        ARROW_RETURN_NOT_OK(takeRows<DoubleType>(*column->data(), rows, &array));
+        break;
+      default:
+        return Status::NotImplemented("Unable to group column " + column->name() + " of type " + column->type()->ToString());
+    }
+    arrays.push_back(array);
+  }
+  *out = arrow::Table::Make(table->schema(), arrays);
   return arrow::Status::OK();
 }
+} // namespace
+
+Status SortedGroupByKernel::Call(FunctionContext* ctx, Datum const& inputTable, Datum* outputRanges)
+{
+  using namespace arrow;
+  if (inputTable.kind() != Datum::TABLE) {
+    return Status::Invalid("Input Datum was not a table");
+  }
+  auto table = util::get<std::shared_ptr<arrow::Table>>(inputTable.value);
+  auto columnIndex = table->schema()->GetFieldIndex(mOptions.columnName);
+  if (columnIndex == -1) {
+    return Status::Invalid("Unable to find column " + mOptions.columnName);
+  }
+  auto chunkedArray = table->column(columnIndex)->data();
+  return dispatchIndexType(chunkedArray->type(), [&](auto type) {
+    using T = typename decltype(type)::c_type;
+    return doGrouping<T>(*chunkedArray, mOptions, outputRanges);
+  });
+}
+
+HashGroupByKernel::HashGroupByKernel(GroupByOptions options)
+  : mOptions(options)
+{
+}
+
+Status HashGroupByKernel::Call(FunctionContext* ctx, Datum const& inputTable, Datum* outputRows)
+{
+  if (inputTable.kind() != Datum::TABLE) {
+    return Status::Invalid("Input Datum was not a table");
+  }
+  auto table = util::get<std::shared_ptr<arrow::Table>>(inputTable.value);
+  auto columnIndex = table->schema()->GetFieldIndex(mOptions.columnName);
+  if (columnIndex == -1) {
+    return Status::Invalid("Unable to find column " + mOptions.columnName);
+  }
+  auto chunkedArray = table->column(columnIndex)->data();
+  return dispatchIndexType(chunkedArray->type(), [&](auto type) {
+    using T = typename decltype(type)::c_type;
+    return doHashGrouping<T>(*chunkedArray, outputRows);
+  });
+}
 
 /// Slice a given table is a vector of tables each containing a slice.
 arrow::Status sliceByColumn(FunctionContext* context, std::string const& key,
                             Datum const& inputTable, std::vector<Datum>* outputSlices)
 {
+  return sliceByColumn(context, GroupByOptions{key}, inputTable, outputSlices);
+}
+
+arrow::Status sliceByColumn(FunctionContext* context, GroupByOptions const& options,
+                            Datum const& inputTable, std::vector<Datum>* outputSlices,
+                            std::vector<uint64_t>* outputKeys)
+{
+  auto& key = options.columnName;
   if (inputTable.kind() != Datum::TABLE) {
     return Status::Invalid("Input Datum was not a table");
   }
+  auto table = arrow::util::get<std::shared_ptr<arrow::Table>>(inputTable.value);
+  auto columnIndex = table->schema()->GetFieldIndex(key);
+  if (columnIndex == -1) {
+    return Status::Invalid("Unable to find column " + key);
+  }
+
+  // In case the input is not sorted, we first need to bring together the
+  // rows which belong to the same group.
+  bool sorted = true;
+  auto keyColumn = table->column(columnIndex)->data();
+  ARROW_RETURN_NOT_OK(dispatchIndexType(keyColumn->type(), [&sorted, &keyColumn](auto type) {
+    using T = typename decltype(type)::c_type;
+    sorted = isSorted<T>(*keyColumn);
+    return Status::OK();
+  }));
+  if (sorted == false) {
+    Datum outRows;
+    HashGroupByKernel hashGroupBy({GroupByOptions{key}});
+    ARROW_RETURN_NOT_OK(hashGroupBy.Call(context, inputTable, &outRows));
+    auto rowsTable = util::get<std::shared_ptr<arrow::Table>>(outRows.value);
+    auto rowsData = std::static_pointer_cast<UInt64Array>(rowsTable->column(0)->data()->chunk(0));
+    std::vector<uint64_t> rows(rowsData->raw_values(), rowsData->raw_values() + rowsData->length());
+    std::shared_ptr<arrow::Table> grouped;
+    ARROW_RETURN_NOT_OK(takeRows(table, rows, &grouped));
+    table = grouped;
+  }
 
   // build all the ranges on the fly.
   Datum outRanges;
-  SortedGroupByKernel groupBy({GroupByOptions{key}});
-  ARROW_RETURN_NOT_OK(groupBy.Call(context, inputTable, &outRanges));
+  SortedGroupByKernel groupBy(options);
+  ARROW_RETURN_NOT_OK(groupBy.Call(context, Datum(table), &outRanges));
   auto ranges = util::get<std::shared_ptr<arrow::Table>>(outRanges.value);
   outputSlices->reserve(ranges->num_rows());
+  if (outputKeys) {
+    outputKeys->clear();
+  }
+  if (ranges->num_rows() == 0) {
+    return arrow::Status::OK();
+  }
 
   auto startChunks = ranges->column(0)->data();
   assert(startChunks->num_chunks() == 1);
@@ -116,7 +428,27 @@ arrow::Status sliceByColumn(FunctionContext* context, std::string const& key,
   auto startData = std::static_pointer_cast<UInt64Array>(startChunks->chunk(0))->raw_values();
   auto countData = std::static_pointer_cast<UInt64Array>(countChunks->chunk(0))->raw_values();
 
-  auto table = arrow::util::get<std::shared_ptr<arrow::Table>>(inputTable.value);
+  // Unassigned rows do not end up in any slice, so the keys are never
+  // negative.
+  if (outputKeys) {
+    outputKeys->reserve(ranges->num_rows());
+    auto groupedKeys = table->column(columnIndex)->data();
+    ARROW_RETURN_NOT_OK(dispatchIndexType(groupedKeys->type(), [&](auto type) {
+      using T = typename decltype(type)::c_type;
+      auto chunks = getChunks<T>(*groupedKeys);
+      // Ranges are ordered by their first row.
+      size_t ci = 0;
+      int64_t chunkStart = 0;
+      for (size_t ri = 0; ri < ranges->num_rows(); ++ri) {
+        while ((int64_t)startData[ri] >= chunkStart + chunks[ci].second) {
+          chunkStart += chunks[ci++].second;
+        }
+        outputKeys->push_back(chunks[ci].first[startData[ri] - chunkStart]);
+      }
+      return Status::OK();
+    }));
+  }
+
   for (size_t ri = 0; ri < ranges->num_rows(); ++ri) {
     auto start = startData[ri];
     auto count = countData[ri];
@@ -9,6 +9,7 @@
 // or submit itself to any jurisdiction.
 
 #include "Framework/MessageContext.h"
+#include "Framework/MessagePool.h"
 #include "fairmq/FairMQDevice.h"
 
 namespace o2
@@ -18,6 +19,9 @@ namespace framework
 
 FairMQMessagePtr MessageContext::createMessage(const std::string& channel, int index, size_t size)
 {
+  if (mPools) {
+    return mPools->get(channel, proxy().getTransport(channel, 0)).create(size);
+  }
   return proxy().getDevice()->NewMessageFor(channel, 0, size);
 }
 
@@ -26,5 +30,17 @@ FairMQMessagePtr MessageContext::createMessage(const std::string& channel, int i
   return proxy().getDevice()->NewMessageFor(channel, 0, data, size, ffn, hint);
 }
 
+pmr::FairMQMemoryResource* MessageContext::getMemoryResource(const std::string& channel, int index)
+{
+  auto transport = proxy().getTransport(channel, index);
+  if (transport == nullptr) {
+    return nullptr;
+  }
+  if (mPools) {
+    return &mPools->get(channel, transport);
+  }
+  return transport->GetMemoryResource();
+}
+
 } // namespace framework
 } // namespace o2
@@ -0,0 +1,197 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/MessagePool.h"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace o2::framework
+{
+
+MessagePool::MessagePool(FairMQTransportFactory* transport, size_t regionSize, size_t minSize)
+  : mTransport{transport},
+    mMinSize{minSize}
+{
+  if (mTransport == nullptr) {
+    throw std::runtime_error("MessagePool needs a transport");
+  }
+  // The capacity of each buffer travels as the hint of its message, so
+  // that it does not need to be looked up when the buffer comes back.
+  mRegion = mTransport->CreateUnmanagedRegion(regionSize, [this](void* data, size_t, void* hint) {
+    this->release(data, reinterpret_cast<size_t>(hint));
+  });
+}
+
+MessagePool::~MessagePool()
+{
+  // Allocations which were never turned into messages go back to the
+  // region before it is destroyed.
+  std::unordered_map<void*, FairMQMessagePtr> allocated;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    allocated.swap(mAllocated);
+  }
+}
+
+FairMQMessagePtr MessagePool::create(size_t size)
+{
+  if (size < mMinSize) {
+    return mTransport->CreateMessage(size);
+  }
+  size_t capacity = (size + Granularity - 1) / Granularity * Granularity;
+  char* data = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Best fit among the released ranges, what is left of it stays free.
+    auto free = mFreeBySize.lower_bound(capacity);
+    if (free != mFreeBySize.end()) {
+      data = free->second;
+      size_t available = free->first;
+      eraseFree(mFreeByAddress.find(data));
+      if (available > capacity) {
+        addFree(data + capacity, available - capacity);
+      }
+      mStats.hits++;
+    } else if (mRegionOffset + capacity <= mRegion->GetSize()) {
+      data = static_cast<char*>(mRegion->GetData()) + mRegionOffset;
+      mRegionOffset += capacity;
+      mStats.reservedBytes += capacity;
+    } else {
+      mStats.misses++;
+    }
+  }
+  if (data == nullptr) {
+    return mTransport->CreateMessage(size);
+  }
+  return mTransport->CreateMessage(mRegion, data, size, reinterpret_cast<void*>(capacity));
+}
+
+void MessagePool::release(void* data, size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  addFree(static_cast<char*>(data), capacity);
+  mStats.recycled++;
+}
+
+void MessagePool::addFree(char* data, size_t size)
+{
+  auto next = mFreeByAddress.lower_bound(data);
+  if (next != mFreeByAddress.begin()) {
+    auto previous = std::prev(next);
+    if (previous->first + previous->second == data) {
+      data = previous->first;
+      size += previous->second;
+      eraseFree(previous);
+    }
+  }
+  if (next != mFreeByAddress.end() && data + size == next->first) {
+    size += next->second;
+    eraseFree(next);
+  }
+  mFreeByAddress.emplace(data, size);
+  mFreeBySize.emplace(size, data);
+}
+
+void MessagePool::eraseFree(std::map<char*, size_t>::iterator range)
+{
+  auto [first, last] = mFreeBySize.equal_range(range->second);
+  for (auto bySize = first; bySize != last; ++bySize) {
+    if (bySize->second == range->first) {
+      mFreeBySize.erase(bySize);
+      break;
+    }
+  }
+  mFreeByAddress.erase(range);
+}
+
+MessagePoolStats MessagePool::stats() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStats;
+}
+
+void* MessagePool::do_allocate(std::size_t bytes, std::size_t)
+{
+  auto message = create(bytes);
+  auto data = message->GetData();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mAllocated[data] = std::move(message);
+  return data;
+}
+
+void MessagePool::do_deallocate(void* p, std::size_t, std::size_t)
+{
+  FairMQMessagePtr message;
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto allocated = mAllocated.find(p);
+    if (allocated == mAllocated.end()) {
+      return;
+    }
+    message = std::move(allocated->second);
+    mAllocated.erase(allocated);
+  }
+  // Destroying the message outside of the lock, as it might give the
+  // buffer back to the pool right away.
+}
+
+FairMQMessagePtr MessagePool::getMessage(void* p)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto allocated = mAllocated.find(p);
+  if (allocated == mAllocated.end()) {
+    return nullptr;
+  }
+  auto message = std::move(allocated->second);
+  mAllocated.erase(allocated);
+  return message;
+}
+
+void* MessagePool::setMessage(FairMQMessagePtr message)
+{
+  auto data = message->GetData();
+  std::lock_guard<std::mutex> lock(mMutex);
+  mAllocated[data] = std::move(message);
+  return data;
+}
+
+size_t MessagePool::getNumberOfMessages() const noexcept
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mAllocated.size();
+}
+
+MessagePools::MessagePools(size_t regionSize, size_t minSize)
+  : mRegionSize{regionSize},
+    mMinSize{minSize}
+{
+}
+
+MessagePool& MessagePools::get(std::string const& channel, FairMQTransportFactory* transport)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& pool = mPools[channel];
+  if (pool.get() == nullptr) {
+    pool = std::make_unique<MessagePool>(transport, mRegionSize, mMinSize);
+  }
+  return *pool;
+}
+
+std::vector<std::pair<std::string, MessagePoolStats>> MessagePools::stats() const
+{
+  std::vector<std::pair<std::string, MessagePoolStats>> result;
+  std::lock_guard<std::mutex> lock(mMutex);
+  for (auto& [channel, pool] : mPools) {
+    result.emplace_back(channel, pool->stats());
+  }
+  return result;
+}
+
+} // namespace o2::framework
@@ -37,7 +37,7 @@ void dumpDeviceSpec2O2Control(std::ostream& out,
         << "\n";
     out << R"(          mode: "fairmq")"
         << "\n";
-    if (spec.outputChannels.empty()) {
+    if (spec.outputChannels.empty() && spec.creditInputChannels.empty()) {
       out << R"(      bind: [])"
           << "\n";
     } else {
@@ -47,6 +47,12 @@ void dumpDeviceSpec2O2Control(std::ostream& out,
         out << R"(        - name: ")" << channel.name << "\"\n";
         out << R"(          type: ")" << ChannelSpecHelpers::typeAsString(channel.type) << "\"\n";
       }
+      // The credits of LeastLoaded time pipelines are pulled from a
+      // channel bound by the producer.
+      for (auto& channel : spec.creditInputChannels) {
+        out << R"(        - name: ")" << channel.name << "\"\n";
+        out << R"(          type: ")" << ChannelSpecHelpers::typeAsString(channel.type) << "\"\n";
+      }
     }
     out << R"(      command:)"
         << "\n";
@@ -105,6 +111,13 @@ void dumpDeviceSpec2O2Control(std::ostream& out,
       out << R"(            target: "{{parent}}.)" << sourceDevice << ":" << channel.name << "\"\n";
       out << R"(            type: ")" << ChannelSpecHelpers::typeAsString(channel.type) << "\"\n";
     }
+    // Credit channels are named credits_from_<replica>_to_<producer>.
+    for (auto& channel : spec.creditOutputChannels) {
+      out << R"(          - name: ")" << channel.name << "\"\n";
+      std::string producer = channel.name.substr(channel.name.rfind("_to_") + 4);
+      out << R"(            target: "{{parent}}.)" << producer << ":" << channel.name << "\"\n";
+      out << R"(            type: ")" << ChannelSpecHelpers::typeAsString(channel.type) << "\"\n";
+    }
     out << "          task:\n";
     out << "            load: " << spec.name << "\n";
   }
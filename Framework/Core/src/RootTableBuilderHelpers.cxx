@@ -0,0 +1,237 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/RootTableBuilderHelpers.h"
+#include "Framework/ThreadPool.h"
+
+#include <arrow/array.h>
+#include <arrow/buffer.h>
+#include <arrow/memory_pool.h>
+
+#include <Bytes.h>
+#include <TBranch.h>
+#include <TBufferFile.h>
+#include <TFile.h>
+#include <TLeaf.h>
+#include <TMemFile.h>
+#include <TROOT.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+namespace o2::framework
+{
+
+namespace
+{
+/// Convert @a n values serialized by ROOT (i.e. big endian) from @a source
+/// to @a target, advancing @a source past them.
+template <typename T>
+void unpack(char*& source, void* target, size_t n)
+{
+  auto values = static_cast<T*>(target);
+  for (size_t i = 0; i < n; ++i) {
+    frombuf(source, values + i);
+  }
+}
+
+struct LeafConverter {
+  char const* typeName;
+  std::shared_ptr<arrow::DataType> (*arrowType)();
+  size_t size;
+  void (*unpack)(char*& source, void* target, size_t n);
+};
+
+constexpr LeafConverter LeafConverters[] = {
+  {"Bool_t", arrow::boolean, sizeof(Bool_t), unpack<Bool_t>},
+  {"Char_t", arrow::int8, sizeof(Char_t), unpack<Char_t>},
+  {"UChar_t", arrow::uint8, sizeof(UChar_t), unpack<UChar_t>},
+  {"Short_t", arrow::int16, sizeof(Short_t), unpack<Short_t>},
+  {"UShort_t", arrow::uint16, sizeof(UShort_t), unpack<UShort_t>},
+  {"Int_t", arrow::int32, sizeof(Int_t), unpack<Int_t>},
+  {"UInt_t", arrow::uint32, sizeof(UInt_t), unpack<UInt_t>},
+  {"Long64_t", arrow::int64, sizeof(Long64_t), unpack<Long64_t>},
+  {"ULong64_t", arrow::uint64, sizeof(ULong64_t), unpack<ULong64_t>},
+  {"Float_t", arrow::float32, sizeof(Float_t), unpack<Float_t>},
+  {"Double_t", arrow::float64, sizeof(Double_t), unpack<Double_t>}};
+
+std::shared_ptr<arrow::Buffer> allocate(int64_t size)
+{
+  std::shared_ptr<arrow::Buffer> buffer;
+  auto status = arrow::AllocateBuffer(arrow::default_memory_pool(), size, &buffer);
+  if (status.ok() == false) {
+    throw std::runtime_error("Unable to allocate column: " + status.message());
+  }
+  return buffer;
+}
+
+/// Read the whole @a branch into a single column.
+std::shared_ptr<arrow::Array> convertBranch(TBranch& branch, int64_t entries)
+{
+  std::string name = branch.GetName();
+  auto leaves = branch.GetListOfLeaves();
+  if (leaves->GetEntries() != 1) {
+    throw std::runtime_error("Branch " + name + " has more than one leaf");
+  }
+  auto leaf = static_cast<TLeaf*>(leaves->At(0));
+  if (leaf->GetLeafCount() != nullptr) {
+    throw std::runtime_error("Branch " + name + " is a variable size array, which is not supported");
+  }
+  auto converter = std::find_if(std::begin(LeafConverters), std::end(LeafConverters),
+                                [typeName = std::string(leaf->GetTypeName())](auto& c) { return typeName == c.typeName; });
+  if (converter == std::end(LeafConverters)) {
+    throw std::runtime_error("Branch " + name + " has unsupported type " + leaf->GetTypeName());
+  }
+  int64_t length = std::max(leaf->GetLenStatic(), 1);
+  int64_t entrySize = length * converter->size;
+  auto values = allocate(entries * entrySize);
+  auto target = reinterpret_cast<char*>(values->mutable_data());
+
+  if (branch.SupportsBulkRead()) {
+    TBufferFile buffer(TBuffer::kWrite, 32 * 1024);
+    int64_t entry = 0;
+    while (entry < entries) {
+      int64_t count = branch.GetBulkRead().GetEntriesSerialized(entry, buffer);
+      if (count <= 0) {
+        throw std::runtime_error("Unable to read entry " + std::to_string(entry) + " of branch " + name);
+      }
+      count = std::min(count, entries - entry);
+      char* source = buffer.GetCurrent();
+      converter->unpack(source, target + entry * entrySize, count * length);
+      entry += count;
+    }
+  } else {
+    // No bulk I/O for this branch, let ROOT deserialize each entry.
+    std::vector<char> current(entrySize);
+    auto previous = branch.GetAddress();
+    branch.SetAddress(current.data());
+    for (int64_t entry = 0; entry < entries; ++entry) {
+      if (branch.GetEntry(entry) <= 0) {
+        branch.SetAddress(previous);
+        throw std::runtime_error("Unable to read entry " + std::to_string(entry) + " of branch " + name);
+      }
+      std::memcpy(target + entry * entrySize, current.data(), entrySize);
+    }
+    branch.SetAddress(previous);
+  }
+
+  // Arrow stores booleans as bits, rather than one per byte.
+  if (converter->arrowType()->id() == arrow::Type::BOOL) {
+    auto bits = allocate((entries * length + 7) / 8);
+    auto bitsData = bits->mutable_data();
+    std::memset(bitsData, 0, bits->size());
+    for (int64_t i = 0; i < entries * length; ++i) {
+      if (reinterpret_cast<Bool_t const*>(target)[i]) {
+        bitsData[i / 8] |= 1 << (i % 8);
+      }
+    }
+    values = bits;
+  }
+
+  auto type = converter->arrowType();
+  auto flat = arrow::MakeArray(arrow::ArrayData::Make(type, entries * length, {nullptr, values}, 0));
+  if (leaf->GetLenStatic() <= 1) {
+    return flat;
+  }
+  auto offsets = allocate((entries + 1) * sizeof(int32_t));
+  auto offsetsData = reinterpret_cast<int32_t*>(offsets->mutable_data());
+  for (int64_t i = 0; i <= entries; ++i) {
+    offsetsData[i] = i * length;
+  }
+  return std::make_shared<arrow::ListArray>(arrow::list(type), entries, offsets, flat, nullptr, 0);
+}
+} // namespace
+
+std::shared_ptr<arrow::Table> RootTableBuilderHelpers::convertTTreeBulk(TTree& tree,
+                                                                        std::vector<std::string> const& branchNames,
+                                                                        ThreadPool* pool)
+{
+  std::vector<TBranch*> branches;
+  for (auto& name : branchNames) {
+    auto branch = tree.GetBranch(name.c_str());
+    if (branch == nullptr) {
+      throw std::runtime_error("Branch " + name + " not found in tree " + tree.GetName());
+    }
+    branches.push_back(branch);
+  }
+  auto entries = tree.GetEntries();
+
+  // Tasks running at the same time must not share the TFile, nor the
+  // TTreeCache, of the tree, so each worker reads from a tree of its own,
+  // opened from the same file. An in-memory file cannot be opened again, in
+  // which case the branches are converted one after the other.
+  auto file = tree.GetCurrentFile();
+  bool parallel = pool != nullptr && pool->size() > 0 && branches.size() > 1 &&
+                  file != nullptr && dynamic_cast<TMemFile*>(file) == nullptr;
+  std::string treePath = tree.GetName();
+  if (parallel) {
+    ROOT::EnableThreadSafety();
+    std::string directory = tree.GetDirectory()->GetPath();
+    auto inFile = directory.find(":/");
+    if (inFile != std::string::npos && inFile + 2 < directory.size()) {
+      treePath = directory.substr(inFile + 2) + "/" + treePath;
+    }
+  }
+  struct WorkerTree {
+    std::unique_ptr<TFile> file;
+    TTree* tree = nullptr;
+  };
+  std::vector<WorkerTree> workerTrees(parallel ? pool->size() : 0);
+
+  std::vector<std::shared_ptr<arrow::Array>> arrays(branches.size());
+  std::vector<std::string> errors(branches.size());
+  auto convert = [&](size_t bi, TTree* source) {
+    try {
+      auto branch = source == &tree ? branches[bi] : source->GetBranch(branchNames[bi].c_str());
+      if (branch == nullptr) {
+        throw std::runtime_error("Branch " + branchNames[bi] + " not found in tree " + source->GetName());
+      }
+      arrays[bi] = convertBranch(*branch, entries);
+    } catch (std::exception& e) {
+      errors[bi] = e.what();
+    }
+  };
+  for (size_t bi = 0; bi < branches.size(); ++bi) {
+    if (parallel == false) {
+      convert(bi, &tree);
+      continue;
+    }
+    pool->push([&, bi](size_t workerId) {
+      auto& worker = workerTrees[workerId];
+      if (worker.tree == nullptr) {
+        worker.file.reset(TFile::Open(file->GetName(), "READ"));
+        worker.tree = worker.file ? dynamic_cast<TTree*>(worker.file->Get(treePath.c_str())) : nullptr;
+      }
+      if (worker.tree == nullptr) {
+        errors[bi] = "Unable to open tree " + treePath + " from " + file->GetName();
+        return;
+      }
+      convert(bi, worker.tree);
+    });
+  }
+  if (parallel) {
+    pool->wait();
+  }
+  for (auto& error : errors) {
+    if (error.empty() == false) {
+      throw std::runtime_error(error);
+    }
+  }
+
+  std::vector<std::shared_ptr<arrow::Field>> fields;
+  for (size_t bi = 0; bi < branches.size(); ++bi) {
+    fields.push_back(arrow::field(branchNames[bi], arrays[bi]->type()));
+  }
+  return arrow::Table::Make(arrow::schema(fields), arrays);
+}
+
+} // namespace o2::framework
@@ -0,0 +1,100 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/ThreadPool.h"
+#include "Framework/Logger.h"
+
+#include <chrono>
+#include <exception>
+
+namespace o2::framework
+{
+
+ThreadPool::ThreadPool(size_t nWorkers)
+{
+  mWorkers.reserve(nWorkers);
+  for (size_t wi = 0; wi < nWorkers; ++wi) {
+    mWorkers.emplace_back([this, wi]() { this->run(wi); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+  mTaskAvailable.notify_all();
+  for (auto& worker : mWorkers) {
+    worker.join();
+  }
+}
+
+void ThreadPool::push(Task&& task)
+{
+  // Without workers we simply behave as a synchronous executor.
+  if (mWorkers.empty()) {
+    task(0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mQueue.emplace_back(std::move(task));
+    mPending++;
+  }
+  mTaskAvailable.notify_one();
+}
+
+void ThreadPool::wait()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mTaskDone.wait(lock, [this]() { return mPending == 0; });
+}
+
+void ThreadPool::waitForIdleWorker(int timeout)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mTaskDone.wait_for(lock, std::chrono::milliseconds(timeout), [this]() { return mPending < mWorkers.size(); });
+}
+
+size_t ThreadPool::pending() const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mPending;
+}
+
+void ThreadPool::run(size_t workerId)
+{
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mTaskAvailable.wait(lock, [this]() { return mStopping || mQueue.empty() == false; });
+      if (mQueue.empty()) {
+        return;
+      }
+      task = std::move(mQueue.front());
+      mQueue.pop_front();
+    }
+    try {
+      task(workerId);
+    } catch (std::exception& e) {
+      LOG(ERROR) << "Exception caught in worker " << workerId << ": " << e.what();
+    } catch (...) {
+      LOG(ERROR) << "Unknown exception caught in worker " << workerId;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mPending--;
+    }
+    mTaskDone.notify_all();
+  }
+}
+
+} // namespace o2::framework
@@ -0,0 +1,79 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/TimePipelineDispatch.h"
+
+namespace o2::framework
+{
+
+size_t TimePipelineDispatcher::replicaFor(std::string const& consumer, size_t replicas, size_t timeslice)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto& pipeline = mPipelines[consumer];
+  if (pipeline.outstanding.size() != replicas) {
+    pipeline.outstanding.resize(replicas, 0);
+  }
+  auto assigned = pipeline.assigned.find(timeslice);
+  if (assigned != pipeline.assigned.end()) {
+    return assigned->second;
+  }
+  // Start from the round robin choice, so that with an even load we
+  // behave exactly like the plain time pipelining.
+  size_t best = timeslice % replicas;
+  for (size_t ri = 1; ri < replicas; ++ri) {
+    size_t candidate = (timeslice + ri) % replicas;
+    if (pipeline.outstanding[candidate] < pipeline.outstanding[best]) {
+      best = candidate;
+    }
+  }
+  pipeline.outstanding[best]++;
+  pipeline.assigned.emplace(timeslice, best);
+  pipeline.order.push_back(timeslice);
+  // Forget about the timeslices which were credited, and about those
+  // whose credit is overdue.
+  while (pipeline.order.empty() == false) {
+    auto oldest = pipeline.assigned.find(pipeline.order.front());
+    if (oldest != pipeline.assigned.end() && pipeline.order.size() <= mExpireAfter) {
+      break;
+    }
+    if (oldest != pipeline.assigned.end()) {
+      pipeline.outstanding[oldest->second]--;
+      pipeline.assigned.erase(oldest);
+    }
+    pipeline.order.pop_front();
+  }
+  return best;
+}
+
+void TimePipelineDispatcher::credit(std::string const& consumer, size_t timeslice)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto pipeline = mPipelines.find(consumer);
+  if (pipeline == mPipelines.end()) {
+    return;
+  }
+  auto assigned = pipeline->second.assigned.find(timeslice);
+  if (assigned == pipeline->second.assigned.end()) {
+    return;
+  }
+  pipeline->second.outstanding[assigned->second]--;
+  pipeline->second.assigned.erase(assigned);
+}
+
+size_t TimePipelineDispatcher::outstanding(std::string const& consumer, size_t replica) const
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  auto pipeline = mPipelines.find(consumer);
+  if (pipeline == mPipelines.end() || replica >= pipeline->second.outstanding.size()) {
+    return 0;
+  }
+  return pipeline->second.outstanding[replica];
+}
+
+} // namespace o2::framework
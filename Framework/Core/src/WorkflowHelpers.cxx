@@ -190,7 +190,8 @@ void WorkflowHelpers::injectServiceDevices(WorkflowSpec& workflow)
                static_cast<DataAllocator::SubSpecificationType>(separateEnumerations++), Lifetime::Enumeration}},
     {},
     readers::AODReaderHelpers::rootFileReaderCallback(),
-    {ConfigParamSpec{"aod-file", VariantType::String, "aod.root", {"Input AOD file"}},
+    {ConfigParamSpec{"aod-file", VariantType::String, "aod.root", {"Input AOD file (.root, or .arrow as produced by run2ESD2Run3AOD)"}},
+     ConfigParamSpec{"aod-reader-threads", VariantType::Int, 0, {"threads used to convert the branches of the AOD trees (0: no extra threads)"}},
      ConfigParamSpec{"start-value-enumeration", VariantType::Int, 0, {"initial value for the enumeration"}},
      ConfigParamSpec{"end-value-enumeration", VariantType::Int, -1, {"final value for the enumeration"}},
      ConfigParamSpec{"step-value-enumeration", VariantType::Int, 1, {"step between one value and the other"}}}};
@@ -139,12 +139,14 @@ Inputs mergeInputs(Inputs inputs,
 }
 
 DataProcessorSpec timePipeline(DataProcessorSpec original,
-                               size_t count)
+                               size_t count,
+                               TimePipelineDispatch dispatch)
 {
   if (original.maxInputTimeslices != 1) {
     std::runtime_error("You can time slice only once");
   }
   original.maxInputTimeslices = count;
+  original.timePipelineDispatch = dispatch;
   return original;
 }
 
@@ -639,9 +639,14 @@ int doChild(int argc, char** argv, const o2::framework::DeviceSpec& spec)
     runner.AddHook<fair::mq::hooks::SetCustomCmdLineOptions>([&spec](fair::mq::DeviceRunner& r) {
       boost::program_options::options_description optsDesc;
       ConfigParamsHelper::populateBoostProgramOptions(optsDesc, spec.options, gHiddenDeviceOptions);
-      optsDesc.add_options()("monitoring-backend", bpo::value<std::string>()->default_value("infologger://"), "monitoring backend info") //
-        ("infologger-severity", bpo::value<std::string>()->default_value(""), "minimum FairLogger severity to send to InfoLogger")       //
-        ("infologger-mode", bpo::value<std::string>()->default_value(""), "INFOLOGGER_MODE override");
+      optsDesc.add_options()("monitoring-backend", bpo::value<std::string>()->default_value("infologger://"), "monitoring backend info")            //
+        ("infologger-severity", bpo::value<std::string>()->default_value(""), "minimum FairLogger severity to send to InfoLogger")                  //
+        ("infologger-mode", bpo::value<std::string>()->default_value(""), "INFOLOGGER_MODE override")                                               //
+        ("worker-threads", bpo::value<int>()->default_value(0), "number of threads processing timeslices concurrently (0: main thread only)")       //
+        ("max-pipeline-length", bpo::value<int>()->default_value(0), "upper bound for the runtime tuned number of in flight timeslices (0: fixed)") //
+        ("max-pipeline-bytes", bpo::value<size_t>()->default_value(0), "do not grow the pipeline beyond this many cached bytes (0: no limit)")      //
+        ("polling-timeout", bpo::value<int>()->default_value(0), "max ms to sleep waiting for inputs or timers (0: busy polling)")                  //
+        ("message-pool-size", bpo::value<size_t>()->default_value(0), "bytes per output channel to recycle output messages from (0: no pooling)");
       r.fConfig.AddToCmdLineOptions(optsDesc, true);
     });
 
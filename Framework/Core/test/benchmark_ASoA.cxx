@@ -255,6 +255,71 @@ static void BM_ASoASimpleForLoopWithOp(benchmark::State& state)
 
 BENCHMARK(BM_ASoASimpleForLoopWithOp)->Range(8, 8 << maxrange);
 
+static void BM_ASoASpanForLoopWithOp(benchmark::State& state)
+{
+  // Seed with a real random value, if available
+  std::default_random_engine e1(1234567891);
+  std::uniform_real_distribution<float> uniform_dist(0, 1);
+
+  TableBuilder builder;
+  auto rowWriter = builder.persist<float, float, float>({"x", "y", "z"});
+  for (auto i = 0; i < state.range(0); ++i) {
+    rowWriter(0, uniform_dist(e1), uniform_dist(e1), uniform_dist(e1));
+  }
+  auto table = builder.finalize();
+
+  using Test = o2::soa::Table<test::X, test::Y>;
+
+  for (auto _ : state) {
+    Test tests{table};
+    float sum = 0;
+    tests.forEachSpan<test::X, test::Y>([&sum](auto xs, auto ys) {
+      for (size_t i = 0; i < xs.size(); ++i) {
+        sum += xs[i] + ys[i];
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(float) * 2);
+}
+
+BENCHMARK(BM_ASoASpanForLoopWithOp)->Range(8, 8 << maxrange);
+
+static void BM_ASoAChunkedSpanForLoopWithOp(benchmark::State& state)
+{
+  // Seed with a real random value, if available
+  std::default_random_engine e1(1234567891);
+  std::uniform_real_distribution<float> uniform_dist(0, 1);
+
+  // Same as above, but with the rows split in two chunks.
+  std::vector<std::shared_ptr<arrow::Table>> tables;
+  for (auto half = 0; half < 2; ++half) {
+    TableBuilder builder;
+    auto rowWriter = builder.persist<float, float, float>({"x", "y", "z"});
+    for (auto i = 0; i < state.range(0) / 2; ++i) {
+      rowWriter(0, uniform_dist(e1), uniform_dist(e1), uniform_dist(e1));
+    }
+    tables.push_back(builder.finalize());
+  }
+
+  using Test = o2::soa::Table<test::X, test::Y>;
+  using ConcatTest = Concat<Test, Test>;
+
+  for (auto _ : state) {
+    ConcatTest tests{tables[0], tables[1]};
+    float sum = 0;
+    tests.forEachSpan<test::X, test::Y>([&sum](auto xs, auto ys) {
+      for (size_t i = 0; i < xs.size(); ++i) {
+        sum += xs[i] + ys[i];
+      }
+    });
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(float) * 2);
+}
+
+BENCHMARK(BM_ASoAChunkedSpanForLoopWithOp)->Range(8, 8 << maxrange);
+
 static void BM_ASoADynamicColumnPresent(benchmark::State& state)
 {
   // Seed with a real random value, if available
@@ -343,6 +408,41 @@ static void BM_ASoAGettersPhi(benchmark::State& state)
 
 BENCHMARK(BM_ASoAGettersPhi)->Range(8, 8 << maxrange);
 
+static void BM_ASoASpanPhi(benchmark::State& state)
+{
+  // Seed with a real random value, if available
+  std::default_random_engine e1(1234567891);
+  std::uniform_real_distribution<float> uniform_dist(0, 1);
+
+  TableBuilder builder;
+  auto rowWriter = builder.cursor<o2::aod::Tracks>();
+  for (auto i = 0; i < state.range(0); ++i) {
+    rowWriter(0, uniform_dist(e1), uniform_dist(e1), uniform_dist(e1),
+              uniform_dist(e1), uniform_dist(e1), uniform_dist(e1),
+              uniform_dist(e1), uniform_dist(e1));
+  }
+  auto table = builder.finalize();
+
+  o2::aod::Tracks tracks{table};
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<float> out;
+    out.resize(state.range(0));
+    float* result = out.data();
+    state.ResumeTiming();
+    tracks.forEachSpan<o2::aod::track::Snp, o2::aod::track::Alpha>([&result](auto snps, auto alphas) {
+      for (size_t i = 0; i < snps.size(); ++i) {
+        result[i] = asin(snps[i]) + alphas[i] + M_PI;
+      }
+      result += snps.size();
+    });
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetBytesProcessed(state.iterations() * state.range(0) * sizeof(float) * 2);
+}
+
+BENCHMARK(BM_ASoASpanPhi)->Range(8, 8 << maxrange);
+
 static void BM_ASoAWholeTrackForLoop(benchmark::State& state)
 {
   // Seed with a real random value, if available
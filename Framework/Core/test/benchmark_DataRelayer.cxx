@@ -235,4 +235,78 @@ static void BM_RelayMultipleRoutes(benchmark::State& state)
 
 BENCHMARK(BM_RelayMultipleRoutes);
 
+/// Relay a message for the last of @a nRoutes routes, either expressed as
+/// concrete matchers (which can be looked up directly) or as equivalent
+/// DataDescriptorMatchers (which need to be walked one by one).
+static void relayToManyRoutes(benchmark::State& state, bool concrete)
+{
+  using namespace o2::framework::data_matcher;
+  Monitoring metrics;
+  size_t nRoutes = state.range(0);
+
+  std::vector<InputRoute> inputs;
+  for (size_t ri = 0; ri < nRoutes; ++ri) {
+    auto subSpec = static_cast<DataHeader::SubSpecificationType>(ri);
+    if (concrete) {
+      inputs.emplace_back(InputRoute{InputSpec{"clusters", "TPC", "CLUSTERS", subSpec}, ri, "Fake", 0});
+      continue;
+    }
+    DataDescriptorMatcher matcher{
+      DataDescriptorMatcher::Op::And,
+      StartTimeValueMatcher{ContextRef{0}},
+      std::make_unique<DataDescriptorMatcher>(
+        DataDescriptorMatcher::Op::And,
+        OriginValueMatcher{"TPC"},
+        std::make_unique<DataDescriptorMatcher>(
+          DataDescriptorMatcher::Op::And,
+          DescriptionValueMatcher{"CLUSTERS"},
+          std::make_unique<DataDescriptorMatcher>(
+            DataDescriptorMatcher::Op::Just,
+            SubSpecificationTypeValueMatcher{subSpec})))};
+    inputs.emplace_back(InputRoute{InputSpec{"clusters", std::move(matcher)}, ri, "Fake", 0});
+  }
+
+  TimesliceIndex index;
+
+  auto policy = CompletionPolicyHelpers::consumeWhenAny();
+  DataRelayer relayer(policy, inputs, metrics, index);
+  relayer.setPipelineLength(4);
+
+  DataHeader dh;
+  dh.dataDescription = "CLUSTERS";
+  dh.dataOrigin = "TPC";
+  dh.subSpecification = nRoutes - 1;
+
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  size_t timeslice = 0;
+
+  for (auto _ : state) {
+    DataProcessingHeader dph{timeslice++, 1};
+    Stack stack{dh, dph};
+    FairMQMessagePtr header = transport->CreateMessage(stack.size());
+    FairMQMessagePtr payload = transport->CreateMessage(1000);
+    memcpy(header->GetData(), stack.data(), stack.size());
+
+    relayer.relay(std::move(header), std::move(payload));
+    auto ready = relayer.getReadyToProcess();
+    assert(ready.size() == 1);
+    assert(ready[0].op == CompletionPolicy::CompletionOp::Consume);
+    auto result = relayer.getInputsForTimeslice(ready[0].slot);
+    assert(result.size() == 2 * nRoutes);
+  }
+}
+
+static void BM_RelayManyConcreteRoutes(benchmark::State& state)
+{
+  relayToManyRoutes(state, true);
+}
+
+static void BM_RelayManyMatcherRoutes(benchmark::State& state)
+{
+  relayToManyRoutes(state, false);
+}
+
+BENCHMARK(BM_RelayManyConcreteRoutes)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK(BM_RelayManyMatcherRoutes)->Arg(10)->Arg(100)->Arg(1000);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,115 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include <benchmark/benchmark.h>
+
+#include "Framework/DataSamplingPolicy.h"
+#include "Framework/DataRef.h"
+#include "Framework/DataProcessingHeader.h"
+#include "Headers/DataHeader.h"
+#include "Headers/Stack.h"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace o2::framework;
+using namespace o2::header;
+
+namespace
+{
+constexpr size_t INPUTS_PER_TIMESLICE = 16;
+
+std::vector<std::unique_ptr<DataSamplingPolicy>> createPolicies(size_t n)
+{
+  using boost::property_tree::ptree;
+  std::vector<std::unique_ptr<DataSamplingPolicy>> policies;
+  for (size_t i = 0; i < n; ++i) {
+    ptree config;
+    config.put("id", "policy" + std::to_string(i));
+    config.put("active", "true");
+    config.put("query", "x:TST/RAWDATA");
+    ptree conditions;
+    ptree random;
+    random.put("condition", "random");
+    random.put("fraction", "0.1");
+    random.put("seed", std::to_string(i));
+    conditions.push_back(std::make_pair("", random));
+    ptree payloadSize;
+    payloadSize.put("condition", "payloadSize");
+    payloadSize.put("lowerLimit", 0);
+    payloadSize.put("upperLimit", 1000000);
+    conditions.push_back(std::make_pair("", payloadSize));
+    config.add_child("samplingConditions", conditions);
+    policies.push_back(std::make_unique<DataSamplingPolicy>(config));
+  }
+  return policies;
+}
+
+std::vector<Stack> createHeaders(DataProcessingHeader::StartTime timeslice)
+{
+  std::vector<Stack> stacks;
+  for (size_t i = 0; i < INPUTS_PER_TIMESLICE; ++i) {
+    DataHeader dh{"RAWDATA", "TST", static_cast<DataHeader::SubSpecificationType>(i), 1000 * i};
+    stacks.emplace_back(dh, DataProcessingHeader{timeslice, 1});
+  }
+  return stacks;
+}
+} // namespace
+
+// Decision cost per message, one decision per message and policy.
+static void BM_DecidePerMessage(benchmark::State& state)
+{
+  auto policies = createPolicies(state.range(0));
+  DataProcessingHeader::StartTime timeslice = 0;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stacks = createHeaders(timeslice++);
+    state.ResumeTiming();
+    for (auto& stack : stacks) {
+      DataRef ref{nullptr, reinterpret_cast<const char*>(stack.data()), nullptr};
+      for (auto& policy : policies) {
+        benchmark::DoNotOptimize(policy->decide(ref));
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * INPUTS_PER_TIMESLICE);
+}
+
+BENCHMARK(BM_DecidePerMessage)->RangeMultiplier(2)->Range(1, 64);
+
+// Decision cost per message, with each policy evaluating all the messages of a timeslice at once.
+static void BM_DecideBatch(benchmark::State& state)
+{
+  auto policies = createPolicies(state.range(0));
+  DataProcessingHeader::StartTime timeslice = 0;
+  DataSamplingBatch batch;
+  std::vector<uint8_t> mask;
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto stacks = createHeaders(timeslice++);
+    state.ResumeTiming();
+    batch.clear();
+    for (auto& stack : stacks) {
+      batch.add(DataRef{nullptr, reinterpret_cast<const char*>(stack.data()), nullptr});
+    }
+    for (auto& policy : policies) {
+      mask.assign(batch.size(), 1);
+      policy->decide(batch, mask);
+      benchmark::DoNotOptimize(mask.data());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * INPUTS_PER_TIMESLICE);
+}
+
+BENCHMARK(BM_DecideBatch)->RangeMultiplier(2)->Range(1, 64);
+
+BENCHMARK_MAIN();
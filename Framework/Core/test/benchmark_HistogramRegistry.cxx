@@ -61,7 +61,37 @@ static void BM_StandardNameLookup(benchmark::State& state)
     }
   }
 }
+/// Fill histograms of a registry, entries are buffered and filled in bulk
+static void BM_RegistryFill(benchmark::State& state)
+{
+  HistogramRegistry registry{"registry", true, {{"eta", "#Eta", {"TH1F", 100, -2.0, 2.0}}, {"etaphi", "#Eta #Phi", {"TH2F", {{100, -2.0, 2.0}, {100, 0, 2 * M_PI}}}}}};
+  for (auto _ : state) {
+    for (auto i = 0; i < state.range(0); ++i) {
+      registry.fill("eta", 0.1);
+      registry.fill("etaphi", 0.1, 0.2);
+    }
+    registry.flush();
+  }
+  state.SetItemsProcessed(2 * state.iterations() * state.range(0));
+}
+
+/// Fill the same histograms one entry at the time
+static void BM_DirectFill(benchmark::State& state)
+{
+  TH1F eta("eta", "#Eta", 100, -2.0, 2.0);
+  TH2F etaphi("etaphi", "#Eta #Phi", 100, -2.0, 2.0, 100, 0, 2 * M_PI);
+  for (auto _ : state) {
+    for (auto i = 0; i < state.range(0); ++i) {
+      eta.Fill(0.1);
+      etaphi.Fill(0.1, 0.2);
+    }
+  }
+  state.SetItemsProcessed(2 * state.iterations() * state.range(0));
+}
+
 BENCHMARK(BM_HashedNameLookup)->Arg(4)->Arg(8)->Arg(16)->Arg(64)->Arg(128)->Arg(256)->Arg(512);
 BENCHMARK(BM_StandardNameLookup)->Arg(4)->Arg(8)->Arg(16)->Arg(64)->Arg(128)->Arg(256)->Arg(512);
+BENCHMARK(BM_RegistryFill)->Arg(1000)->Arg(100000);
+BENCHMARK(BM_DirectFill)->Arg(1000)->Arg(100000);
 
 BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "Framework/TableBuilder.h"
+#include "Framework/RootTableBuilderHelpers.h"
+#include "Framework/ThreadPool.h"
+
+#include <TFile.h>
+#include <TRandom.h>
+#include <TTree.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace o2::framework;
+
+namespace
+{
+constexpr int nEntries = 1 << 18;
+constexpr char const* branchNames[] = {"fX", "fAlpha", "fY", "fZ", "fSnp", "fTgl", "fSigned1Pt", "fID4Tracks"};
+
+/// A tree with the same shape as the O2tracks one, written to a file
+/// so that the baskets go through compression as they would for the AOD,
+/// and so that each worker of the bulk conversion can open it on its own.
+char const* makeTree()
+{
+  constexpr char const* fileName = "benchmark_Root2ArrowTable.root";
+  static bool written = false;
+  if (written == false) {
+    TFile output(fileName, "RECREATE");
+    auto tree = new TTree("O2tracks", "Track parameters");
+    Float_t values[7];
+    Int_t id;
+    for (int i = 0; i < 7; ++i) {
+      tree->Branch(branchNames[i], &values[i], (std::string(branchNames[i]) + "/F").c_str());
+    }
+    tree->Branch("fID4Tracks", &id, "fID4Tracks/I");
+    for (int i = 0; i < nEntries; ++i) {
+      for (auto& value : values) {
+        value = gRandom->Gaus();
+      }
+      id = i;
+      tree->Fill();
+    }
+    output.Write();
+    written = true;
+  }
+  return fileName;
+}
+} // namespace
+
+static void BM_ConvertTTree(benchmark::State& state)
+{
+  TFile file(makeTree());
+  auto tree = dynamic_cast<TTree*>(file.Get("O2tracks"));
+  for (auto _ : state) {
+    TableBuilder builder;
+    TTreeReader reader(tree);
+    TTreeReaderValue<int> c0(reader, "fID4Tracks");
+    TTreeReaderValue<float> c1(reader, "fX");
+    TTreeReaderValue<float> c2(reader, "fAlpha");
+    TTreeReaderValue<float> c3(reader, "fY");
+    TTreeReaderValue<float> c4(reader, "fZ");
+    TTreeReaderValue<float> c5(reader, "fSnp");
+    TTreeReaderValue<float> c6(reader, "fTgl");
+    TTreeReaderValue<float> c7(reader, "fSigned1Pt");
+    RootTableBuilderHelpers::convertTTree(builder, reader, c0, c1, c2, c3, c4, c5, c6, c7);
+    auto table = builder.finalize();
+    benchmark::DoNotOptimize(table);
+  }
+  state.SetItemsProcessed(state.iterations() * nEntries);
+}
+
+BENCHMARK(BM_ConvertTTree);
+
+static void BM_ConvertTTreeBulk(benchmark::State& state)
+{
+  TFile file(makeTree());
+  auto tree = dynamic_cast<TTree*>(file.Get("O2tracks"));
+  std::vector<std::string> names{std::begin(branchNames), std::end(branchNames)};
+  ThreadPool pool(state.range(0));
+  for (auto _ : state) {
+    auto table = RootTableBuilderHelpers::convertTTreeBulk(*tree, names, &pool);
+    benchmark::DoNotOptimize(table);
+  }
+  state.SetItemsProcessed(state.iterations() * nEntries);
+}
+
+BENCHMARK(BM_ConvertTTreeBulk)->Arg(0)->Arg(2)->Arg(4)->Arg(8);
+
+BENCHMARK_MAIN();
@@ -13,6 +13,8 @@
 
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
+
 using namespace o2::framework;
 
 static void BM_TableBuilderOverhead(benchmark::State& state)
@@ -127,10 +129,65 @@ static void BM_TableBuilderSoA(benchmark::State& state)
     }
     auto table = builder.finalize();
   }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
 }
 
 BENCHMARK(BM_TableBuilderSoA)->Range(8, 8 << 16);
 
+static void BM_TableBuilderSoABulk(benchmark::State& state)
+{
+  using namespace o2::framework;
+  constexpr size_t chunkSize = 1024;
+  std::vector<float> x(chunkSize, 0.f);
+  std::vector<float> y(chunkSize, 0.f);
+  std::vector<float> z(chunkSize, 0.f);
+  for (auto _ : state) {
+    TableBuilder builder;
+    auto rowWriter = builder.cursor<TestVectors>();
+    auto bulkWriter = builder.bulkCursor<TestVectors>();
+    builder.reserve(state.range(0));
+    for (size_t i = 0; i < state.range(0); i += chunkSize) {
+      bulkWriter(0, std::min<size_t>(chunkSize, state.range(0) - i), x.data(), y.data(), z.data());
+    }
+    auto table = builder.finalize();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_TableBuilderSoABulk)->Range(8, 8 << 16);
+
+static void BM_TableBuilderStructsBulk(benchmark::State& state)
+{
+  using namespace o2::framework;
+  struct Vector {
+    float x;
+    float y;
+    float z;
+  };
+  constexpr size_t chunkSize = 1024;
+  std::vector<Vector> rows(chunkSize, Vector{0.f, 0.f, 0.f});
+  std::vector<float> x(chunkSize);
+  std::vector<float> y(chunkSize);
+  std::vector<float> z(chunkSize);
+  for (auto _ : state) {
+    TableBuilder builder;
+    auto rowWriter = builder.cursor<TestVectors>();
+    auto bulkWriter = builder.bulkCursor<TestVectors>();
+    builder.reserve(state.range(0));
+    for (size_t i = 0; i < state.range(0); i += chunkSize) {
+      auto n = std::min<size_t>(chunkSize, state.range(0) - i);
+      TableBuilderHelpers::transpose(rows.data(), n, &Vector::x, x.data());
+      TableBuilderHelpers::transpose(rows.data(), n, &Vector::y, y.data());
+      TableBuilderHelpers::transpose(rows.data(), n, &Vector::z, z.data());
+      bulkWriter(0, n, x.data(), y.data(), z.data());
+    }
+    auto table = builder.finalize();
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_TableBuilderStructsBulk)->Range(8, 8 << 16);
+
 static void BM_TableBuilderComplex(benchmark::State& state)
 {
   using namespace o2::framework;
@@ -0,0 +1,124 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Framework AODReaderHelpers
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "Framework/AODReaderHelpers.h"
+
+#include <arrow/array.h>
+#include <arrow/builder.h>
+#include <arrow/io/memory.h>
+#include <arrow/ipc/writer.h>
+#include <arrow/record_batch.h>
+#include <arrow/util/key_value_metadata.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace o2::framework::readers;
+
+namespace
+{
+/// An Arrow IPC stream with one int column and one record batch per
+/// element of @a batches, described as @a description.
+std::vector<uint8_t> writeStream(std::string const& description, std::vector<std::vector<int32_t>> const& batches)
+{
+  auto schema = arrow::schema({arrow::field("x", arrow::int32())},
+                              arrow::key_value_metadata({"description"}, {description}));
+  std::shared_ptr<arrow::io::BufferOutputStream> stream;
+  BOOST_REQUIRE(arrow::io::BufferOutputStream::Create(1024, arrow::default_memory_pool(), &stream).ok());
+  std::shared_ptr<arrow::ipc::RecordBatchWriter> writer;
+  BOOST_REQUIRE(arrow::ipc::RecordBatchStreamWriter::Open(stream.get(), schema, &writer).ok());
+  for (auto const& values : batches) {
+    arrow::Int32Builder builder;
+    BOOST_REQUIRE(builder.AppendValues(values).ok());
+    std::shared_ptr<arrow::Array> array;
+    BOOST_REQUIRE(builder.Finish(&array).ok());
+    BOOST_REQUIRE(writer->WriteRecordBatch(*arrow::RecordBatch::Make(schema, values.size(), {array})).ok());
+  }
+  BOOST_REQUIRE(writer->Close().ok());
+  std::shared_ptr<arrow::Buffer> buffer;
+  BOOST_REQUIRE(stream->Finish(&buffer).ok());
+  return {buffer->data(), buffer->data() + buffer->size()};
+}
+
+/// The descriptions of the streams and the values of their batches, as read back from @a content
+struct ReadBack {
+  std::vector<std::string> descriptions;
+  std::vector<std::vector<int32_t>> batches;
+};
+
+ReadBack readStreams(std::vector<uint8_t> const& content)
+{
+  ReadBack result;
+  AODReaderHelpers::readArrowStreams(
+    std::make_shared<arrow::Buffer>(content.data(), content.size()),
+    [&result](std::shared_ptr<arrow::Schema> const& schema) {
+      std::unordered_map<std::string, std::string> meta;
+      schema->metadata()->ToUnorderedMap(&meta);
+      result.descriptions.push_back(meta["description"]);
+    },
+    [&result](arrow::RecordBatch const& batch) {
+      auto column = std::static_pointer_cast<arrow::Int32Array>(batch.column(0));
+      result.batches.emplace_back(column->raw_values(), column->raw_values() + column->length());
+    });
+  return result;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestReadArrowStreams)
+{
+  std::vector<std::vector<int32_t>> tracks{{1, 2, 3}, {4, 5}, {6}};
+  std::vector<std::vector<int32_t>> collisions{{10, 20}, {30, 40, 50, 60}};
+  auto first = writeStream("TRACKPAR", tracks);
+  auto second = writeStream("COLLISION", collisions);
+  std::vector<std::vector<int32_t>> allBatches{tracks};
+  allBatches.insert(allBatches.end(), collisions.begin(), collisions.end());
+
+  // Streams one after the other
+  std::vector<uint8_t> content{first};
+  content.insert(content.end(), second.begin(), second.end());
+  auto result = readStreams(content);
+  BOOST_CHECK((result.descriptions == std::vector<std::string>{"TRACKPAR", "COLLISION"}));
+  BOOST_CHECK(result.batches == allBatches);
+
+  // Streams separated and followed by 0-padding
+  std::vector<uint8_t> padded{first};
+  padded.insert(padded.end(), 5, 0);
+  padded.insert(padded.end(), second.begin(), second.end());
+  padded.insert(padded.end(), 4096 + 3, 0);
+  result = readStreams(padded);
+  BOOST_CHECK((result.descriptions == std::vector<std::string>{"TRACKPAR", "COLLISION"}));
+  BOOST_CHECK(result.batches == allBatches);
+
+  // Nothing but padding
+  result = readStreams(std::vector<uint8_t>(100, 0));
+  BOOST_CHECK(result.descriptions.empty());
+  BOOST_CHECK(result.batches.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestReadArrowStreamsErrors)
+{
+  auto stream = writeStream("TRACKPAR", {{1, 2, 3}, {4, 5}});
+
+  // Something which is not a stream after the padding
+  std::vector<uint8_t> garbage{stream};
+  garbage.insert(garbage.end(), 8, 0);
+  garbage.insert(garbage.end(), {1, 2, 3, 4, 5, 6, 7, 8});
+  BOOST_CHECK_THROW(readStreams(garbage), std::runtime_error);
+
+  // A truncated stream
+  std::vector<uint8_t> truncated{stream.begin(), stream.begin() + stream.size() / 2};
+  BOOST_CHECK_THROW(readStreams(truncated), std::runtime_error);
+}
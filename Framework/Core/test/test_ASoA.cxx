@@ -339,3 +339,56 @@ BOOST_AUTO_TEST_CASE(TestConcatTables)
   }
   BOOST_CHECK_EQUAL(i, 3);
 }
+
+BOOST_AUTO_TEST_CASE(TestSpanIteration)
+{
+  TableBuilder builderA;
+  auto rowWriterA = builderA.persist<uint64_t, uint64_t>({"x", "y"});
+  for (uint64_t i = 0; i < 8; ++i) {
+    rowWriterA(0, i, 2 * i);
+  }
+  auto tableA = builderA.finalize();
+
+  TableBuilder builderB;
+  auto rowWriterB = builderB.persist<uint64_t, uint64_t>({"x", "y"});
+  for (uint64_t i = 8; i < 13; ++i) {
+    rowWriterB(0, i, 2 * i);
+  }
+  auto tableB = builderB.finalize();
+
+  // A single chunk table gets the whole columns in one go.
+  using TestA = o2::soa::Table<test::X, test::Y>;
+  TestA testA{tableA};
+  BOOST_CHECK(testA.isFlat<test::X, test::Y>());
+  int calls = 0;
+  testA.forEachSpan<test::X, test::Y>([&calls](gsl::span<uint64_t const> xs, gsl::span<uint64_t const> ys) {
+    BOOST_REQUIRE_EQUAL(xs.size(), 8);
+    BOOST_REQUIRE_EQUAL(ys.size(), 8);
+    for (size_t i = 0; i < xs.size(); ++i) {
+      BOOST_CHECK_EQUAL(xs[i], i);
+      BOOST_CHECK_EQUAL(ys[i], 2 * i);
+    }
+    calls++;
+  });
+  BOOST_CHECK_EQUAL(calls, 1);
+
+  // A concatenated table has one span per chunk, and the spans together
+  // cover all the rows in order.
+  using ConcatTest = Concat<TestA, TestA>;
+  ConcatTest concat{tableA, tableB};
+  BOOST_CHECK(concat.isFlat<test::X>() == false);
+  std::vector<size_t> sizes;
+  uint64_t expected = 0;
+  concat.forEachSpan<test::X, test::Y>([&sizes, &expected](auto xs, auto ys) {
+    sizes.push_back(xs.size());
+    for (size_t i = 0; i < xs.size(); ++i) {
+      BOOST_CHECK_EQUAL(xs[i], expected);
+      BOOST_CHECK_EQUAL(ys[i], 2 * expected);
+      expected++;
+    }
+  });
+  BOOST_REQUIRE_EQUAL(sizes.size(), 2);
+  BOOST_CHECK_EQUAL(sizes[0], 8);
+  BOOST_CHECK_EQUAL(sizes[1], 5);
+  BOOST_CHECK_EQUAL(expected, 13);
+}
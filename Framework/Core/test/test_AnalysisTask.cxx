@@ -102,3 +102,31 @@ BOOST_AUTO_TEST_CASE(AdaptorCompilation)
   BOOST_CHECK_EQUAL(task5.inputs.size(), 1);
   BOOST_CHECK_EQUAL(task5.inputs[0].binding, "FooBars");
 }
+
+BOOST_AUTO_TEST_CASE(BulkWritingCursor)
+{
+  struct FooBar {
+    float bar;
+    float foo;
+  };
+  std::vector<FooBar> rows{{1.f, 10.f}, {2.f, 20.f}, {3.f, 30.f}};
+  float foos[] = {40.f, 50.f};
+  float bars[] = {4.f, 5.f};
+
+  TableBuilder builder;
+  Produces<aod::FooBars> foobars;
+  foobars.resetCursor(builder);
+  foobars.reserve(rows.size() + 3);
+  foobars(0.f, 0.f);
+  foobars.bulk(rows.data(), rows.size(), &FooBar::foo, &FooBar::bar);
+  foobars.bulk(2, foos, bars);
+  auto table = builder.finalize();
+  BOOST_REQUIRE_EQUAL(table->num_rows(), 6);
+
+  size_t i = 0;
+  for (auto& row : aod::FooBars{table}) {
+    BOOST_CHECK_EQUAL(row.foo(), i * 10.f);
+    BOOST_CHECK_EQUAL(row.bar(), float(i));
+    ++i;
+  }
+}
@@ -0,0 +1,109 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Framework DataDumpFile
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "../src/DataDumpFile.h"
+#include "Framework/CommonDataProcessors.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace o2::framework;
+using namespace o2::header;
+
+namespace
+{
+void writeAndReadBack(std::string const& compression)
+{
+  std::string filename = "test_DataDumpFile_" + compression + ".bin";
+  {
+    // Small blocks, so that entries end up in different blocks,
+    // and one entry bigger than a block.
+    DataDumpWriter writer{filename, compression, 1024, 1};
+    for (uint64_t timeslice = 0; timeslice < 10; ++timeslice) {
+      for (uint32_t subSpec = 0; subSpec < 3; ++subSpec) {
+        DataHeader dh{"CLUSTERS", "TPC", subSpec};
+        std::vector<char> payload(subSpec == 2 && timeslice == 5 ? 10000 : 100, static_cast<char>(timeslice + subSpec));
+        dh.payloadSize = payload.size();
+        dh.payloadSerializationMethod = subSpec == 1 ? gSerializationMethodROOT : gSerializationMethodNone;
+        dh.splitPayloadParts = 2;
+        dh.splitPayloadIndex = timeslice % 2;
+        writer.write(dh, DataProcessingHeader{timeslice}, payload.data(), payload.size());
+      }
+    }
+    BOOST_CHECK_EQUAL(writer.entries(), 30);
+    writer.close();
+    BOOST_CHECK_THROW(writer.write(DataHeader{}, DataProcessingHeader{}, nullptr, 0), std::runtime_error);
+  }
+
+  DataDumpReader reader{filename};
+  BOOST_REQUIRE_EQUAL(reader.index().size(), 30);
+  BOOST_REQUIRE_EQUAL(reader.timeslices().size(), 10);
+
+  // Random access, going backwards
+  for (int64_t timeslice = 9; timeslice >= 0; --timeslice) {
+    auto entries = reader.entries(timeslice);
+    BOOST_REQUIRE_EQUAL(entries.size(), 3);
+    for (uint32_t subSpec = 0; subSpec < 3; ++subSpec) {
+      BOOST_CHECK(entries[subSpec].origin == DataOrigin{"TPC"});
+      BOOST_CHECK(entries[subSpec].description == DataDescription{"CLUSTERS"});
+      BOOST_CHECK_EQUAL(entries[subSpec].subSpec, subSpec);
+      auto entry = reader.read(entries[subSpec]);
+      // The whole DataHeader is kept
+      BOOST_CHECK_EQUAL(entry.header.subSpecification, subSpec);
+      BOOST_CHECK(entry.header.payloadSerializationMethod == (subSpec == 1 ? gSerializationMethodROOT : gSerializationMethodNone));
+      BOOST_CHECK_EQUAL(entry.header.splitPayloadParts, 2);
+      BOOST_CHECK_EQUAL(entry.header.splitPayloadIndex, timeslice % 2);
+      BOOST_CHECK_EQUAL(entry.header.payloadSize, entry.payloadSize);
+      BOOST_CHECK_EQUAL(entry.processingHeader.startTime, timeslice);
+      BOOST_REQUIRE_EQUAL(entry.payloadSize, subSpec == 2 && timeslice == 5 ? 10000 : 100);
+      BOOST_CHECK_EQUAL(entry.payload[0], static_cast<char>(timeslice + subSpec));
+      BOOST_CHECK_EQUAL(entry.payload[entry.payloadSize - 1], static_cast<char>(timeslice + subSpec));
+    }
+  }
+  std::remove(filename.c_str());
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestUncompressed)
+{
+  writeAndReadBack("none");
+}
+
+BOOST_AUTO_TEST_CASE(TestCompressed)
+{
+  for (auto compression : {"lz4", "zstd"}) {
+    try {
+      DataDumpWriter probe{"test_DataDumpFile_probe.bin", compression};
+    } catch (std::runtime_error& e) {
+      BOOST_TEST_MESSAGE(std::string("Skipping ") + compression + ": " + e.what());
+      continue;
+    }
+    writeAndReadBack(compression);
+  }
+  std::remove("test_DataDumpFile_probe.bin");
+}
+
+BOOST_AUTO_TEST_CASE(TestInvalidFiles)
+{
+  BOOST_CHECK_THROW(DataDumpWriter("test_DataDumpFile_invalid.bin", "unknown"), std::runtime_error);
+  BOOST_CHECK_THROW(DataDumpReader("test_DataDumpFile_does_not_exist.bin"), std::runtime_error);
+  // The replay only opens the file when it starts
+  DataProcessorSpec source;
+  BOOST_CHECK_NO_THROW(source = CommonDataProcessors::getGlobalFileSource({OutputSpec{ConcreteDataTypeMatcher{"TPC", "CLUSTERS"}}},
+                                                                          "test_DataDumpFile_does_not_exist.bin"));
+  BOOST_CHECK_EQUAL(source.outputs.size(), 1);
+}
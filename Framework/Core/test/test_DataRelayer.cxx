@@ -21,14 +21,41 @@
 #include "Framework/DataProcessingHeader.h"
 #include "Framework/WorkflowSpec.h"
 #include <Monitoring/Monitoring.h>
+#include <Monitoring/Backend.h>
 #include <fairmq/FairMQTransportFactory.h>
 #include <cstring>
+#include <memory>
+#include <set>
+#include <string>
 
 using Monitoring = o2::monitoring::Monitoring;
 using namespace o2::framework;
 using DataHeader = o2::header::DataHeader;
 using Stack = o2::header::Stack;
 
+namespace
+{
+/// A monitoring backend which only remembers the names of the metrics it
+/// was sent, so that we can check what the relayer publishes.
+class RecordingBackend : public o2::monitoring::Backend
+{
+ public:
+  RecordingBackend(std::shared_ptr<std::set<std::string>> sent) : mSent{sent} {}
+  void send(const o2::monitoring::Metric& metric) override { mSent->insert(metric.getName()); }
+  void send(std::vector<o2::monitoring::Metric>&& metrics) override
+  {
+    for (auto& metric : metrics) {
+      send(metric);
+    }
+  }
+  void sendMultiple(std::string, std::vector<o2::monitoring::Metric>&& metrics) override { send(std::move(metrics)); }
+  void addGlobalTag(std::string_view, std::string_view) override {}
+
+ private:
+  std::shared_ptr<std::set<std::string>> mSent;
+};
+} // namespace
+
 // A simple test where an input is provided
 // and the subsequent InputRecord is immediately requested.
 BOOST_AUTO_TEST_CASE(TestNoWait)
@@ -309,6 +336,11 @@ BOOST_AUTO_TEST_CASE(TestCache)
   createMessage(DataProcessingHeader{4, 1});
   ready = relayer.getReadyToProcess();
   BOOST_REQUIRE_EQUAL(ready.size(), 2);
+  // Timeslice 2 was dropped to make space for 4.
+  auto dropped = relayer.getDroppedTimeslices();
+  BOOST_REQUIRE_EQUAL(dropped.size(), 1);
+  BOOST_CHECK_EQUAL(dropped[0].value, 2);
+  BOOST_CHECK(relayer.getDroppedTimeslices().empty());
 
   auto result1 = relayer.getInputsForTimeslice(ready[0].slot);
   auto result2 = relayer.getInputsForTimeslice(ready[1].slot);
@@ -378,3 +410,216 @@ BOOST_AUTO_TEST_CASE(TestPolicies)
   BOOST_CHECK_EQUAL(ready3[0].slot.index, 1);
   BOOST_CHECK_EQUAL(ready3[0].op, CompletionPolicy::CompletionOp::Consume);
 }
+
+// This verifies that the pipeline grows when computations are dropped
+// because of lack of slots and shrinks back once they are not needed.
+BOOST_AUTO_TEST_CASE(TestAdaptivePipelineLength)
+{
+  Monitoring metrics;
+  InputSpec spec1{"clusters", "TPC", "CLUSTERS"};
+  InputSpec spec2{"tracks", "TPC", "TRACKS"};
+
+  std::vector<InputRoute> inputs = {
+    InputRoute{spec1, 0, "Fake1", 0},
+    InputRoute{spec2, 1, "Fake2", 0},
+  };
+
+  TimesliceIndex index;
+  auto policy = CompletionPolicyHelpers::consumeWhenAll();
+  DataRelayer relayer(policy, inputs, metrics, index);
+  relayer.setPipelineLength(2);
+  relayer.setAdaptivePipelineLength(8, 0);
+  BOOST_CHECK_EQUAL(relayer.getParallelTimeslices(), 2);
+  // Nothing happened, nothing to adapt.
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), false);
+
+  DataHeader dh;
+  dh.dataDescription = "CLUSTERS";
+  dh.dataOrigin = "TPC";
+  dh.subSpecification = 0;
+
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  auto createMessage = [&transport, &relayer, &dh](const DataProcessingHeader& h) {
+    Stack stack{dh, h};
+    FairMQMessagePtr header = transport->CreateMessage(stack.size());
+    FairMQMessagePtr payload = transport->CreateMessage(1000);
+    memcpy(header->GetData(), stack.data(), stack.size());
+    return relayer.relay(std::move(header), std::move(payload));
+  };
+
+  // Three incomplete timeslices for two slots: one computation is dropped.
+  createMessage(DataProcessingHeader{0, 1});
+  createMessage(DataProcessingHeader{1, 1});
+  createMessage(DataProcessingHeader{2, 1});
+  BOOST_CHECK_EQUAL(relayer.getStats().droppedComputations, 1);
+  BOOST_CHECK_EQUAL(relayer.getCachedBytes(), 2000);
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), true);
+  BOOST_CHECK_EQUAL(relayer.getParallelTimeslices(), 4);
+  BOOST_CHECK_EQUAL(relayer.getStats().pipelineResizes, 1);
+
+  // Growth is capped by the upper bound.
+  createMessage(DataProcessingHeader{3, 1});
+  createMessage(DataProcessingHeader{4, 1});
+  createMessage(DataProcessingHeader{5, 1});
+  createMessage(DataProcessingHeader{6, 1});
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), true);
+  BOOST_CHECK_EQUAL(relayer.getParallelTimeslices(), 8);
+  createMessage(DataProcessingHeader{7, 1});
+  createMessage(DataProcessingHeader{8, 1});
+  createMessage(DataProcessingHeader{9, 1});
+  createMessage(DataProcessingHeader{10, 1});
+  createMessage(DataProcessingHeader{11, 1});
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), false);
+  BOOST_CHECK_EQUAL(relayer.getParallelTimeslices(), 8);
+
+  // Once all the slots are consumed, a few quiet intervals shrink
+  // the pipeline back to the minimum.
+  for (size_t si = 0; si < relayer.getParallelTimeslices(); ++si) {
+    relayer.getInputsForTimeslice(TimesliceSlot{si});
+  }
+  BOOST_CHECK_EQUAL(relayer.getCachedBytes(), 0);
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), false);
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), false);
+  BOOST_CHECK_EQUAL(relayer.adaptPipelineLength(), true);
+  BOOST_CHECK_EQUAL(relayer.getParallelTimeslices(), 2);
+}
+
+// Concrete routes are looked up directly, while wildcard ones are still
+// matched via their DataDescriptorMatcher. Both need to end up in the
+// right position of the record.
+BOOST_AUTO_TEST_CASE(TestConcreteAndWildcardRoutes)
+{
+  Monitoring metrics;
+  auto specs = o2::framework::select("clusters:TPC/CLUSTERS");
+  InputSpec spec2{"tracks", "TPC", "TRACKS", 1};
+
+  std::vector<InputRoute> inputs = {
+    InputRoute{specs[0], 0, "Fake1", 0},
+    InputRoute{spec2, 1, "Fake2", 0},
+  };
+
+  TimesliceIndex index;
+  auto policy = CompletionPolicyHelpers::consumeWhenAll();
+  DataRelayer relayer(policy, inputs, metrics, index);
+  relayer.setPipelineLength(4);
+
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  auto createMessage = [&transport, &relayer](DataHeader const& dh, DataProcessingHeader const& h) {
+    Stack stack{dh, h};
+    FairMQMessagePtr header = transport->CreateMessage(stack.size());
+    FairMQMessagePtr payload = transport->CreateMessage(dh.payloadSize);
+    memcpy(header->GetData(), stack.data(), stack.size());
+    return relayer.relay(std::move(header), std::move(payload));
+  };
+
+  DataHeader dh1;
+  dh1.dataDescription = "CLUSTERS";
+  dh1.dataOrigin = "TPC";
+  dh1.subSpecification = 3;
+  dh1.payloadSize = 100;
+
+  DataHeader dh2;
+  dh2.dataDescription = "TRACKS";
+  dh2.dataOrigin = "TPC";
+  dh2.subSpecification = 1;
+  dh2.payloadSize = 200;
+
+  DataHeader dh3;
+  dh3.dataDescription = "TRACKS";
+  dh3.dataOrigin = "TPC";
+  dh3.subSpecification = 2;
+  dh3.payloadSize = 300;
+
+  // Wrong subSpec for the concrete route.
+  BOOST_CHECK_EQUAL(createMessage(dh3, DataProcessingHeader{0, 1}), DataRelayer::WillNotRelay);
+  BOOST_CHECK_EQUAL(createMessage(dh2, DataProcessingHeader{0, 1}), DataRelayer::WillRelay);
+  BOOST_CHECK_EQUAL(relayer.getReadyToProcess().size(), 0);
+  BOOST_CHECK_EQUAL(createMessage(dh1, DataProcessingHeader{0, 1}), DataRelayer::WillRelay);
+  // Same data, different timeslice, goes to a different slot.
+  BOOST_CHECK_EQUAL(createMessage(dh2, DataProcessingHeader{1, 1}), DataRelayer::WillRelay);
+  auto ready = relayer.getReadyToProcess();
+  BOOST_REQUIRE_EQUAL(ready.size(), 1);
+  auto result = relayer.getInputsForTimeslice(ready[0].slot);
+  BOOST_REQUIRE_EQUAL(result.size(), 4);
+  BOOST_CHECK_EQUAL(result[1]->GetSize(), 100);
+  BOOST_CHECK_EQUAL(result[3]->GetSize(), 200);
+}
+
+// Only the state of the slots which changed since the previous call of
+// sendContextState is sent.
+BOOST_AUTO_TEST_CASE(TestContextStateDelta)
+{
+  Monitoring metrics;
+  auto sent = std::make_shared<std::set<std::string>>();
+  metrics.addBackend(std::make_unique<RecordingBackend>(sent));
+  InputSpec spec{"clusters", "TPC", "CLUSTERS"};
+
+  std::vector<InputRoute> inputs = {
+    InputRoute{spec, 0, "Fake", 0}};
+
+  auto policy = CompletionPolicyHelpers::consumeWhenAll();
+  TimesliceIndex index;
+  DataRelayer relayer(policy, inputs, metrics, index);
+  relayer.setPipelineLength(4);
+
+  DataHeader dh;
+  dh.dataDescription = "CLUSTERS";
+  dh.dataOrigin = "TPC";
+  dh.subSpecification = 0;
+
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  auto createMessage = [&transport, &relayer, &dh](const DataProcessingHeader& h) {
+    Stack stack{dh, h};
+    FairMQMessagePtr header = transport->CreateMessage(stack.size());
+    FairMQMessagePtr payload = transport->CreateMessage(1000);
+    memcpy(header->GetData(), stack.data(), stack.size());
+    relayer.relay(std::move(header), std::move(payload));
+  };
+  // @return the names of the metrics sent by the next sendContextState
+  auto flush = [&relayer, &sent]() {
+    sent->clear();
+    relayer.sendContextState();
+    auto result = *sent;
+    sent->clear();
+    return result;
+  };
+  // Everything sent for @a slot must be either its relayer state or one of its variables
+  auto checkOnlySlot = [](std::set<std::string> const& names, size_t slot) {
+    BOOST_CHECK_EQUAL(names.count("data_relayer/" + std::to_string(slot)), 1);
+    for (auto& name : names) {
+      if (name.rfind("data_relayer/", 0) == 0) {
+        BOOST_CHECK_EQUAL(name, "data_relayer/" + std::to_string(slot));
+      } else {
+        BOOST_REQUIRE_EQUAL(name.rfind("matcher_variables/", 0), 0);
+        auto variable = std::stoul(name.substr(std::string("matcher_variables/").size()));
+        BOOST_CHECK_EQUAL(variable / 16, slot);
+      }
+    }
+  };
+
+  // Nothing changed since the metrics were reset by setPipelineLength
+  BOOST_CHECK(flush().empty());
+
+  // A new timeslice in slot 0 publishes its state and its variables, once
+  createMessage(DataProcessingHeader{0, 1});
+  auto names = flush();
+  checkOnlySlot(names, 0);
+  BOOST_CHECK_EQUAL(names.count("matcher_variables/0"), 1);
+  BOOST_CHECK(flush().empty());
+
+  // Consuming it only changes its state, the variables stay the same
+  auto ready = relayer.getReadyToProcess();
+  BOOST_REQUIRE_EQUAL(ready.size(), 1);
+  BOOST_REQUIRE_EQUAL(ready[0].slot.index, 0);
+  relayer.getInputsForTimeslice(ready[0].slot);
+  names = flush();
+  BOOST_CHECK(names == std::set<std::string>{"data_relayer/0"});
+  BOOST_CHECK(flush().empty());
+
+  // The next timeslice only changes the slot it goes to
+  createMessage(DataProcessingHeader{1, 1});
+  ready = relayer.getReadyToProcess();
+  BOOST_REQUIRE_EQUAL(ready.size(), 1);
+  checkOnlySlot(flush(), ready[0].slot.index);
+  BOOST_CHECK(flush().empty());
+}
@@ -126,3 +126,49 @@ BOOST_AUTO_TEST_CASE(DataSamplingConditionNConsecutive)
     BOOST_CHECK_EQUAL(conditionNConsecutive->decide(dr), t.second);
   }
 }
+
+BOOST_AUTO_TEST_CASE(DataSamplingConditionBatch)
+{
+  std::vector<std::unique_ptr<DataSamplingCondition>> conditions;
+  boost::property_tree::ptree config;
+  config.put("fraction", "0.5");
+  config.put("seed", "943753948");
+  config.put("upperLimit", 500);
+  config.put("lowerLimit", 30);
+  config.put("samplesNumber", 3);
+  config.put("cycleSize", 10);
+  for (auto name : {"random", "payloadSize", "nConsecutive"}) {
+    conditions.push_back(DataSamplingConditionFactory::create(name));
+    conditions.back()->configure(config);
+  }
+
+  // A few samples per timeslice, out of order and with a gap
+  std::vector<o2::header::Stack> stacks;
+  for (DataProcessingHeader::StartTime id : {1, 1, 2, 3, 3, 3, 7, 5, 20, 21, 22}) {
+    DataHeader dh;
+    dh.payloadSize = id * 37;
+    stacks.emplace_back(dh, DataProcessingHeader{id, 0});
+  }
+  DataSamplingBatch batch;
+  for (auto& stack : stacks) {
+    batch.add(DataRef{nullptr, reinterpret_cast<const char*>(stack.data()), nullptr});
+  }
+  BOOST_REQUIRE_EQUAL(batch.size(), stacks.size());
+
+  // The same conditions, evaluated one sample at a time
+  std::vector<std::unique_ptr<DataSamplingCondition>> references;
+  for (auto name : {"random", "payloadSize", "nConsecutive"}) {
+    references.push_back(DataSamplingConditionFactory::create(name));
+    references.back()->configure(config);
+  }
+
+  for (size_t c = 0; c < conditions.size(); ++c) {
+    std::vector<uint8_t> mask(batch.size(), 1);
+    mask[4] = 0;
+    conditions[c]->decideBatch(batch, mask);
+    for (size_t i = 0; i < batch.size(); ++i) {
+      bool expected = i != 4 && references[c]->decide(batch.refs[i]);
+      BOOST_CHECK_EQUAL(static_cast<bool>(mask[i]), expected);
+    }
+  }
+}
@@ -15,6 +15,7 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include "Framework/DataSamplingPolicy.h"
+#include "Framework/DataSamplingCondition.h"
 #include "Framework/DataRef.h"
 #include "Framework/DataProcessingHeader.h"
 
@@ -94,3 +95,57 @@ BOOST_AUTO_TEST_CASE(DataSamplingPolicyConfiguration)
   BOOST_CHECK((policy.prepareOutput(ConcreteDataMatcher{"TST", "MLEKO", 33})) == (Output{"DS", "too-long-polic-1", 33}));
   BOOST_CHECK_EQUAL(policy.getPathMap().size(), 2); // previous paths should be cleared
 }
+
+BOOST_AUTO_TEST_CASE(DataSamplingPolicyBatchMask)
+{
+  using boost::property_tree::ptree;
+  DataSamplingPolicy policy;
+
+  // Samples which pass the conditions have payload sizes in [30, 500] and start times 0, 1 or 2 modulo 10
+  ptree config;
+  config.put("id", "my_policy");
+  config.put("active", "true");
+  config.put("query", "c:TST/CHLEB/33");
+  ptree samplingConditions;
+  ptree conditionPayloadSize;
+  conditionPayloadSize.put("condition", "payloadSize");
+  conditionPayloadSize.put("lowerLimit", 30);
+  conditionPayloadSize.put("upperLimit", 500);
+  samplingConditions.push_back(std::make_pair("", conditionPayloadSize));
+  ptree conditionNConsecutive;
+  conditionNConsecutive.put("condition", "nConsecutive");
+  conditionNConsecutive.put("samplesNumber", 3);
+  conditionNConsecutive.put("cycleSize", 10);
+  samplingConditions.push_back(std::make_pair("", conditionNConsecutive));
+  config.add_child("samplingConditions", samplingConditions);
+  config.put("blocking", "false");
+  policy.configure(config);
+
+  std::vector<std::pair<DataProcessingHeader::StartTime, uint32_t>> samples{
+    {1, 100}, {2, 100}, {11, 200}, {12, 10}, {5, 100}, {20, 100}, {21, 600}, {22, 30}};
+  std::vector<o2::header::Stack> stacks;
+  for (const auto& [startTime, payloadSize] : samples) {
+    o2::header::DataHeader dh;
+    dh.payloadSize = payloadSize;
+    stacks.emplace_back(dh, DataProcessingHeader{startTime, 0});
+  }
+  DataSamplingBatch batch;
+  for (auto& stack : stacks) {
+    batch.add(DataRef{nullptr, reinterpret_cast<const char*>(stack.data()), nullptr});
+  }
+
+  // Any non-zero value marks a sample to be evaluated, not only 1, and keeps it accepted
+  std::vector<uint8_t> mask{2, 255, 4, 1, 6, 0, 8, 128};
+  policy.decide(batch, mask);
+  std::vector<bool> expected{true, true, true, false, false, false, false, true};
+  for (size_t i = 0; i < mask.size(); ++i) {
+    BOOST_CHECK_EQUAL(mask[i] != 0, expected[i]);
+  }
+  BOOST_CHECK_EQUAL(policy.getTotalEvaluatedMessages(), 7);
+  BOOST_CHECK_EQUAL(policy.getTotalAcceptedMessages(), 4);
+
+  mask.assign(samples.size(), 0);
+  policy.decide(batch, mask);
+  BOOST_CHECK_EQUAL(policy.getTotalEvaluatedMessages(), 7);
+  BOOST_CHECK_EQUAL(policy.getTotalAcceptedMessages(), 4);
+}
@@ -0,0 +1,74 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Framework Dispatcher
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "Framework/Dispatcher.h"
+#include "Framework/DataSamplingPolicy.h"
+#include <fairmq/FairMQTransportFactory.h>
+
+#include <cstring>
+#include <numeric>
+
+using namespace o2::framework;
+
+BOOST_AUTO_TEST_CASE(DispatcherSharedPayload)
+{
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  DataSamplingPolicy policy;
+
+  auto input = transport->CreateMessage(1000);
+  auto* data = static_cast<char*>(input->GetData());
+  std::iota(data, data + 1000, 0);
+
+  // The ZeroMQ transport refcounts its buffers, the sample refers to the input one.
+  auto sample = Dispatcher::samplePayload(*transport, input.get(), data, 1000, policy);
+  BOOST_REQUIRE_EQUAL(sample->GetSize(), 1000);
+  BOOST_CHECK_EQUAL(sample->GetData(), input->GetData());
+  BOOST_CHECK_EQUAL(policy.getTotalSharedBytes(), 1000);
+  BOOST_CHECK_EQUAL(policy.getTotalCopiedBytes(), 0);
+
+  // The input stays valid after the sample is gone, and the other way round.
+  sample.reset();
+  BOOST_CHECK_EQUAL(data[999], static_cast<char>(999));
+  sample = Dispatcher::samplePayload(*transport, input.get(), data, 1000, policy);
+  input.reset();
+  BOOST_CHECK_EQUAL(static_cast<char*>(sample->GetData())[999], static_cast<char>(999));
+  BOOST_CHECK_EQUAL(policy.getTotalSharedBytes(), 2000);
+  BOOST_CHECK_EQUAL(policy.getTotalCopiedBytes(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(DispatcherCopiedPayload)
+{
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  DataSamplingPolicy policy;
+  const char payload[] = "a payload which does not come from a message";
+
+  // Without the input message, the payload is copied.
+  auto sample = Dispatcher::samplePayload(*transport, nullptr, payload, sizeof(payload), policy);
+  BOOST_REQUIRE_EQUAL(sample->GetSize(), sizeof(payload));
+  BOOST_CHECK(sample->GetData() != payload);
+  BOOST_CHECK_EQUAL(std::memcmp(sample->GetData(), payload, sizeof(payload)), 0);
+  BOOST_CHECK_EQUAL(policy.getTotalSharedBytes(), 0);
+  BOOST_CHECK_EQUAL(policy.getTotalCopiedBytes(), sizeof(payload));
+
+  // A payload counts as shared only if the sample has the same buffer, whatever the transport does in Copy().
+  auto input = transport->CreateMessage(16);
+  std::memset(input->GetData(), 42, 16);
+  sample = Dispatcher::samplePayload(*transport, input.get(), static_cast<char*>(input->GetData()), 16, policy);
+  BOOST_REQUIRE_EQUAL(sample->GetSize(), 16);
+  BOOST_CHECK_EQUAL(static_cast<char*>(sample->GetData())[15], 42);
+  bool shared = sample->GetData() == input->GetData();
+  BOOST_CHECK_EQUAL(policy.getTotalSharedBytes(), shared ? 16 : 0);
+  BOOST_CHECK_EQUAL(policy.getTotalCopiedBytes(), sizeof(payload) + (shared ? 0 : 16));
+}
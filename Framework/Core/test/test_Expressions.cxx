@@ -13,8 +13,11 @@
 #define BOOST_TEST_DYN_LINK
 
 #include "../src/ExpressionHelpers.h"
+#include "Framework/TableBuilder.h"
 #include <boost/test/unit_test.hpp>
+#include <gandiva/selection_vector.h>
 
+using namespace o2::framework;
 using namespace o2::framework::expressions;
 
 namespace nodes
@@ -22,6 +25,7 @@ namespace nodes
 static BindingNode pt{"pt"};
 static BindingNode phi{"phi"};
 static BindingNode eta{"eta"};
+static BindingNode n{"n"};
 } // namespace nodes
 
 BOOST_AUTO_TEST_CASE(TestTreeParsing)
@@ -48,3 +52,52 @@ BOOST_AUTO_TEST_CASE(TestTreeParsing)
   BOOST_REQUIRE_EQUAL(specs[4].right, DatumSpec{LiteralNode::var_t{1}});
   BOOST_REQUIRE_EQUAL(specs[4].result, DatumSpec{3u});
 }
+
+BOOST_AUTO_TEST_CASE(TestGandivaFilter)
+{
+  TableBuilder builder;
+  auto rowWriter = builder.persist<float, float, int>({"phi", "eta", "n"});
+  for (int i = 0; i < 10; ++i) {
+    rowWriter(0, 0.5f * i, 0.25f * i, i);
+  }
+  auto table = builder.finalize();
+
+  Filter f = ((nodes::phi > 1) && (nodes::phi < 4)) && (nodes::eta < 1);
+  BOOST_REQUIRE(isSchemaCompatible(table->schema(), f));
+  auto gfilter = createFilter(table->schema(), f);
+  BOOST_REQUIRE(gfilter != nullptr);
+  // The same expression on the same schema gives back the cached filter.
+  BOOST_CHECK_EQUAL(gfilter, createFilter(table->schema(), f));
+
+  auto selection = createSelection(table, gfilter);
+  // Only row 3 has phi in (1, 4) and eta < 1.
+  BOOST_REQUIRE_EQUAL(selection->GetNumSlots(), 1);
+  BOOST_CHECK_EQUAL(selection->GetIndex(0), 3);
+
+  // Literals are converted to the type of the column they are compared with.
+  Filter g = nodes::n >= 7;
+  selection = createSelection(table, g);
+  BOOST_REQUIRE_EQUAL(selection->GetNumSlots(), 3);
+  BOOST_CHECK_EQUAL(selection->GetIndex(0), 7);
+  BOOST_CHECK_EQUAL(selection->GetIndex(2), 9);
+
+  // ... unless that would change their value, in which case the column is
+  // promoted to double instead of truncating the literal.
+  Filter k = nodes::n >= 6.5;
+  selection = createSelection(table, k);
+  BOOST_REQUIRE_EQUAL(selection->GetNumSlots(), 3);
+  BOOST_CHECK_EQUAL(selection->GetIndex(0), 7);
+  Filter z = nodes::n == 0.5;
+  selection = createSelection(table, z);
+  BOOST_CHECK_EQUAL(selection->GetNumSlots(), 0);
+  Filter e = nodes::n == 4.;
+  selection = createSelection(table, e);
+  BOOST_REQUIRE_EQUAL(selection->GetNumSlots(), 1);
+  BOOST_CHECK_EQUAL(selection->GetIndex(0), 4);
+
+  // A missing filter selects everything, while a filter on missing columns
+  // is not compatible.
+  BOOST_CHECK_EQUAL(createSelection(table, FilterPtr{nullptr})->GetNumSlots(), 10);
+  Filter h = nodes::pt > 1;
+  BOOST_CHECK(isSchemaCompatible(table->schema(), h) == false);
+}
@@ -0,0 +1,85 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Framework HeaderStackIndex
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include "Framework/HeaderStackIndex.h"
+#include "Framework/DataDescriptorMatcher.h"
+#include "Headers/Stack.h"
+#include <boost/test/unit_test.hpp>
+
+using namespace o2::framework;
+using namespace o2::header;
+using namespace o2::framework::data_matcher;
+
+BOOST_AUTO_TEST_CASE(TestHeaderStackIndex)
+{
+  DataHeader dh;
+  dh.dataOrigin = "TPC";
+  dh.dataDescription = "CLUSTERS";
+  dh.subSpecification = 1;
+  DataProcessingHeader dph{3, 1};
+  Stack stack{dh, dph};
+
+  auto index = HeaderStackIndex::parse(stack.data());
+  BOOST_CHECK_EQUAL(index.dataHeader, 0);
+  BOOST_CHECK_EQUAL(index.sourceInfoHeader, HeaderStackIndex::Missing);
+  BOOST_CHECK(index.get<SourceInfoHeader>(stack.data()) == nullptr);
+  // Same headers as a full walk of the stack
+  BOOST_CHECK_EQUAL(index.get<DataHeader>(stack.data()), get<DataHeader*>(stack.data()));
+  BOOST_CHECK_EQUAL(index.get<DataProcessingHeader>(stack.data()), get<DataProcessingHeader*>(stack.data()));
+  BOOST_CHECK_EQUAL(index.get<DataProcessingHeader>(stack.data())->startTime, 3);
+
+  // Not a header stack at all
+  char garbage[16] = {0};
+  auto empty = HeaderStackIndex::parse(garbage);
+  BOOST_CHECK(empty.get<DataHeader>(garbage) == nullptr);
+  BOOST_CHECK(empty.get<DataProcessingHeader>(garbage) == nullptr);
+
+  SourceInfoHeader sih;
+  Stack infoStack{sih};
+  auto infoIndex = HeaderStackIndex::parse(infoStack.data());
+  BOOST_CHECK(infoIndex.get<SourceInfoHeader>(infoStack.data()) != nullptr);
+  BOOST_CHECK(infoIndex.get<DataHeader>(infoStack.data()) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(TestMatchWithHeaderStackIndex)
+{
+  DataHeader dh;
+  dh.dataOrigin = "TPC";
+  dh.dataDescription = "CLUSTERS";
+  dh.subSpecification = 1;
+  DataProcessingHeader dph{3, 1};
+  Stack stack{dh, dph};
+  auto data = reinterpret_cast<char const*>(stack.data());
+  auto index = HeaderStackIndex::parse(stack.data());
+
+  DataDescriptorMatcher matcher{
+    DataDescriptorMatcher::Op::And,
+    OriginValueMatcher{"TPC"},
+    std::make_unique<DataDescriptorMatcher>(
+      DataDescriptorMatcher::Op::And,
+      DescriptionValueMatcher{"CLUSTERS"},
+      std::make_unique<DataDescriptorMatcher>(
+        DataDescriptorMatcher::Op::And,
+        SubSpecificationTypeValueMatcher{1},
+        StartTimeValueMatcher{ContextRef{0}}))};
+  DataDescriptorMatcher other{
+    DataDescriptorMatcher::Op::Just,
+    OriginValueMatcher{"ITS"}};
+
+  VariableContext context;
+  BOOST_CHECK(matcher.match(data, index, context) == true);
+  BOOST_CHECK(other.match(data, index, context) == false);
+  VariableContext walkContext;
+  BOOST_CHECK(matcher.match(data, walkContext) == true);
+}
@@ -41,3 +41,54 @@ BOOST_AUTO_TEST_CASE(HistogramRegistryLookup)
   auto histo2 = r.get("histo").get();
   BOOST_REQUIRE_EQUAL(histo2->GetNbinsX(), 100);
 }
+
+BOOST_AUTO_TEST_CASE(HistogramRegistryKinds)
+{
+  HistogramRegistry registry{"registry", true, {{"eta", "#Eta", {"TH1D", 100, -2.0, 2.0}}, {"etaphi", "#Eta #Phi", {"TH2F", {{100, -2.0, 2.0}, {102, 0, 2 * M_PI}}}}, {"xyz", "xyz", {"TH3I", {{10, 0, 1}, {20, 0, 1}, {30, 0, 1}}}}, {"thn", "thn", {"THnF", {{10, 0, 1}, {20, 0, 1}, {30, 0, 1}, {40, 0, 1}}}}, {"sparse", "sparse", {"THnSparseD", {{10, 0, 1}, {20, 0, 1}}}}}};
+
+  BOOST_CHECK(registry.get<TH1D>("eta") != nullptr);
+  BOOST_CHECK(registry.get<TH2F>("etaphi") != nullptr);
+  BOOST_CHECK(registry.get<TH1D>("etaphi") == nullptr);
+  BOOST_REQUIRE_EQUAL(registry.get("etaphi")->GetNbinsY(), 102);
+  BOOST_REQUIRE_EQUAL(registry.get<TH3I>("xyz")->GetNbinsZ(), 30);
+  BOOST_REQUIRE_EQUAL(registry.get<THnF>("thn")->GetNdimensions(), 4);
+  BOOST_REQUIRE_EQUAL(registry.get<THnSparseD>("sparse")->GetAxis(1)->GetNbins(), 20);
+  BOOST_CHECK_THROW(registry.get("thn"), std::runtime_error);
+
+  BOOST_CHECK_THROW((HistogramRegistry{"r", true, {{"h", "h", {"TH2F", 10, 0, 1}}}}), std::runtime_error);
+  BOOST_CHECK_THROW((HistogramRegistry{"r", true, {{"h", "h", {"TH4F", 10, 0, 1}}}}), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(HistogramRegistryFill)
+{
+  HistogramRegistry registry{"registry", true, {{"eta", "#Eta", {"TH1F", 100, -2.0, 2.0}}, {"etaphi", "#Eta #Phi", {"TH2F", {{100, -2.0, 2.0}, {102, 0, 2 * M_PI}}}}, {"sparse", "sparse", {"THnSparseD", {{10, 0, 1}, {20, 0, 1}, {30, 0, 1}}}}}};
+
+  // More than a buffer worth of entries, so that some are flushed on fill
+  for (int i = 0; i < 3000; ++i) {
+    registry.fill("eta", 0.5);
+    registry.fill("etaphi", 0.5, 1., 2.);
+    registry.fill("sparse", 0.5, 0.5, 0.5);
+  }
+  BOOST_CHECK_THROW(registry.fill("etaphi", 0.5, 1., 1., 1.), std::runtime_error);
+
+  // The entries still in the buffers are filled when the histograms are accessed
+  BOOST_CHECK_EQUAL(registry.get("eta")->GetEntries(), 3000);
+  BOOST_CHECK_EQUAL(registry.get("etaphi")->GetSumOfWeights(), 6000);
+  BOOST_CHECK_EQUAL(registry.get<THnSparseD>("sparse")->GetEntries(), 3000);
+  registry.fill("eta", 0.5);
+  BOOST_CHECK_EQUAL(registry.get<TH1F>("eta")->GetEntries(), 3001);
+  registry.flush();
+
+  BOOST_CHECK_EQUAL(registry.get("eta")->GetEntries(), 3001);
+  BOOST_CHECK_EQUAL(registry.get("etaphi")->GetSumOfWeights(), 6000);
+  BOOST_CHECK_EQUAL(registry.get<THnSparseD>("sparse")->GetEntries(), 3000);
+
+  /// Sub registries start empty and can be merged back
+  auto sub = registry.createSubRegistry();
+  BOOST_CHECK_EQUAL(sub.get("eta")->GetEntries(), 0);
+  sub.fill("eta", 0.5);
+  sub.fill("sparse", 0.5, 0.5, 0.5);
+  registry.merge(sub);
+  BOOST_CHECK_EQUAL(registry.get("eta")->GetEntries(), 3002);
+  BOOST_CHECK_EQUAL(registry.get<THnSparseD>("sparse")->GetEntries(), 3001);
+}
@@ -118,6 +118,13 @@ BOOST_AUTO_TEST_CASE(TestInputRecord)
   BOOST_CHECK_EQUAL(record.isValid(0), true);
   BOOST_CHECK_EQUAL(record.isValid(1), true);
   BOOST_CHECK_EQUAL(record.isValid(2), false);
+
+  // The span is not backed by messages
+  BOOST_CHECK(record.getPayloadMessage(0) == nullptr);
+  BOOST_CHECK(record.getPayloadMessage(2) == nullptr);
+  BOOST_CHECK_EXCEPTION(record.getPayloadMessage(3), std::exception, any_exception);
+  BOOST_CHECK_EXCEPTION(record.getPayloadMessage(-1), std::exception, any_exception);
+  BOOST_CHECK_EXCEPTION(record.getPayloadMessage(10), std::exception, any_exception);
   // This by default is a shortcut for
   //
   // *static_cast<int const *>(record.get("x").payload);
@@ -15,6 +15,7 @@
 #include "Framework/AnalysisDataModel.h"
 #include "Framework/Kernels.h"
 #include "Framework/TableBuilder.h"
+#include "Framework/ThreadPool.h"
 #include <arrow/compute/context.h>
 #include <arrow/compute/kernels/hash.h>
 #include <boost/test/unit_test.hpp>
@@ -95,3 +96,103 @@ BOOST_AUTO_TEST_CASE(TestWithSOATables)
   BOOST_CHECK_EQUAL(util::get<std::shared_ptr<Table>>(splitted[0].value)->num_rows(), 1);
   BOOST_CHECK_EQUAL(util::get<std::shared_ptr<Table>>(splitted[1].value)->num_rows(), 2);
 }
+
+BOOST_AUTO_TEST_CASE(TestParallelSortedGroupBy)
+{
+  TableBuilder builder;
+  auto rowWriter = builder.persist<int32_t, int32_t>({"x", "y"});
+  // Groups of increasing size, with unassigned (-1) rows at the beginning.
+  rowWriter(0, -1, 0);
+  rowWriter(0, -1, 1);
+  int32_t row = 2;
+  for (int32_t group = 0; group < 20; ++group) {
+    for (int32_t i = 0; i <= group; ++i) {
+      rowWriter(0, group, row++);
+    }
+  }
+  auto table = builder.finalize();
+
+  arrow::compute::FunctionContext ctx;
+  for (size_t nThreads : {1, 2, 3, 7, 1000}) {
+    arrow::compute::Datum outRanges;
+    SortedGroupByKernel groupBy{{"x", nThreads}};
+    BOOST_REQUIRE_EQUAL(groupBy.Call(&ctx, arrow::compute::Datum(table), &outRanges).ok(), true);
+    auto result = arrow::util::get<std::shared_ptr<arrow::Table>>(outRanges.value);
+    BOOST_REQUIRE_EQUAL(result->num_rows(), 20);
+    auto starts = std::static_pointer_cast<UInt64Array>(result->column(0)->data()->chunk(0));
+    auto counts = std::static_pointer_cast<UInt64Array>(result->column(1)->data()->chunk(0));
+    uint64_t expectedStart = 2;
+    for (int64_t group = 0; group < 20; ++group) {
+      BOOST_CHECK_EQUAL(starts->Value(group), expectedStart);
+      BOOST_CHECK_EQUAL(counts->Value(group), group + 1);
+      expectedStart += group + 1;
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestHashGroupBy)
+{
+  TableBuilder builder;
+  auto rowWriter = builder.persist<int32_t, float>({"x", "y"});
+  rowWriter(0, 2, 0.f);
+  rowWriter(0, 0, 1.f);
+  rowWriter(0, -1, 2.f);
+  rowWriter(0, 2, 3.f);
+  rowWriter(0, 1, 4.f);
+  rowWriter(0, 0, 5.f);
+  auto table = builder.finalize();
+
+  arrow::compute::FunctionContext ctx;
+  arrow::compute::Datum outRows;
+  HashGroupByKernel groupBy{{"x"}};
+  BOOST_REQUIRE_EQUAL(groupBy.Call(&ctx, arrow::compute::Datum(table), &outRows).ok(), true);
+  auto result = arrow::util::get<std::shared_ptr<arrow::Table>>(outRows.value);
+  auto rows = std::static_pointer_cast<UInt64Array>(result->column(0)->data()->chunk(0));
+  std::vector<uint64_t> expected{1, 5, 4, 0, 3};
+  BOOST_REQUIRE_EQUAL(rows->length(), expected.size());
+  for (size_t ri = 0; ri < expected.size(); ++ri) {
+    BOOST_CHECK_EQUAL(rows->Value(ri), expected[ri]);
+  }
+
+  // Unsorted tables are sliced by value as well.
+  std::vector<Datum> splitted;
+  BOOST_REQUIRE_EQUAL(sliceByColumn(&ctx, "x", arrow::compute::Datum(table), &splitted).ok(), true);
+  BOOST_REQUIRE_EQUAL(splitted.size(), 3);
+  std::vector<int64_t> sizes{2, 1, 2};
+  std::vector<float> firstY{1.f, 4.f, 0.f};
+  for (size_t si = 0; si < splitted.size(); ++si) {
+    auto slice = util::get<std::shared_ptr<Table>>(splitted[si].value);
+    BOOST_CHECK_EQUAL(slice->num_rows(), sizes[si]);
+    auto ys = slice->column(1)->data();
+    BOOST_CHECK_EQUAL(std::static_pointer_cast<FloatArray>(ys->chunk(0))->Value(0), firstY[si]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TestSliceByColumnKeys)
+{
+  // Nothing refers to 1 and 4, and some rows are unassigned.
+  TableBuilder builder;
+  auto rowWriter = builder.persist<int32_t, float>({"x", "y"});
+  std::vector<int32_t> xs{0, 0, -1, 2, 2, 2, 3, 5, 5, -1};
+  for (size_t ri = 0; ri < xs.size(); ++ri) {
+    rowWriter(0, xs[ri], (float)ri);
+  }
+  auto table = builder.finalize();
+
+  arrow::compute::FunctionContext ctx;
+  ThreadPool pool(2);
+  for (size_t nThreads : {1, 3}) {
+    std::vector<Datum> splitted;
+    std::vector<uint64_t> keys;
+    GroupByOptions options{"x", nThreads, &pool};
+    BOOST_REQUIRE_EQUAL(sliceByColumn(&ctx, options, arrow::compute::Datum(table), &splitted, &keys).ok(), true);
+    std::vector<uint64_t> expectedKeys{0, 2, 3, 5};
+    std::vector<int64_t> sizes{2, 3, 1, 2};
+    BOOST_REQUIRE_EQUAL(splitted.size(), expectedKeys.size());
+    BOOST_REQUIRE_EQUAL(keys.size(), expectedKeys.size());
+    for (size_t si = 0; si < keys.size(); ++si) {
+      BOOST_CHECK_EQUAL(keys[si], expectedKeys[si]);
+      BOOST_CHECK_EQUAL(util::get<std::shared_ptr<Table>>(splitted[si].value)->num_rows(), sizes[si]);
+    }
+  }
+}
@@ -0,0 +1,84 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/InputSpec.h"
+#include "Framework/CallbackService.h"
+#include "Framework/ControlService.h"
+#include "Framework/DataProcessorSpec.h"
+#include "Framework/EndOfStreamContext.h"
+#include "Framework/DeviceSpec.h"
+#include "Framework/RawDeviceService.h"
+#include "Framework/runDataProcessing.h"
+
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#define ASSERT_ERROR(condition)                                   \
+  if ((condition) == false) {                                     \
+    LOG(ERROR) << R"(Test condition ")" #condition R"(" failed)"; \
+  }
+
+using namespace o2::framework;
+
+// Replica 0 takes much longer than the interval between two timeslices,
+// replica 1 is immediate, so with the LeastLoaded dispatch most of the
+// timeslices need to end up in replica 1. With the round robin one they
+// would be evenly split.
+constexpr int nTimeslices = 40;
+constexpr int nReplicas = 2;
+
+std::vector<DataProcessorSpec> defineDataProcessing(ConfigContext const&)
+{
+  return WorkflowSpec{
+    {"producer",
+     Inputs{},
+     Outputs{{"TST", "SLICE"}},
+     AlgorithmSpec{[counter = std::make_shared<int>(0)](ProcessingContext& ctx) {
+       if (*counter < nTimeslices) {
+         std::this_thread::sleep_for(std::chrono::milliseconds(20));
+         ctx.outputs().make<int>(Output{"TST", "SLICE", 0}) = (*counter)++;
+       }
+       if (*counter == nTimeslices) {
+         ctx.services().get<ControlService>().endOfStream();
+         ctx.services().get<ControlService>().readyToQuit(QuitRequest::Me);
+       }
+     }}},
+    timePipeline(
+      DataProcessorSpec{
+        "worker",
+        Inputs{{"slice", "TST", "SLICE"}},
+        Outputs{{"TST", "DONE"}},
+        AlgorithmSpec{[](ProcessingContext& ctx) {
+          auto replica = (int)ctx.services().get<RawDeviceService>().spec().inputTimesliceId;
+          if (replica == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+          }
+          ctx.outputs().make<int>(Output{"TST", "DONE", 0}) = replica;
+        }}},
+      nReplicas, TimePipelineDispatch::LeastLoaded),
+    {"collector",
+     Inputs{{"done", "TST", "DONE"}},
+     Outputs{},
+     AlgorithmSpec{adaptStateful([](CallbackService& callbacks) {
+       auto counts = std::make_shared<std::vector<int>>(nReplicas, 0);
+       callbacks.set(CallbackService::Id::EndOfStream, [counts](EndOfStreamContext& ctx) {
+         LOG(INFO) << "Timeslices processed by each replica: " << (*counts)[0] << " " << (*counts)[1];
+         ASSERT_ERROR((*counts)[0] + (*counts)[1] == nTimeslices);
+         ASSERT_ERROR((*counts)[1] > 2 * (*counts)[0]);
+         ctx.services().get<ControlService>().readyToQuit(QuitRequest::All);
+       });
+       return adaptStateless([counts](InputRecord& inputs) {
+         auto replica = inputs.get<int>("done");
+         ASSERT_ERROR(replica >= 0 && replica < nReplicas);
+         (*counts)[replica]++;
+       });
+     })}}};
+}
@@ -0,0 +1,124 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Framework MessagePool
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "Framework/MessagePool.h"
+#include <fairmq/FairMQTransportFactory.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace o2::framework;
+
+namespace
+{
+/// Region callbacks might come from a different thread.
+bool waitForRecycled(MessagePool& pool, size_t expected)
+{
+  for (int i = 0; i < 1000 && pool.stats().recycled < expected; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return pool.stats().recycled >= expected;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TestRecycling)
+{
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  MessagePool pool(transport.get(), 1024 * 1024, 1024);
+
+  // Small messages bypass the pool.
+  auto small = pool.create(100);
+  BOOST_CHECK_EQUAL(small->GetSize(), 100);
+  BOOST_CHECK_EQUAL(pool.stats().reservedBytes, 0);
+
+  auto first = pool.create(100000);
+  BOOST_REQUIRE_EQUAL(first->GetSize(), 100000);
+  void* data = first->GetData();
+  auto stats = pool.stats();
+  BOOST_CHECK_EQUAL(stats.hits, 0);
+  BOOST_CHECK_EQUAL(stats.misses, 0);
+  BOOST_CHECK_EQUAL(stats.reservedBytes, 102400);
+
+  first.reset();
+  BOOST_REQUIRE(waitForRecycled(pool, 1));
+
+  // Same size, same buffer.
+  auto second = pool.create(100000);
+  BOOST_CHECK_EQUAL(second->GetData(), data);
+  BOOST_CHECK_EQUAL(pool.stats().hits, 1);
+  BOOST_CHECK_EQUAL(pool.stats().reservedBytes, 102400);
+
+  // The only released buffer is in use again, so a new one is carved.
+  auto other = pool.create(10000);
+  BOOST_CHECK(other->GetData() != data);
+
+  // Once the region is full, we fall back to the transport.
+  auto big = pool.create(2 * 1024 * 1024);
+  BOOST_CHECK_EQUAL(big->GetSize(), 2 * 1024 * 1024);
+  BOOST_CHECK_EQUAL(pool.stats().misses, 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestMergeReleased)
+{
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  MessagePool pool(transport.get(), 4 * 102400, 1024);
+
+  auto a = pool.create(100000);
+  auto b = pool.create(100000);
+  auto c = pool.create(100000);
+  auto* data = static_cast<char*>(a->GetData());
+  BOOST_CHECK_EQUAL(static_cast<char*>(b->GetData()), data + 102400);
+
+  // Two neighbouring buffers come back as a single free range.
+  a.reset();
+  b.reset();
+  BOOST_REQUIRE(waitForRecycled(pool, 2));
+  auto merged = pool.create(200000);
+  BOOST_CHECK_EQUAL(static_cast<char*>(merged->GetData()), data);
+  BOOST_CHECK_EQUAL(pool.stats().hits, 1);
+  BOOST_CHECK_EQUAL(pool.stats().misses, 0);
+
+  // A smaller message takes the front of a free range and leaves the rest.
+  merged.reset();
+  BOOST_REQUIRE(waitForRecycled(pool, 3));
+  auto front = pool.create(50000);
+  auto back = pool.create(150000);
+  BOOST_CHECK_EQUAL(static_cast<char*>(front->GetData()), data);
+  BOOST_CHECK_EQUAL(static_cast<char*>(back->GetData()), data + 53248);
+  BOOST_CHECK_EQUAL(pool.stats().hits, 3);
+  BOOST_CHECK_EQUAL(pool.stats().reservedBytes, 3 * 102400);
+}
+
+BOOST_AUTO_TEST_CASE(TestMemoryResource)
+{
+  auto transport = FairMQTransportFactory::CreateTransportFactory("zeromq");
+  MessagePools pools(1024 * 1024, 1024);
+  auto& pool = pools.get("output", transport.get());
+  BOOST_CHECK_EQUAL(&pools.get("output", transport.get()), &pool);
+
+  o2::pmr::vector<int> values(o2::pmr::polymorphic_allocator<int>(&pool));
+  values.resize(10000, 1);
+  auto message = o2::pmr::getMessage(std::move(values));
+  BOOST_REQUIRE(message.get() != nullptr);
+  BOOST_CHECK_EQUAL(message->GetSize(), 10000 * sizeof(int));
+  BOOST_CHECK_EQUAL(pool.getNumberOfMessages(), 0);
+  message.reset();
+  BOOST_REQUIRE(waitForRecycled(pool, 1));
+
+  auto stats = pools.stats();
+  BOOST_REQUIRE_EQUAL(stats.size(), 1);
+  BOOST_CHECK_EQUAL(stats[0].first, "output");
+  BOOST_CHECK(stats[0].second.recycled >= 1);
+}
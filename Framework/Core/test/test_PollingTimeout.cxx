@@ -0,0 +1,106 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+#include "Framework/CompletionPolicy.h"
+#include "Framework/CompletionPolicyHelpers.h"
+#include "Framework/DeviceSpec.h"
+
+#include <chrono>
+#include <memory>
+
+void customize(std::vector<o2::framework::CompletionPolicy>& policies)
+{
+  // The data and the timer of the consumer never belong to the same
+  // timeslice, so it must process each of them on its own.
+  policies.push_back({"consumer-any",
+                      [](o2::framework::DeviceSpec const& spec) { return spec.name == "consumer"; },
+                      o2::framework::CompletionPolicyHelpers::consumeWhenAny().callback});
+}
+
+#include "Framework/runDataProcessing.h"
+#include "Framework/ControlService.h"
+#include "Framework/Logger.h"
+
+using namespace o2::framework;
+
+#define ASSERT_ERROR(condition)                                   \
+  if ((condition) == false) {                                     \
+    LOG(ERROR) << R"(Test condition ")" #condition R"(" failed)"; \
+  }
+
+// This workflow is run with --polling-timeout 5000, so that the consumer
+// sleeps on its input channel. Each message must wake it up right away,
+// rather than at its next timer, and its timer must keep firing once the
+// producer stops sending, rather than after the polling timeout.
+constexpr int nMessages = 10;
+constexpr int producerPeriodUs = 100000;
+constexpr int consumerTimerPeriodUs = 1000000;
+constexpr int64_t maxLatencyUs = 300000;
+constexpr int64_t maxTimerIntervalUs = 2500000;
+constexpr int nQuietTimers = 3;
+
+int64_t nowUs()
+{
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::vector<DataProcessorSpec> defineDataProcessing(ConfigContext const&)
+{
+  return {
+    DataProcessorSpec{
+      "producer",
+      Inputs{InputSpec{"tick", "TST", "TICK", 0, Lifetime::Timer}},
+      Outputs{OutputSpec{"TST", "DATA", 0}},
+      AlgorithmSpec{adaptStateful([]() {
+        return adaptStateless([sent = std::make_shared<int>(0)](DataAllocator& outputs) {
+          if (*sent < nMessages) {
+            outputs.snapshot(Output{"TST", "DATA", 0}, nowUs());
+            ++*sent;
+          }
+        });
+      })},
+      {ConfigParamSpec{"period-tick", VariantType::Int, producerPeriodUs, {"period of the messages"}}}},
+    DataProcessorSpec{
+      "consumer",
+      Inputs{InputSpec{"data", "TST", "DATA", 0, Lifetime::Timeframe},
+             InputSpec{"timer", "TST", "TIMER", 0, Lifetime::Timer}},
+      {},
+      AlgorithmSpec{adaptStateful([]() {
+        struct State {
+          int64_t start = nowUs();
+          int received = 0;
+          int64_t lastTimer = 0;
+          int quietTimers = 0;
+        };
+        return adaptStateless([state = std::make_shared<State>()](InputRecord& inputs, ControlService& control) {
+          auto current = nowUs();
+          if (inputs.isValid("data")) {
+            auto sent = inputs.get<int64_t>("data");
+            // Messages queued while we were starting up arrive late anyway
+            if (sent > state->start) {
+              LOG(INFO) << "Message received after " << current - sent << " us";
+              ASSERT_ERROR(current - sent < maxLatencyUs);
+            }
+            state->received++;
+            state->quietTimers = 0;
+          }
+          if (inputs.isValid("timer")) {
+            if (state->lastTimer != 0) {
+              LOG(INFO) << "Timer fired after " << current - state->lastTimer << " us";
+              ASSERT_ERROR(current - state->lastTimer < maxTimerIntervalUs);
+            }
+            state->lastTimer = current;
+            if (state->received == nMessages && ++state->quietTimers == nQuietTimers) {
+              control.readyToQuit(QuitRequest::All);
+            }
+          }
+        });
+      })},
+      {ConfigParamSpec{"period-timer", VariantType::Int, consumerTimerPeriodUs, {"period of the timer"}}}}};
+}
@@ -16,10 +16,12 @@
 
 #include "Framework/TableBuilder.h"
 #include "Framework/RootTableBuilderHelpers.h"
+#include "Framework/ThreadPool.h"
 #include "../src/ArrowDebugHelpers.h"
 
 #include <ROOT/RDataFrame.hxx>
 #include <ROOT/RArrowDS.hxx>
+#include <TFile.h>
 #include <TTree.h>
 #include <TRandom.h>
 #include <arrow/table.h>
@@ -102,3 +104,81 @@ BOOST_AUTO_TEST_CASE(RootTree2Table)
     }
   }
 }
+
+BOOST_AUTO_TEST_CASE(RootTree2TableBulk)
+{
+  using namespace o2::framework;
+  // Bulk I/O needs the baskets to be written out, hence the file. The
+  // parallel conversion opens it once per worker, so it is not in memory.
+  {
+    TFile output("test_Root2ArrowTableBulk.root", "RECREATE");
+    TTree t1("t1", "a simple Tree with simple variables");
+    Float_t xyz[3];
+    Int_t ij[2];
+    Float_t px;
+    Double_t random;
+    Int_t ev;
+    UChar_t flags;
+    Bool_t even;
+    Int_t n;
+    Float_t values[10];
+    t1.Branch("px", &px, "px/F");
+    t1.Branch("random", &random, "random/D");
+    t1.Branch("ev", &ev, "ev/I");
+    t1.Branch("flags", &flags, "flags/b");
+    t1.Branch("xyz", xyz, "xyz[3]/F");
+    t1.Branch("ij", ij, "ij[2]/I");
+    t1.Branch("even", &even, "even/O");
+    t1.Branch("n", &n, "n/I");
+    t1.Branch("values", values, "values[n]/F");
+    for (Int_t i = 0; i < 10000; i++) {
+      gRandom->Rannor(xyz[0], xyz[1]);
+      px = gRandom->Gaus();
+      xyz[2] = i + 1;
+      ij[0] = i;
+      ij[1] = i + 1;
+      random = gRandom->Rndm();
+      ev = i + 1;
+      flags = i % 256;
+      even = i % 2 == 0;
+      n = i % 10;
+      t1.Fill();
+    }
+    output.Write();
+  }
+  TFile input("test_Root2ArrowTableBulk.root");
+  auto t1 = dynamic_cast<TTree*>(input.Get("t1"));
+  BOOST_REQUIRE(t1 != nullptr);
+
+  TableBuilder builder;
+  TTreeReader reader(t1);
+  TTreeReaderValue<float> pxReader(reader, "px");
+  TTreeReaderValue<double> randomReader(reader, "random");
+  TTreeReaderValue<int> evReader(reader, "ev");
+  TTreeReaderValue<unsigned char> flagsReader(reader, "flags");
+  TTreeReaderArray<float> xyzReader(reader, "xyz");
+  TTreeReaderArray<int> ijReader(reader, "ij");
+  TTreeReaderValue<bool> evenReader(reader, "even");
+  RootTableBuilderHelpers::convertTTree(builder, reader, pxReader, randomReader, evReader, flagsReader, xyzReader, ijReader, evenReader);
+  auto expected = builder.finalize();
+
+  std::vector<std::string> branches{"px", "random", "ev", "flags", "xyz", "ij", "even"};
+  ThreadPool serial(0);
+  ThreadPool parallel(3);
+  for (auto pool : {static_cast<ThreadPool*>(nullptr), &serial, &parallel}) {
+    auto table = RootTableBuilderHelpers::convertTTreeBulk(*t1, branches, pool);
+    BOOST_REQUIRE_EQUAL(table->num_rows(), 10000);
+    BOOST_REQUIRE_EQUAL(table->num_columns(), 7);
+    BOOST_CHECK_EQUAL(table->column(3)->type()->id(), arrow::uint8()->id());
+    BOOST_CHECK_EQUAL(table->column(4)->type()->id(), arrow::list(arrow::float32())->id());
+    BOOST_CHECK_EQUAL(table->column(6)->type()->id(), arrow::boolean()->id());
+    for (int ci = 0; ci < table->num_columns(); ++ci) {
+      BOOST_CHECK_EQUAL(table->schema()->field(ci)->name(), branches[ci]);
+      BOOST_CHECK(table->column(ci)->data()->Equals(*expected->column(ci)->data()));
+    }
+  }
+
+  BOOST_CHECK_THROW(RootTableBuilderHelpers::convertTTreeBulk(*t1, {"px", "missing"}, &parallel), std::runtime_error);
+  BOOST_CHECK_THROW(RootTableBuilderHelpers::convertTTreeBulk(*t1, {"values"}), std::runtime_error);
+  BOOST_CHECK_THROW(RootTableBuilderHelpers::convertTTreeBulk(*t1, {"px", "values"}, &parallel), std::runtime_error);
+}
@@ -242,6 +242,40 @@ BOOST_AUTO_TEST_CASE(TestSoAIntegration)
   }
 }
 
+BOOST_AUTO_TEST_CASE(TestSoABulkIntegration)
+{
+  TableBuilder builder;
+  auto rowWriter = builder.cursor<TestTable>();
+  auto bulkWriter = builder.bulkCursor<TestTable>();
+  builder.reserve(6);
+  rowWriter(0, 0, 0);
+  uint64_t x[] = {10, 20, 30, 40};
+  uint64_t y[] = {1, 2, 3, 4};
+  bulkWriter(0, 4, x, y);
+  rowWriter(0, 50, 5);
+
+  struct XY {
+    uint64_t y;
+    uint64_t x;
+  };
+  XY rows[] = {{6, 60}, {7, 70}};
+  uint64_t xs[2];
+  uint64_t ys[2];
+  TableBuilderHelpers::transpose(rows, 2, &XY::x, xs);
+  TableBuilderHelpers::transpose(rows, 2, &XY::y, ys);
+  bulkWriter(0, 2, xs, ys);
+
+  auto table = builder.finalize();
+  BOOST_REQUIRE_EQUAL(table->num_rows(), 8);
+  auto readBack = TestTable{table};
+  size_t i = 0;
+  for (auto& row : readBack) {
+    BOOST_CHECK_EQUAL(row.x(), i * 10);
+    BOOST_CHECK_EQUAL(row.y(), i);
+    ++i;
+  }
+}
+
 BOOST_AUTO_TEST_CASE(TestDataAllocatorReturnType)
 {
   TimingInfo* timingInfo = nullptr;
@@ -0,0 +1,86 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#define BOOST_TEST_MODULE Test Framework ThreadPool
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "Framework/ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace o2::framework;
+
+BOOST_AUTO_TEST_CASE(TestInlineExecution)
+{
+  ThreadPool pool(0);
+  BOOST_CHECK_EQUAL(pool.size(), 0);
+  int value = 0;
+  pool.push([&value](size_t workerId) { value = 1 + workerId; });
+  BOOST_CHECK_EQUAL(value, 1);
+  BOOST_CHECK_EQUAL(pool.pending(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelExecution)
+{
+  ThreadPool pool(4);
+  BOOST_CHECK_EQUAL(pool.size(), 4);
+  std::atomic<int> sum = 0;
+  std::vector<std::atomic<int>> perWorker(4);
+  for (int i = 0; i < 1000; ++i) {
+    pool.push([&sum, &perWorker, i](size_t workerId) {
+      sum += i;
+      perWorker.at(workerId)++;
+    });
+  }
+  pool.wait();
+  BOOST_CHECK_EQUAL(pool.pending(), 0);
+  BOOST_CHECK_EQUAL(sum, 999 * 1000 / 2);
+  int total = 0;
+  for (auto& count : perWorker) {
+    total += count;
+  }
+  BOOST_CHECK_EQUAL(total, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(TestExceptionsDoNotKillWorkers)
+{
+  ThreadPool pool(1);
+  std::atomic<int> executed = 0;
+  pool.push([](size_t) { throw std::runtime_error("failure"); });
+  pool.push([&executed](size_t) { executed++; });
+  pool.wait();
+  BOOST_CHECK_EQUAL(executed, 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestWaitForIdleWorker)
+{
+  ThreadPool pool(1);
+  std::atomic<bool> release = false;
+  pool.push([&release](size_t) {
+    while (release == false) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  // The only worker is busy, so we give up after the timeout.
+  pool.waitForIdleWorker(10);
+  BOOST_CHECK_EQUAL(pool.pending(), 1);
+  // We wake up as soon as the worker is done, well before the timeout.
+  release = true;
+  auto start = std::chrono::steady_clock::now();
+  pool.waitForIdleWorker(100000);
+  BOOST_CHECK_EQUAL(pool.pending(), 0);
+  BOOST_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+}
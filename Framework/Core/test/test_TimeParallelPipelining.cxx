@@ -17,8 +17,11 @@
 #include "../src/ComputingResourceHelpers.h"
 #include "Framework/DeviceControl.h"
 #include "Framework/DeviceSpec.h"
+#include "Framework/TimePipelineDispatch.h"
 #include "Framework/WorkflowSpec.h"
 
+#include <deque>
+
 using namespace o2::framework;
 
 // This is how you can define your processing in a declarative way
@@ -125,3 +128,200 @@ BOOST_AUTO_TEST_CASE(TimePipeliningFull)
   BOOST_CHECK_EQUAL(layer1Consumer2.id, "C_t2");
   BOOST_CHECK_EQUAL(layer2Consumer0.id, "D");
 }
+
+WorkflowSpec defineLoadAwarePipelining()
+{
+  return WorkflowSpec{{
+                        "A",
+                        Inputs{},
+                        {
+                          OutputSpec{"TST", "A1"},
+                          OutputSpec{"TST", "A2"},
+                        },
+                      },
+                      timePipeline(
+                        {
+                          "B",
+                          Inputs{InputSpec{"a1", "TST", "A1"}, InputSpec{"a2", "TST", "A2"}},
+                          Outputs{
+                            OutputSpec{"TST", "B"},
+                          },
+                        },
+                        2, TimePipelineDispatch::LeastLoaded),
+                      {
+                        "C",
+                        {InputSpec{"b", "TST", "B"}},
+                      }};
+}
+
+BOOST_AUTO_TEST_CASE(TimePipeliningLeastLoaded)
+{
+  auto workflow = defineLoadAwarePipelining();
+  std::vector<DeviceSpec> devices;
+  auto channelPolicies = ChannelConfigurationPolicy::createDefaultPolicies();
+  auto completionPolicies = CompletionPolicy::createDefaultPolicies();
+  std::vector<ComputingResource> resources = {ComputingResourceHelpers::getLocalhostResource()};
+  SimpleResourceManager rm(resources);
+  DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(workflow, channelPolicies, completionPolicies, devices, rm, "workflow-id");
+  BOOST_REQUIRE_EQUAL(devices.size(), 4);
+  auto& producer = devices[0];
+  auto& replica0 = devices[1];
+  auto& replica1 = devices[2];
+  auto& consumer = devices[3];
+  BOOST_CHECK_EQUAL(replica0.id, "B_t0");
+  BOOST_CHECK_EQUAL(replica1.id, "B_t1");
+
+  // One credit channel per replica, bound by the producer.
+  BOOST_REQUIRE_EQUAL(producer.creditInputChannels.size(), 2);
+  BOOST_REQUIRE_EQUAL(replica0.creditOutputChannels.size(), 1);
+  BOOST_REQUIRE_EQUAL(replica1.creditOutputChannels.size(), 1);
+  BOOST_CHECK_EQUAL(producer.creditInputChannels[0].name, "credits_from_B_t0_to_A");
+  BOOST_CHECK_EQUAL(producer.creditInputChannels[1].name, "credits_from_B_t1_to_A");
+  BOOST_CHECK_EQUAL(replica0.creditOutputChannels[0].name, producer.creditInputChannels[0].name);
+  BOOST_CHECK_EQUAL(replica0.creditOutputChannels[0].port, producer.creditInputChannels[0].port);
+  BOOST_CHECK_EQUAL(replica1.creditOutputChannels[0].port, producer.creditInputChannels[1].port);
+  BOOST_CHECK_NE(producer.creditInputChannels[0].port, producer.creditInputChannels[1].port);
+  BOOST_CHECK(consumer.creditInputChannels.empty());
+  BOOST_CHECK(consumer.creditOutputChannels.empty());
+
+  BOOST_REQUIRE_EQUAL(producer.outputs.size(), 4);
+  for (auto& route : producer.outputs) {
+    BOOST_CHECK(route.dispatch == TimePipelineDispatch::LeastLoaded);
+    BOOST_CHECK_EQUAL(route.consumer, "B");
+    BOOST_CHECK_EQUAL(route.creditChannel, "credits_from_B_t" + std::to_string(route.timeslice) + "_to_A");
+  }
+  for (auto& route : replica0.outputs) {
+    BOOST_CHECK(route.dispatch == TimePipelineDispatch::RoundRobin);
+    BOOST_CHECK(route.creditChannel.empty());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(TimePipeliningLeastLoadedSingleProducer)
+{
+  // The inputs of a given timeslice could end up in different replicas,
+  // if more than one device feeds them.
+  auto workflow = WorkflowSpec{{"A", Inputs{}, {OutputSpec{"TST", "A"}}},
+                               {"X", Inputs{}, {OutputSpec{"TST", "X"}}},
+                               timePipeline({"B", Inputs{InputSpec{"a", "TST", "A"}, InputSpec{"x", "TST", "X"}}}, 2, TimePipelineDispatch::LeastLoaded)};
+  std::vector<DeviceSpec> devices;
+  auto channelPolicies = ChannelConfigurationPolicy::createDefaultPolicies();
+  auto completionPolicies = CompletionPolicy::createDefaultPolicies();
+  std::vector<ComputingResource> resources = {ComputingResourceHelpers::getLocalhostResource()};
+  SimpleResourceManager rm(resources);
+  BOOST_CHECK_THROW(DeviceSpecHelpers::dataProcessorSpecs2DeviceSpecs(workflow, channelPolicies, completionPolicies, devices, rm, "workflow-id"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(TimePipelineDispatcherChoice)
+{
+  TimePipelineDispatcher dispatcher;
+  // With an even load we get the round robin choice.
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 3, 0), 0);
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 3, 1), 1);
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 3, 2), 2);
+  // Further outputs of the same timeslice go to the same replica.
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 3, 1), 1);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 1), 1);
+  // Replica 1 is done, so it gets the next one rather than replica 0.
+  dispatcher.credit("B", 1);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 1), 0);
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 3, 3), 1);
+  // Credits for unknown timeslices or consumers are ignored.
+  dispatcher.credit("B", 1);
+  dispatcher.credit("C", 0);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 1), 1);
+  // Each consumer is accounted for separately.
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("C", 2, 4), 0);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 0), 1);
+}
+
+BOOST_AUTO_TEST_CASE(TimePipelineDispatcherExpiry)
+{
+  // Credits for timeslices 0 and 2 never come back.
+  TimePipelineDispatcher dispatcher{4};
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 0), 0);
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 1), 1);
+  dispatcher.credit("B", 1);
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 2), 1);
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 3), 1);
+  dispatcher.credit("B", 3);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 0), 1);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 1), 1);
+  // Timeslice 0 is forgotten once 4 newer ones were sent.
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 4), 0);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 0), 1);
+  dispatcher.credit("B", 4);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 0), 0);
+  // The late credit does not make the count go negative.
+  dispatcher.credit("B", 0);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 0), 0);
+  // Replica 1 is still waiting for timeslice 2, so 5 goes to replica 0.
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 5), 0);
+  dispatcher.credit("B", 5);
+  // ... until that is forgotten as well.
+  BOOST_CHECK_EQUAL(dispatcher.replicaFor("B", 2, 6), 0);
+  BOOST_CHECK_EQUAL(dispatcher.outstanding("B", 1), 0);
+}
+
+namespace
+{
+/// Simulates a producer creating a new timeslice every other tick for two
+/// replicas, where even timeslices take 5 ticks to be processed and odd
+/// ones only one.
+/// @return the tick by which all the timeslices were processed.
+size_t simulateVariableProcessingTime(TimePipelineDispatch dispatch, size_t timeslices)
+{
+  constexpr size_t replicas = 2;
+  auto cost = [](size_t timeslice) -> size_t { return timeslice % 2 == 0 ? 5 : 1; };
+  struct Replica {
+    std::deque<size_t> queue;
+    size_t busyUntil = 0;
+  };
+  std::vector<Replica> pipeline(replicas);
+  TimePipelineDispatcher dispatcher;
+  size_t produced = 0;
+  size_t completed = 0;
+  size_t tick = 0;
+  for (; completed < timeslices; ++tick) {
+    for (auto& replica : pipeline) {
+      if (replica.queue.empty() || replica.busyUntil > tick) {
+        continue;
+      }
+      dispatcher.credit("B", replica.queue.front());
+      replica.queue.pop_front();
+      completed++;
+      if (replica.queue.empty() == false) {
+        replica.busyUntil = tick + cost(replica.queue.front());
+      }
+    }
+    if (tick % 2 == 0 && produced < timeslices) {
+      size_t ri = produced % replicas;
+      if (dispatch == TimePipelineDispatch::LeastLoaded) {
+        ri = dispatcher.replicaFor("B", replicas, produced);
+      }
+      auto& replica = pipeline[ri];
+      if (replica.queue.empty()) {
+        replica.busyUntil = tick + cost(produced);
+      }
+      replica.queue.push_back(produced++);
+    }
+  }
+  for (size_t ri = 0; ri < replicas; ++ri) {
+    BOOST_CHECK_EQUAL(dispatcher.outstanding("B", ri), 0);
+  }
+  return tick;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(TimePipeliningVariableProcessingTime)
+{
+  constexpr size_t timeslices = 100;
+  auto roundRobin = simulateVariableProcessingTime(TimePipelineDispatch::RoundRobin, timeslices);
+  auto leastLoaded = simulateVariableProcessingTime(TimePipelineDispatch::LeastLoaded, timeslices);
+  // Round robin sends all the expensive timeslices to the same replica,
+  // which cannot keep up.
+  BOOST_CHECK_GE(roundRobin, timeslices / 2 * 5);
+  // Balancing them, each replica has enough time to catch up before the
+  // next timeslice arrives, so we finish shortly after the last one.
+  BOOST_CHECK_LE(leastLoaded, 2 * timeslices + 5);
+  BOOST_CHECK_LT(leastLoaded, roundRobin);
+}
@@ -189,6 +189,8 @@ struct GPUTrackingInOutPointers {
   const GPUTPCGMMergedTrackHit* mergedTrackHits = nullptr;
   unsigned int nMergedTrackHits = 0;
   const o2::tpc::CompressedClusters* tpcCompressedClusters = nullptr;
+  const char* tpcCompressedClustersEncoded = nullptr;
+  size_t tpcCompressedClustersEncodedSize = 0;
   const GPUTRDTrackletWord* trdTracklets = nullptr;
   unsigned int nTRDTracklets = 0;
   const GPUTRDTrackletLabels* trdTrackletsMC = nullptr;
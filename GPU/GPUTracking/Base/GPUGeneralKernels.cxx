@@ -17,12 +17,20 @@ using namespace GPUCA_NAMESPACE::gpu;
 template <>
 GPUd() void GPUMemClean16::Thread<0>(int nBlocks, int nThreads, int iBlock, int iThread, GPUsharedref() MEM_LOCAL(GPUTPCSharedMemory) & smem, processorType& processors, GPUglobalref() void* ptr, unsigned long size)
 {
-  const unsigned long stride = get_global_size(0);
   int4 i0;
   i0.x = i0.y = i0.z = i0.w = 0;
   int4* ptra = (int4*)ptr;
   unsigned long len = (size + sizeof(int4) - 1) / sizeof(int4);
+#ifdef GPUCA_GPUCODE
+  const unsigned long stride = get_global_size(0);
   for (unsigned long i = get_global_id(0); i < len; i += stride) {
     ptra[i] = i0;
   }
+#else
+  // On the CPU, blocks may run on different threads: each cleans a contiguous range, so that they do not share cache lines
+  const unsigned long blockLen = (len + nBlocks - 1) / nBlocks;
+  for (unsigned long i = iBlock * blockLen; i < len && i < (iBlock + 1) * blockLen; i++) {
+    ptra[i] = i0;
+  }
+#endif
 }
@@ -59,6 +59,8 @@ class GPUKernelTemplate
 
   typedef GPUconstantref() MEM_CONSTANT(GPUConstantMem) processorType;
   GPUhdi() CONSTEXPR static GPUDataTypes::RecoStep GetRecoStep() { return GPUCA_RECO_STEP::NoRecoStep; }
+  // Kernels whose blocks must not run concurrently on the CPU, e.g. since they parallelize internally, override this to return true
+  GPUhdi() CONSTEXPR static bool CPUSerialBlocks() { return false; }
   MEM_TEMPLATE()
   GPUhdi() static processorType* Processor(MEM_TYPE(GPUConstantMem) & processors)
   {
@@ -93,7 +93,7 @@ class GPUTPCClusterStatistics
 {
  public:
   void Finish() {}
-  void RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const GPUFakeEmpty* clustersCompressed, const GPUParam& param) {}
+  void RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const GPUFakeEmpty* clustersCompressed, const GPUParam& param, const char* clustersEncoded = nullptr, size_t clustersEncodedSize = 0) {}
 };
 #endif
 } // namespace gpu
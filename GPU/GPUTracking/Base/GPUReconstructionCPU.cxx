@@ -35,6 +35,9 @@
 #define GPUCA_LOGGING_PRINTF
 #include "GPULogging.h"
 
+#include <algorithm>
+#include <exception>
+
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -70,11 +73,45 @@ int GPUReconstructionCPUBackend::runKernelBackend(krnlSetup& _xyz, const Args&..
     throw std::runtime_error("Cannot run device kernel on host with nThreads != 1");
   }
   unsigned int num = y.num == 0 || y.num == -1 ? 1 : y.num;
+  int nThreads = 1;
+#ifdef GPUCA_HAVE_OPENMP
+  // Blocks are independent, as on the GPU, so we can distribute them over the OpenMP threads.
+  // Not if we are already running in parallel, e.g. one slice per thread.
+  if (mDeviceProcessingSettings.ompKernels && !T::CPUSerialBlocks() && !omp_in_parallel()) {
+    nThreads = std::min<unsigned int>(mDeviceProcessingSettings.nThreads, x.nBlocks);
+  }
+#endif
   for (unsigned int k = 0; k < num; k++) {
-    for (unsigned int iB = 0; iB < x.nBlocks; iB++) {
-      typename T::GPUTPCSharedMemory smem;
-      T::template Thread<I>(x.nBlocks, 1, iB, 0, smem, T::Processor(*mHostConstantMem)[y.start + k], args...);
+    if (nThreads <= 1) {
+      for (unsigned int iB = 0; iB < x.nBlocks; iB++) {
+        typename T::GPUTPCSharedMemory smem;
+        T::template Thread<I>(x.nBlocks, 1, iB, 0, smem, T::Processor(*mHostConstantMem)[y.start + k], args...);
+      }
+      continue;
+    }
+#ifdef GPUCA_HAVE_OPENMP
+    // Blocks may differ a lot in cost (e.g. rows), so they are handed out dynamically, in chunks to keep the overhead low for many small blocks.
+    const int chunk = std::max<int>(1, x.nBlocks / (16 * nThreads));
+    std::exception_ptr error;
+#pragma omp parallel num_threads(nThreads)
+    {
+      typename T::GPUTPCSharedMemory smem; // Shared memory scratch of this worker
+#pragma omp for schedule(dynamic, chunk)
+      for (unsigned int iB = 0; iB < x.nBlocks; iB++) {
+        try {
+          T::template Thread<I>(x.nBlocks, 1, iB, 0, smem, T::Processor(*mHostConstantMem)[y.start + k], args...);
+        } catch (...) {
+#pragma omp critical
+          if (!error) {
+            error = std::current_exception();
+          }
+        }
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
     }
+#endif
   }
   return 0;
 }
@@ -152,7 +189,13 @@ int GPUReconstructionCPU::ExitDevice()
   return 0;
 }
 
-void GPUReconstructionCPU::SetThreadCounts() { mThreadCount = mBlockCount = mConstructorBlockCount = mSelectorBlockCount = mConstructorThreadCount = mSelectorThreadCount = mFinderThreadCount = mTRDThreadCount = mClustererThreadCount = mScanThreadCount = 1; }
+void GPUReconstructionCPU::SetThreadCounts()
+{
+  mThreadCount = mConstructorBlockCount = mSelectorBlockCount = mConstructorThreadCount = mSelectorThreadCount = mFinderThreadCount = mTRDThreadCount = mClustererThreadCount = mScanThreadCount = 1;
+  // runKernelBackend runs at most one block per OpenMP thread at a time, so the default grid needs one block per thread for the kernels to run in parallel.
+  // The tracklet constructor and selector run in the per-slice parallel loop, where the blocks are processed serially anyway.
+  mBlockCount = mDeviceProcessingSettings.ompKernels ? std::max(1, mDeviceProcessingSettings.nThreads) : 1;
+}
 
 void GPUReconstructionCPU::SetThreadCounts(RecoStep step)
 {
@@ -65,6 +65,7 @@ void GPUSettingsProcessing::SetDefaults()
 void GPUSettingsDeviceProcessing::SetDefaults()
 {
   nThreads = 1;
+  ompKernels = false;
   deviceNum = -1;
   platformNum = -1;
   globalInitMutex = false;
@@ -78,6 +79,7 @@ void GPUSettingsDeviceProcessing::SetDefaults()
   eventDisplay = nullptr;
   runQA = false;
   runCompressionStatistics = false;
+  tpcEntropyCoding = false;
   stuckProtection = 0;
   memoryAllocationStrategy = 0;
   keepAllMemory = false;
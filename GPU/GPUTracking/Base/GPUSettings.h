@@ -120,6 +120,7 @@ struct GPUSettingsDeviceProcessing {
 #endif
 
   int nThreads;                       // Numnber of threads on CPU, 0 = auto-detect
+  bool ompKernels;                    // Distribute the blocks of the kernels over nThreads OpenMP threads when running on the CPU (off by default, the output order is then not reproducible)
   int deviceNum;                      // Device number to use, in case the backend provides multiple devices (-1 = auto-select)
   int platformNum;                    // Platform to use, in case the backend provides multiple platforms (-1 = auto-select)
   bool globalInitMutex;               // Global mutex to synchronize initialization over multiple instances
@@ -132,6 +133,7 @@ struct GPUSettingsDeviceProcessing {
   GPUDisplayBackend* eventDisplay;    // Run event display after processing, ptr to backend
   bool runQA;                         // Run QA after processing
   bool runCompressionStatistics;      // Run statistics and verification for cluster compression
+  bool tpcEntropyCoding;              // Entropy code the compressed TPC clusters on the host after the compression
   int stuckProtection;                // Timeout in us, When AMD GPU is stuck, just continue processing and skip tracking, do not crash or stall the chain
   int memoryAllocationStrategy;       // 0 = auto, 1 = new/delete per resource (default for CPU), 2 = big chunk single allocation (default for device)
   bool keepAllMemory;                 // Allocate all memory on both device and host, and do not reuse
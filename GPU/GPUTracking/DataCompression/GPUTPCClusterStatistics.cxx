@@ -102,13 +102,22 @@ void GenerateCodes(const INode* node, const HuffCode& prefix, HuffCodeMap& outCo
 }
 } // namespace
 
-void GPUTPCClusterStatistics::RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const o2::tpc::CompressedClusters* clustersCompressed, const GPUParam& param)
+void GPUTPCClusterStatistics::RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const o2::tpc::CompressedClusters* clustersCompressed, const GPUParam& param, const char* clustersEncoded, size_t clustersEncodedSize)
 {
   bool decodingError = false;
   o2::tpc::ClusterNativeAccess clustersNativeDecoded;
   std::vector<o2::tpc::ClusterNative> clusterBuffer;
-  GPUInfo("Compression statistics, decoding: %d attached (%d tracks), %d unattached", clustersCompressed->nAttachedClusters, clustersCompressed->nTracks, clustersCompressed->nUnattachedClusters);
-  mDecoder.decompress(clustersCompressed, clustersNativeDecoded, clusterBuffer, param);
+  GPUInfo("Compression statistics, decoding: %d attached (%d tracks), %d unattached%s", clustersCompressed->nAttachedClusters, clustersCompressed->nTracks, clustersCompressed->nUnattachedClusters, clustersEncoded ? ", from entropy coded data" : "");
+  if (clustersEncoded) { // Verify the full chain including the entropy decoding
+    if (mDecoder.decompress(clustersEncoded, clustersEncodedSize, clustersNativeDecoded, clusterBuffer, param)) {
+      GPUError("Error decoding entropy coded clusters");
+      mDecodingError = true;
+      return;
+    }
+    mEncodedSize += clustersEncodedSize;
+  } else {
+    mDecoder.decompress(clustersCompressed, clustersNativeDecoded, clusterBuffer, param);
+  }
   std::vector<o2::tpc::ClusterNative> tmpClusters;
   if (param.rec.tpcRejectionMode == GPUSettings::RejectionNone) { // verification does not make sense if we reject clusters during compression
     for (unsigned int i = 0; i < NSLICES; i++) {
@@ -221,7 +230,12 @@ void GPUTPCClusterStatistics::Finish()
   GPUInfo("Combined Sigma: %6.4f --> %6.4f (%6.4f%%)", eSigma, eSigmaCombined, 100. * (eSigma - eSigmaCombined) / eSigma);
   GPUInfo("Combined Q: %6.4f --> %6.4f (%6.4f%%)", eQ, eQCombined, 100. * (eQ - eQCombined) / eQ);
 
-  printf("\nConbined Entropy: %7.4f   (Size %'13.0f, %'lld cluster)\nCombined Huffman: %7.4f   (Size %'13.0f, %f%%)\n\n", mEntropy / mNTotalClusters, mEntropy, (long long int)mNTotalClusters, mHuffman / mNTotalClusters, mHuffman, 100. * (mHuffman - mEntropy) / mHuffman);
+  printf("\nConbined Entropy: %7.4f   (Size %'13.0f, %'lld cluster)\nCombined Huffman: %7.4f   (Size %'13.0f, %f%%)\n", mEntropy / mNTotalClusters, mEntropy, (long long int)mNTotalClusters, mHuffman / mNTotalClusters, mHuffman, 100. * (mHuffman - mEntropy) / mHuffman);
+  if (mEncodedSize) {
+    double encoded = 8. * mEncodedSize;
+    printf("Entropy Coded:    %7.4f   (Size %'13.0f, %f%%)\n", encoded / mNTotalClusters, encoded, 100. * (encoded - mEntropy) / encoded);
+  }
+  printf("\n");
 }
 
 float GPUTPCClusterStatistics::Analyze(std::vector<int>& p, const char* name, bool count)
@@ -34,11 +34,11 @@ class GPUTPCClusterStatistics
 {
  public:
 #ifndef HAVE_O2HEADERS
-  void RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const o2::tpc::CompressedClusters* clustersCompressed, const GPUParam& param){};
+  void RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const o2::tpc::CompressedClusters* clustersCompressed, const GPUParam& param, const char* clustersEncoded = nullptr, size_t clustersEncodedSize = 0){};
   void Finish(){};
 #else
   static constexpr unsigned int NSLICES = GPUCA_NSLICES;
-  void RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const o2::tpc::CompressedClusters* clustersCompressed, const GPUParam& param);
+  void RunStatistics(const o2::tpc::ClusterNativeAccess* clustersNative, const o2::tpc::CompressedClusters* clustersCompressed, const GPUParam& param, const char* clustersEncoded = nullptr, size_t clustersEncodedSize = 0);
   void Finish();
 
  protected:
@@ -91,6 +91,7 @@ class GPUTPCClusterStatistics
   double mEntropy = 0;
   double mHuffman = 0;
   size_t mNTotalClusters = 0;
+  size_t mEncodedSize = 0;
 #endif
 };
 } // namespace gpu
@@ -15,6 +15,7 @@
 #include "GPUO2DataTypes.h"
 #include "GPUParam.h"
 #include "GPUTPCCompressionTrackModel.h"
+#include "TPCClusterEntropyCoder.h"
 #include <algorithm>
 #include <cstring>
 
@@ -116,3 +117,14 @@ int TPCClusterDecompressor::decompress(const CompressedClusters* clustersCompres
 
   return 0;
 }
+
+int TPCClusterDecompressor::decompress(const char* clustersEncoded, size_t size, o2::tpc::ClusterNativeAccess& clustersNative, std::vector<o2::tpc::ClusterNative>& clusterBuffer, const GPUParam& param, int nThreads)
+{
+  CompressedClusters clustersCompressed;
+  std::vector<char> buffer;
+  TPCClusterEntropyCoder coder;
+  if (coder.decode(clustersEncoded, size, clustersCompressed, buffer, nThreads)) {
+    return 1;
+  }
+  return decompress(&clustersCompressed, clustersNative, clusterBuffer, param);
+}
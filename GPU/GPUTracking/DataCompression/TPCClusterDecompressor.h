@@ -38,6 +38,8 @@ class TPCClusterDecompressor
  public:
   static constexpr unsigned int NSLICES = GPUCA_NSLICES;
   int decompress(const CompressedClusters* clustersCompressed, o2::tpc::ClusterNativeAccess& clustersNative, std::vector<o2::tpc::ClusterNative>& clusterBuffer, const GPUParam& param);
+  // Decompress clusters entropy coded with TPCClusterEntropyCoder
+  int decompress(const char* clustersEncoded, size_t size, o2::tpc::ClusterNativeAccess& clustersNative, std::vector<o2::tpc::ClusterNative>& clusterBuffer, const GPUParam& param, int nThreads = 1);
 
  protected:
 };
@@ -0,0 +1,574 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file TPCClusterEntropyCoder.cxx
+
+#include "TPCClusterEntropyCoder.h"
+#include "GPULogging.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+using namespace GPUCA_NAMESPACE::gpu;
+
+// Encoded format: header with the counters, the block partition of each field kind, per stream the frequency table and the sizes of its blocks, then the payloads of all blocks.
+// Each block payload is the rANS byte stream followed by the raw values of the escaped symbols.
+namespace
+{
+constexpr unsigned int SCALE_BITS = TPCClusterEntropyCoder::SCALE_BITS;
+constexpr unsigned int SCALE = 1u << SCALE_BITS;
+constexpr unsigned int SYMBOL_MASK = (1u << TPCClusterEntropyCoder::SYMBOL_BITS) - 1;
+constexpr unsigned int RANS_L = 1u << 23; // Lower bound of the rANS state, renormalized byte-wise
+
+struct Field {
+  void* ptr;
+  unsigned int width; // Bytes per element
+  unsigned int kind;
+  unsigned int n;
+  unsigned int firstStream;
+  unsigned int nStreams;
+};
+
+struct Stream {
+  unsigned int field;
+  unsigned int shift;
+  unsigned int alphabet;                  // Symbol alphabet is the escape symbol, used for symbols too rare to have their own frequency
+  std::vector<unsigned int> freq;         // alphabet + 1 entries
+  std::vector<unsigned int> start;        // alphabet + 1 entries
+  std::vector<unsigned int> slotToSymbol; // SCALE entries, only for decoding
+};
+
+struct EncodedBlock {
+  std::vector<unsigned char> data;
+  std::vector<unsigned short> escapes;
+};
+
+struct DecodedBlock {
+  const unsigned char* data = nullptr;
+  unsigned int nBytes = 0;
+  const unsigned char* escapes = nullptr;
+  unsigned int nEscapes = 0;
+};
+
+inline unsigned int getSymbol(const Field& f, const Stream& s, size_t i)
+{
+  switch (f.width) {
+    case 1:
+      return static_cast<const unsigned char*>(f.ptr)[i];
+    case 2:
+      return static_cast<const unsigned short*>(f.ptr)[i];
+    default:
+      return (static_cast<const unsigned int*>(f.ptr)[i] >> s.shift) & SYMBOL_MASK;
+  }
+}
+
+// The streams of a field are decoded in order, so the higher parts of 32 bit values are or-ed to the lower ones
+inline void setSymbol(const Field& f, const Stream& s, size_t i, unsigned int v)
+{
+  switch (f.width) {
+    case 1:
+      static_cast<unsigned char*>(f.ptr)[i] = v;
+      break;
+    case 2:
+      static_cast<unsigned short*>(f.ptr)[i] = v;
+      break;
+    default:
+      if (s.shift) {
+        static_cast<unsigned int*>(f.ptr)[i] |= v << s.shift;
+      } else {
+        static_cast<unsigned int*>(f.ptr)[i] = v;
+      }
+  }
+}
+
+void putVarInt(std::vector<char>& out, unsigned long long v)
+{
+  while (v >= 0x80) {
+    out.push_back((char)((v & 0x7F) | 0x80));
+    v >>= 7;
+  }
+  out.push_back((char)v);
+}
+
+class Reader
+{
+ public:
+  Reader(const char* ptr, const char* end) : mPtr((const unsigned char*)ptr), mEnd((const unsigned char*)end) {}
+  unsigned long long getVarInt()
+  {
+    unsigned long long v = 0;
+    for (unsigned int shift = 0; shift < 64; shift += 7) {
+      if (mPtr == mEnd) {
+        mError = true;
+        return 0;
+      }
+      unsigned char c = *(mPtr++);
+      v |= (unsigned long long)(c & 0x7F) << shift;
+      if (!(c & 0x80)) {
+        return v;
+      }
+    }
+    mError = true;
+    return 0;
+  }
+  unsigned int getUInt(unsigned long long max = 0xFFFFFFFFu)
+  {
+    unsigned long long v = getVarInt();
+    if (v > max) {
+      mError = true;
+      return 0;
+    }
+    return v;
+  }
+  const unsigned char* ptr() const { return mPtr; }
+  const unsigned char* end() const { return mEnd; }
+  bool error() const { return mError; }
+
+ private:
+  const unsigned char* mPtr;
+  const unsigned char* mEnd;
+  bool mError = false;
+};
+
+// Scales the symbol counts to frequencies summing up to SCALE. Symbols too rare for a frequency of at least 1 share the escape symbol.
+void buildEncodingTable(const std::vector<unsigned int>& counts, size_t total, Stream& s)
+{
+  s.alphabet = counts.size();
+  s.freq.assign(s.alphabet + 1, 0);
+  s.start.assign(s.alphabet + 1, 0);
+  if (total == 0) {
+    return;
+  }
+  std::vector<std::pair<unsigned long long, unsigned int>> remainders;
+  unsigned long long nEscaped = 0, sum = 0;
+  for (unsigned int i = 0; i < s.alphabet; i++) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    unsigned long long scaled = (unsigned long long)counts[i] * SCALE;
+    if (scaled < total) {
+      nEscaped += counts[i];
+      continue;
+    }
+    s.freq[i] = scaled / total;
+    sum += s.freq[i];
+    remainders.emplace_back(scaled % total, i);
+  }
+  if (nEscaped) {
+    unsigned long long scaled = nEscaped * SCALE;
+    s.freq[s.alphabet] = std::max<unsigned long long>(1, scaled / total);
+    sum += s.freq[s.alphabet];
+    remainders.emplace_back(scaled % total, s.alphabet);
+  }
+  // Hand out what was lost by rounding down to the symbols with the largest remainders
+  std::sort(remainders.begin(), remainders.end(), [](const auto& a, const auto& b) { return a.first > b.first || (a.first == b.first && a.second < b.second); });
+  for (unsigned int i = 0; sum < SCALE; i = (i + 1) % remainders.size()) {
+    s.freq[remainders[i].second]++;
+    sum++;
+  }
+  while (sum > SCALE) {
+    (*std::max_element(s.freq.begin(), s.freq.end()))--;
+    sum--;
+  }
+  for (unsigned int i = 1; i <= s.alphabet; i++) {
+    s.start[i] = s.start[i - 1] + s.freq[i - 1];
+  }
+}
+
+void encodeBlock(const Field& f, const Stream& s, size_t begin, unsigned int n, EncodedBlock& out)
+{
+  // At most 2 bytes are emitted per symbol with 16 bit frequencies, plus the final state
+  out.data.resize(2 * (size_t)n + 4);
+  unsigned char* const end = out.data.data() + out.data.size();
+  unsigned char* ptr = end;
+  unsigned int x = RANS_L;
+  for (size_t i = begin + n; i-- > begin;) {
+    unsigned int sym = getSymbol(f, s, i);
+    if (s.freq[sym] == 0) {
+      out.escapes.push_back(sym);
+      sym = s.alphabet;
+    }
+    const unsigned int freq = s.freq[sym];
+    const unsigned int xMax = ((RANS_L >> SCALE_BITS) << 8) * freq;
+    while (x >= xMax) {
+      *(--ptr) = x & 0xFF;
+      x >>= 8;
+    }
+    x = ((x / freq) << SCALE_BITS) + (x % freq) + s.start[sym];
+  }
+  ptr -= 4;
+  for (int i = 0; i < 4; i++) {
+    ptr[i] = (x >> (8 * i)) & 0xFF;
+  }
+  size_t nBytes = end - ptr;
+  memmove(out.data.data(), ptr, nBytes);
+  out.data.resize(nBytes);
+  std::reverse(out.escapes.begin(), out.escapes.end()); // Symbols were encoded backwards
+}
+
+int decodeBlock(const Field& f, const Stream& s, size_t begin, unsigned int n, const DecodedBlock& in)
+{
+  if (in.nBytes < 4) {
+    return 1;
+  }
+  const unsigned char* ptr = in.data;
+  const unsigned char* const end = in.data + in.nBytes;
+  unsigned int x = ptr[0] | (ptr[1] << 8) | (ptr[2] << 16) | ((unsigned int)ptr[3] << 24);
+  ptr += 4;
+  unsigned int iEscape = 0;
+  for (size_t i = begin; i < begin + n; i++) {
+    const unsigned int slot = x & (SCALE - 1);
+    unsigned int sym = s.slotToSymbol[slot];
+    x = s.freq[sym] * (x >> SCALE_BITS) + slot - s.start[sym];
+    while (x < RANS_L && ptr < end) {
+      x = (x << 8) | *(ptr++);
+    }
+    if (sym == s.alphabet) {
+      if (iEscape >= in.nEscapes) {
+        return 1;
+      }
+      sym = in.escapes[2 * iEscape] | (in.escapes[2 * iEscape + 1] << 8);
+      iEscape++;
+    }
+    setSymbol(f, s, i, sym);
+  }
+  // The decoder must end up where the encoder started, otherwise the data is corrupt
+  return x != RANS_L || ptr != end || iEscape != in.nEscapes;
+}
+} // namespace
+
+template <class C, class F>
+void TPCClusterEntropyCoder::forEachField(C& c, F&& f)
+{
+  f(c.qTotA, KindAttached);
+  f(c.qMaxA, KindAttached);
+  f(c.flagsA, KindAttached);
+  f(c.rowDiffA, KindAttachedReduced);
+  f(c.sliceLegDiffA, KindAttachedReduced);
+  f(c.padResA, KindAttachedReduced);
+  f(c.timeResA, KindAttachedReduced);
+  f(c.sigmaPadA, KindAttached);
+  f(c.sigmaTimeA, KindAttached);
+  f(c.qPtA, KindTracks);
+  f(c.rowA, KindTracks);
+  f(c.sliceA, KindTracks);
+  f(c.timeA, KindTracks);
+  f(c.padA, KindTracks);
+  f(c.qTotU, KindUnattached);
+  f(c.qMaxU, KindUnattached);
+  f(c.flagsU, KindUnattached);
+  f(c.padDiffU, KindUnattached);
+  f(c.timeDiffU, KindUnattached);
+  f(c.sigmaPadU, KindUnattached);
+  f(c.sigmaTimeU, KindUnattached);
+  f(c.nTrackClusters, KindTracks);
+  f(c.nSliceRowClusters, KindSliceRows);
+}
+
+unsigned int TPCClusterEntropyCoder::getFieldSize(const CompressedClusters& c, FieldKind kind)
+{
+  switch (kind) {
+    case KindAttached:
+      return c.nAttachedClusters;
+    case KindAttachedReduced:
+      return c.nAttachedClustersReduced;
+    case KindTracks:
+      return c.nTracks;
+    case KindUnattached:
+      return c.nUnattachedClusters;
+    default:
+      return c.nSliceRows;
+  }
+}
+
+int TPCClusterEntropyCoder::getBlocks(const CompressedClusters& c, std::vector<unsigned int> (&blocks)[NKinds])
+{
+  for (unsigned int i = 0; i < NKinds; i++) {
+    blocks[i].clear();
+  }
+  // Attached clusters are stored track by track, so we split them at track boundaries
+  const unsigned int nTrackBlocks = std::min(c.nTracks, NSLICES);
+  for (unsigned int i = 0; i < nTrackBlocks; i++) {
+    unsigned int first = (size_t)i * c.nTracks / nTrackBlocks;
+    unsigned int last = (size_t)(i + 1) * c.nTracks / nTrackBlocks;
+    unsigned int nCl = 0, nClReduced = 0;
+    for (unsigned int j = first; j < last; j++) {
+      nCl += c.nTrackClusters[j];
+      nClReduced += c.nTrackClusters[j] ? c.nTrackClusters[j] - 1 : 0;
+    }
+    blocks[KindTracks].emplace_back(last - first);
+    blocks[KindAttached].emplace_back(nCl);
+    blocks[KindAttachedReduced].emplace_back(nClReduced);
+  }
+  // Unattached clusters are stored slice by slice
+  if (c.nSliceRows == NSLICES * GPUCA_ROW_COUNT) {
+    for (unsigned int i = 0; i < NSLICES; i++) {
+      unsigned int nCl = 0;
+      for (unsigned int j = 0; j < GPUCA_ROW_COUNT; j++) {
+        nCl += c.nSliceRowClusters[i * GPUCA_ROW_COUNT + j];
+      }
+      blocks[KindUnattached].emplace_back(nCl);
+      blocks[KindSliceRows].emplace_back(GPUCA_ROW_COUNT);
+    }
+  } else {
+    blocks[KindUnattached].emplace_back(c.nUnattachedClusters);
+    blocks[KindSliceRows].emplace_back(c.nSliceRows);
+  }
+  for (unsigned int i = 0; i < NKinds; i++) {
+    size_t sum = 0;
+    for (unsigned int n : blocks[i]) {
+      sum += n;
+    }
+    if (sum != getFieldSize(c, (FieldKind)i)) {
+      GPUError("Inconsistent compressed clusters: %lld entries in blocks of kind %u, expected %u", (long long int)sum, i, getFieldSize(c, (FieldKind)i));
+      return 1;
+    }
+  }
+  return 0;
+}
+
+int TPCClusterEntropyCoder::encode(const CompressedClusters* clustersCompressed, std::vector<char>& output, int nThreads)
+{
+  const CompressedClusters& c = *clustersCompressed;
+  nThreads = std::max(nThreads, 1);
+  std::vector<unsigned int> blocks[NKinds];
+  if (getBlocks(c, blocks)) {
+    return 1;
+  }
+
+  std::vector<Field> fields;
+  std::vector<Stream> streams;
+  forEachField(c, [&](auto& ptr, FieldKind kind) {
+    const unsigned int width = sizeof(*ptr);
+    fields.emplace_back(Field{(void*)ptr, width, (unsigned int)kind, getFieldSize(c, kind), (unsigned int)streams.size(), width == 4 ? 2u : 1u});
+    for (unsigned int i = 0; i < fields.back().nStreams; i++) {
+      streams.emplace_back();
+      streams.back().field = fields.size() - 1;
+      streams.back().shift = i * SYMBOL_BITS;
+    }
+  });
+
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+  for (unsigned int i = 0; i < streams.size(); i++) {
+    const Field& f = fields[streams[i].field];
+    std::vector<unsigned int> counts(f.width == 1 ? 256 : (1u << SYMBOL_BITS), 0);
+    for (size_t j = 0; j < f.n; j++) {
+      counts[getSymbol(f, streams[i], j)]++;
+    }
+    buildEncodingTable(counts, f.n, streams[i]);
+  }
+
+  std::vector<std::pair<unsigned int, unsigned int>> tasks; // stream, block
+  std::vector<std::vector<size_t>> blockOffsets(NKinds);
+  for (unsigned int i = 0; i < NKinds; i++) {
+    blockOffsets[i].resize(blocks[i].size() + 1, 0);
+    for (unsigned int j = 0; j < blocks[i].size(); j++) {
+      blockOffsets[i][j + 1] = blockOffsets[i][j] + blocks[i][j];
+    }
+  }
+  std::vector<std::vector<EncodedBlock>> encoded(streams.size());
+  for (unsigned int i = 0; i < streams.size(); i++) {
+    const unsigned int kind = fields[streams[i].field].kind;
+    encoded[i].resize(blocks[kind].size());
+    for (unsigned int j = 0; j < blocks[kind].size(); j++) {
+      tasks.emplace_back(i, j);
+    }
+  }
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    const Stream& s = streams[tasks[i].first];
+    const Field& f = fields[s.field];
+    const unsigned int iBlock = tasks[i].second;
+    encodeBlock(f, s, blockOffsets[f.kind][iBlock], blocks[f.kind][iBlock], encoded[tasks[i].first][iBlock]);
+  }
+
+  output.clear();
+  putVarInt(output, VERSION);
+  putVarInt(output, c.nTracks);
+  putVarInt(output, c.nAttachedClusters);
+  putVarInt(output, c.nUnattachedClusters);
+  putVarInt(output, c.nAttachedClustersReduced);
+  putVarInt(output, c.nSliceRows);
+  putVarInt(output, c.nComppressionModes);
+  for (unsigned int i = 0; i < NKinds; i++) {
+    putVarInt(output, blocks[i].size());
+    for (unsigned int n : blocks[i]) {
+      putVarInt(output, n);
+    }
+  }
+  size_t payloadSize = 0;
+  for (unsigned int i = 0; i < streams.size(); i++) {
+    const Stream& s = streams[i];
+    unsigned int nEntries = std::count_if(s.freq.begin(), s.freq.end(), [](unsigned int v) { return v != 0; });
+    putVarInt(output, nEntries);
+    for (unsigned int j = 0, last = 0; j <= s.alphabet; j++) {
+      if (s.freq[j]) {
+        putVarInt(output, j - last);
+        putVarInt(output, s.freq[j] - 1);
+        last = j;
+      }
+    }
+    for (const EncodedBlock& b : encoded[i]) {
+      putVarInt(output, b.data.size());
+      putVarInt(output, b.escapes.size());
+      payloadSize += b.data.size() + 2 * b.escapes.size();
+    }
+  }
+  size_t offset = output.size();
+  output.resize(offset + payloadSize);
+  for (unsigned int i = 0; i < streams.size(); i++) {
+    for (const EncodedBlock& b : encoded[i]) {
+      memcpy(output.data() + offset, b.data.data(), b.data.size());
+      offset += b.data.size();
+      for (unsigned short v : b.escapes) {
+        output[offset++] = v & 0xFF;
+        output[offset++] = v >> 8;
+      }
+    }
+  }
+  return 0;
+}
+
+int TPCClusterEntropyCoder::decode(const char* input, size_t size, CompressedClusters& clustersCompressed, std::vector<char>& buffer, int nThreads)
+{
+  CompressedClusters& c = clustersCompressed;
+  nThreads = std::max(nThreads, 1);
+  Reader r(input, input + size);
+  unsigned int version = r.getUInt();
+  if (r.error() || version != VERSION) {
+    GPUError("Unsupported version %u of entropy coded TPC clusters", version);
+    return 1;
+  }
+  c.nTracks = r.getUInt();
+  c.nAttachedClusters = r.getUInt();
+  c.nUnattachedClusters = r.getUInt();
+  c.nAttachedClustersReduced = r.getUInt();
+  c.nSliceRows = r.getUInt();
+  c.nComppressionModes = r.getUInt(0xFF);
+  std::vector<unsigned int> blocks[NKinds];
+  std::vector<std::vector<size_t>> blockOffsets(NKinds);
+  for (unsigned int i = 0; i < NKinds && !r.error(); i++) {
+    unsigned int nBlocks = r.getUInt(r.end() - r.ptr());
+    blocks[i].resize(nBlocks);
+    blockOffsets[i].resize(nBlocks + 1, 0);
+    for (unsigned int j = 0; j < nBlocks; j++) {
+      blocks[i][j] = r.getUInt();
+      blockOffsets[i][j + 1] = blockOffsets[i][j] + blocks[i][j];
+    }
+    if (blockOffsets[i][nBlocks] != getFieldSize(c, (FieldKind)i)) {
+      GPUError("Inconsistent block sizes in entropy coded TPC clusters");
+      return 1;
+    }
+  }
+  if (r.error()) {
+    GPUError("Truncated entropy coded TPC clusters");
+    return 1;
+  }
+
+  std::vector<Field> fields;
+  std::vector<Stream> streams;
+  size_t bufferSize = 0;
+  forEachField(c, [&](auto& ptr, FieldKind kind) {
+    const unsigned int width = sizeof(*ptr);
+    fields.emplace_back(Field{nullptr, width, (unsigned int)kind, getFieldSize(c, kind), (unsigned int)streams.size(), width == 4 ? 2u : 1u});
+    bufferSize += ((size_t)fields.back().n * width + 7) & ~(size_t)7;
+    for (unsigned int i = 0; i < fields.back().nStreams; i++) {
+      streams.emplace_back();
+      streams.back().field = fields.size() - 1;
+      streams.back().shift = i * SYMBOL_BITS;
+    }
+  });
+  buffer.resize(bufferSize);
+  size_t offset = 0;
+  unsigned int iField = 0;
+  forEachField(c, [&](auto& ptr, FieldKind) {
+    ptr = reinterpret_cast<std::remove_reference_t<decltype(ptr)>>(buffer.data() + offset);
+    fields[iField].ptr = buffer.data() + offset;
+    offset += ((size_t)fields[iField++].n * sizeof(*ptr) + 7) & ~(size_t)7;
+  });
+
+  std::vector<std::vector<DecodedBlock>> decoded(streams.size());
+  for (unsigned int i = 0; i < streams.size() && !r.error(); i++) {
+    Stream& s = streams[i];
+    const Field& f = fields[s.field];
+    s.alphabet = f.width == 1 ? 256 : (1u << SYMBOL_BITS);
+    s.freq.assign(s.alphabet + 1, 0);
+    s.start.assign(s.alphabet + 1, 0);
+    unsigned int nEntries = r.getUInt(s.alphabet + 1);
+    unsigned int sum = 0;
+    for (unsigned int j = 0, index = 0; j < nEntries && !r.error(); j++) {
+      index += r.getUInt(s.alphabet);
+      if (index > s.alphabet || s.freq[index]) {
+        GPUError("Invalid frequency table in entropy coded TPC clusters");
+        return 1;
+      }
+      s.freq[index] = r.getUInt(SCALE - 1) + 1;
+      sum += s.freq[index];
+    }
+    if (!r.error() && (nEntries || f.n) && sum != SCALE) {
+      GPUError("Invalid frequency table in entropy coded TPC clusters");
+      return 1;
+    }
+    if (nEntries) {
+      s.slotToSymbol.resize(SCALE);
+      for (unsigned int j = 0; j <= s.alphabet; j++) {
+        if (j) {
+          s.start[j] = s.start[j - 1] + s.freq[j - 1];
+        }
+        std::fill(s.slotToSymbol.begin() + s.start[j], s.slotToSymbol.begin() + s.start[j] + s.freq[j], j);
+      }
+    }
+    decoded[i].resize(blocks[f.kind].size());
+    for (DecodedBlock& b : decoded[i]) {
+      b.nBytes = r.getUInt();
+      b.nEscapes = r.getUInt();
+    }
+  }
+  if (r.error()) {
+    GPUError("Truncated entropy coded TPC clusters");
+    return 1;
+  }
+  const unsigned char* payload = r.ptr();
+  for (unsigned int i = 0; i < streams.size(); i++) {
+    for (DecodedBlock& b : decoded[i]) {
+      if ((size_t)(r.end() - payload) < b.nBytes + 2 * (size_t)b.nEscapes) {
+        GPUError("Truncated entropy coded TPC clusters");
+        return 1;
+      }
+      b.data = payload;
+      b.escapes = payload + b.nBytes;
+      payload += b.nBytes + 2 * (size_t)b.nEscapes;
+    }
+  }
+
+  // The streams of one field write to the same elements, so one task decodes all streams of a field for one block
+  std::vector<std::pair<unsigned int, unsigned int>> tasks; // field, block
+  for (unsigned int i = 0; i < fields.size(); i++) {
+    for (unsigned int j = 0; j < blocks[fields[i].kind].size(); j++) {
+      tasks.emplace_back(i, j);
+    }
+  }
+  std::vector<char> errors(tasks.size(), 0);
+#pragma omp parallel for num_threads(nThreads) schedule(dynamic)
+  for (unsigned int i = 0; i < tasks.size(); i++) {
+    const Field& f = fields[tasks[i].first];
+    const unsigned int iBlock = tasks[i].second;
+    for (unsigned int j = 0; j < f.nStreams; j++) {
+      const unsigned int iStream = f.firstStream + j;
+      errors[i] |= decodeBlock(f, streams[iStream], blockOffsets[f.kind][iBlock], blocks[f.kind][iBlock], decoded[iStream][iBlock]);
+    }
+  }
+  if (std::find(errors.begin(), errors.end(), 1) != errors.end()) {
+    GPUError("Corrupt entropy coded TPC clusters");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file TPCClusterEntropyCoder.h
+
+#ifndef TPCCLUSTERENTROPYCODER_H
+#define TPCCLUSTERENTROPYCODER_H
+
+#include "GPUTPCCompression.h"
+#include <vector>
+
+namespace GPUCA_NAMESPACE
+{
+namespace gpu
+{
+using CompressedClusters = o2::tpc::CompressedClusters;
+
+// rANS entropy coder for the fields of the compressed TPC clusters.
+// Each field has its own static frequency table, which is stored with the encoded data.
+// Fields are coded in independent blocks (by slice for the unattached clusters, by ranges of tracks for the attached ones), which are encoded and decoded in parallel.
+class TPCClusterEntropyCoder
+{
+ public:
+  static constexpr unsigned int NSLICES = GPUCA_NSLICES;
+  static constexpr unsigned int VERSION = 1;
+  static constexpr unsigned int SCALE_BITS = 16;  // Precision of the normalized symbol frequencies
+  static constexpr unsigned int SYMBOL_BITS = 16; // 32 bit fields are coded as two streams of 16 bit symbols
+
+  // Returns 0 on success, the encoded data replaces the content of output
+  int encode(const CompressedClusters* clustersCompressed, std::vector<char>& output, int nThreads = 1);
+  // Returns 0 on success, the arrays of clustersCompressed point inside buffer afterwards
+  int decode(const char* input, size_t size, CompressedClusters& clustersCompressed, std::vector<char>& buffer, int nThreads = 1);
+
+ protected:
+  enum FieldKind { KindAttached = 0,
+                   KindAttachedReduced = 1,
+                   KindTracks = 2,
+                   KindUnattached = 3,
+                   KindSliceRows = 4,
+                   NKinds = 5 };
+
+  template <class C, class F>
+  static void forEachField(C& c, F&& f);
+  static unsigned int getFieldSize(const CompressedClusters& c, FieldKind kind);
+  static int getBlocks(const CompressedClusters& c, std::vector<unsigned int> (&blocks)[NKinds]);
+};
+} // namespace gpu
+} // namespace GPUCA_NAMESPACE
+
+#endif
@@ -35,6 +35,7 @@
 
 #ifdef HAVE_O2HEADERS
 #include "GPUTPCClusterStatistics.h"
+#include "TPCClusterEntropyCoder.h"
 #else
 #include "GPUO2FakeClasses.h"
 #endif
@@ -1535,6 +1536,23 @@ int GPUChainTracking::RunTPCCompression()
   return 0;
 }
 
+int GPUChainTracking::RunTPCEntropyCoding()
+{
+#ifdef HAVE_O2HEADERS
+  TPCClusterEntropyCoder coder;
+  if (coder.encode(mIOPtrs.tpcCompressedClusters, mTPCCompressedClustersEncoded, GetDeviceProcessingSettings().nThreads)) {
+    GPUError("Error entropy coding TPC clusters");
+    return 1;
+  }
+  mIOPtrs.tpcCompressedClustersEncoded = mTPCCompressedClustersEncoded.data();
+  mIOPtrs.tpcCompressedClustersEncodedSize = mTPCCompressedClustersEncoded.size();
+  if (GetDeviceProcessingSettings().debugLevel >= 2) {
+    GPUInfo("TPC Entropy Coding Finished (%lld bytes)", (long long int)mTPCCompressedClustersEncoded.size());
+  }
+#endif
+  return 0;
+}
+
 int GPUChainTracking::RunTRDTracking()
 {
   if (!processors()->trdTracker.IsInitialized()) {
@@ -1679,8 +1697,11 @@ int GPUChainTracking::RunChain()
   if (GetRecoSteps().isSet(RecoStep::TPCCompression) && mIOPtrs.clustersNative) {
     timerCompression.Start();
     RunTPCCompression();
+    if (GetDeviceProcessingSettings().tpcEntropyCoding && RunTPCEntropyCoding()) {
+      return 1;
+    }
     if (GetDeviceProcessingSettings().runCompressionStatistics) {
-      mCompressionStatistics->RunStatistics(mClusterNativeAccess.get(), &processors()->tpcCompressor.mOutput, param());
+      mCompressionStatistics->RunStatistics(mClusterNativeAccess.get(), &processors()->tpcCompressor.mOutput, param(), mIOPtrs.tpcCompressedClustersEncoded, mIOPtrs.tpcCompressedClustersEncodedSize);
     }
     timerCompression.Stop();
   }
@@ -19,6 +19,7 @@
 #include "GPUDataTypes.h"
 #include <atomic>
 #include <array>
+#include <vector>
 
 namespace o2
 {
@@ -129,6 +130,7 @@ class GPUChainTracking : public GPUChain, GPUReconstructionHelpers::helperDelega
   int RunTRDTracking();
   int DoTRDGPUTracking();
   int RunTPCCompression();
+  int RunTPCEntropyCoding();
 
   // Getters / setters for parameters
   const TPCFastTransform* GetTPCTransform() const { return processors()->calibObjects.fastTransform; }
@@ -190,6 +192,9 @@ class GPUChainTracking : public GPUChain, GPUReconstructionHelpers::helperDelega
   std::unique_ptr<GPUQA> mQA;
   std::unique_ptr<GPUTPCClusterStatistics> mCompressionStatistics;
 
+  // Output of the TPC entropy coding
+  std::vector<char> mTPCCompressedClustersEncoded;
+
   // Ptr to reconstruction detector objects
   std::unique_ptr<o2::tpc::ClusterNativeAccess> mClusterNativeAccess; // Internal memory for clusterNativeAccess
   std::unique_ptr<GPUTrackingInOutDigits> mDigitMap;                  // Internal memory for digit-map, if needed
@@ -90,6 +90,11 @@ struct GPUO2InterfaceIOPtrs {
   // Output for entropy-reduced clusters of TPC compression
   const o2::tpc::CompressedClusters* compressedClusters;
 
+  // Output for entropy coded compressed clusters, if enabled by configDeviceProcessing.tpcEntropyCoding.
+  // Not published by the TPC tracking workflow yet, same as compressedClusters.
+  const char* compressedClustersEncoded = nullptr;
+  size_t compressedClustersEncodedSize = 0;
+
   // Hint for GPUCATracking to place its output in this buffer if possible.
   // This enables to create the output directly in a shared memory segment of the framework.
   // This allows further processing with zero-copy.
@@ -127,6 +127,7 @@ AddOption(runs2, int, 1, "runsExternal", 0, "Number of iterations to perform (re
 AddOption(runsInit, int, 1, "runsInit", 0, "Number of initial iterations excluded from average", min(0))
 AddOption(EventsDir, const char*, "pp", "events", 'e', "Directory with events to process", message("Reading events from Directory events/%s"))
 AddOption(OMPThreads, int, -1, "omp", 't', "Number of OMP threads to run (-1: all)", min(-1), message("Using %d OMP threads"))
+AddOption(ompKernels, bool, false, "ompKernels", 0, "Distribute the blocks of the CPU kernels over the OMP threads (output order of atomics not reproducible)")
 AddOption(eventDisplay, int, 0, "display", 'd', "Show standalone event display", def(1)) //1: default display (Windows / X11), 2: glut, 3: glfw
 AddOption(qa, bool, false, "qa", 'q', "Enable tracking QA", message("Running QA: %s"))
 AddOption(eventGenerator, bool, false, "eventGenerator", 0, "Run event generator")
@@ -149,6 +150,7 @@ AddOption(rejectMode, char, 5, "rejectMode", 0, "Merger Reject Mode")
 AddOption(allocationStrategy, int, 0, "allocationStrategy", 0, "Memory Allocation Stragegy (0 = auto, 1 = individual allocations, 2 = single global allocation)")
 AddOption(printSettings, bool, false, "printSettings", 0, "Print all settings")
 AddOption(compressionStat, bool, false, "compressionStat", 0, "Run statistics and verification for cluster compression")
+AddOption(entropyCoding, bool, false, "entropyCoding", 0, "Entropy code the compressed TPC clusters")
 AddOption(memoryStat, bool, false, "memoryStat", 0, "Print memory statistics")
 AddHelp("help", 'h')
 AddHelpAll("helpall", 'H')
@@ -287,12 +287,14 @@ int SetupReconstruction()
   if (configStandalone.OMPThreads != -1) {
     devProc.nThreads = configStandalone.OMPThreads;
   }
+  devProc.ompKernels = configStandalone.ompKernels;
   devProc.deviceNum = configStandalone.cudaDevice;
   devProc.forceMemoryPoolSize = configStandalone.forceMemorySize;
   devProc.debugLevel = configStandalone.DebugLevel;
   devProc.deviceTimers = configStandalone.DeviceTiming;
   devProc.runQA = configStandalone.qa;
   devProc.runCompressionStatistics = configStandalone.compressionStat;
+  devProc.tpcEntropyCoding = configStandalone.entropyCoding;
   if (configStandalone.eventDisplay) {
 #ifdef GPUCA_BUILD_EVENT_DISPLAY
 #ifdef _WIN32
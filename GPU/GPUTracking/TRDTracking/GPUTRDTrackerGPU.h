@@ -25,6 +25,7 @@ class GPUTRDTrackerGPU : public GPUKernelTemplate
 {
  public:
   GPUhdi() CONSTEXPR static GPUDataTypes::RecoStep GetRecoStep() { return GPUCA_RECO_STEP::TRDTracking; }
+  GPUhdi() CONSTEXPR static bool CPUSerialBlocks() { return true; } // Uses OpenMP internally
   template <int iKernel = 0>
   GPUd() static void Thread(int nBlocks, int nThreads, int iBlock, int iThread, GPUsharedref() GPUTPCSharedMemory& smem, processorType& processors);
 };
@@ -0,0 +1,114 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file testGPUReconstructionCPU.cxx
+
+#define BOOST_TEST_MODULE Test GPU Reconstruction CPU Kernels
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "GPUReconstructionCPU.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace o2::gpu;
+
+namespace
+{
+class TestReconstructionCPU : public GPUReconstructionCPU
+{
+ public:
+  TestReconstructionCPU(int nThreads, bool ompKernels) : GPUReconstructionCPU(GPUSettingsProcessing())
+  {
+    GPUSettingsEvent event;
+    GPUSettingsDeviceProcessing proc;
+    proc.nThreads = nThreads;
+    proc.ompKernels = ompKernels;
+    SetSettings(&event, nullptr, &proc);
+  }
+  unsigned int DefaultBlockCount() const { return mBlockCount; }
+
+  /// Clean @a size bytes at @a ptr with a grid of @a nBlocks, @return the time it took in seconds
+  double clean(unsigned int nBlocks, int4* ptr, unsigned long size)
+  {
+    auto start = std::chrono::steady_clock::now();
+    runKernel<GPUMemClean16>({nBlocks, 1, 0, RecoStep::TPCClusterFinding}, krnlRunRangeNone, krnlEventNone, (void*)ptr, size);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+};
+
+void fill(std::vector<int4>& buffer)
+{
+  std::memset((void*)buffer.data(), 0xFF, buffer.size() * sizeof(int4));
+}
+
+bool isClean(const std::vector<int4>& buffer, size_t n)
+{
+  return std::all_of(buffer.begin(), buffer.begin() + n, [](const int4& v) { return v.x == 0 && v.y == 0 && v.z == 0 && v.w == 0; }) &&
+         std::all_of(buffer.begin() + n, buffer.end(), [](const int4& v) { return v.x == -1 && v.y == -1 && v.z == -1 && v.w == -1; });
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(CPUDefaultBlockCount)
+{
+  TestReconstructionCPU serial(4, false);
+  BOOST_REQUIRE_EQUAL(serial.Init(), 0);
+  BOOST_CHECK_EQUAL(serial.DefaultBlockCount(), 1);
+
+  // With ompKernels, the kernels launched with the default grid have a block per thread to distribute
+  TestReconstructionCPU parallel(4, true);
+  BOOST_REQUIRE_EQUAL(parallel.Init(), 0);
+  BOOST_CHECK_EQUAL(parallel.DefaultBlockCount(), parallel.GetDeviceProcessingSettings().nThreads);
+}
+
+BOOST_AUTO_TEST_CASE(CPUParallelBlocksSameAsSerial)
+{
+  TestReconstructionCPU serial(4, false), parallel(4, true);
+  BOOST_REQUIRE_EQUAL(serial.Init(), 0);
+  BOOST_REQUIRE_EQUAL(parallel.Init(), 0);
+
+  // Only the given size, extended to a multiple of 16 bytes, is cleaned, whatever the number of blocks
+  for (size_t n : {0, 1, 5, 1000, 100003}) {
+    std::vector<int4> buffer(n + 8);
+    for (unsigned int nBlocks : {1u, serial.DefaultBlockCount(), parallel.DefaultBlockCount(), 7u, 1000u}) {
+      for (auto* rec : {&serial, &parallel}) {
+        fill(buffer);
+        rec->clean(nBlocks, buffer.data(), n * sizeof(int4) - (n ? 5 : 0));
+        BOOST_CHECK(isClean(buffer, n));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(CPUParallelBlocksScaling)
+{
+  TestReconstructionCPU serial(4, false), parallel(4, true);
+  BOOST_REQUIRE_EQUAL(serial.Init(), 0);
+  BOOST_REQUIRE_EQUAL(parallel.Init(), 0);
+
+  // The timings depend on the machine, so they are only reported
+  std::vector<int4> buffer(1 << 24);
+  double serialTime = 1e9, parallelTime = 1e9;
+  for (int i = 0; i < 5; i++) {
+    fill(buffer);
+    serialTime = std::min(serialTime, serial.clean(serial.DefaultBlockCount(), buffer.data(), buffer.size() * sizeof(int4)));
+    BOOST_CHECK(isClean(buffer, buffer.size()));
+    fill(buffer);
+    parallelTime = std::min(parallelTime, parallel.clean(parallel.DefaultBlockCount(), buffer.data(), buffer.size() * sizeof(int4)));
+    BOOST_CHECK(isClean(buffer, buffer.size()));
+  }
+  BOOST_TEST_MESSAGE("Cleaning " << (buffer.size() * sizeof(int4) >> 20) << " MB: " << serialTime * 1e3 << " ms serial, " << parallelTime * 1e3 << " ms with "
+                                 << parallel.DefaultBlockCount() << " blocks on " << parallel.GetDeviceProcessingSettings().nThreads << " threads");
+}
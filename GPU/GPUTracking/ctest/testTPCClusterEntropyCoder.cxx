@@ -0,0 +1,203 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file testTPCClusterEntropyCoder.cxx
+
+#define BOOST_TEST_MODULE Test TPC Cluster Entropy Coder
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+#include "TPCClusterEntropyCoder.h"
+
+#include <algorithm>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace o2::gpu;
+
+namespace
+{
+constexpr unsigned int NSLICEROWS = GPUCA_NSLICES * GPUCA_ROW_COUNT;
+
+template <class C, class F>
+void forEachField(C& a, C& b, F&& f)
+{
+  f(a.qTotA, b.qTotA, a.nAttachedClusters);
+  f(a.qMaxA, b.qMaxA, a.nAttachedClusters);
+  f(a.flagsA, b.flagsA, a.nAttachedClusters);
+  f(a.rowDiffA, b.rowDiffA, a.nAttachedClustersReduced);
+  f(a.sliceLegDiffA, b.sliceLegDiffA, a.nAttachedClustersReduced);
+  f(a.padResA, b.padResA, a.nAttachedClustersReduced);
+  f(a.timeResA, b.timeResA, a.nAttachedClustersReduced);
+  f(a.sigmaPadA, b.sigmaPadA, a.nAttachedClusters);
+  f(a.sigmaTimeA, b.sigmaTimeA, a.nAttachedClusters);
+  f(a.qPtA, b.qPtA, a.nTracks);
+  f(a.rowA, b.rowA, a.nTracks);
+  f(a.sliceA, b.sliceA, a.nTracks);
+  f(a.timeA, b.timeA, a.nTracks);
+  f(a.padA, b.padA, a.nTracks);
+  f(a.qTotU, b.qTotU, a.nUnattachedClusters);
+  f(a.qMaxU, b.qMaxU, a.nUnattachedClusters);
+  f(a.flagsU, b.flagsU, a.nUnattachedClusters);
+  f(a.padDiffU, b.padDiffU, a.nUnattachedClusters);
+  f(a.timeDiffU, b.timeDiffU, a.nUnattachedClusters);
+  f(a.sigmaPadU, b.sigmaPadU, a.nUnattachedClusters);
+  f(a.sigmaTimeU, b.sigmaTimeU, a.nUnattachedClusters);
+  f(a.nTrackClusters, b.nTrackClusters, a.nTracks);
+  f(a.nSliceRowClusters, b.nSliceRowClusters, a.nSliceRows);
+}
+
+/// Compressed clusters with the given number of clusters per track and
+/// per slice row, all other fields set to 0.
+struct TestClusters {
+  CompressedClusters c;
+  std::vector<std::vector<char>> storage;
+
+  TestClusters(const std::vector<unsigned short>& trackClusters, const std::vector<unsigned int>& sliceRowClusters)
+  {
+    c.nTracks = trackClusters.size();
+    c.nSliceRows = sliceRowClusters.size();
+    for (auto n : trackClusters) {
+      c.nAttachedClusters += n;
+      c.nAttachedClustersReduced += n ? n - 1 : 0;
+    }
+    for (auto n : sliceRowClusters) {
+      c.nUnattachedClusters += n;
+    }
+    forEachField(c, c, [this](auto& ptr, auto&, unsigned int n) {
+      storage.emplace_back(n * sizeof(*ptr), 0);
+      ptr = reinterpret_cast<std::remove_reference_t<decltype(ptr)>>(storage.back().data());
+    });
+    std::copy(trackClusters.begin(), trackClusters.end(), c.nTrackClusters);
+    std::copy(sliceRowClusters.begin(), sliceRowClusters.end(), c.nSliceRowClusters);
+  }
+
+  template <class T, class F>
+  void fill(T* ptr, unsigned int n, F&& f)
+  {
+    for (unsigned int i = 0; i < n; i++) {
+      ptr[i] = f(i);
+    }
+  }
+};
+
+std::vector<char> checkRoundTrip(CompressedClusters& c, int nThreads)
+{
+  TPCClusterEntropyCoder coder;
+  std::vector<char> encoded;
+  BOOST_REQUIRE_EQUAL(coder.encode(&c, encoded, nThreads), 0);
+  CompressedClusters decoded;
+  std::vector<char> buffer;
+  BOOST_REQUIRE_EQUAL(coder.decode(encoded.data(), encoded.size(), decoded, buffer, nThreads), 0);
+  BOOST_CHECK_EQUAL(decoded.nTracks, c.nTracks);
+  BOOST_CHECK_EQUAL(decoded.nAttachedClusters, c.nAttachedClusters);
+  BOOST_CHECK_EQUAL(decoded.nUnattachedClusters, c.nUnattachedClusters);
+  BOOST_CHECK_EQUAL(decoded.nAttachedClustersReduced, c.nAttachedClustersReduced);
+  BOOST_CHECK_EQUAL(decoded.nSliceRows, c.nSliceRows);
+  BOOST_CHECK_EQUAL(decoded.nComppressionModes, c.nComppressionModes);
+  forEachField(c, decoded, [](auto& a, auto& b, unsigned int n) {
+    BOOST_CHECK(std::equal(a, a + n, b));
+  });
+  return encoded;
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(EntropyCoderEmptyFields)
+{
+  for (int nThreads : {1, 4}) {
+    TestClusters empty({}, {});
+    BOOST_CHECK(checkRoundTrip(empty.c, nThreads).size() > 0);
+    // An event without any cluster still has its slice rows
+    TestClusters noClusters({}, std::vector<unsigned int>(NSLICEROWS, 0));
+    checkRoundTrip(noClusters.c, nThreads);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EntropyCoderSingleSymbolFields)
+{
+  TestClusters t(std::vector<unsigned short>(100, 5), std::vector<unsigned int>(NSLICEROWS, 2));
+  t.c.nComppressionModes = 3;
+  t.fill(t.c.qTotA, t.c.nAttachedClusters, [](unsigned int) { return 42; });
+  t.fill(t.c.padResA, t.c.nAttachedClustersReduced, [](unsigned int) { return 0xFFFF; });
+  t.fill(t.c.timeA, t.c.nTracks, [](unsigned int) { return 0x12345678; });
+  t.fill(t.c.qTotU, t.c.nUnattachedClusters, [](unsigned int) { return 7; });
+  t.fill(t.c.timeDiffU, t.c.nUnattachedClusters, [](unsigned int) { return 0xFFFFFFFF; });
+  size_t rawSize = 0;
+  forEachField(t.c, t.c, [&rawSize](auto& ptr, auto&, unsigned int n) { rawSize += n * sizeof(*ptr); });
+  for (int nThreads : {1, 4}) {
+    // Each block is reduced to its final rANS state
+    BOOST_CHECK_LT(checkRoundTrip(t.c, nThreads).size(), rawSize / 10);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EntropyCoderEscapedSymbols)
+{
+  // With more than 2^16 values, a symbol occurring once is too rare for a frequency of its own
+  TestClusters t({}, std::vector<unsigned int>(NSLICEROWS, 20));
+  BOOST_REQUIRE_GT(t.c.nUnattachedClusters, 1u << TPCClusterEntropyCoder::SCALE_BITS);
+  t.fill(t.c.qTotU, t.c.nUnattachedClusters, [](unsigned int i) { return i % 7 ? 5 : 10000 + i / 7; });
+  t.fill(t.c.qMaxU, t.c.nUnattachedClusters, [](unsigned int i) { return i % 1000 ? i % 3 : 0xFFFF - i / 1000; });
+  t.fill(t.c.flagsU, t.c.nUnattachedClusters, [](unsigned int i) { return i & 0xFF; });
+  for (int nThreads : {1, 4}) {
+    checkRoundTrip(t.c, nThreads);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EntropyCoder32BitFields)
+{
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<unsigned short> nClusters(0, 100);
+  std::vector<unsigned short> trackClusters(2000);
+  std::generate(trackClusters.begin(), trackClusters.end(), [&]() { return nClusters(rng); });
+  std::vector<unsigned int> sliceRowClusters(NSLICEROWS);
+  std::generate(sliceRowClusters.begin(), sliceRowClusters.end(), [&]() { return nClusters(rng) / 10; });
+  TestClusters t(trackClusters, sliceRowClusters);
+  t.fill(t.c.timeA, t.c.nTracks, [&](unsigned int) { return rng(); });
+  t.fill(t.c.timeResA, t.c.nAttachedClustersReduced, [&](unsigned int) { return rng() & 0xFFFFFF; });
+  t.fill(t.c.timeDiffU, t.c.nUnattachedClusters, [&](unsigned int i) { return i % 2 ? rng() % 50 : 0xFFFFFFFF - rng() % 50; });
+  t.fill(t.c.padA, t.c.nTracks, [&](unsigned int) { return rng() & 0xFFFF; });
+  t.fill(t.c.qTotA, t.c.nAttachedClusters, [&](unsigned int) { return rng() % 300; });
+  t.fill(t.c.sliceLegDiffA, t.c.nAttachedClustersReduced, [&](unsigned int) { return rng() % 4; });
+  for (int nThreads : {1, 4}) {
+    checkRoundTrip(t.c, nThreads);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(EntropyCoderRejectsInvalidInput)
+{
+  std::vector<unsigned short> trackClusters(500);
+  for (unsigned int i = 0; i < trackClusters.size(); i++) {
+    trackClusters[i] = i % 40;
+  }
+  TestClusters t(trackClusters, std::vector<unsigned int>(NSLICEROWS, 3));
+  t.fill(t.c.qTotA, t.c.nAttachedClusters, [](unsigned int i) { return (i * 7919) % 13; });
+  t.fill(t.c.timeResA, t.c.nAttachedClustersReduced, [](unsigned int i) { return (i * 104729) % 1000; });
+  t.fill(t.c.padDiffU, t.c.nUnattachedClusters, [](unsigned int i) { return (i * 31) % 100; });
+  t.fill(t.c.timeDiffU, t.c.nUnattachedClusters, [](unsigned int i) { return (i * 7) % 19; });
+  std::vector<char> encoded = checkRoundTrip(t.c, 1);
+
+  TPCClusterEntropyCoder coder;
+  CompressedClusters decoded;
+  std::vector<char> buffer;
+  for (size_t size : {(size_t)0, (size_t)1, encoded.size() / 2, encoded.size() - 1}) {
+    BOOST_CHECK_NE(coder.decode(encoded.data(), size, decoded, buffer), 0);
+  }
+
+  // None of the symbols is escaped, so the whole end of the buffer is rANS coded data
+  std::vector<char> corrupt;
+  for (size_t pos : {(size_t)0, encoded.size() - 64, encoded.size() - 63, encoded.size() - 20, encoded.size() - 5, encoded.size() - 1}) {
+    corrupt = encoded;
+    corrupt[pos] ^= 0x55;
+    BOOST_CHECK_NE(coder.decode(corrupt.data(), corrupt.size(), decoded, buffer), 0);
+  }
+  BOOST_CHECK_EQUAL(coder.decode(encoded.data(), encoded.size(), decoded, buffer), 0);
+}
@@ -41,7 +41,9 @@ class MergeInterface
   /// \brief Custom merge function.
   virtual Long64_t merge(TCollection* list) = 0;
 
-  /// \brief Timestamp getter function. It needs to return a timestamp when moving window functionality should be used.
+  /// \brief Timestamp getter function, used to order the objects with MergingMode::Timewise.
+  /// It should return the time in seconds since the epoch of std::chrono::system_clock (UNIX time), so that the objects
+  /// which do not implement it, ordered by their arrival time, can be compared with it.
   virtual double getTimestamp() = 0;
 
   ClassDef(MergeInterface, 0);
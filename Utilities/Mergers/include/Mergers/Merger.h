@@ -19,11 +19,14 @@
 #include "Mergers/MergerConfig.h"
 #include "Mergers/MergerCache.h"
 #include "Mergers/MergeInterface.h"
+#include "Mergers/MergerWindow.h"
 
 #include <Framework/Task.h>
+#include <Framework/ThreadPool.h>
 
 #include <TObject.h>
 
+#include <chrono>
 #include <memory>
 
 namespace o2
@@ -52,7 +55,10 @@ class Merger : public framework::Task
   std::function<void()> prepareTimerCallback(framework::InitContext& ictx) const;
   std::vector<TObject*> unpackObjects(TObject* obj);
   void mergeCache();
+  void updateMovingWindow();
   void publish(framework::DataAllocator& allocator);
+  void resetMergedObjects();
+  void reportStats(framework::ProcessingContext& ctx);
 
   void cleanCacheAfterMerging();
   void cleanCacheAfterPublishing();
@@ -65,6 +71,17 @@ class Merger : public framework::Task
   MergerCache mCache;
   std::unique_ptr<TObject> mMergedObjects;
   MergerConfig mConfig;
+  std::unique_ptr<framework::ThreadPool> mThreadPool;
+
+  // With Timespan::MovingWindow, the partial merges of each publication interval in the window.
+  // With MergingMode::Timewise, the received objects, ordered by timestamp.
+  MergerWindow mWindow;
+  // The merge of the partial merges in the window, with Timespan::MovingWindow.
+  std::unique_ptr<TObject> mWindowObject;
+
+  // merging statistics, reset at each publication
+  size_t mObjectsMerged = 0;
+  std::chrono::steady_clock::time_point mLastReport = std::chrono::steady_clock::now();
 };
 
 } // namespace experimental::mergers
@@ -0,0 +1,45 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef ALICEO2_MERGERALGORITHM_H
+#define ALICEO2_MERGERALGORITHM_H
+
+/// \file MergerAlgorithm.h
+/// \brief Algorithms used by a Merger to merge and to reuse the objects
+
+#include <Framework/ThreadPool.h>
+
+#include <TObject.h>
+
+#include <vector>
+
+namespace o2
+{
+namespace experimental::mergers::algorithm
+{
+
+/// \brief Merges @a other into @a target.
+/// Histograms with the same binning are simply added, which is much cheaper than the generic Merge.
+/// \throws std::runtime_error if the objects cannot be merged.
+void merge(TObject* target, TObject* other);
+
+/// \brief Merges each vector of @a deltas, one after the other, into @a targets, element by element.
+/// The targets are independent one from the other, so they are merged in parallel on @a pool, if any.
+/// \throws std::runtime_error if any of the objects cannot be merged.
+void merge(std::vector<TObject*> const& targets, std::vector<std::vector<TObject*>> const& deltas, framework::ThreadPool* pool);
+
+/// \brief Resets @a objects, so that they can be reused as empty targets of the merge.
+/// \return false, leaving them untouched, if not all of them are histograms which can be reset.
+bool reset(std::vector<TObject*> const& objects);
+
+} // namespace experimental::mergers::algorithm
+} // namespace o2
+
+#endif //ALICEO2_MERGERALGORITHM_H
@@ -30,7 +30,9 @@ enum class OwnershipMode { // todo better name
 
 enum class MergingMode {
   Binwise,     // Bins of histograms are added, TTree branches are attached, objects inside TCollections are merged correspondingly.
-  Timewise,    // NOT SUPPORTED YET. Arriving objects are merged into one T*****, ordered in time.
+  Timewise,    // Arriving objects are published together in a TObjArray, ordered in time. Timestamps are taken from
+               // MergeInterface::getTimestamp() when available, otherwise the arrival time is used. Requires OwnershipMode::Integral
+               // and Timespan::LastDifference or Timespan::MovingWindow.
   Concatenate, // Arriving objects are merged into one TObjArray, no particular order.
 };
 
@@ -44,7 +46,8 @@ enum class MergingTime {
 enum class Timespan {
   FullHistory,    // Merged object should consist of all the partial data that Mergers received..
   LastDifference, // Merged object should consist of only data received after last publication. Merged object is reset after published.
-  //  MovingWindow // NOT SUPPORTED YET. Merged object should consist of object from last N seconds. Inherit MergeInterface and implement time().
+  MovingWindow    // Merged object should consist of data received in the last N (param) seconds, with the granularity of the
+                  // publication interval. Requires OwnershipMode::Integral.
 };
 
 enum class PublicationDecision {
@@ -60,7 +63,7 @@ enum class TopologySize {
 
 enum class UnpackingMethod {
   NoUnpackingNeeded, // Merger treats object as it is.
-  TCollection,       // NOT SUPPORTED YET. Merger treats each object as TCollection and merges each member accordingly. todo
+  TCollection,       // Merger treats each object as TCollection and merges each member accordingly.
 };
 
 template <typename V, typename P = double>
@@ -78,6 +81,8 @@ struct MergerConfig {
   ConfigEntry<PublicationDecision> publicationDecision = {PublicationDecision::WhenXInputsUpdated, 0.999999};
   ConfigEntry<TopologySize, int> topologySize = {TopologySize::NumberOfLayers, 1};
   ConfigEntry<UnpackingMethod> unpackingMethod = {UnpackingMethod::NoUnpackingNeeded};
+  // Number of threads used to merge the objects unpacked from a collection in parallel. 1 means merging in the main thread.
+  int mergingThreads = 1;
 };
 
 } // namespace experimental::mergers
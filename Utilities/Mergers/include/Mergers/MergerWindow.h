@@ -0,0 +1,71 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#ifndef ALICEO2_MERGERWINDOW_H
+#define ALICEO2_MERGERWINDOW_H
+
+/// \file MergerWindow.h
+/// \brief Definition of the objects kept by a Merger for a moving window or a time series
+
+#include <TObject.h>
+
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace o2
+{
+namespace experimental::mergers
+{
+
+/// \brief Objects kept by a Merger for a limited time, ordered by their timestamps.
+///
+/// Timestamps are in seconds since the epoch of std::chrono::system_clock, which is also the unit of
+/// MergeInterface::getTimestamp(). Objects expire according to their arrival time instead, which is
+/// measured with std::chrono::steady_clock, so that they are kept for the configured time even if
+/// their timestamps are late or in the future.
+class MergerWindow
+{
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /// \brief An object, together with its arrival time and its timestamp.
+  struct Entry {
+    Clock::time_point arrival;
+    double timestamp;
+    std::unique_ptr<TObject> object;
+  };
+
+  /// \brief Inserts the object after all the ones with an earlier or equal timestamp.
+  void insert(std::unique_ptr<TObject> object, double timestamp, Clock::time_point arrival);
+  /// \brief Removes the objects which arrived before windowStart and returns them, in the window order.
+  std::vector<std::unique_ptr<TObject>> expire(Clock::time_point windowStart);
+
+  size_t size() const { return mEntries.size(); }
+  bool empty() const { return mEntries.empty(); }
+  void clear() { mEntries.clear(); }
+  const Entry& operator[](size_t i) const { return mEntries[i]; }
+
+  using const_iterator = std::deque<Entry>::const_iterator;
+  const_iterator begin() const { return mEntries.begin(); }
+  const_iterator end() const { return mEntries.end(); }
+
+  /// \return the current time as a timestamp, i.e. in seconds since the epoch of std::chrono::system_clock.
+  static double timestampNow();
+
+ private:
+  std::deque<Entry> mEntries;
+};
+
+} // namespace experimental::mergers
+} // namespace o2
+
+#endif //ALICEO2_MERGERWINDOW_H
@@ -14,13 +14,17 @@
 /// \author Piotr Konopka, piotr.jan.konopka@cern.ch
 
 #include "Mergers/Merger.h"
+#include "Mergers/MergerAlgorithm.h"
 #include "Mergers/MergerBuilder.h"
 
 #include <Framework/CompletionPolicyHelpers.h>
 #include <Framework/TimesliceIndex.h>
 #include <Framework/CallbackService.h>
+#include <Monitoring/Monitoring.h>
 
 #include <TObjArray.h>
+#include <TList.h>
+#include <TROOT.h>
 #include <TH1.h>
 #include <TH2.h>
 #include <TH3.h>
@@ -28,23 +32,57 @@
 #include <TTree.h>
 #include <THnSparse.h>
 
+#include <sys/resource.h>
+
+#include <algorithm>
+
 using namespace o2::framework;
 using namespace std::chrono;
+using o2::monitoring::Metric;
+using o2::monitoring::Monitoring;
 
 namespace o2
 {
 namespace experimental::mergers
 {
 
+namespace
+{
+/// \return the peak resident set size of the process in kB.
+long getPeakRSS()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+} // namespace
+
 Merger::Merger(MergerConfig config, header::DataHeader::SubSpecificationType subSpec)
   : mConfig(config),
     mSubSpec(subSpec),
     mCache(config.ownershipMode.value == OwnershipMode::Full)
 {
+  if ((mConfig.timespan.value == Timespan::MovingWindow || mConfig.mergingMode.value == MergingMode::Timewise) &&
+      mConfig.ownershipMode.value != OwnershipMode::Integral) {
+    throw std::runtime_error("Timespan::MovingWindow and MergingMode::Timewise require OwnershipMode::Integral");
+  }
+  if (mConfig.timespan.value == Timespan::MovingWindow && mConfig.mergingMode.value == MergingMode::Concatenate) {
+    throw std::runtime_error("Timespan::MovingWindow is not supported with MergingMode::Concatenate");
+  }
+  if (mConfig.mergingMode.value == MergingMode::Timewise && mConfig.timespan.value == Timespan::FullHistory) {
+    // Each object would be kept forever.
+    throw std::runtime_error("MergingMode::Timewise requires Timespan::LastDifference or Timespan::MovingWindow");
+  }
 }
 
 void Merger::init(framework::InitContext& ictx)
 {
+  if (mConfig.mergingThreads > 1) {
+    // Merging histograms might create temporary objects, which ROOT
+    // registers in its global lists.
+    ROOT::EnableThreadSafety();
+    mThreadPool = std::make_unique<ThreadPool>(mConfig.mergingThreads);
+  }
   if (mConfig.publicationDecision.value == PublicationDecision::EachNSeconds) {
     // Register a device callback which creates timeslice in the TimesliceIndex
     // each N seconds, so it can serve as timer input.
@@ -65,12 +103,22 @@ void Merger::run(framework::ProcessingContext& ctx)
 
   if (shouldPublish(ctx)) {
 
+    if (mConfig.timespan.value == Timespan::MovingWindow) {
+      updateMovingWindow();
+    }
+
     publish(ctx.outputs());
 
+    reportStats(ctx);
+
     cleanCacheAfterPublishing();
 
-    if (mConfig.timespan.value == Timespan::LastDifference) {
-      mMergedObjects.reset();
+    // In these modes the merged object is built from scratch for the next publication.
+    if (mConfig.timespan.value == Timespan::LastDifference || mConfig.ownershipMode.value == OwnershipMode::Full) {
+      resetMergedObjects();
+      if (mConfig.mergingMode.value == MergingMode::Timewise) {
+        mWindow.clear();
+      }
     }
   }
 }
@@ -124,6 +172,9 @@ void Merger::mergeCache()
         for (; i < mCache.size(); i++) {
           if (!mCache[i].deque.empty()) {
             mMergedObjects.reset(mCache[i].deque[0].obj->Clone());
+            if (auto collection = dynamic_cast<TCollection*>(mMergedObjects.get())) {
+              collection->SetOwner(true);
+            }
             mCache.setMerged(i, 0);
             break;
           }
@@ -135,56 +186,23 @@ void Merger::mergeCache()
         return;
       }
 
-      auto unpackedMergedObjects = unpackObjects(mMergedObjects.get());
-      std::vector<TObjArray> unpackedCollectionsOfObjects(unpackedMergedObjects.size());
-      // todo: unpack straight to TCollection?
+      // The cached objects are merged one by one in the target objects, which are
+      // independent one from the other and thus can be merged in parallel.
+      auto targets = unpackObjects(mMergedObjects.get());
+      std::vector<std::vector<TObject*>> deltas;
       for (; i < mCache.size(); i++) {
         for (const auto& entry : mCache[i].deque) {
           if (!entry.is_merged) {
-            auto unpackedCachedObjects = unpackObjects(entry.obj.get());
-            assert(unpackedMergedObjects.size() == unpackedCachedObjects.size());
-
-            for (int j = 0; j < unpackedCachedObjects.size(); j++) {
-              unpackedCollectionsOfObjects[j].Add(unpackedCachedObjects[j]);
+            deltas.emplace_back(unpackObjects(entry.obj.get()));
+            if (deltas.back().size() != targets.size()) {
+              throw std::runtime_error("Cached object does not contain the same number of objects as the merged one.");
             }
           }
         }
       }
 
-      for (int k = 0; k < unpackedMergedObjects.size(); k++) {
-
-        TObject* mergedObject = unpackedMergedObjects[k];
-        const char* className = mergedObject->ClassName();
-        Long64_t errorCode = 0;
-
-        //todo: investigate -NOCHECK flag for histogram merging
-        auto objectMergeInterface = dynamic_cast<MergeInterface*>(mergedObject);
-        if (objectMergeInterface) {
-          errorCode = objectMergeInterface->merge(&unpackedCollectionsOfObjects[k]);
-        } else if (strncmp(className, "TH1", 3) == 0) {
-          errorCode = reinterpret_cast<TH1*>(mergedObject)->Merge(&unpackedCollectionsOfObjects[k]);
-        } else if (strncmp(className, "TH2", 3) == 0) {
-          errorCode = reinterpret_cast<TH2*>(mergedObject)->Merge(&unpackedCollectionsOfObjects[k]);
-        } else if (strncmp(className, "TH3", 3) == 0) {
-          errorCode = reinterpret_cast<TH3*>(mergedObject)->Merge(&unpackedCollectionsOfObjects[k]);
-        } else if (strncmp(className, "THn", 3) == 0) {
-          errorCode = reinterpret_cast<THn*>(mergedObject)->Merge(&unpackedCollectionsOfObjects[k]);
-        } else if (strncmp(className, "THnSparse", 8) == 0) {
-          errorCode = reinterpret_cast<THnSparse*>(mergedObject)->Merge(&unpackedCollectionsOfObjects[k]);
-        } else if (strcmp(className, "TTree") == 0) {
-          errorCode = reinterpret_cast<TTree*>(mergedObject)->Merge(&unpackedCollectionsOfObjects[k]);
-        } else {
-          //          LOG(ERROR) << "Object with type " << className << " is not one of mergeable type.";
-          throw std::runtime_error("Object with type '" + std::string(className) + "' is not one of mergeable type.");
-          // todo: maybe it is fine to just overwrite?
-        }
-
-        if (errorCode == -1) {
-          throw std::runtime_error("Binwise merging object of type '" + std::string(className) + "' failed.");
-          //          LOG(ERROR) << "Merging object of type " << className << " failed";
-          return;
-        }
-      }
+      algorithm::merge(targets, deltas, mThreadPool.get());
+      mObjectsMerged += deltas.size() * targets.size();
 
       break;
     }
@@ -212,22 +230,112 @@ void Merger::mergeCache()
 
       break;
     }
-    case MergingMode::Timewise:
-      throw std::runtime_error("MergingMode::Timewise not supported yet");
+    case MergingMode::Timewise: {
+
+      // Objects are kept sorted by their timestamp, which is not necessarily their arrival order.
+      auto arrival = steady_clock::now();
+      auto timestampNow = MergerWindow::timestampNow();
+      for (const auto& queue : mCache) {
+        for (const auto& entry : queue.deque) {
+          if (!entry.is_merged) {
+            auto objectMergeInterface = dynamic_cast<MergeInterface*>(entry.obj.get());
+            double timestamp = objectMergeInterface ? objectMergeInterface->getTimestamp() : timestampNow;
+            mWindow.insert(std::unique_ptr<TObject>(entry.obj->Clone()), timestamp, arrival);
+            mObjectsMerged++;
+          }
+        }
+      }
+      break;
+    }
     default:
       break;
   }
 }
 
-void Merger::publish(framework::DataAllocator& allocator)
+void Merger::updateMovingWindow()
 {
+  // The data merged since the last publication becomes the newest partial merge of the window.
+  auto now = steady_clock::now();
   if (mMergedObjects) {
-    if (mConfig.ownershipMode.value == OwnershipMode::Integral) {
-      allocator.snapshot(framework::OutputRef{MergerBuilder::mergerOutputBinding(), mSubSpec}, *mMergedObjects.get());
-    } else if (mConfig.ownershipMode.value == OwnershipMode::Full) {
-      allocator.adopt(framework::OutputRef{MergerBuilder::mergerOutputBinding(), mSubSpec}, mMergedObjects.release());
+    mWindow.insert(std::move(mMergedObjects), MergerWindow::timestampNow(), now);
+  }
+  auto windowStart = now - duration_cast<steady_clock::duration>(duration<double>(mConfig.timespan.param));
+  auto expired = mWindow.expire(windowStart);
+  if (mConfig.mergingMode.value == MergingMode::Timewise) {
+    return;
+  }
+  for (auto& oldest : expired) {
+    // The oldest partial merge is recycled for the next interval, if possible.
+    if (!mMergedObjects && algorithm::reset(unpackObjects(oldest.get()))) {
+      mMergedObjects = std::move(oldest);
+    }
+  }
+
+  // Only the partial merges in the window are merged, not the whole history.
+  if (mWindow.empty()) {
+    mWindowObject.reset();
+    return;
+  }
+  size_t first = 0;
+  if (!mWindowObject || !algorithm::reset(unpackObjects(mWindowObject.get()))) {
+    mWindowObject.reset(mWindow[0].object->Clone());
+    if (auto collection = dynamic_cast<TCollection*>(mWindowObject.get())) {
+      collection->SetOwner(true);
+    }
+    first = 1;
+  }
+  auto targets = unpackObjects(mWindowObject.get());
+  std::vector<std::vector<TObject*>> deltas;
+  for (size_t i = first; i < mWindow.size(); i++) {
+    deltas.emplace_back(unpackObjects(mWindow[i].object.get()));
+  }
+  algorithm::merge(targets, deltas, mThreadPool.get());
+}
+
+void Merger::publish(framework::DataAllocator& allocator)
+{
+  // The object is serialised right away, so that we can keep reusing it.
+  if (mConfig.mergingMode.value == MergingMode::Timewise) {
+    if (!mWindow.empty()) {
+      TObjArray series;
+      for (const auto& entry : mWindow) {
+        series.Add(entry.object.get());
+      }
+      allocator.snapshot(framework::OutputRef{MergerBuilder::mergerOutputBinding(), mSubSpec}, series);
     }
+  } else if (mConfig.timespan.value == Timespan::MovingWindow) {
+    if (mWindowObject) {
+      allocator.snapshot(framework::OutputRef{MergerBuilder::mergerOutputBinding(), mSubSpec}, *mWindowObject.get());
+    }
+  } else if (mMergedObjects) {
+    allocator.snapshot(framework::OutputRef{MergerBuilder::mergerOutputBinding(), mSubSpec}, *mMergedObjects.get());
+  }
+}
+
+void Merger::resetMergedObjects()
+{
+  if (!mMergedObjects) {
+    return;
   }
+  if (mConfig.mergingMode.value == MergingMode::Binwise && algorithm::reset(unpackObjects(mMergedObjects.get()))) {
+    return;
+  }
+  mMergedObjects.reset();
+}
+
+void Merger::reportStats(framework::ProcessingContext& ctx)
+{
+  auto now = steady_clock::now();
+  double seconds = duration_cast<duration<double>>(now - mLastReport).count();
+  double rate = seconds > 0 ? mObjectsMerged / seconds : 0;
+  auto peakRSS = getPeakRSS();
+  auto& monitoring = ctx.services().get<Monitoring>();
+  monitoring.send(Metric{rate, "mergers_objects_merged_per_second"});
+  monitoring.send(Metric{(int)peakRSS, "mergers_peak_rss_kb"});
+  LOG(INFO) << "Merged " << mObjectsMerged << " objects in the last " << seconds << " s (" << rate
+            << " objects/s), peak RSS " << peakRSS / 1024 << " MB";
+  mObjectsMerged = 0;
+  mLastReport = now;
 }
 
 std::vector<TObject*> Merger::unpackObjects(TObject* obj)
@@ -237,8 +345,14 @@ std::vector<TObject*> Merger::unpackObjects(TObject* obj)
   } else if (mConfig.unpackingMethod.value == UnpackingMethod::NoUnpackingNeeded) {
     return std::vector<TObject*>{obj};
   } else if (mConfig.unpackingMethod.value == UnpackingMethod::TCollection) {
-    // todo: this could be also checked by casting
-    return {};
+    std::vector<TObject*> objects;
+    if (auto collection = dynamic_cast<TCollection*>(obj)) {
+      TIter next(collection);
+      while (auto object = next()) {
+        objects.push_back(object);
+      }
+    }
+    return objects;
   } else {
     return {};
   }
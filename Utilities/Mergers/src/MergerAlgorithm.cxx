@@ -0,0 +1,123 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MergerAlgorithm.cxx
+/// \brief Implementation of the algorithms used by a Merger to merge and to reuse the objects
+
+#include "Mergers/MergerAlgorithm.h"
+#include "Mergers/MergeInterface.h"
+
+#include <TList.h>
+#include <TH1.h>
+#include <THn.h>
+#include <TTree.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+namespace o2
+{
+namespace experimental::mergers::algorithm
+{
+
+namespace
+{
+bool sameBinning(TAxis const* a, TAxis const* b)
+{
+  auto aBins = a->GetXbins();
+  auto bBins = b->GetXbins();
+  return a->GetNbins() == b->GetNbins() && a->GetXmin() == b->GetXmin() && a->GetXmax() == b->GetXmax() &&
+         a->GetLabels() == nullptr && b->GetLabels() == nullptr &&
+         aBins->GetSize() == bBins->GetSize() && std::equal(aBins->GetArray(), aBins->GetArray() + aBins->GetSize(), bBins->GetArray());
+}
+
+bool sameBinning(TH1 const* a, TH1 const* b)
+{
+  return a->IsA() == b->IsA() && sameBinning(a->GetXaxis(), b->GetXaxis()) &&
+         sameBinning(a->GetYaxis(), b->GetYaxis()) && sameBinning(a->GetZaxis(), b->GetZaxis());
+}
+} // namespace
+
+void merge(TObject* target, TObject* other)
+{
+  TList list;
+  list.Add(other);
+  Long64_t errorCode = 0;
+  if (auto objectMergeInterface = dynamic_cast<MergeInterface*>(target)) {
+    errorCode = objectMergeInterface->merge(&list);
+  } else if (auto histogram = dynamic_cast<TH1*>(target)) {
+    auto otherHistogram = dynamic_cast<TH1*>(other);
+    if (otherHistogram && sameBinning(histogram, otherHistogram) && histogram->Add(otherHistogram)) {
+      return;
+    }
+    errorCode = histogram->Merge(&list);
+  } else if (auto histogramN = dynamic_cast<THnBase*>(target)) {
+    errorCode = histogramN->Merge(&list);
+  } else if (auto tree = dynamic_cast<TTree*>(target)) {
+    errorCode = tree->Merge(&list);
+  } else {
+    throw std::runtime_error("Object with type '" + std::string(target->ClassName()) + "' is not one of mergeable type.");
+  }
+  if (errorCode == -1) {
+    throw std::runtime_error("Binwise merging object of type '" + std::string(target->ClassName()) + "' failed.");
+  }
+}
+
+void merge(std::vector<TObject*> const& targets, std::vector<std::vector<TObject*>> const& deltas, framework::ThreadPool* pool)
+{
+  std::vector<std::string> errors(targets.size());
+  auto mergeTarget = [&targets, &deltas, &errors](size_t k) {
+    try {
+      for (auto& delta : deltas) {
+        merge(targets[k], delta[k]);
+      }
+    } catch (std::exception& e) {
+      errors[k] = e.what();
+    }
+  };
+  if (pool && targets.size() > 1) {
+    for (size_t k = 0; k < targets.size(); k++) {
+      pool->push([&mergeTarget, k](size_t) { mergeTarget(k); });
+    }
+    pool->wait();
+  } else {
+    for (size_t k = 0; k < targets.size(); k++) {
+      mergeTarget(k);
+    }
+  }
+  for (const auto& error : errors) {
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+  }
+}
+
+bool reset(std::vector<TObject*> const& objects)
+{
+  // Histograms can be reset and reused, which avoids cloning them again.
+  bool resettable = std::all_of(objects.begin(), objects.end(), [](TObject* object) {
+    return dynamic_cast<MergeInterface*>(object) == nullptr && (dynamic_cast<TH1*>(object) || dynamic_cast<THnBase*>(object));
+  });
+  if (!resettable) {
+    return false;
+  }
+  for (auto object : objects) {
+    if (auto histogram = dynamic_cast<TH1*>(object)) {
+      histogram->Reset();
+    } else {
+      dynamic_cast<THnBase*>(object)->Reset();
+    }
+  }
+  return true;
+}
+
+} // namespace experimental::mergers::algorithm
+} // namespace o2
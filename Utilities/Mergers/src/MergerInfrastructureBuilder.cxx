@@ -81,6 +81,22 @@ std::string MergerInfrastructureBuilder::validateConfig()
     error += preamble + "with OwnershipMode::Full, only MergingTime::BeforePublication is allowed.";
   }
 
+  if (mConfig.ownershipMode.value == OwnershipMode::Full && mConfig.timespan.value == Timespan::MovingWindow) {
+    error += preamble + "with OwnershipMode::Full, Timespan::MovingWindow is not allowed.";
+  }
+  if (mConfig.ownershipMode.value == OwnershipMode::Full && mConfig.mergingMode.value == MergingMode::Timewise) {
+    error += preamble + "with OwnershipMode::Full, MergingMode::Timewise is not allowed.";
+  }
+  if (mConfig.timespan.value == Timespan::MovingWindow && mConfig.mergingMode.value == MergingMode::Concatenate) {
+    error += preamble + "Timespan::MovingWindow is not supported with MergingMode::Concatenate.";
+  }
+  if (mConfig.mergingMode.value == MergingMode::Timewise && mConfig.timespan.value == Timespan::FullHistory) {
+    error += preamble + "MergingMode::Timewise requires Timespan::LastDifference or Timespan::MovingWindow.";
+  }
+  if (mConfig.timespan.value == Timespan::MovingWindow && mConfig.timespan.param <= 0.0) {
+    error += preamble + "the length of Timespan::MovingWindow should be positive, it is " + std::to_string(mConfig.timespan.param) + "\n";
+  }
+
   return error;
 }
 
@@ -110,6 +126,9 @@ framework::WorkflowSpec MergerInfrastructureBuilder::generateInfrastructure()
     if (layer > 1 && mConfig.ownershipMode.value == OwnershipMode::Integral) {
       layerConfig.ownershipMode = {OwnershipMode::Full}; // in Integral mode only the first layer should integrate
       layerConfig.timespan = {Timespan::LastDifference}; // and objects that are merged should not be used again
+      if (mConfig.mergingMode.value == MergingMode::Timewise) {
+        layerConfig.mergingMode = {MergingMode::Concatenate}; // time series from the first layer are only gathered
+      }
     }
     mergerBuilder.setConfig(layerConfig);
 
@@ -0,0 +1,53 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file MergerWindow.cxx
+/// \brief Implementation of the objects kept by a Merger for a moving window or a time series
+
+#include "Mergers/MergerWindow.h"
+
+#include <algorithm>
+
+using namespace std::chrono;
+
+namespace o2
+{
+namespace experimental::mergers
+{
+
+void MergerWindow::insert(std::unique_ptr<TObject> object, double timestamp, Clock::time_point arrival)
+{
+  auto position = std::upper_bound(mEntries.begin(), mEntries.end(), timestamp,
+                                   [](double t, Entry const& e) { return t < e.timestamp; });
+  mEntries.insert(position, Entry{arrival, timestamp, std::move(object)});
+}
+
+std::vector<std::unique_ptr<TObject>> MergerWindow::expire(Clock::time_point windowStart)
+{
+  std::vector<std::unique_ptr<TObject>> expired;
+  auto kept = mEntries.begin();
+  for (auto& entry : mEntries) {
+    if (entry.arrival < windowStart) {
+      expired.push_back(std::move(entry.object));
+    } else {
+      *(kept++) = std::move(entry);
+    }
+  }
+  mEntries.erase(kept, mEntries.end());
+  return expired;
+}
+
+double MergerWindow::timestampNow()
+{
+  return duration_cast<duration<double>>(system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace experimental::mergers
+} // namespace o2
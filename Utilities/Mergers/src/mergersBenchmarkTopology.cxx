@@ -19,6 +19,8 @@
 #include <Framework/CompletionPolicy.h>
 
 #include <TH1F.h>
+#include <TH2F.h>
+#include <TObjArray.h>
 #include <memory>
 #include <random>
 
@@ -36,6 +38,7 @@ void customize(std::vector<ConfigParamSpec>& options)
   options.push_back({"obj-bins", VariantType::Int, 100, {"Number of bins in a histogram"}});
   options.push_back({"obj-rate", VariantType::Double, 1.0, {"Number of objects per second sent by one producer"}});
   options.push_back({"obj-producers", VariantType::Int, 4, {"Number of objects producers"}});
+  options.push_back({"obj-collection-size", VariantType::Int, 1, {"Number of TH2F sent in a TObjArray by each producer. With 1, a single TH1F is sent"}});
 
   options.push_back({"mergers-layers", VariantType::Int, 2, {"Number of layers in the merger topology"}});
   options.push_back({"mergers-merge-decision", VariantType::String, "publication", {"At which occasion objects are merged: 'arrival' or 'publication'"}});
@@ -43,6 +46,7 @@ void customize(std::vector<ConfigParamSpec>& options)
   options.push_back({"mergers-publication-interval", VariantType::Double, 10.0, {"Publication interval of merged object [s]. It takes effect with --mergers-publication-decision interval"}});
   options.push_back(
     {"mergers-ownership-mode", VariantType::String, "diffs", {"Should the topology use 'diffs' or 'full' objects"}});
+  options.push_back({"mergers-threads", VariantType::Int, 1, {"Number of threads used by each merger to merge collections"}});
 }
 
 #include <Framework/runDataProcessing.h>
@@ -58,6 +62,7 @@ WorkflowSpec defineDataProcessing(ConfigContext const& config)
   int objectsBins = config.options().get<int>("obj-bins");
   double objectsRate = config.options().get<double>("obj-rate");
   int objectsProducers = config.options().get<int>("obj-producers");
+  int objectsCollectionSize = config.options().get<int>("obj-collection-size");
 
   int mergersLayers = config.options().get<int>("mergers-layers");
   MergingTime mergersMergeDecision =
@@ -67,6 +72,7 @@ WorkflowSpec defineDataProcessing(ConfigContext const& config)
   double mergersPublicationInterval = config.options().get<double>("mergers-publication-interval");
   OwnershipMode mergersOwnershipMode =
     config.options().get<std::string>("mergers-ownership-mode") == "full" ? OwnershipMode::Full : OwnershipMode::Integral;
+  int mergersThreads = config.options().get<int>("mergers-threads");
 
   WorkflowSpec specs;
   // clang-format off
@@ -85,7 +91,7 @@ WorkflowSpec defineDataProcessing(ConfigContext const& config)
                    static_cast<o2::header::DataHeader::SubSpecificationType>(p + 1),
                    Lifetime::Timeframe } },
         AlgorithmSpec{
-          (AlgorithmSpec::ProcessCallback)[ p, periodus = int(1000000 / objectsRate), objectsBins, objectsProducers ](
+          (AlgorithmSpec::ProcessCallback)[ p, periodus = int(1000000 / objectsRate), objectsBins, objectsProducers, objectsCollectionSize ](
             ProcessingContext& processingContext) mutable { static auto lastTime = steady_clock::now();
             auto now = steady_clock::now();
 
@@ -93,11 +99,25 @@ WorkflowSpec defineDataProcessing(ConfigContext const& config)
 
               lastTime += microseconds(periodus);
 
-              TH1F* histo = new TH1F("gauss", "gauss", objectsBins, -3, 3);
-              histo->FillRandom("gaus", 1000);
+              TObject* object = nullptr;
+              if (objectsCollectionSize == 1) {
+                TH1F* histo = new TH1F("gauss", "gauss", objectsBins, -3, 3);
+                histo->FillRandom("gaus", 1000);
+                object = histo;
+              } else {
+                auto collection = new TObjArray();
+                collection->SetOwner(true);
+                for (int i = 0; i < objectsCollectionSize; i++) {
+                  auto name = "gauss" + std::to_string(i);
+                  TH2F* histo = new TH2F(name.c_str(), name.c_str(), objectsBins, -3, 3, objectsBins, -3, 3);
+                  histo->FillRandom("gaus", 1000);
+                  collection->Add(histo);
+                }
+                object = collection;
+              }
 
               processingContext.outputs().adopt(
-                Output{ "TST", "HISTO", static_cast<o2::header::DataHeader::SubSpecificationType>(p + 1) }, histo);
+                Output{ "TST", "HISTO", static_cast<o2::header::DataHeader::SubSpecificationType>(p + 1) }, object);
             }
           }
         }
@@ -115,6 +135,8 @@ WorkflowSpec defineDataProcessing(ConfigContext const& config)
     mergerConfig.mergingTime = { mergersMergeDecision };
     mergerConfig.timespan = { Timespan::FullHistory };
     mergerConfig.topologySize = { TopologySize::NumberOfLayers, mergersLayers };
+    mergerConfig.unpackingMethod = { objectsCollectionSize == 1 ? UnpackingMethod::NoUnpackingNeeded : UnpackingMethod::TCollection };
+    mergerConfig.mergingThreads = mergersThreads;
     mergersBuilder.setConfig(mergerConfig);
 
     mergersBuilder.generateInfrastructure(specs);
@@ -126,9 +148,14 @@ WorkflowSpec defineDataProcessing(ConfigContext const& config)
       },
       Outputs{},
       AlgorithmSpec{
-        (AlgorithmSpec::InitCallback) [](InitContext&) {
-          return (AlgorithmSpec::ProcessCallback) [](ProcessingContext& processingContext) mutable {
+        (AlgorithmSpec::InitCallback) [objectsCollectionSize](InitContext&) {
+          return (AlgorithmSpec::ProcessCallback) [objectsCollectionSize](ProcessingContext& processingContext) mutable {
 //            LOG(INFO) << "printer invoked";
+            if (objectsCollectionSize != 1) {
+              auto collection = processingContext.inputs().get<TObjArray*>("histo");
+              LOG(INFO) << "Received a collection of " << collection->GetEntries() << " objects";
+              return;
+            }
             auto histo = processingContext.inputs().get<TH1F*>("histo");
             std::string bins = "BINS:";
             for (int i = 1; i <= histo->GetNbinsX(); i++) {
@@ -52,6 +52,45 @@ BOOST_AUTO_TEST_CASE(InfrastructureBuilderUnconfigured)
   BOOST_CHECK_NO_THROW(builder.generateInfrastructure());
 }
 
+BOOST_AUTO_TEST_CASE(InfrastructureBuilderMovingWindow)
+{
+  MergerInfrastructureBuilder builder;
+  builder.setInfrastructureName("name");
+  builder.setInputSpecs({{"one", "TST", "test", 1}});
+  builder.setOutputSpec({{"main"}, "TST", "test", 0});
+  MergerConfig config;
+  config.ownershipMode = {OwnershipMode::Integral};
+
+  config.timespan = {Timespan::MovingWindow, 0};
+  builder.setConfig(config);
+  BOOST_CHECK_THROW(builder.generateInfrastructure(), std::runtime_error);
+
+  config.timespan = {Timespan::MovingWindow, 60};
+  builder.setConfig(config);
+  BOOST_CHECK_NO_THROW(builder.generateInfrastructure());
+
+  config.mergingMode = {MergingMode::Concatenate};
+  builder.setConfig(config);
+  BOOST_CHECK_THROW(builder.generateInfrastructure(), std::runtime_error);
+
+  config.mergingMode = {MergingMode::Timewise};
+  builder.setConfig(config);
+  BOOST_CHECK_NO_THROW(builder.generateInfrastructure());
+
+  config.timespan = {Timespan::FullHistory};
+  builder.setConfig(config);
+  BOOST_CHECK_THROW(builder.generateInfrastructure(), std::runtime_error);
+
+  config.timespan = {Timespan::LastDifference};
+  builder.setConfig(config);
+  BOOST_CHECK_NO_THROW(builder.generateInfrastructure());
+
+  config.timespan = {Timespan::MovingWindow, 60};
+  config.ownershipMode = {OwnershipMode::Full};
+  builder.setConfig(config);
+  BOOST_CHECK_THROW(builder.generateInfrastructure(), std::runtime_error);
+}
+
 BOOST_AUTO_TEST_CASE(InfrastructureBuilderLayers)
 {
   MergerInfrastructureBuilder builder;
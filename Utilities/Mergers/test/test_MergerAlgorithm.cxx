@@ -0,0 +1,261 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file test_MergerAlgorithm.cxx
+/// \brief A unit test of the merging and the reuse of the objects in Mergers
+
+#define BOOST_TEST_MODULE Test Utilities MergerAlgorithm
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+
+#include "Mergers/MergerAlgorithm.h"
+
+#include <TH1.h>
+#include <TH2.h>
+#include <TH3.h>
+#include <THnSparse.h>
+#include <TList.h>
+#include <TNamed.h>
+#include <TRandom3.h>
+#include <TROOT.h>
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace o2::experimental::mergers;
+
+namespace
+{
+struct NoDirectory {
+  NoDirectory() { TH1::AddDirectory(false); }
+};
+
+/// Fills @a histogram around its axes, extended by @a margin on both sides to reach the under- and overflows
+void fill(TH1* histogram, int entries, unsigned int seed, double margin = 1)
+{
+  TRandom3 random(seed);
+  auto uniform = [&random, margin](TAxis const* axis) { return random.Uniform(axis->GetXmin() - margin, axis->GetXmax() + margin); };
+  for (int i = 0; i < entries; i++) {
+    auto x = uniform(histogram->GetXaxis());
+    auto y = uniform(histogram->GetYaxis());
+    auto z = uniform(histogram->GetZaxis());
+    switch (histogram->GetDimension()) {
+      case 1:
+        histogram->Fill(x, random.Uniform(0, 2));
+        break;
+      case 2:
+        dynamic_cast<TH2*>(histogram)->Fill(x, y, random.Uniform(0, 2));
+        break;
+      default:
+        dynamic_cast<TH3*>(histogram)->Fill(x, y, z, random.Uniform(0, 2));
+        break;
+    }
+  }
+}
+
+std::unique_ptr<TH1> clone(TH1 const* histogram)
+{
+  return std::unique_ptr<TH1>(dynamic_cast<TH1*>(histogram->Clone()));
+}
+
+/// \return @a other merged into a copy of @a target with the generic TH1::Merge
+std::unique_ptr<TH1> referenceMerge(TH1 const* target, TH1* other)
+{
+  auto result = clone(target);
+  TList list;
+  list.Add(other);
+  BOOST_REQUIRE(result->Merge(&list) != -1);
+  return result;
+}
+
+void checkSame(TH1 const* a, TH1 const* b)
+{
+  BOOST_REQUIRE_EQUAL(a->GetNcells(), b->GetNcells());
+  BOOST_CHECK_EQUAL(a->GetXaxis()->GetXmin(), b->GetXaxis()->GetXmin());
+  BOOST_CHECK_EQUAL(a->GetXaxis()->GetXmax(), b->GetXaxis()->GetXmax());
+  for (int bin = 0; bin < a->GetNcells(); bin++) {
+    BOOST_CHECK_CLOSE(a->GetBinContent(bin), b->GetBinContent(bin), 1e-4);
+    BOOST_CHECK_CLOSE(a->GetBinError(bin), b->GetBinError(bin), 1e-4);
+  }
+  BOOST_CHECK_EQUAL(a->GetEntries(), b->GetEntries());
+  BOOST_CHECK_CLOSE(a->GetMean(), b->GetMean(), 1e-4);
+  BOOST_CHECK_CLOSE(a->GetStdDev(), b->GetStdDev(), 1e-4);
+}
+
+std::vector<std::unique_ptr<TH1>> sameBinningPairs()
+{
+  std::vector<std::unique_ptr<TH1>> histograms;
+  const double edges[] = {0, 0.5, 1, 2, 4, 8, 10};
+  for (int i = 0; i < 2; i++) {
+    histograms.emplace_back(new TH1F("fixed", "fixed", 100, 0, 10));
+    histograms.emplace_back(new TH1D("variable", "variable", 6, edges));
+    histograms.emplace_back(new TH2F("2d", "2d", 20, 0, 10, 30, 0, 10));
+    histograms.emplace_back(new TH3D("3d", "3d", 5, 0, 10, 6, 0, 10, 7, 0, 10));
+  }
+  for (size_t i = 0; i < histograms.size(); i++) {
+    histograms[i]->Sumw2();
+    fill(histograms[i].get(), 1000, i + 1);
+  }
+  return histograms;
+}
+} // namespace
+
+BOOST_GLOBAL_FIXTURE(NoDirectory);
+
+BOOST_AUTO_TEST_CASE(MergerAlgorithmSameBinningAsMerge)
+{
+  // Histograms with the same binning are added, which must give the same as TH1::Merge
+  auto histograms = sameBinningPairs();
+  const size_t nKinds = histograms.size() / 2;
+  for (size_t i = 0; i < nKinds; i++) {
+    auto target = histograms[i].get();
+    auto other = histograms[i + nKinds].get();
+    auto reference = referenceMerge(target, other);
+    auto merged = clone(target);
+    algorithm::merge(merged.get(), other);
+    checkSame(merged.get(), reference.get());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MergerAlgorithmDifferentBinningFallsBack)
+{
+  // Different ranges: Add would sum the bins one by one, while the axis has to be extended
+  TH1F target("target", "target", 10, 0, 10);
+  TH1F other("other", "other", 10, 10, 20);
+  for (int i = 0; i < 10; i++) {
+    target.Fill(i + 0.5);
+    other.Fill(i + 10.5, 2);
+  }
+  auto reference = referenceMerge(&target, &other);
+  auto merged = clone(&target);
+  algorithm::merge(merged.get(), &other);
+  checkSame(merged.get(), reference.get());
+  BOOST_CHECK_EQUAL(merged->GetXaxis()->GetXmax(), 20);
+  BOOST_CHECK_EQUAL(merged->Integral(merged->FindBin(10.5), merged->FindBin(19.5)), 20);
+
+  // Different types
+  TH1D otherDouble("otherDouble", "otherDouble", 10, 0, 10);
+  otherDouble.Fill(3.5, 4);
+  reference = referenceMerge(&target, &otherDouble);
+  merged = clone(&target);
+  algorithm::merge(merged.get(), &otherDouble);
+  checkSame(merged.get(), reference.get());
+
+  // Labelled bins, which are matched by label rather than by position
+  TH1F labelsA("labelsA", "labelsA", 2, 0, 2);
+  TH1F labelsB("labelsB", "labelsB", 2, 0, 2);
+  labelsA.Fill("a", 1);
+  labelsA.Fill("b", 2);
+  labelsB.Fill("b", 3);
+  labelsB.Fill("a", 4);
+  reference = referenceMerge(&labelsA, &labelsB);
+  merged = clone(&labelsA);
+  algorithm::merge(merged.get(), &labelsB);
+  checkSame(merged.get(), reference.get());
+  BOOST_CHECK_EQUAL(merged->GetBinContent(merged->GetXaxis()->FindBin("a")), 5);
+  BOOST_CHECK_EQUAL(merged->GetBinContent(merged->GetXaxis()->FindBin("b")), 5);
+}
+
+BOOST_AUTO_TEST_CASE(MergerAlgorithmParallelAsSerial)
+{
+  const size_t nTargets = 8;
+  const size_t nDeltas = 10;
+  std::vector<std::unique_ptr<TH1>> serialTargets, parallelTargets;
+  std::vector<std::vector<std::unique_ptr<TH1>>> deltaStorage(nDeltas);
+  // TH1::Merge refuses to merge different axes with under- or overflows, so the entries stay inside
+  const double inside = -0.01;
+  for (size_t k = 0; k < nTargets; k++) {
+    serialTargets.emplace_back(new TH2F("target", "target", 50, 0, 10, 50, 0, 10));
+    fill(serialTargets.back().get(), 100, k + 1, inside);
+    parallelTargets.push_back(clone(serialTargets.back().get()));
+    for (size_t d = 0; d < nDeltas; d++) {
+      // One of the targets gets deltas which need the generic Merge
+      auto xMax = k == 3 ? 20 : 10;
+      deltaStorage[d].emplace_back(new TH2F("delta", "delta", 50, 0, xMax, 50, 0, 10));
+      fill(deltaStorage[d].back().get(), 100, 1000 * (k + 1) + d, inside);
+    }
+  }
+  std::vector<TObject*> serial, parallel;
+  for (size_t k = 0; k < nTargets; k++) {
+    serial.push_back(serialTargets[k].get());
+    parallel.push_back(parallelTargets[k].get());
+  }
+  std::vector<std::vector<TObject*>> deltas(nDeltas);
+  for (size_t d = 0; d < nDeltas; d++) {
+    for (auto& delta : deltaStorage[d]) {
+      deltas[d].push_back(delta.get());
+    }
+  }
+
+  ROOT::EnableThreadSafety();
+  o2::framework::ThreadPool pool(4);
+  algorithm::merge(serial, deltas, nullptr);
+  algorithm::merge(parallel, deltas, &pool);
+  for (size_t k = 0; k < nTargets; k++) {
+    checkSame(parallelTargets[k].get(), serialTargets[k].get());
+  }
+
+  // An object which cannot be merged is reported, whether or not the merge is parallel
+  TNamed notMergeable("notMergeable", "notMergeable");
+  parallel[5] = &notMergeable;
+  BOOST_CHECK_THROW(algorithm::merge(parallel, deltas, &pool), std::runtime_error);
+  BOOST_CHECK_THROW(algorithm::merge(parallel, deltas, nullptr), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(MergerAlgorithmResetReuse)
+{
+  auto histograms = sameBinningPairs();
+  const size_t nKinds = histograms.size() / 2;
+  for (size_t i = 0; i < nKinds; i++) {
+    // A first cycle, then the target is reset for the second one, where it gets a single delta
+    auto target = clone(histograms[i].get());
+    algorithm::merge(target.get(), histograms[i + nKinds].get());
+    BOOST_REQUIRE(algorithm::reset({target.get()}));
+    BOOST_CHECK_EQUAL(target->GetEntries(), 0);
+    BOOST_CHECK_EQUAL(target->GetSumOfWeights(), 0);
+    algorithm::merge(target.get(), histograms[i].get());
+    checkSame(target.get(), histograms[i].get());
+  }
+
+  // A target extended by a delta with a different binning
+  TH1F target("target", "target", 10, 0, 10);
+  TH1F wide("wide", "wide", 10, 10, 20);
+  target.Fill(5);
+  wide.Fill(15);
+  algorithm::merge(&target, &wide);
+  BOOST_REQUIRE(algorithm::reset({&target}));
+  TH1F narrow("narrow", "narrow", 10, 0, 10);
+  narrow.Fill(2.5, 3);
+  algorithm::merge(&target, &narrow);
+  BOOST_CHECK_EQUAL(target.GetEntries(), 1);
+  BOOST_CHECK_EQUAL(target.GetSumOfWeights(), 3);
+  BOOST_CHECK_EQUAL(target.GetBinContent(target.FindBin(2.5)), 3);
+
+  // Sparse histograms can be reused as well
+  const Int_t bins[] = {10, 10};
+  const Double_t min[] = {0, 0};
+  const Double_t max[] = {10, 10};
+  THnSparseF sparse("sparse", "sparse", 2, bins, min, max);
+  const Double_t point[] = {1, 2};
+  sparse.Fill(point);
+  BOOST_REQUIRE(algorithm::reset({&sparse}));
+  BOOST_CHECK_EQUAL(sparse.GetNbins(), 0);
+  BOOST_CHECK_EQUAL(sparse.GetEntries(), 0);
+
+  // Objects which cannot be reset are left untouched, together with the others
+  TH1F histogram("histogram", "histogram", 10, 0, 10);
+  histogram.Fill(1);
+  TNamed named("named", "named");
+  BOOST_CHECK(algorithm::reset({&histogram, &named}) == false);
+  BOOST_CHECK_EQUAL(histogram.GetEntries(), 1);
+}
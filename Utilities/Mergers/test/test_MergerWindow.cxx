@@ -0,0 +1,101 @@
+// Copyright CERN and copyright holders of ALICE O2. This software is
+// distributed under the terms of the GNU General Public License v3 (GPL
+// Version 3), copied verbatim in the file "COPYING".
+//
+// See http://alice-o2.web.cern.ch/license for full licensing information.
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \file test_MergerWindow.cxx
+/// \brief A unit test of the moving window and the time series of Mergers
+
+#define BOOST_TEST_MODULE Test Utilities MergerWindow
+#define BOOST_TEST_MAIN
+#define BOOST_TEST_DYN_LINK
+
+#include <boost/test/unit_test.hpp>
+
+#include "Mergers/MergerWindow.h"
+
+#include <TNamed.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+using namespace o2::experimental::mergers;
+using namespace std::chrono_literals;
+
+namespace
+{
+std::vector<std::string> names(MergerWindow const& window)
+{
+  std::vector<std::string> result;
+  for (const auto& entry : window) {
+    result.emplace_back(entry.object->GetName());
+  }
+  return result;
+}
+
+std::unique_ptr<TObject> named(const char* name)
+{
+  return std::make_unique<TNamed>(name, name);
+}
+} // namespace
+
+BOOST_AUTO_TEST_CASE(MergerWindowTimewiseOrdering)
+{
+  MergerWindow window;
+  auto t0 = MergerWindow::Clock::now();
+
+  // Objects are ordered by their timestamp, not by their arrival
+  window.insert(named("b"), 20.0, t0);
+  window.insert(named("c"), 30.0, t0 + 1s);
+  window.insert(named("a"), 10.0, t0 + 2s);
+  window.insert(named("b2"), 20.0, t0 + 3s); // after the earlier object with the same timestamp
+  window.insert(named("d"), 40.0, t0 + 4s);
+  BOOST_CHECK((names(window) == std::vector<std::string>{"a", "b", "b2", "c", "d"}));
+  BOOST_CHECK_EQUAL(window[0].timestamp, 10.0);
+  BOOST_CHECK(window[0].arrival == t0 + 2s);
+
+  // Objects without a timestamp of their own get the current time, in the same unit
+  auto before = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  auto now = MergerWindow::timestampNow();
+  auto after = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+  BOOST_CHECK(before <= now && now <= after);
+  window.insert(named("now"), now, t0 + 5s);
+  BOOST_CHECK_EQUAL(names(window).back(), "now");
+}
+
+BOOST_AUTO_TEST_CASE(MergerWindowExpiry)
+{
+  MergerWindow window;
+  auto t0 = MergerWindow::Clock::now();
+  BOOST_CHECK(window.expire(t0).empty());
+
+  window.insert(named("late"), 10.0, t0 + 3s); // arrived last, but has the earliest timestamp
+  window.insert(named("first"), 20.0, t0);
+  window.insert(named("second"), 30.0, t0 + 1s);
+  window.insert(named("third"), 40.0, t0 + 2s);
+
+  // Nothing arrived before the start of the window
+  BOOST_CHECK(window.expire(t0).empty());
+  BOOST_CHECK_EQUAL(window.size(), 4);
+
+  // Objects expire according to their arrival, and are returned in the window order
+  auto expired = window.expire(t0 + 1500ms);
+  BOOST_REQUIRE_EQUAL(expired.size(), 2);
+  BOOST_CHECK_EQUAL(expired[0]->GetName(), std::string("first"));
+  BOOST_CHECK_EQUAL(expired[1]->GetName(), std::string("second"));
+  BOOST_CHECK((names(window) == std::vector<std::string>{"late", "third"}));
+
+  // The remaining objects keep their order when new ones come
+  window.insert(named("new"), 35.0, t0 + 4s);
+  BOOST_CHECK((names(window) == std::vector<std::string>{"late", "new", "third"}));
+
+  expired = window.expire(t0 + 10s);
+  BOOST_CHECK_EQUAL(expired.size(), 3);
+  BOOST_CHECK(window.empty());
+}